@@ -18,6 +18,8 @@
 
 #include "ai_client.hpp"
 #include "ard_ev.hpp"
+#include "ard_httppool.hpp"
+#include "ard_sched.hpp"
 #include "utils.hpp"
 
 #include <wx/defs.h>
@@ -34,6 +36,8 @@
 #include <nlohmann/json.hpp>
 
 #include <curl/curl.h>
+#include <chrono>
+#include <cstring>
 #include <mutex>
 #include <thread>
 #include <cstdio>
@@ -53,14 +57,6 @@ using json = nlohmann::json;
 
 namespace {
 
-std::once_flag g_curlInitFlag;
-
-void EnsureCurlInitialized() {
-  std::call_once(g_curlInitFlag, []() {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-  });
-}
-
 size_t CurlWriteCallback(char *ptr, size_t size, size_t nmemb, void *userdata) {
   const size_t total = size * nmemb;
   if (!userdata || total == 0)
@@ -765,16 +761,279 @@ static bool FinalizeCliInvocationResult(const CliInvocation &inv,
   return true;
 }
 
-bool HttpPostWithCurl(const AiSettings &settings,
+// Incremental decoder of a streamed answer, fed from the cURL write callback.
+// Understands SSE ("data: {...}" events of chat/completions and the Responses
+// API) and NDJSON (native Ollama). Text deltas are coalesced and queued as
+// wxEVT_AI_SIMPLE_CHAT_PROGRESS events, the first one right away.
+class AiHttpStreamDecoder {
+public:
+  explicit AiHttpStreamDecoder(wxEvtHandler *target)
+      : m_target(target) {}
+
+  // A new attempt starts (request retry).
+  void Reset() {
+    m_line.clear();
+    m_data.clear();
+    m_text.clear();
+    m_pending.clear();
+    m_error.clear();
+    m_started = false;
+    m_streamed = false;
+    m_inTokens = -1;
+    m_outTokens = -1;
+  }
+
+  void Feed(const char *data, size_t len) {
+    m_line.append(data, len);
+
+    size_t pos = 0;
+    while (true) {
+      const size_t end = m_line.find('\n', pos);
+      if (end == std::string::npos)
+        break;
+      size_t lineEnd = end;
+      if (lineEnd > pos && m_line[lineEnd - 1] == '\r')
+        --lineEnd;
+      ProcessLine(m_line.data() + pos, lineEnd - pos);
+      pos = end + 1;
+    }
+    m_line.erase(0, pos);
+
+    MaybeFlush(false);
+  }
+
+  // End of the body: processes an unterminated last line and queues the rest.
+  void Finish() {
+    if (!m_line.empty()) {
+      ProcessLine(m_line.data(), m_line.size());
+      m_line.clear();
+    }
+    DispatchSseEvent();
+    MaybeFlush(true);
+  }
+
+  // Called periodically by cURL, so a coalesced delta does not wait for the next chunk.
+  void Tick() { MaybeFlush(false); }
+
+  // The body was a stream (SSE events or Ollama chunks), not a plain response.
+  bool IsStreamed() const { return m_streamed; }
+  const std::string &GetText() const { return m_text; }
+  const std::string &GetError() const { return m_error; }
+  int GetInputTokens() const { return m_inTokens; }
+  int GetOutputTokens() const { return m_outTokens; }
+
+private:
+  static constexpr long kFlushIntervalMs = 40;
+
+  wxEvtHandler *m_target = nullptr;
+
+  std::string m_line; // unterminated line
+  std::string m_data; // data of the current SSE event
+  std::string m_text; // whole answer so far
+  std::string m_pending;
+  std::string m_error;
+  bool m_started = false;
+  bool m_streamed = false;
+  std::chrono::steady_clock::time_point m_lastFlush;
+
+  int m_inTokens = -1;
+  int m_outTokens = -1;
+
+  void ProcessLine(const char *p, size_t len) {
+    if (len == 0) {
+      DispatchSseEvent();
+      return;
+    }
+
+    if (len >= 5 && std::memcmp(p, "data:", 5) == 0) {
+      size_t off = 5;
+      if (off < len && p[off] == ' ')
+        ++off;
+      if (!m_data.empty())
+        m_data.push_back('\n');
+      m_data.append(p + off, len - off);
+      return;
+    }
+
+    if (p[0] == '{') {
+      // NDJSON: one object per line
+      HandleJson(std::string(p, len));
+    }
+    // "event:", "id:", "retry:" and ": comment" lines are not needed
+  }
+
+  void DispatchSseEvent() {
+    if (m_data.empty())
+      return;
+    m_streamed = true;
+    if (m_data != "[DONE]")
+      HandleJson(m_data);
+    m_data.clear();
+  }
+
+  void HandleJson(const std::string &raw) {
+    json j = json::parse(raw, nullptr, false);
+    if (j.is_discarded() || !j.is_object())
+      return;
+
+    // every native Ollama chunk carries "done"
+    if (j.contains("done"))
+      m_streamed = true;
+
+    if (j.contains("error")) {
+      const json &e = j["error"];
+      if (e.is_string())
+        m_error = e.get<std::string>();
+      else if (e.is_object())
+        m_error = e.value("message", std::string("Unknown error from AI endpoint."));
+      return;
+    }
+
+    const std::string type = j.value("type", "");
+
+    // Responses API
+    if (!type.empty()) {
+      if (type == "response.output_text.delta" && j.contains("delta") && j["delta"].is_string()) {
+        AddDelta(j["delta"].get_ref<const std::string &>());
+      } else if (type == "response.completed" && j.contains("response") && j["response"].is_object()) {
+        ReadUsage(j["response"]);
+      } else if (type == "response.failed" || type == "error") {
+        const json &r = j.contains("response") ? j["response"] : j;
+        if (r.contains("error") && r["error"].is_object())
+          m_error = r["error"].value("message", std::string("AI request failed."));
+        else
+          m_error = r.value("message", std::string("AI request failed."));
+      }
+      return;
+    }
+
+    // chat/completions chunk (the last one carries usage only)
+    if (j.contains("choices") && j["choices"].is_array()) {
+      for (const auto &choice : j["choices"]) {
+        if (choice.is_object() && choice.contains("delta") && choice["delta"].is_object()) {
+          const json &d = choice["delta"];
+          if (d.contains("content") && d["content"].is_string())
+            AddDelta(d["content"].get_ref<const std::string &>());
+        }
+        break; // only the first choice is shown
+      }
+    }
+
+    // native Ollama: /api/chat and /api/generate
+    if (j.contains("message") && j["message"].is_object()) {
+      const json &m = j["message"];
+      if (m.contains("content") && m["content"].is_string())
+        AddDelta(m["content"].get_ref<const std::string &>());
+    } else if (j.contains("response") && j["response"].is_string()) {
+      AddDelta(j["response"].get_ref<const std::string &>());
+    }
+
+    ReadUsage(j);
+  }
+
+  void ReadUsage(const json &j) {
+    if (j.contains("usage") && j["usage"].is_object()) {
+      const json &u = j["usage"];
+      auto pick = [&u](const char *a, const char *b) -> int {
+        if (u.contains(a) && u[a].is_number_integer())
+          return u[a].get<int>();
+        if (u.contains(b) && u[b].is_number_integer())
+          return u[b].get<int>();
+        return -1;
+      };
+      m_inTokens = pick("input_tokens", "prompt_tokens");
+      m_outTokens = pick("output_tokens", "completion_tokens");
+    }
+
+    if (j.contains("prompt_eval_count") && j["prompt_eval_count"].is_number_integer())
+      m_inTokens = j["prompt_eval_count"].get<int>();
+    if (j.contains("eval_count") && j["eval_count"].is_number_integer())
+      m_outTokens = j["eval_count"].get<int>();
+  }
+
+  void AddDelta(const std::string &delta) {
+    if (delta.empty())
+      return;
+    m_text += delta;
+    m_pending += delta;
+  }
+
+  void MaybeFlush(bool force) {
+    if (m_pending.empty() || !m_target)
+      return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!force && m_started &&
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_lastFlush).count() < kFlushIntervalMs) {
+      return;
+    }
+
+    // never split a UTF-8 sequence between two events
+    size_t cut = m_pending.size();
+    if (!force) {
+      size_t i = cut;
+      while (i > 0 && (((unsigned char)m_pending[i - 1]) & 0xC0) == 0x80)
+        --i;
+      if (i > 0) {
+        const unsigned char lead = (unsigned char)m_pending[i - 1];
+        const size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        if (cut - (i - 1) < need)
+          cut = i - 1;
+      }
+      if (cut == 0)
+        return;
+    }
+
+    auto *evt = new wxThreadEvent(wxEVT_AI_SIMPLE_CHAT_PROGRESS);
+    evt->SetString(wxString::FromUTF8(m_pending.data(), cut));
+    evt->SetInt(m_started ? AI_PROGRESS_STREAM_DELTA : AI_PROGRESS_STREAM_START);
+    wxQueueEvent(m_target, evt);
+
+    m_pending.erase(0, cut);
+    m_started = true;
+    m_lastFlush = now;
+  }
+};
+
+struct CurlStreamContext {
+  CURL *curl = nullptr;
+  std::string *body = nullptr;
+  AiHttpStreamDecoder *stream = nullptr;
+};
+
+size_t CurlStreamWriteCallback(char *ptr, size_t size, size_t nmemb, void *userdata) {
+  const size_t total = size * nmemb;
+  if (!userdata || total == 0)
+    return total;
+
+  auto *ctx = static_cast<CurlStreamContext *>(userdata);
+  ctx->body->append(ptr, total);
+
+  // error bodies are reported from the whole body later
+  long httpCode = 0;
+  curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &httpCode);
+  if (httpCode >= 200 && httpCode < 300)
+    ctx->stream->Feed(ptr, total);
+  return total;
+}
+
+int CurlStreamProgressCallback(void *userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+  static_cast<CurlStreamContext *>(userdata)->stream->Tick();
+  return 0;
+}
+
+bool HttpPostWithCurl(ArduinoHttpPool &pool,
+                      const AiSettings &settings,
                       const wxString &bodyJson,
                       const wxString &apiKey,
                       wxString &responseOut,
-                      wxString *errorOut) {
+                      wxString *errorOut,
+                      AiHttpStreamDecoder *stream = nullptr) {
   responseOut.clear();
 
-  EnsureCurlInitialized();
-
-  CURL *curl = curl_easy_init();
+  // Pooled handle: a warm connection to the endpoint is reused when there is one.
+  ArduinoHttpPool::Handle handle = pool.Acquire();
+  CURL *curl = handle.get();
   if (!curl) {
     if (errorOut) {
       *errorOut = _("Failed to initialize HTTP client (cURL).");
@@ -804,8 +1063,20 @@ bool HttpPostWithCurl(const AiSettings &settings,
   curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
   curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.size());
 
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+  CurlStreamContext streamCtx;
+  if (stream) {
+    streamCtx.curl = curl;
+    streamCtx.body = &responseBody;
+    streamCtx.stream = stream;
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlStreamWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &streamCtx);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CurlStreamProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &streamCtx);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+  } else {
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseBody);
+  }
 
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
 
@@ -841,9 +1112,14 @@ bool HttpPostWithCurl(const AiSettings &settings,
   for (int attempt = 0; attempt < 3; attempt++) {
     responseBody.clear();
     httpCode = 0;
+    if (stream)
+      stream->Reset();
 
     res = curl_easy_perform(curl);
 
+    if (stream)
+      stream->Finish();
+
     if (res == CURLE_OK) {
       curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
     }
@@ -852,7 +1128,6 @@ bool HttpPostWithCurl(const AiSettings &settings,
     if (success) {
       responseOut = wxString::FromUTF8(responseBody.c_str());
       curl_slist_free_all(headers);
-      curl_easy_cleanup(curl);
       return true;
     }
 
@@ -877,17 +1152,16 @@ bool HttpPostWithCurl(const AiSettings &settings,
                   attempt + 1, backoffMs, (int)res, httpCode);
 
     std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+  }
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+  curl_slist_free_all(headers);
 
-    if (res != CURLE_OK) {
-      if (errorOut) {
-        *errorOut = _("HTTP request failed: ") +
-                    wxString::FromUTF8(curl_easy_strerror(res));
-      }
-      return false;
+  if (res != CURLE_OK) {
+    if (errorOut) {
+      *errorOut = _("HTTP request failed: ") +
+                  wxString::FromUTF8(curl_easy_strerror(res));
     }
+    return false;
   }
 
   if (httpCode < 200 || httpCode >= 300) {
@@ -938,7 +1212,7 @@ bool HttpPostWithCurl(const AiSettings &settings,
 // ===== AiClient =====
 
 AiClient::AiClient(const AiSettings &settings)
-    : m_settings(settings) {
+    : m_settings(settings), m_httpPool(ArduinoHttpPool::Shared()) {
 }
 
 bool AiClient::IsEnabled() const {
@@ -1117,7 +1391,7 @@ bool AiClient::SimpleChatAsync(const wxString &systemPrompt,
     wxString systemCopy = systemPrompt;
     wxString userCopy = userPrompt;
 
-    std::thread([systemCopy, userCopy, target, this]() {
+    ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [systemCopy, userCopy, target, this]() {
       CliInvocation inv = BuildCliCommand(m_settings, systemCopy, userCopy);
       APP_DEBUG_LOG("AICLI: CLI COMMAND: %s", wxToStd(BuildCliShellCommand(inv)).c_str());
 
@@ -1135,7 +1409,7 @@ bool AiClient::SimpleChatAsync(const wxString &systemPrompt,
         evt->SetString(err.IsEmpty() ? _("CLI process failed.") : err);
         wxQueueEvent(target, evt);
       }
-    }).detach();
+    });
 
     return true;
   }
@@ -1167,8 +1441,17 @@ bool AiClient::SimpleChatAsync(const wxString &systemPrompt,
           ? std::set<std::string>{"model", "messages"}
           : std::set<std::string>{"model", "instructions", "input"};
 
+  // The answer is streamed token by token, extra JSON may still turn it off.
+  j["stream"] = true;
+
   MergeExtraNoOverride(j, extra, protectedKeys);
 
+  if (IsChatCompletionsEndpoint(m_settings.endpointUrl) &&
+      j.value("stream", false) && !j.contains("stream_options")) {
+    // token usage comes in the last chunk only when asked for
+    j["stream_options"] = json{{"include_usage", true}};
+  }
+
   wxString bodyJson = wxString::FromUTF8(j.dump().c_str());
 
   APP_DEBUG_LOG("AICLI: REQUEST:\n%s\n%s",
@@ -1178,49 +1461,32 @@ bool AiClient::SimpleChatAsync(const wxString &systemPrompt,
   wxEvtHandler *target = handler;
   wxString bodyCopy = bodyJson;
 
-  // Worker thread with a blocking HTTP request via cURL,
-  // returns wxEVT_AI_SIMPLE_CHAT_SUCCESS/ERROR when finished.
-  std::thread([bodyCopy, target, this]() {
-    wxString rawResponse;
+  // Worker thread with a blocking HTTP request via cURL, the answer is
+  // streamed as wxEVT_AI_SIMPLE_CHAT_PROGRESS while it is generated and
+  // wxEVT_AI_SIMPLE_CHAT_SUCCESS/ERROR is sent when finished.
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [bodyCopy, target, this]() {
+    wxString reply;
     wxString err;
 
-    if (!DoHttpPost(bodyCopy, rawResponse, &err)) {
-      auto *evt = new wxThreadEvent(wxEVT_AI_SIMPLE_CHAT_ERROR);
-      if (err.IsEmpty())
-        err = _("HTTP request failed.");
-      evt->SetString(err);
-      wxQueueEvent(target, evt);
-
-      APP_DEBUG_LOG("AICLI: COMMUNICATION ERROR %s", wxToStd(err).c_str());
-
-      return;
-    }
-
-    wxString reply;
-    wxString extractErr;
-    if (ExtractAssistantText(rawResponse, reply, &extractErr)) {
+    if (DoHttpPostStreaming(bodyCopy, target, reply, &err)) {
       APP_DEBUG_LOG("AICLI: RESPONSE:\n%s", wxToStd(reply).c_str());
       auto *evt = new wxThreadEvent(wxEVT_AI_SIMPLE_CHAT_SUCCESS);
       evt->SetString(reply);
       wxQueueEvent(target, evt);
     } else {
-      if (extractErr.IsEmpty())
-        extractErr = _("Could not extract assistant text from AI response.");
-      APP_DEBUG_LOG("AICLI: ERROR EXTRACT RESPONSE:\n%s", wxToStd(reply).c_str());
+      if (err.IsEmpty())
+        err = _("HTTP request failed.");
+      APP_DEBUG_LOG("AICLI: REQUEST ERROR %s", wxToStd(err).c_str());
       auto *evt = new wxThreadEvent(wxEVT_AI_SIMPLE_CHAT_ERROR);
-      evt->SetString(extractErr);
+      evt->SetString(err);
       wxQueueEvent(target, evt);
     }
-  }).detach();
+  });
 
   return true;
 }
 
-bool AiClient::DoHttpPost(const wxString &bodyJson,
-                          wxString &responseOut,
-                          wxString *errorOut) const {
-  responseOut.clear();
-
+wxString AiClient::ResolveApiKey() const {
   wxString apiKey;
   wxString keyErr;
   if (m_settings.hasAuthentization) {
@@ -1232,8 +1498,51 @@ bool AiClient::DoHttpPost(const wxString &bodyJson,
   } else {
     APP_DEBUG_LOG("AICLI: Endpoint %s has no authentication.", wxToStd(m_settings.endpointUrl).c_str());
   }
+  return apiKey;
+}
 
-  return HttpPostWithCurl(m_settings, bodyJson, apiKey, responseOut, errorOut);
+bool AiClient::DoHttpPost(const wxString &bodyJson,
+                          wxString &responseOut,
+                          wxString *errorOut) const {
+  responseOut.clear();
+
+  return HttpPostWithCurl(*m_httpPool, m_settings, bodyJson, ResolveApiKey(), responseOut, errorOut);
+}
+
+bool AiClient::DoHttpPostStreaming(const wxString &bodyJson,
+                                   wxEvtHandler *progressTarget,
+                                   wxString &assistantText,
+                                   wxString *errorOut) const {
+  assistantText.clear();
+
+  AiHttpStreamDecoder stream(progressTarget);
+  wxString rawResponse;
+  if (!HttpPostWithCurl(*m_httpPool, m_settings, bodyJson, ResolveApiKey(), rawResponse, errorOut, &stream)) {
+    return false;
+  }
+
+  if (!stream.GetError().empty()) {
+    if (errorOut)
+      *errorOut = wxString::FromUTF8(stream.GetError().c_str());
+    return false;
+  }
+
+  if (!stream.IsStreamed()) {
+    // The endpoint ignored "stream" and answered with a plain response.
+    return ExtractAssistantText(rawResponse, assistantText, errorOut);
+  }
+
+  // a stream without text deltas (e.g. tool calls only) is an empty answer
+  StoreTokenUsage(stream.GetInputTokens(), stream.GetOutputTokens());
+  assistantText = wxString::FromUTF8(stream.GetText().c_str());
+  return true;
+}
+
+void AiClient::StoreTokenUsage(int inTok, int outTok) const {
+  int totalTok = (inTok >= 0 && outTok >= 0) ? (inTok + outTok) : 0;
+  m_lastInputTokens.store(std::max(0, inTok), std::memory_order_relaxed);
+  m_lastOutputTokens.store(std::max(0, outTok), std::memory_order_relaxed);
+  m_lastTotalTokens.store(std::max(0, totalTok), std::memory_order_relaxed);
 }
 
 bool AiClient::ExtractAssistantText(const wxString &responseJson,
@@ -1246,13 +1555,6 @@ bool AiClient::ExtractAssistantText(const wxString &responseJson,
       *errorOut = msg;
   };
 
-  auto StoreTokenUsage = [&](int inTok, int outTok) {
-    int totalTok = (inTok >= 0 && outTok >= 0) ? (inTok + outTok) : 0;
-    m_lastInputTokens.store(std::max(0, inTok), std::memory_order_relaxed);
-    m_lastOutputTokens.store(std::max(0, outTok), std::memory_order_relaxed);
-    m_lastTotalTokens.store(std::max(0, totalTok), std::memory_order_relaxed);
-  };
-
   auto ExtractFromSingleJsonObject = [&](const json &j, wxString &out, wxString *err) -> bool {
     // --- 0) error (OpenAI i Ollama varianty)
     try {
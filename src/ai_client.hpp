@@ -19,8 +19,18 @@
 #pragma once
 
 #include "ard_setdlg.hpp"
+#include <memory>
 #include <wx/string.h>
 
+class ArduinoHttpPool;
+
+// GetInt() of a wxEVT_AI_SIMPLE_CHAT_PROGRESS event.
+enum AiProgressKind {
+  AI_PROGRESS_MESSAGE = 0,      // a whole progress message (CLI output)
+  AI_PROGRESS_STREAM_START = 1, // first text delta of a streamed answer
+  AI_PROGRESS_STREAM_DELTA = 2  // next text delta of the same answer
+};
+
 class AiClient {
 public:
   explicit AiClient(const AiSettings &settings);
@@ -49,16 +59,28 @@ public:
 
 private:
   AiSettings m_settings;
+  std::shared_ptr<ArduinoHttpPool> m_httpPool; // warm connections across requests and clients
   mutable std::atomic<int> m_lastInputTokens{0};
   mutable std::atomic<int> m_lastOutputTokens{0};
   mutable std::atomic<int> m_lastTotalTokens{0};
 
   bool LoadApiKey(wxString &keyOut, wxString *errorOut = nullptr) const;
 
+  wxString ResolveApiKey() const;
+
   bool DoHttpPost(const wxString &bodyJson,
                   wxString &responseOut,
                   wxString *errorOut = nullptr) const;
 
+  // Posts a "stream": true request, text deltas are queued to progressTarget
+  // as they arrive. assistantText gets the whole answer.
+  bool DoHttpPostStreaming(const wxString &bodyJson,
+                           wxEvtHandler *progressTarget,
+                           wxString &assistantText,
+                           wxString *errorOut = nullptr) const;
+
+  void StoreTokenUsage(int inTok, int outTok) const;
+
   bool ExtractAssistantText(const wxString &responseJson,
                             wxString &assistantText,
                             wxString *errorOut = nullptr) const;
@@ -25,6 +25,7 @@
 #include "ard_indic.hpp"
 #include "ard_pop.hpp"
 #include "ard_ps.hpp"
+#include "ard_sched.hpp"
 
 #include <algorithm>
 #include <nlohmann/json.hpp>
@@ -854,9 +855,9 @@ static bool FilesDifferent(const std::string &sketchRoot,
   mb.reserve(b.size());
 
   for (const auto &x : a)
-    ma[KeyRel(sketchRoot, x.filename)] = x.code;
+    ma[KeyRel(sketchRoot, x.filename)] = x.Code();
   for (const auto &x : b)
-    mb[KeyRel(sketchRoot, x.filename)] = x.code;
+    mb[KeyRel(sketchRoot, x.filename)] = x.Code();
 
   if (ma.size() != mb.size())
     return true;
@@ -1920,7 +1921,7 @@ wxString ArduinoAiActions::GenerateSessionTitleIfRequested(const wxString &userT
     textForAi = textForAi.Mid(0, 1200) + wxT("...");
   }
 
-  std::thread([this, st, sketchRoot, sessionId, textForAi]() mutable {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, st, sketchRoot, sessionId, textForAi]() mutable {
     // Build a short prompt
     wxString systemPrompt = wxT(
         "You are an assistant embedded in an IDE. "
@@ -1961,7 +1962,7 @@ wxString ArduinoAiActions::GenerateSessionTitleIfRequested(const wxString &userT
     wxThreadEvent evt(wxEVT_AI_SUMMARIZATION_UPDATED);
     evt.SetString(wxString::FromUTF8(sessionId) + wxT("\n") + title);
     wxPostEvent(this, evt);
-  }).detach();
+  });
 
   return heuristicTitle;
 }
@@ -2152,7 +2153,7 @@ bool ArduinoAiActions::StartInteractiveChat(const wxString &userText, wxEvtHandl
   // Copy settings for thread lifetime
   const AiSettings st = m_editor->m_aiSettings;
 
-  std::thread([this, st, routerInput, ephemeralPrompt, seq]() mutable {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, st, routerInput, ephemeralPrompt, seq]() mutable {
     AiRouterDecision dec; // defaults LIGHT/INVESTIGATE
     try {
       AiClient rc(st);
@@ -2252,7 +2253,7 @@ bool ArduinoAiActions::StartInteractiveChat(const wxString &userText, wxEvtHandl
         return;
       }
     });
-  }).detach();
+  });
 
   return true;
 }
@@ -2700,7 +2701,7 @@ wxString ArduinoAiActions::HandleInfoRequest(const AiInfoRequest &req) {
     int matchCount = 0;
 
     for (const auto &b : m_solveSession.workingFiles) {
-      const std::string text = b.code;
+      const std::string &text = b.Code();
 
       // Precompute line starts for fast line/col computations
       std::vector<size_t> lineStarts;
@@ -2816,7 +2817,7 @@ wxString ArduinoAiActions::HandleInfoRequest(const AiInfoRequest &req) {
       return resp;
     }
 
-    const std::string &text = buf->code;
+    const std::string &text = buf->Code();
 
     // Build line starts
     std::vector<size_t> lineStarts;
@@ -3100,7 +3101,7 @@ bool ArduinoAiActions::ApplyAiPatchToFiles(const std::vector<AiPatchHunk> &patch
                 return a.fromLine > b.fromLine;
               });
 
-    std::string &text = buf->code;
+    std::string &text = buf->MutableCode();
 
     // Precompute line starts once per file (but must refresh after each replace if ranges might depend on updated text).
     // Because we apply from end, we can recompute each time cheaply and stay correct even if earlier hunks change line structure.
@@ -4016,7 +4017,7 @@ std::string ArduinoAiActions::GetCurrentCode() {
 
     for (auto &buff : m_solveSession.workingFiles) {
       if (normName == NormalizeFilename(sketchRoot, buff.filename)) {
-        return buff.code;
+        return buff.Code();
       }
     }
 
@@ -4035,9 +4036,7 @@ SketchFileBuffer *ArduinoAiActions::FindBufferWithFile(const std::string &filena
   }
 
   if (allowCreate) {
-    SketchFileBuffer buff;
-    buff.filename = normName;
-    buff.code.clear();
+    SketchFileBuffer buff(normName, std::string());
     m_solveSession.workingFiles.push_back(std::move(buff));
     return &m_solveSession.workingFiles.back();
   } else {
@@ -4179,8 +4178,45 @@ void ArduinoAiActions::OnAiSimpleChatProgress(wxThreadEvent &event) {
   if (m_currentAction != Action::InteractiveChat)
     return;
 
+  int kind = event.GetInt(); // AiProgressKind
+  wxString text = event.GetString();
+
+  if (kind != AI_PROGRESS_MESSAGE) {
+    // A streamed answer may be a PATCH / INFO_REQUEST block, which is
+    // processed, not shown. Its raw markup never reaches the chat.
+    static const wxString marker = wxT("*** BEGIN");
+
+    if (kind == AI_PROGRESS_STREAM_START) {
+      m_streamText.clear();
+      m_streamShown = 0;
+      m_streamHidden = false;
+    }
+    if (m_streamHidden)
+      return;
+
+    m_streamText += text;
+    if (m_streamText.Find(marker) != wxNOT_FOUND) {
+      m_streamHidden = true;
+      return;
+    }
+
+    // hold back a tail that may still grow into the marker
+    size_t hold = std::min(m_streamText.length(), marker.length() - 1);
+    while (hold > 0 && !marker.StartsWith(m_streamText.Right(hold)))
+      --hold;
+
+    const size_t end = m_streamText.length() - hold;
+    if (end <= m_streamShown)
+      return;
+
+    text = m_streamText.Mid(m_streamShown, end - m_streamShown);
+    kind = (m_streamShown == 0) ? AI_PROGRESS_STREAM_START : AI_PROGRESS_STREAM_DELTA;
+    m_streamShown = end;
+  }
+
   wxThreadEvent evt(wxEVT_AI_SIMPLE_CHAT_PROGRESS);
-  evt.SetString(event.GetString());
+  evt.SetString(text);
+  evt.SetInt(kind);
   wxPostEvent(m_origin, evt);
 }
 
@@ -4337,7 +4373,7 @@ void ArduinoAiActions::OnDiagnosticsUpdated(wxThreadEvent &evt) {
         }
       }
 
-      pathEd->SetText(newSfb.code);
+      pathEd->SetText(newSfb.Code());
 
       // 3) summary to chat
       m_interactiveChatPayload.Append(
@@ -4381,7 +4417,7 @@ void ArduinoAiActions::OnDiagnosticsUpdated(wxThreadEvent &evt) {
     TrimTranscriptToLastPatchWindow(m_chatTranscript);
 
     std::string basename = StripFilename(sketchRoot, best->file);
-    wxString ctx = GetNumberedContextAroundLine(wxString::FromUTF8(buf->code), (int)best->line - 1, 150);
+    wxString ctx = GetNumberedContextAroundLine(wxString::FromUTF8(buf->Code()), (int)best->line - 1, 150);
 
     m_solveSession.basename = wxString::FromUTF8(basename);
 
@@ -4537,11 +4573,11 @@ wxString ArduinoAiActions::BuildProjectFilesIndexForAi(size_t maxFiles) const {
 
       // optional: quick line count (helps the model estimate ranges)
       int lines = 0;
-      for (char c : b.code) {
+      for (char c : b.Code()) {
         if (c == '\n')
           ++lines;
       }
-      if (!b.code.empty())
+      if (!b.Code().empty())
         ++lines;
 
       if (lines > 0) {
@@ -4675,7 +4711,7 @@ wxString ArduinoAiActions::BuildAppliedPatchEvidence(const std::vector<AiPatchHu
       continue;
     }
 
-    const wxString allText = wxString::FromUTF8(wf->code);
+    const wxString allText = wxString::FromUTF8(wf->Code());
 
     const int from0 = std::max(0, (int)p.fromLine - 1 - extraContextLines);
     const int to0 = std::max(0, (int)p.toLine - 1 + extraContextLines);
@@ -4780,6 +4816,6 @@ void ArduinoAiActions::OpenPendingPatchReview(const std::string &id) {
         continue;
       }
     }
-    ed->SetText(newSfb.code);
+    ed->SetText(newSfb.Code());
   }
 }
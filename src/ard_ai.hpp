@@ -244,6 +244,11 @@ private:
   wxEvtHandler *m_origin;
 
   wxString m_interactiveChatPayload;
+
+  // streamed HTTP answer of the interactive chat, only its prose goes to the panel
+  wxString m_streamText;
+  size_t m_streamShown = 0;
+  bool m_streamHidden = false;
   uint64_t m_routerSeq = 0;
   uint64_t m_routerActiveSeq = 0;
 
@@ -19,6 +19,7 @@
 #include "ard_aimdldlg.hpp"
 
 #include "ai_client.hpp" // AiClient::CheckExtraRequestJson
+#include "ard_sched.hpp"
 #include "utils.hpp"
 
 #include <thread>
@@ -536,7 +537,7 @@ void ArduinoAiModelDialog::OnOk() {
     const wxString service = KeyService();
     const wxString username = KeyUser();
 
-    std::thread([service, username, apiKey]() {
+    ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [service, username, apiKey]() {
       wxSecretStore store = wxSecretStore::GetDefault();
       wxString e;
       if (!store.IsOk(&e))
@@ -544,7 +545,7 @@ void ArduinoAiModelDialog::OnOk() {
 
       // This may still block, but only this background thread, not the UI.
       store.Save(service, username, apiKey);
-    }).detach();
+    });
   }
 #else
   if (doSaveKey) {
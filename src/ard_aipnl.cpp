@@ -716,6 +716,7 @@ void ArduinoAiChatPanel::SendCurrentInput() {
   // Clean input
   m_inputCtrl->SetText(wxEmptyString);
   m_hasStreamingOutput = false;
+  m_streamingAnswer = false;
   m_lastStreamingMessage.Clear();
 
   if (!m_actions) {
@@ -795,7 +796,10 @@ void ArduinoAiChatPanel::OnChatSuccess(wxThreadEvent &event) {
     const wxString trimmedAnswer = TrimCopy(answer);
     const wxString trimmedLastStream = TrimCopy(m_lastStreamingMessage);
 
-    if (!m_hasStreamingOutput) {
+    if (m_streamingAnswer) {
+      // the final answer replaces the live one
+      m_historyPanel->ReplaceLastMarkdown(answer, info, time);
+    } else if (!m_hasStreamingOutput) {
       m_historyPanel->AppendMarkdown(answer, AiMarkdownRole::Assistant, info, time);
     } else if (trimmedAnswer != trimmedLastStream) {
       m_historyPanel->AppendMarkdown(wxT("\n\n---\n\n") + answer, AiMarkdownRole::Assistant, info, time);
@@ -803,6 +807,7 @@ void ArduinoAiChatPanel::OnChatSuccess(wxThreadEvent &event) {
   }
 
   m_hasStreamingOutput = false;
+  m_streamingAnswer = false;
   m_lastStreamingMessage.Clear();
 
   RefreshSessionList();
@@ -823,10 +828,15 @@ void ArduinoAiChatPanel::OnChatError(wxThreadEvent &event) {
   }
 
   if (m_historyPanel) {
+    if (m_streamingAnswer) {
+      // a partial live answer must not look like a finished one
+      m_historyPanel->RemoveLastMarkdown();
+    }
     m_historyPanel->AppendMarkdown(msg, AiMarkdownRole::Error);
   }
 
   m_hasStreamingOutput = false;
+  m_streamingAnswer = false;
   m_lastStreamingMessage.Clear();
 
   // Keep the choice labels (message counts) in sync even on errors.
@@ -893,15 +903,29 @@ void ArduinoAiChatPanel::OnChatProgress(wxThreadEvent &event) {
     return;
   }
 
-  wxString placeholder = wxT("  ") + _("AI model thinking...") + wxT("  ");
-  m_inputCtrl->SetText(placeholder);
-  m_inputCtrl->StartStyling(0);
-  m_inputCtrl->SetStyling((int)placeholder.length() * 2, kStylePlaceholder);
-  m_inputCtrl->GotoPos(0);
+  const int kind = event.GetInt(); // AiProgressKind
+
+  if (kind != AI_PROGRESS_STREAM_DELTA) {
+    wxString placeholder = wxT("  ") + _("AI model thinking...") + wxT("  ");
+    m_inputCtrl->SetText(placeholder);
+    m_inputCtrl->StartStyling(0);
+    m_inputCtrl->SetStyling((int)placeholder.length() * 2, kStylePlaceholder);
+    m_inputCtrl->GotoPos(0);
+  }
 
   if (m_historyPanel) {
-    m_historyPanel->AppendMarkdown(msg, AiMarkdownRole::Assistant);
+    if (m_streamingAnswer && kind == AI_PROGRESS_STREAM_DELTA) {
+      m_historyPanel->AppendToLastMarkdown(msg);
+      m_lastStreamingMessage += msg;
+    } else if (m_streamingAnswer && kind == AI_PROGRESS_STREAM_START) {
+      // next request of the same chat turn (or a retry) - show its answer instead
+      m_historyPanel->ReplaceLastMarkdown(msg);
+      m_lastStreamingMessage = msg;
+    } else {
+      m_historyPanel->AppendMarkdown(msg, AiMarkdownRole::Assistant);
+      m_streamingAnswer = (kind != AI_PROGRESS_MESSAGE);
+      m_lastStreamingMessage = msg;
+    }
     m_hasStreamingOutput = true;
-    m_lastStreamingMessage = msg;
   }
 }
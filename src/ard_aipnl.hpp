@@ -57,6 +57,7 @@ private:
 
   bool m_isBusy{false};
   bool m_hasStreamingOutput{false};
+  bool m_streamingAnswer{false}; // the last history message is a live streamed answer
   wxString m_lastStreamingMessage;
 
   ArduinoAiActions *m_actions = nullptr;
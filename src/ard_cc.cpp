@@ -18,12 +18,17 @@
 
 #include "ard_cc.hpp"
 #include "ard_ed_frm.hpp"
+#include "ard_fuzzy.hpp"
+#include "ard_inoproto.hpp"
+#include "ard_sched.hpp"
+#include "ard_xref.hpp"
 #include <algorithm>
 #include <cctype>
 #include <fstream>
 #include <regex>
 #include <set>
 #include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -143,6 +148,35 @@ static bool HasUnknownTargetDiag(CXTranslationUnit tu) {
   return false;
 }
 
+// libclang does not fail the parse when -include-pch is rejected (out of date,
+// different compiler, ...), it just reports a fatal error.
+static bool HasRejectedPchDiag(CXTranslationUnit tu) {
+  if (!tu)
+    return false;
+
+  const unsigned n = clang_getNumDiagnostics(tu);
+
+  for (unsigned i = 0; i < n; ++i) {
+    CXDiagnostic d = clang_getDiagnostic(tu, i);
+    bool hit = false;
+
+    if (clang_getDiagnosticSeverity(d) == CXDiagnostic_Fatal) {
+      CXString s = clang_getDiagnosticSpelling(d);
+      const char *msg = clang_getCString(s);
+      if (msg && (strstr(msg, "PCH") || strstr(msg, "precompiled header") || strstr(msg, "AST file"))) {
+        hit = true;
+      }
+      clang_disposeString(s);
+    }
+
+    clang_disposeDiagnostic(d);
+
+    if (hit)
+      return true;
+  }
+  return false;
+}
+
 static void LogClangArgsDebug(const std::vector<const char *> &args, int maxArgs = 1000) {
   const int n = (int)args.size();
   APP_DEBUG_LOG("CC: clang args (%d):", n);
@@ -479,6 +513,140 @@ static bool GetBodyRangeForCursor(CXTranslationUnit tu,
   return false;
 }
 
+struct SymbolsVisitorData {
+  CXTranslationUnit tu;
+  std::vector<SymbolInfo> *symbols;
+  std::string mainFile;
+  int addedLines;
+  CXCursor parentFilter;
+  bool useParentFilter;
+};
+
+static CXChildVisitResult CollectSymbolsVisitor(CXCursor cursor, CXCursor WXUNUSED(parent), CXClientData client_data) {
+  auto *data = static_cast<SymbolsVisitorData *>(client_data);
+
+  CXCursorKind kind = clang_getCursorKind(cursor);
+
+  switch (kind) {
+    case CXCursor_FunctionDecl:
+    case CXCursor_CXXMethod:
+    case CXCursor_Constructor:
+    case CXCursor_Destructor:
+    case CXCursor_FunctionTemplate:
+    case CXCursor_VarDecl:
+    case CXCursor_FieldDecl:
+    case CXCursor_ParmDecl:
+    case CXCursor_EnumConstantDecl:
+    case CXCursor_StructDecl:
+    case CXCursor_ClassDecl:
+    case CXCursor_UnionDecl:
+    case CXCursor_EnumDecl:
+    case CXCursor_TypedefDecl:
+    case CXCursor_MacroDefinition:
+      break;
+    default:
+      return CXChildVisit_Recurse;
+  }
+
+  std::string name = cxStringToStd(clang_getCursorSpelling(cursor));
+  if (name.empty())
+    return CXChildVisit_Recurse;
+
+  // If we have a filter on the parent (container), we check the semantic parent
+  if (data->useParentFilter) {
+    CXCursor parent = clang_getCursorSemanticParent(cursor);
+    if (clang_Cursor_isNull(parent))
+      return CXChildVisit_Recurse;
+
+    CXCursor canonParent = clang_getCanonicalCursor(parent);
+    if (!clang_equalCursors(canonParent, data->parentFilter)) {
+      return CXChildVisit_Recurse;
+    }
+  }
+
+  CXSourceLocation loc = clang_getCursorLocation(cursor);
+  CXFile file;
+  unsigned line = 0, column = 0, offset = 0;
+  clang_getSpellingLocation(loc, &file, &line, &column, &offset);
+  if (!file)
+    return CXChildVisit_Recurse;
+
+  std::string fileName = cxStringToStd(clang_getFileName(file));
+
+  SymbolInfo si;
+  si.name = std::move(name);
+  si.display = cxStringToStd(clang_getCursorDisplayName(cursor));
+  if (si.display.empty())
+    si.display = si.name;
+  si.usr = GetCursorUsr(cursor);
+  si.file = std::move(fileName);
+  si.line = (int)line;
+  si.column = (int)column;
+  si.kind = kind;
+
+  // If the symbol is a function/method/ctor/dtor/template -> fill in the parameters
+  switch (kind) {
+    case CXCursor_FunctionDecl:
+    case CXCursor_CXXMethod:
+    case CXCursor_Constructor:
+    case CXCursor_Destructor:
+    case CXCursor_FunctionTemplate:
+      FillParameterInfoFromCursor(cursor, si.parameters);
+      break;
+    default:
+      break;
+  }
+
+  // Strip bogus "void " for constructors/destructors.
+  if ((kind == CXCursor_Constructor || kind == CXCursor_Destructor) &&
+      hasPrefix(si.display, "void ")) {
+    si.display.erase(0, 5); // drop "void "
+    while (!si.display.empty() &&
+           std::isspace((unsigned char)si.display[0])) {
+      si.display.erase(0, 1);
+    }
+  }
+
+  // Body scope { ... } for functions/methods
+  {
+    unsigned blFrom = 0, bcFrom = 0, blTo = 0, bcTo = 0;
+    if (GetBodyRangeForCursor(data->tu, cursor, blFrom, bcFrom, blTo, bcTo)) {
+      // correction .ino addedLines, same as si.line
+      if (!data->mainFile.empty() &&
+          si.file == data->mainFile &&
+          data->addedLines > 0) {
+
+        if (blFrom > (unsigned)data->addedLines &&
+            blTo > (unsigned)data->addedLines) {
+          blFrom -= (unsigned)data->addedLines;
+          blTo -= (unsigned)data->addedLines;
+        } else {
+          // the body is in the synthetic part (ino.hpp / include) -> we ignore
+          blFrom = bcFrom = blTo = bcTo = 0;
+        }
+      }
+
+      si.bodyLineFrom = (int)blFrom;
+      si.bodyColFrom = (int)bcFrom;
+      si.bodyLineTo = (int)blTo;
+      si.bodyColTo = (int)bcTo;
+    }
+  }
+
+  // Line correction for synthetic .ino.cpp
+  if (!data->mainFile.empty() &&
+      si.file == data->mainFile &&
+      data->addedLines > 0) {
+    si.line -= data->addedLines;
+    if (si.line <= 0) {
+      return CXChildVisit_Recurse;
+    }
+  }
+
+  data->symbols->push_back(std::move(si));
+  return CXChildVisit_Recurse;
+}
+
 // Shared helper that collects symbols from a TU.
 // If parentFilter is non-null cursor, only symbols whose semantic parent
 // matches parentFilter are collected. Otherwise all top-level / nested
@@ -498,144 +666,25 @@ static void CollectSymbolsInTUForParent(CXTranslationUnit tu,
     parentFilter = clang_getCanonicalCursor(parentFilter);
   }
 
-  struct VisitorData {
-    CXTranslationUnit *tu;
-    std::vector<SymbolInfo> *symbols;
-    std::string mainFile;
-    int addedLines;
-    CXCursor parentFilter;
-    bool useParentFilter;
-  } data{&tu, &symbols, mainFile, addedLines, parentFilter, useParentFilter};
+  SymbolsVisitorData data{tu, &symbols, mainFile, addedLines, parentFilter, useParentFilter};
 
   CXCursor tuCursor = clang_getTranslationUnitCursor(tu);
 
-  clang_visitChildren(
-      tuCursor,
-      [](CXCursor cursor, CXCursor WXUNUSED(parent), CXClientData client_data) -> CXChildVisitResult {
-        auto *data = static_cast<VisitorData *>(client_data);
-
-        CXCursorKind kind = clang_getCursorKind(cursor);
-
-        switch (kind) {
-          case CXCursor_FunctionDecl:
-          case CXCursor_CXXMethod:
-          case CXCursor_Constructor:
-          case CXCursor_Destructor:
-          case CXCursor_FunctionTemplate:
-          case CXCursor_VarDecl:
-          case CXCursor_FieldDecl:
-          case CXCursor_ParmDecl:
-          case CXCursor_EnumConstantDecl:
-          case CXCursor_StructDecl:
-          case CXCursor_ClassDecl:
-          case CXCursor_UnionDecl:
-          case CXCursor_EnumDecl:
-          case CXCursor_TypedefDecl:
-          case CXCursor_MacroDefinition:
-            break;
-          default:
-            return CXChildVisit_Recurse;
-        }
-
-        std::string name = cxStringToStd(clang_getCursorSpelling(cursor));
-        if (name.empty())
-          return CXChildVisit_Recurse;
-
-        // If we have a filter on the parent (container), we check the semantic parent
-        if (data->useParentFilter) {
-          CXCursor parent = clang_getCursorSemanticParent(cursor);
-          if (clang_Cursor_isNull(parent))
-            return CXChildVisit_Recurse;
-
-          CXCursor canonParent = clang_getCanonicalCursor(parent);
-          if (!clang_equalCursors(canonParent, data->parentFilter)) {
-            return CXChildVisit_Recurse;
-          }
-        }
-
-        CXSourceLocation loc = clang_getCursorLocation(cursor);
-        CXFile file;
-        unsigned line = 0, column = 0, offset = 0;
-        clang_getSpellingLocation(loc, &file, &line, &column, &offset);
-        if (!file)
-          return CXChildVisit_Recurse;
-
-        std::string fileName = cxStringToStd(clang_getFileName(file));
-
-        SymbolInfo si;
-        si.name = std::move(name);
-        si.display = cxStringToStd(clang_getCursorDisplayName(cursor));
-        if (si.display.empty())
-          si.display = si.name;
-        si.usr = GetCursorUsr(cursor);
-        si.file = std::move(fileName);
-        si.line = (int)line;
-        si.column = (int)column;
-        si.kind = kind;
-
-        // If the symbol is a function/method/ctor/dtor/template -> fill in the parameters
-        switch (kind) {
-          case CXCursor_FunctionDecl:
-          case CXCursor_CXXMethod:
-          case CXCursor_Constructor:
-          case CXCursor_Destructor:
-          case CXCursor_FunctionTemplate:
-            FillParameterInfoFromCursor(cursor, si.parameters);
-            break;
-          default:
-            break;
-        }
-
-        // Strip bogus "void " for constructors/destructors.
-        if ((kind == CXCursor_Constructor || kind == CXCursor_Destructor) &&
-            hasPrefix(si.display, "void ")) {
-          si.display.erase(0, 5); // drop "void "
-          while (!si.display.empty() &&
-                 std::isspace((unsigned char)si.display[0])) {
-            si.display.erase(0, 1);
-          }
-        }
-
-        // Body scope { ... } for functions/methods
-        {
-          unsigned blFrom = 0, bcFrom = 0, blTo = 0, bcTo = 0;
-          if (GetBodyRangeForCursor(*data->tu, cursor, blFrom, bcFrom, blTo, bcTo)) {
-            // correction .ino addedLines, same as si.line
-            if (!data->mainFile.empty() &&
-                si.file == data->mainFile &&
-                data->addedLines > 0) {
-
-              if (blFrom > (unsigned)data->addedLines &&
-                  blTo > (unsigned)data->addedLines) {
-                blFrom -= (unsigned)data->addedLines;
-                blTo -= (unsigned)data->addedLines;
-              } else {
-                // the body is in the synthetic part (ino.hpp / include) -> we ignore
-                blFrom = bcFrom = blTo = bcTo = 0;
-              }
-            }
-
-            si.bodyLineFrom = (int)blFrom;
-            si.bodyColFrom = (int)bcFrom;
-            si.bodyLineTo = (int)blTo;
-            si.bodyColTo = (int)bcTo;
-          }
-        }
+  clang_visitChildren(tuCursor, CollectSymbolsVisitor, &data);
+}
 
-        // Line correction for synthetic .ino.cpp
-        if (!data->mainFile.empty() &&
-            si.file == data->mainFile &&
-            data->addedLines > 0) {
-          si.line -= data->addedLines;
-          if (si.line <= 0) {
-            return CXChildVisit_Recurse;
-          }
-        }
+// Same as CollectSymbolsInTUForParent() (without filter), but only for one
+// top-level cursor and everything below it.
+static void CollectSymbolsInCursor(CXTranslationUnit tu,
+                                   CXCursor cursor,
+                                   const std::string &mainFile,
+                                   int addedLines,
+                                   std::vector<SymbolInfo> &symbols) {
+  SymbolsVisitorData data{tu, &symbols, mainFile, addedLines, clang_getNullCursor(), false};
 
-        data->symbols->push_back(std::move(si));
-        return CXChildVisit_Recurse;
-      },
-      &data);
+  if (CollectSymbolsVisitor(cursor, clang_getTranslationUnitCursor(tu), &data) == CXChildVisit_Recurse) {
+    clang_visitChildren(cursor, CollectSymbolsVisitor, &data);
+  }
 }
 
 static bool FindFunctionInTU(CXTranslationUnit tu,
@@ -1342,9 +1391,17 @@ std::string ArduinoCodeCompletion::GetClangCode(const std::string &filename,
   // Fast-path: cache the insert line for the generated .ino.hpp include.
   // Typing inside function bodies keeps the same "declarations signature" -> we can avoid a clang scan.
   const uint64_t declsSig = CcSumDecls(std::string_view(filename), std::string_view(code));
-  auto itCached = m_inoInsertCache.find(declsSig);
-  if (itCached != m_inoInsertCache.end()) {
-    const std::size_t cachedIdx = itCached->second;
+  std::optional<std::size_t> cachedInsertIdx;
+  {
+    std::lock_guard<std::mutex> lk(m_inoCacheMutex);
+    auto itCached = m_inoInsertCache.find(declsSig);
+    if (itCached != m_inoInsertCache.end()) {
+      cachedInsertIdx = itCached->second;
+    }
+  }
+
+  if (cachedInsertIdx) {
+    const std::size_t cachedIdx = *cachedInsertIdx;
     if (cachedIdx < lines.size() && isBlankLine(lines[cachedIdx])) {
       fs::path p(filename);
       std::string hppIncludeName = p.filename().string() + ".hpp";
@@ -1366,106 +1423,15 @@ std::string ArduinoCodeCompletion::GetClangCode(const std::string &filename,
     APP_DEBUG_LOG("CC: InoInsert cache stale for %s (idx=%zu) -> recompute", filename.c_str(), cachedIdx);
   }
 
-  // --- 1) Using clang, we can find out where the top-level function definitions are ---
-  struct FnInfo {
-    unsigned line;
-  };
-
-  std::vector<FnInfo> functions;
-
-  {
-    std::string clangFilename = GetClangFilename(filename);
-
-    const std::vector<std::string> &clangArgs = GetCompilerArgs();
-    std::vector<const char *> args;
-    args.reserve(clangArgs.size());
-    for (const auto &a : clangArgs) {
-      args.push_back(a.c_str());
-    }
-
-    CXUnsavedFile uf{};
-    uf.Filename = clangFilename.c_str();
-    uf.Contents = code.c_str();
-    uf.Length = code.size();
-
-    CXTranslationUnit tu = nullptr;
-    CXErrorCode err = clang_parseTranslationUnit2(
-        index,
-        clangFilename.c_str(),
-        args.data(),
-        static_cast<int>(args.size()),
-        &uf,
-        1,
-        CXTranslationUnit_KeepGoing,
-        &tu);
-
-    if (err == CXError_Success && tu) {
-      struct VisitorData {
-        std::string mainFile;
-        std::vector<FnInfo> *outFns;
-      } data{NormalizePathForClangCompare(clangFilename), &functions};
-
-      CXCursor tuCursor = clang_getTranslationUnitCursor(tu);
-
-      clang_visitChildren(
-          tuCursor,
-          [](CXCursor cursor, CXCursor parent, CXClientData client_data) -> CXChildVisitResult {
-            auto *data = static_cast<VisitorData *>(client_data);
-
-            CXCursorKind pk = clang_getCursorKind(parent);
-            if (pk != CXCursor_TranslationUnit) {
-              return CXChildVisit_Recurse; // only top-level
-            }
-
-            CXCursorKind kind = clang_getCursorKind(cursor);
-            if (kind != CXCursor_FunctionDecl) {
-              return CXChildVisit_Recurse;
-            }
-
-            // only definitions
-            if (!clang_isCursorDefinition(cursor))
-              return CXChildVisit_Recurse;
-
-            CXSourceLocation loc = clang_getCursorLocation(cursor);
-            CXFile file;
-            unsigned line = 0, col = 0, offset = 0;
-            clang_getSpellingLocation(loc, &file, &line, &col, &offset);
-            if (!file)
-              return CXChildVisit_Recurse;
-
-            std::string fileName = cxStringToStd(clang_getFileName(file));
-            fileName = NormalizePathForClangCompare(std::move(fileName));
-            if (fileName != data->mainFile) {
-              return CXChildVisit_Recurse;
-            }
-
-            if (line == 0)
-              return CXChildVisit_Recurse;
-
-            FnInfo fi;
-            fi.line = line;
-            data->outFns->push_back(std::move(fi));
-
-            return CXChildVisit_Recurse;
-          },
-          &data);
-
-      clang_disposeTranslationUnit(tu);
-    } else {
-      APP_DEBUG_LOG("CC: GetClangCode - failed to build TU for function scan: file=%s err=%d (%s)",
-                    clangFilename.c_str(), (int)err, ClangErrorToString(err));
-      // This parse is only used to locate function definitions for .ino preprocessing.
-      // Dump args to make issues debuggable.
-      LogClangArgsDebug(args);
-    }
-  }
+  // --- 1) Find out where the top-level function definitions are ---
+  std::vector<InoFnProto> functions = ExtractInoPrototypes(code);
 
   if (functions.empty()) {
     return code;
   }
 
   std::sort(functions.begin(), functions.end(),
-            [](const FnInfo &a, const FnInfo &b) {
+            [](const InoFnProto &a, const InoFnProto &b) {
               return a.line < b.line;
             });
 
@@ -1500,7 +1466,10 @@ std::string ArduinoCodeCompletion::GetClangCode(const std::string &filename,
   std::string hppIncludeName = p.filename().string() + ".hpp";
 
   // Cache this insert location (keyed by declarations/signatures only).
-  m_inoInsertCache[declsSig] = insertIdx;
+  {
+    std::lock_guard<std::mutex> lk(m_inoCacheMutex);
+    m_inoInsertCache[declsSig] = insertIdx;
+  }
 
   lines[insertIdx] = "#include \"" + hppIncludeName + "\"";
 
@@ -1532,158 +1501,12 @@ std::string ArduinoCodeCompletion::GenerateInoHpp(const std::string &inoFilename
 
   hpp += "#pragma once\n";
 
-  // --- Function prototypes ---
-  struct FnProto {
-    std::string ret;
-    std::string name;
-    std::string params;
-    unsigned line; // definition line in .ino.cpp
-  };
-
-  std::vector<FnProto> functions;
-
-  // --- We will build a mini TU from .ino and extract top-level functions ---
-  {
-    const std::vector<std::string> &clangArgs = GetCompilerArgs();
-
-    std::vector<const char *> args;
-    args.reserve(clangArgs.size());
-    for (const auto &a : clangArgs) {
-      args.push_back(a.c_str());
-      APP_TRACE_LOG("CC: CLP: %s", a.c_str());
-    }
-
-    APP_DEBUG_LOG("CC: GetCompilerArgs(count=%u)", (unsigned)args.size());
-
-    CXUnsavedFile uf;
-    uf.Filename = clangFilename.c_str();
-    uf.Contents = code.c_str();
-    uf.Length = code.size();
-
-    CXTranslationUnit tu = nullptr;
-
-    CXErrorCode err = clang_parseTranslationUnit2(
-        index,
-        clangFilename.c_str(),
-        args.data(),
-        static_cast<int>(args.size()),
-        &uf,
-        1,
-        CXTranslationUnit_KeepGoing,
-        &tu);
-
-    if (err != CXError_Success || !tu) {
-      APP_DEBUG_LOG("CC: GenerateInoHpp - clang_parseTranslationUnit2 failed (%d)", (int)err);
-      // .ino is so broken that we can't get anything out of it -> no prototypes
-      return std::string();
-    }
-
-    APP_DEBUG_LOG("CC: GenerateInoHpp: %s parsed", clangFilename.c_str());
-
-    struct VisitorData {
-      std::string mainFile;
-      std::vector<FnProto> *outFns;
-    } data{NormalizePathForClangCompare(clangFilename), &functions};
-
-    CXCursor tuCursor = clang_getTranslationUnitCursor(tu);
-
-    clang_visitChildren(
-        tuCursor,
-        [](CXCursor cursor, CXCursor parent, CXClientData client_data) -> CXChildVisitResult {
-          auto *data = static_cast<VisitorData *>(client_data);
-
-          CXCursorKind kind = clang_getCursorKind(cursor);
-          CXCursorKind pk = clang_getCursorKind(parent);
-
-          // only top-level declarations from the main file
-          if (pk != CXCursor_TranslationUnit) {
-            return CXChildVisit_Recurse;
-          }
-
-          if (kind != CXCursor_FunctionDecl) {
-            return CXChildVisit_Recurse;
-          }
-
-          if (!clang_isCursorDefinition(cursor))
-            return CXChildVisit_Recurse;
-
-          CXSourceLocation loc = clang_getCursorLocation(cursor);
-          CXFile file;
-          unsigned line = 0, col = 0, offset = 0;
-          clang_getSpellingLocation(loc, &file, &line, &col, &offset);
-          if (!file)
-            return CXChildVisit_Recurse;
-
-          std::string fileName = cxStringToStd(clang_getFileName(file));
-          fileName = NormalizePathForClangCompare(std::move(fileName));
-          std::string mainFileName = NormalizePathForClangCompare(data->mainFile);
-
-          if (fileName != mainFileName) {
-            return CXChildVisit_Recurse;
-          }
-
-          std::string name = cxStringToStd(clang_getCursorSpelling(cursor));
-          if (name.empty())
-            return CXChildVisit_Recurse;
-
-          CXType funcType = clang_getCursorType(cursor);
-          CXType retType = clang_getResultType(funcType);
-          if (retType.kind == CXType_Invalid)
-            return CXChildVisit_Recurse;
-
-          std::string ret = cxStringToStd(clang_getTypeSpelling(retType));
-
-          // storage class (static) - so that the prototype matches the definition
-          CX_StorageClass sc = clang_Cursor_getStorageClass(cursor);
-          if (sc == CX_SC_Static) {
-            ret = "static " + ret;
-          }
-
-          // we compose the parameters "(type1 name1, type2 name2, ...)"
-          std::string params = "(";
-          int numArgs = clang_Cursor_getNumArguments(cursor);
-          for (int i = 0; i < numArgs; ++i) {
-            if (i > 0)
-              params += ", ";
-
-            CXCursor argCur = clang_Cursor_getArgument(cursor, i);
-            CXType argType = clang_getCursorType(argCur);
-
-            std::string argTypeStr = cxStringToStd(clang_getTypeSpelling(argType));
-            std::string argNameStr = cxStringToStd(clang_getCursorSpelling(argCur));
-
-            params += argTypeStr;
-            if (!argNameStr.empty()) {
-              params += " ";
-              params += argNameStr;
-            }
-          }
-
-          if (clang_isFunctionTypeVariadic(funcType)) {
-            if (numArgs > 0)
-              params += ", ";
-            params += "...";
-          }
-
-          params += ")";
-
-          FnProto fp;
-          fp.ret = std::move(ret);
-          fp.name = std::move(name);
-          fp.params = std::move(params);
-          fp.line = line;
-
-          data->outFns->push_back(std::move(fp));
-          return CXChildVisit_Recurse;
-        },
-        &data);
-
-    clang_disposeTranslationUnit(tu);
-  }
+  // --- Top-level function definitions (token scan, no TU needed) ---
+  std::vector<InoFnProto> functions = ExtractInoPrototypes(code);
 
   // sort by definition line and deduplicate signatures
   std::sort(functions.begin(), functions.end(),
-            [](const FnProto &a, const FnProto &b) {
+            [](const InoFnProto &a, const InoFnProto &b) {
               return a.line < b.line;
             });
 
@@ -1732,49 +1555,80 @@ std::string ArduinoCodeCompletion::GenerateInoHpp(const std::string &inoFilename
 
 void ArduinoCodeCompletion::CreateClangUnsavedFiles(const std::string &filename, const std::string &code, ClangUnsavedFiles &uf) {
   uf.mainFilename = GetClangFilename(filename);
-  uf.mainCode = GetClangCode(filename, code, &uf.hppAddedLines);
-
   uf.files[0].Filename = uf.mainFilename.c_str();
+  uf.count = 1;
+
+  if (!IsIno(filename)) {
+    // Nothing to rewrite - libclang reads the caller's buffer directly
+    // (code has to outlive uf, which all callers keep on their stack).
+    uf.files[0].Contents = code.c_str();
+    uf.files[0].Length = code.size();
+    return;
+  }
+
+  uf.mainCode = GetClangCode(filename, code, &uf.hppAddedLines);
   uf.files[0].Contents = uf.mainCode.c_str();
   uf.files[0].Length = uf.mainCode.size();
-  uf.count = 1;
 
-  if (IsIno(filename)) {
-    const std::string absIno = AbsoluteFilename(filename);
-    const std::size_t codeHash = HashCode(code);
+  const std::string absIno = AbsoluteFilename(filename);
+  const std::size_t codeHash = HashCode(code);
 
-    uint64_t sum = CcSumDecls(std::string_view(filename), std::string_view(code));
+  uint64_t sum = CcSumDecls(std::string_view(filename), std::string_view(code));
 
-    std::string hppCode;
+  std::string hppCode;
+  bool cacheHit = false;
+  {
+    std::lock_guard<std::mutex> lk(m_inoCacheMutex);
     auto it = m_inoHeaderCache.find(sum);
     if (it != m_inoHeaderCache.end()) {
-      // cache hit
       hppCode = it->second.hppCode;
-      APP_DEBUG_LOG("CC: InoHpp cache hit for %s", absIno.c_str());
-    } else {
-      // cache miss / code changed -> regenerate
-      hppCode = GenerateInoHpp(filename, code);
-      APP_DEBUG_LOG("CC: InoHpp cache miss for %s", absIno.c_str());
-
-      InoHeaderCacheEntry entry;
-      entry.codeHash = codeHash;
-      entry.hppCode = hppCode;
-      m_inoHeaderCache[sum] = std::move(entry);
+      cacheHit = true;
     }
+  }
 
-    uf.hppFilename = absIno + ".hpp";
-    uf.hppCode = std::move(hppCode);
+  if (cacheHit) {
+    APP_DEBUG_LOG("CC: InoHpp cache hit for %s", absIno.c_str());
+  } else {
+    // cache miss / code changed -> regenerate (outside of the lock, it parses)
+    hppCode = GenerateInoHpp(filename, code);
+    APP_DEBUG_LOG("CC: InoHpp cache miss for %s", absIno.c_str());
 
-    if (!uf.hppCode.empty()) {
-      uf.files[1].Filename = uf.hppFilename.c_str();
-      uf.files[1].Contents = uf.hppCode.c_str();
-      uf.files[1].Length = uf.hppCode.size();
-      uf.count = 2;
-    } else {
-      // GenerateInoHpp may return an empty string if TU is not built at all
-      APP_DEBUG_LOG("CC: InoHpp is empty for %s - skipping", absIno.c_str());
-    }
+    InoHeaderCacheEntry entry;
+    entry.codeHash = codeHash;
+    entry.hppCode = hppCode;
+
+    std::lock_guard<std::mutex> lk(m_inoCacheMutex);
+    m_inoHeaderCache[sum] = std::move(entry);
+  }
+
+  uf.hppFilename = absIno + ".hpp";
+  uf.hppCode = std::move(hppCode);
+
+  if (!uf.hppCode.empty()) {
+    uf.files[1].Filename = uf.hppFilename.c_str();
+    uf.files[1].Contents = uf.hppCode.c_str();
+    uf.files[1].Length = uf.hppCode.size();
+    uf.count = 2;
+  } else {
+    // nothing generated
+    APP_DEBUG_LOG("CC: InoHpp is empty for %s - skipping", absIno.c_str());
+  }
+}
+
+CachedTranslationUnit &ArduinoCodeCompletion::GetTuEntry(const std::string &key) {
+  std::lock_guard<std::mutex> lk(m_tuCacheMutex);
+
+  // operator[] constructs the entry in place (it holds a mutex, it is not movable)
+  CachedTranslationUnit &entry = m_tuCache[key];
+  if (entry.filename.empty()) {
+    entry.filename = key;
   }
+  return entry;
+}
+
+std::unique_lock<std::mutex> ArduinoCodeCompletion::LockTranslationUnit(const std::string &filename) {
+  CachedTranslationUnit &entry = GetTuEntry(AbsoluteFilename(filename));
+  return std::unique_lock<std::mutex>(entry.mutex);
 }
 
 // They will try to get a translation unit at all costs.
@@ -1783,7 +1637,7 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
                                                             const std::string &code,
                                                             int *outAddedLines,
                                                             std::string *outMainFile) {
-  // WARNING: expects that m_ccMutex is held!
+  // WARNING: expects that LockTranslationUnit(filename) is held!
   ScopeTimer t("CC: GetTranslationUnit()");
 
   APP_DEBUG_LOG("CC: GetTranslationUnit: filename=%s, code.length=%d", filename.c_str(), code.length());
@@ -1800,8 +1654,8 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
 
   const std::size_t codeHash = HashCode(code);
 
-  auto it = m_tuCache.find(key);
-  if (it == m_tuCache.end()) {
+  CachedTranslationUnit &entry = GetTuEntry(key);
+  if (!entry.tu) {
     // ---------- DOES NOT EXIST HERE -> we will create ----------
     ClangUnsavedFiles uf;
     CreateClangUnsavedFiles(key, code, uf);
@@ -1828,11 +1682,13 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
     }
 
     bool isInoMain = hasSuffix(uf.mainFilename, ".ino.cpp");
+    std::string corePch;
+    size_t arduinoIncludePos = args.size();
     if (isInoMain) {
-      args.push_back("-include");
-      args.push_back("Arduino.h");
-      APP_TRACE_LOG("CC: CLP: -include");
-      APP_TRACE_LOG("CC: CLP: Arduino.h");
+      corePch = GetCorePch(clangArgs);
+      AppendArduinoInclude(args, corePch);
+      APP_TRACE_LOG("CC: CLP: %s", args[args.size() - 2]);
+      APP_TRACE_LOG("CC: CLP: %s", args[args.size() - 1]);
     }
 
     m_clangSettings.AppendWarningFlags(args);
@@ -1860,6 +1716,26 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
         parseOptsFull,
         &tu);
 
+    if (tu && !corePch.empty() && HasRejectedPchDiag(tu)) {
+      // stale PCH (core updated, other libclang, ...) -> plain Arduino.h include
+      clang_disposeTranslationUnit(tu);
+      tu = nullptr;
+      DiscardCorePch(corePch);
+
+      args[arduinoIncludePos] = "-include";
+      args[arduinoIncludePos + 1] = "Arduino.h";
+
+      err = clang_parseTranslationUnit2(
+          index,
+          uf.mainFilename.c_str(),
+          args.data(),
+          static_cast<int>(args.size()),
+          uf.files,
+          uf.count,
+          parseOptsFull,
+          &tu);
+    }
+
     if ((err != CXError_Success || !tu) && tu) {
       // Some libclang builds may return a TU even when err != Success (rare).
       APP_DEBUG_LOG("CC: parse returned TU but err=%d (%s) -> continuing",
@@ -1913,10 +1789,9 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
       // 2) If this is the synthetic .ino.cpp, probe without the forced Arduino.h include.
       // (Often indicates missing Arduino core/toolchain include paths.)
       if (!tu && isInoMain) {
-        if (args.size() >= 2 &&
-            args[args.size() - 2] &&
-            std::string(args[args.size() - 2]) == "-include") {
-          std::vector<const char *> argsNoArduino(args.begin(), args.end() - 2);
+        if (arduinoIncludePos + 2 <= args.size()) {
+          std::vector<const char *> argsNoArduino(args.begin(), args.end());
+          argsNoArduino.erase(argsNoArduino.begin() + arduinoIncludePos, argsNoArduino.begin() + arduinoIncludePos + 2);
           tu = tryParse("no-Arduino.h-force-include", argsNoArduino, parseOptsNoPreamble);
           if (!tu) {
             tu = tryParse("no-Arduino.h-force-include(full-opts)", argsNoArduino, parseOptsFull);
@@ -1936,29 +1811,23 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnit(const std::string &f
       }
     }
 
-    CachedTranslationUnit entry;
-    entry.filename = key;
     entry.mainFilename = uf.mainFilename;
     entry.codeHash = codeHash;
     entry.addedLines = uf.hppAddedLines;
     entry.tu = tu;
-
-    auto [insertedIt, ok] = m_tuCache.emplace(key, std::move(entry));
-    const CachedTranslationUnit &e = insertedIt->second;
+    ++m_liveTuCount;
 
     if (outAddedLines) {
-      *outAddedLines = e.addedLines;
+      *outAddedLines = entry.addedLines;
     }
     if (outMainFile) {
-      *outMainFile = e.mainFilename;
+      *outMainFile = entry.mainFilename;
     }
 
-    return e.tu;
+    return entry.tu;
   } else {
     // ---------- HERE EXISTS -> possible reparse ----------
 
-    CachedTranslationUnit &entry = it->second;
-
     if (entry.codeHash != codeHash) {
       // Code has changed -> we need to create unsaved files and reparse
       ClangUnsavedFiles uf;
@@ -1998,17 +1867,15 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnitNoReparse(
     const std::string &code,
     int *outAddedLines,
     std::string *outMainFile) {
-  // expects m_ccMutex to be held, just like GetTranslationUnit
+  // expects LockTranslationUnit(filename) to be held, just like GetTranslationUnit
 
   if (outAddedLines)
     *outAddedLines = 0;
   if (outMainFile)
     *outMainFile = {};
 
-  const std::string key = AbsoluteFilename(filename);
-  auto it = m_tuCache.find(key);
-  if (it != m_tuCache.end()) {
-    const auto &entry = it->second;
+  const CachedTranslationUnit &entry = GetTuEntry(AbsoluteFilename(filename));
+  if (entry.tu) {
     if (outAddedLines)
       *outAddedLines = entry.addedLines;
     if (outMainFile)
@@ -2022,7 +1889,7 @@ CXTranslationUnit ArduinoCodeCompletion::GetTranslationUnitNoReparse(
 
 std::vector<ArduinoParseError> ArduinoCodeCompletion::ParseCode(const std::string &filename,
                                                                 const std::string &code) {
-  // WARNING: called only under m_ccMutex!
+  // WARNING: called only under LockTranslationUnit(filename)!
 
   int addedLines = 0;
   std::string mainFile;
@@ -2352,17 +2219,25 @@ std::size_t ArduinoCodeCompletion::ComputeDiagHash(const std::vector<ArduinoPars
 }
 
 std::vector<ArduinoParseError> ArduinoCodeCompletion::GetErrorsFor(const std::string &filename) const {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
-
   // The same normalization as in GetTranslationUnit - the key is the absolute filename
   std::string key = AbsoluteFilename(filename);
 
-  auto it = m_tuCache.find(key);
-  if (it == m_tuCache.end() || !it->second.tu) {
+  const CachedTranslationUnit *entry = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_tuCacheMutex);
+    auto it = m_tuCache.find(key);
+    if (it == m_tuCache.end()) {
+      return {};
+    }
+    entry = &it->second;
+  }
+
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  if (!entry->tu) {
     return {};
   }
 
-  return CollectDiagnosticsLocked(it->second.tu);
+  return CollectDiagnosticsLocked(entry->tu);
 }
 
 void ArduinoCodeCompletion::RefreshDiagnosticsAsync(const std::string &filename, const std::string &code, wxEvtHandler *handler) {
@@ -2374,10 +2249,10 @@ void ArduinoCodeCompletion::RefreshDiagnosticsAsync(const std::string &filename,
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, filename, code, filesSnapshot = std::move(filesSnapshot), weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Background, [this, filename, code, filesSnapshot = std::move(filesSnapshot), weak]() {
     CcFilesSnapshotGuard guard(&filesSnapshot);
 
-    std::lock_guard<std::mutex> lock(m_ccMutex);
+    auto lock = LockTranslationUnit(filename);
 
     // ParseCode takes care of creating/updating the TU as well as calculating errors
     auto errors = ParseCode(filename, code);
@@ -2386,14 +2261,14 @@ void ArduinoCodeCompletion::RefreshDiagnosticsAsync(const std::string &filename,
     evt.SetInt(1);
     evt.SetPayload(std::move(errors));
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cc.diagnostics", handler));
 }
 
 std::vector<CompletionItem> ArduinoCodeCompletion::GetCompletions(const std::string &filename,
                                                                   const std::string &code,
                                                                   int line,
                                                                   int column) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
   ScopeTimer t("CC: GetCompletions()");
 
   std::vector<CompletionItem> items;
@@ -2487,131 +2362,192 @@ std::vector<CompletionItem> ArduinoCodeCompletion::GetCompletions(const std::str
   return items;
 }
 
-void ArduinoCodeCompletion::FilterAndSortCompletionsWithPrefix(const std::string &prefix, std::vector<CompletionItem> &inOutCompletions) {
-
-  ScopeTimer("CC: FilterAndSortCompletionsWithPrefix(%s)", prefix.c_str());
-
-  inOutCompletions.erase(
-      std::remove_if(inOutCompletions.begin(), inOutCompletions.end(),
-                     [&](const CompletionItem &c) {
-                       const std::string &t = c.text;
-                       if (t.empty())
-                         return true;
-
-                       if (prefix.empty()) {
-                         return !c.fromSketch;
-                       } else {
-                         if (!startsWithCaseSensitive(t, prefix) &&
-                             !startsWithCaseInsensitive(t, prefix) &&
-                             !containsCaseInsensitive(t, prefix)) {
-                           return true;
-                         }
-                       }
-                       return false;
-                     }),
-      inOutCompletions.end());
-
-  std::sort(inOutCompletions.begin(), inOutCompletions.end(),
-            [&](const CompletionItem &a, const CompletionItem &b) {
-              const std::string &ta = a.text;
-              const std::string &tb = b.text;
-
-              //  1) Exact match with the prefix has absolute priority
-              bool a_exact = (ta == prefix);
-              bool b_exact = (tb == prefix);
-              if (a_exact != b_exact)
-                return a_exact; // true < false -> exact upwards
-
-              //  2) Starts with prefix (case-sensitive)
-              bool a_cs = startsWithCaseSensitive(ta, prefix);
-              bool b_cs = startsWithCaseSensitive(tb, prefix);
-              if (a_cs != b_cs)
-                return a_cs;
-
-              //  3) Starts with the prefix (case-insensitive)
-              bool a_ci = startsWithCaseInsensitive(ta, prefix);
-              bool b_ci = startsWithCaseInsensitive(tb, prefix);
-              if (a_ci != b_ci)
-                return a_ci;
-
-              //  4) fromSketch up
-              if (a.fromSketch != b.fromSketch)
-                return a.fromSketch;
-
-              //  5) kindScore
-              int ak = kindScore(a.kind);
-              int bk = kindScore(b.kind);
-              if (ak != bk)
-                return ak < bk;
-
-              //  6) priority (from libclang)
-              if (a.priority != b.priority)
-                return a.priority < b.priority;
-
-              //  7) Macro-like downwards
-              bool a_macroLike = isAllUpperAlpha(ta) && countUnderscores(ta) > 0;
-              bool b_macroLike = isAllUpperAlpha(tb) && countUnderscores(tb) > 0;
-              if (a_macroLike != b_macroLike)
-                return !a_macroLike;
-
-              //  8) Fewer underscores / shorter / lexicographically
-              int a_us = countUnderscores(ta);
-              int b_us = countUnderscores(tb);
-              if (a_us != b_us)
-                return a_us < b_us;
-
-              if (ta.size() != tb.size())
-                return ta.size() < tb.size();
-
-              return ta < tb;
-            });
+namespace {
 
-  // --- Collapse overloads by inserted text, keep them prepared in CompletionItem::overloads ---
-  {
-    std::unordered_set<std::string> seen;
-    seen.reserve(inOutCompletions.size());
+// Everything the ranking needs, computed once per matching item
+struct RankedCompletion {
+  const CompletionItem *item;
+  int tier;  // 0 exact, 1 prefix, 2 prefix (case-insensitive), 3 fuzzy
+  int score; // FuzzyMatcher score
+  int kind;
+  bool macroLike;
+  int underscores;
+};
 
-    auto outIt = inOutCompletions.begin();
+bool RankedBefore(const RankedCompletion &a, const RankedCompletion &b) {
+  //  1) exact match, prefix, case-insensitive prefix, fuzzy
+  if (a.tier != b.tier)
+    return a.tier < b.tier;
 
-    for (auto it = inOutCompletions.begin(); it != inOutCompletions.end(); ++it) {
-      if (it->text.empty())
-        continue;
+  //  2) better fuzzy match
+  if (a.score != b.score)
+    return a.score > b.score;
+
+  //  3) fromSketch up
+  if (a.item->fromSketch != b.item->fromSketch)
+    return a.item->fromSketch;
+
+  //  4) kindScore
+  if (a.kind != b.kind)
+    return a.kind < b.kind;
 
-      const std::string &key = it->text;
+  //  5) priority (from libclang)
+  if (a.item->priority != b.item->priority)
+    return a.item->priority < b.item->priority;
 
-      if (seen.insert(key).second) {
-        // First occurrence => representative item
-        if (outIt != it)
-          *outIt = std::move(*it);
-        ++outIt;
+  //  6) Macro-like downwards
+  if (a.macroLike != b.macroLike)
+    return !a.macroLike;
+
+  //  7) Fewer underscores / shorter / lexicographically
+  if (a.underscores != b.underscores)
+    return a.underscores < b.underscores;
+
+  const std::string &ta = a.item->text;
+  const std::string &tb = b.item->text;
+  if (ta.size() != tb.size())
+    return ta.size() < tb.size();
+
+  return ta < tb;
+}
+
+} // namespace
+
+void ArduinoCodeCompletion::FilterAndSortCompletionsWithPrefix(const std::string &prefix, const std::vector<CompletionItem> &completions, std::vector<CompletionItem> &out) {
+  ScopeTimer t("CC: FilterAndSortCompletionsWithPrefix(%s)", prefix.c_str());
+
+  constexpr std::size_t MAX_ITEMS = 256;
+  constexpr uint32_t NONE = UINT32_MAX;
+
+  out.clear();
+
+  // --- 1) match and rank every item once ---
+  const FuzzyMatcher matcher(prefix);
+
+  std::vector<RankedCompletion> ranked;
+  ranked.reserve(completions.size());
+
+  for (const auto &c : completions) {
+    const std::string &text = c.text;
+    if (text.empty())
+      continue;
+
+    RankedCompletion r;
+    if (prefix.empty()) {
+      // nothing typed yet - offer only what comes from the sketch
+      if (!c.fromSketch)
+        continue;
+      r.score = 0;
+      r.tier = 1;
+    } else {
+      if (!matcher.Match(text, r.score))
+        continue;
+
+      if (text == prefix) {
+        r.tier = 0;
+      } else if (startsWithCaseSensitive(text, prefix)) {
+        r.tier = 1;
+      } else if (startsWithCaseInsensitive(text, prefix)) {
+        r.tier = 2;
       } else {
-        // Another overload => append to representative's overloads
-        // Representative is guaranteed to be the first one we kept for this key.
-        // It's somewhere in [begin, outIt).
-        for (auto rep = inOutCompletions.begin(); rep != outIt; ++rep) {
-          if (rep->text == key) {
-            rep->overloads.push_back(std::move(*it));
-            break;
-          }
-        }
+        r.tier = 3;
       }
     }
 
-    // Now annotate labels (only for those that actually have overloads)
-    for (auto it = inOutCompletions.begin(); it != outIt; ++it) {
-      if (!it->overloads.empty()) {
-        const int total = 1 + static_cast<int>(it->overloads.size());
-        // keep label short; avoid long signatures drowning UI
-        it->label = it->text + "(...) - " + std::to_string(total) + " overloads";
+    bool hasLower = false;
+    bool hasUpper = false;
+    r.underscores = 0;
+    for (char ch : text) {
+      r.underscores += (ch == '_');
+      hasLower |= (ch >= 'a' && ch <= 'z');
+      hasUpper |= (ch >= 'A' && ch <= 'Z');
+    }
+
+    r.item = &c;
+    r.kind = kindScore(c.kind);
+    r.macroLike = r.underscores > 0 && hasUpper && !hasLower; // FOO_BAR
+    ranked.push_back(r);
+  }
+
+  // --- 2) group overloads by inserted text, the best ranked one represents the group ---
+  // Open addressing over group ids - one allocation instead of a node per item.
+  std::vector<uint32_t> best;                      // group -> representative (index into ranked)
+  std::vector<uint32_t> head;                      // group -> first member
+  std::vector<uint32_t> next(ranked.size(), NONE); // member -> next member of the same group
+  {
+    std::size_t mask = 15;
+    while (mask < ranked.size() * 2) {
+      mask = mask * 2 + 1;
+    }
+    std::vector<uint32_t> groups(mask + 1, NONE);
+    const std::hash<std::string_view> hasher;
+
+    for (uint32_t i = 0; i < (uint32_t)ranked.size(); ++i) {
+      const std::string &text = ranked[i].item->text;
+
+      std::size_t slot = hasher(text) & mask;
+      while (groups[slot] != NONE && ranked[head[groups[slot]]].item->text != text) {
+        slot = (slot + 1) & mask;
+      }
+
+      if (groups[slot] == NONE) {
+        groups[slot] = (uint32_t)best.size();
+        best.push_back(i);
+        head.push_back(i);
+        continue;
+      }
+
+      const uint32_t g = groups[slot];
+      next[i] = head[g];
+      head[g] = i;
+      if (RankedBefore(ranked[i], ranked[best[g]])) {
+        best[g] = i;
       }
     }
+  }
 
-    inOutCompletions.erase(outIt, inOutCompletions.end());
+  // --- 3) only the top groups are sorted and copied ---
+  std::vector<uint32_t> order(best.size());
+  for (uint32_t g = 0; g < (uint32_t)order.size(); ++g) {
+    order[g] = g;
   }
 
-  constexpr std::size_t MAX_ITEMS = 256;
-  if (inOutCompletions.size() > MAX_ITEMS) {
-    inOutCompletions.resize(MAX_ITEMS);
+  auto groupBefore = [&](uint32_t a, uint32_t b) {
+    return RankedBefore(ranked[best[a]], ranked[best[b]]);
+  };
+
+  const std::size_t count = std::min(order.size(), MAX_ITEMS);
+  std::partial_sort(order.begin(), order.begin() + count, order.end(), groupBefore);
+
+  out.reserve(count);
+
+  std::vector<uint32_t> members;
+  for (std::size_t k = 0; k < count; ++k) {
+    const uint32_t g = order[k];
+
+    out.push_back(*ranked[best[g]].item);
+    CompletionItem &rep = out.back();
+
+    members.clear();
+    for (uint32_t i = head[g]; i != NONE; i = next[i]) {
+      if (i != best[g])
+        members.push_back(i);
+    }
+    if (members.empty())
+      continue;
+
+    std::sort(members.begin(), members.end(), [&](uint32_t a, uint32_t b) {
+      return RankedBefore(ranked[a], ranked[b]);
+    });
+
+    rep.overloads.reserve(rep.overloads.size() + members.size());
+    for (uint32_t i : members) {
+      rep.overloads.push_back(*ranked[i].item);
+    }
+
+    const int total = 1 + static_cast<int>(rep.overloads.size());
+    // keep label short; avoid long signatures drowning UI
+    rep.label = rep.text + "(...) - " + std::to_string(total) + " overloads";
   }
 }
 
@@ -2667,38 +2603,318 @@ std::vector<std::string> ArduinoCodeCompletion::GetCompilerArgs(const std::vecto
       merged.reserve(compArgs.size() + libsIncludes.size());
       bool injected = false;
 
-      for (const auto &a : compArgs) {
-        merged.push_back(a);
-        if (!injected && a.size() >= 2 && a[0] == '-' && a[1] == 'I') {
-          for (const auto &dir : libsIncludes) {
-            if (!platformPath.empty() && (dir.find(platformPath, 0) == 0)) {
-              merged.push_back("-isystem");
-              merged.push_back(dir);
-              continue;
-            }
+      for (const auto &a : compArgs) {
+        merged.push_back(a);
+        if (!injected && a.size() >= 2 && a[0] == '-' && a[1] == 'I') {
+          for (const auto &dir : libsIncludes) {
+            if (!platformPath.empty() && (dir.find(platformPath, 0) == 0)) {
+              merged.push_back("-isystem");
+              merged.push_back(dir);
+              continue;
+            }
+
+            merged.push_back("-I" + dir);
+          }
+          injected = true;
+        }
+      }
+
+      if (!injected) {
+        for (const auto &dir : libsIncludes) {
+          merged.push_back("-I" + dir);
+        }
+      }
+
+      result = merged;
+    } else {
+      result = compArgs;
+    }
+  }
+
+  return result;
+}
+
+void ArduinoCodeCompletion::AppendArduinoInclude(std::vector<const char *> &args, const std::string &corePch) {
+  if (!corePch.empty()) {
+    args.push_back("-include-pch");
+    args.push_back(corePch.c_str());
+  } else {
+    args.push_back("-include");
+    args.push_back("Arduino.h");
+  }
+}
+
+std::string ArduinoCodeCompletion::GetCorePch(const std::vector<std::string> &clangArgs) {
+  if (m_pchDir.empty() || !arduinoCli || clangArgs.empty()) {
+    return std::string();
+  }
+
+  const std::string sketchPath = arduinoCli->GetSketchPath();
+
+  // Library and sketch include dirs differ between sketches, but Arduino.h does
+  // not need them -> leave them out, so one PCH serves every sketch of the board.
+  auto isCoreDir = [&](const std::string &dir) {
+    if (!sketchPath.empty() && hasPrefix(dir, sketchPath.c_str()))
+      return false;
+    return dir.find("/libraries/") == std::string::npos &&
+           dir.find("\\libraries\\") == std::string::npos;
+  };
+
+  std::vector<std::string> pchArgs;
+  pchArgs.reserve(clangArgs.size() + 2);
+  for (size_t i = 0; i < clangArgs.size(); ++i) {
+    const std::string &a = clangArgs[i];
+    if ((a == "-I" || a == "-isystem") && i + 1 < clangArgs.size()) {
+      if (isCoreDir(clangArgs[i + 1])) {
+        pchArgs.push_back(a);
+        pchArgs.push_back(clangArgs[i + 1]);
+      }
+      ++i;
+      continue;
+    }
+    if (a.size() > 2 && hasPrefix(a, "-I") && !isCoreDir(a.substr(2))) {
+      continue;
+    }
+    pchArgs.push_back(a);
+  }
+
+  std::vector<const char *> warnArgs;
+  m_clangSettings.AppendWarningFlags(warnArgs);
+  for (const char *w : warnArgs) {
+    pchArgs.emplace_back(w);
+  }
+
+  // key = core args + core installation + libclang version
+  std::string keyText;
+  for (const auto &a : pchArgs) {
+    keyText += a;
+    keyText += '\0';
+  }
+  keyText += arduinoCli->GetPlatformPath();
+  keyText += '\0';
+  CXString v = clang_getClangVersion();
+  keyText += clang_getCString(v);
+  clang_disposeString(v);
+
+  const std::size_t key = HashCode(keyText);
+
+  std::lock_guard<std::mutex> lock(m_corePchMutex);
+
+  if (key == m_corePchKey) {
+    return m_corePchPath;
+  }
+
+  m_corePchKey = key;
+  m_corePchPath.clear();
+
+  // A rejected PCH is not deleted right away (TUs of this or another editor instance
+  // may still be built on it), it gets a ".rejected" marker and the next generation
+  // of the same key is written to a new path. It goes once a newer generation works.
+  static const int kMaxPchGenerations = 4;
+
+  auto generationPath = [&](int gen) {
+    char name[48];
+    if (gen == 0) {
+      snprintf(name, sizeof(name), "core-%016llx.pch", (unsigned long long)key);
+    } else {
+      snprintf(name, sizeof(name), "core-%016llx-%d.pch", (unsigned long long)key, gen);
+    }
+    return (fs::path(m_pchDir) / name).string();
+  };
+
+  std::error_code ec;
+  for (int gen = 0; gen < kMaxPchGenerations; ++gen) {
+    const std::string pchPath = generationPath(gen);
+
+    if (fs::exists(pchPath + ".rejected", ec)) {
+      continue;
+    }
+
+    if (fs::exists(pchPath, ec)) {
+      APP_DEBUG_LOG("CC: core PCH reused %s", pchPath.c_str());
+      m_corePchPath = pchPath;
+    } else if (BuildCorePch(pchArgs, pchPath)) {
+      m_corePchPath = pchPath;
+    }
+
+    if (!m_corePchPath.empty()) {
+      // The PCH itself must keep its mtime (TUs built on it validate it),
+      // the eviction looks at this stamp instead.
+      std::ofstream used(m_corePchPath + ".used", std::ios::binary | std::ios::trunc);
+
+      // all earlier generations were rejected and a newer one works now
+      for (int old = 0; old < gen; ++old) {
+        RemoveCorePchFiles(generationPath(old));
+      }
+    }
+    break;
+  }
+
+  return m_corePchPath;
+}
+
+bool ArduinoCodeCompletion::BuildCorePch(const std::vector<std::string> &pchArgs, const std::string &pchPath) {
+  ScopeTimer t("CC: BuildCorePch()");
+
+  // The prelude has to be a real file - PCH validation checks its input files.
+  const std::string preludePath = fs::path(pchPath).replace_extension(".h").string();
+  {
+    std::ofstream out(preludePath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      APP_DEBUG_LOG("CC: cannot write PCH prelude %s", preludePath.c_str());
+      return false;
+    }
+    out << "#include <Arduino.h>\n";
+  }
+
+  std::vector<const char *> args;
+  args.reserve(pchArgs.size() + 2);
+  for (const auto &a : pchArgs) {
+    args.push_back(a.c_str());
+  }
+  args.push_back("-x");
+  args.push_back("c++-header");
+
+  CXTranslationUnit tu = nullptr;
+  CXErrorCode err = clang_parseTranslationUnit2(
+      index,
+      preludePath.c_str(),
+      args.data(),
+      (int)args.size(),
+      nullptr,
+      0,
+      CXTranslationUnit_ForSerialization | CXTranslationUnit_Incomplete,
+      &tu);
+
+  if (err != CXError_Success || !tu) {
+    APP_DEBUG_LOG("CC: core PCH parse failed (%d / %s)", (int)err, ClangErrorToString(err));
+    return false;
+  }
+
+  // A PCH of broken headers would only hide the real diagnostics.
+  bool hasErrors = false;
+  const unsigned n = clang_getNumDiagnostics(tu);
+  for (unsigned i = 0; i < n && !hasErrors; ++i) {
+    CXDiagnostic d = clang_getDiagnostic(tu, i);
+    hasErrors = clang_getDiagnosticSeverity(d) >= CXDiagnostic_Error;
+    clang_disposeDiagnostic(d);
+  }
+
+  bool ok = false;
+  if (hasErrors) {
+    APP_DEBUG_LOG("CC: core headers have errors, PCH not created");
+    LogDiagnosticsDebug(tu, 10);
+  } else {
+    // save under a temporary name, rename is atomic for other editor instances
+    const std::string tmpPath = pchPath + ".tmp" + std::to_string((unsigned long long)std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    int rc = clang_saveTranslationUnit(tu, tmpPath.c_str(), clang_defaultSaveOptions(tu));
+    std::error_code ec;
+    if (rc == CXSaveError_None) {
+      fs::rename(tmpPath, pchPath, ec);
+      ok = !ec;
+    }
+    if (!ok) {
+      APP_DEBUG_LOG("CC: saving core PCH failed (rc=%d, %s)", rc, ec.message().c_str());
+      fs::remove(tmpPath, ec);
+    } else {
+      APP_DEBUG_LOG("CC: core PCH created %s", pchPath.c_str());
+    }
+  }
+
+  clang_disposeTranslationUnit(tu);
+  return ok;
+}
+
+void ArduinoCodeCompletion::DiscardCorePch(const std::string &pchPath) {
+  if (pchPath.empty()) {
+    return;
+  }
+
+  APP_DEBUG_LOG("CC: core PCH rejected by clang, discarding %s", pchPath.c_str());
+
+  std::lock_guard<std::mutex> lock(m_corePchMutex);
+  if (m_corePchPath == pchPath) {
+    // keep the key -> do not try to rebuild it again in this session
+    m_corePchPath.clear();
+  }
+
+  // The file stays - existing TUs were created with -include-pch of it and
+  // would fail to reparse. The changed path (empty now) changes their arg hash,
+  // so they are recreated with the plain include on the next pass. The marker
+  // makes GetCorePch() build the next generation under a new name.
+  std::ofstream marker(pchPath + ".rejected", std::ios::binary | std::ios::trunc);
+}
+
+void ArduinoCodeCompletion::RemoveCorePchFiles(const std::string &pchPath) {
+  // a file still open by a TU of another instance cannot be removed on Windows,
+  // it is simply tried again next time
+  std::error_code ec;
+  fs::remove(pchPath, ec);
+  fs::remove(fs::path(pchPath).replace_extension(".h"), ec);
+  fs::remove(pchPath + ".used", ec);
+  fs::remove(pchPath + ".rejected", ec);
+}
 
-            merged.push_back("-I" + dir);
-          }
-          injected = true;
-        }
-      }
+void ArduinoCodeCompletion::EvictCorePchFiles(const std::string &pchDir) {
+  static const auto kMaxUnusedAge = std::chrono::hours(24 * 30);
 
-      if (!injected) {
-        for (const auto &dir : libsIncludes) {
-          merged.push_back("-I" + dir);
-        }
-      }
+  ScopeTimer t("CC: EvictCorePchFiles()");
 
-      result = merged;
+  std::error_code ec;
+  const auto now = fs::file_time_type::clock::now();
+
+  std::vector<std::string> pchs;
+  std::vector<fs::path> others;
+  for (fs::directory_iterator it(pchDir, ec), end; !ec && it != end; it.increment(ec)) {
+    const fs::path &p = it->path();
+    if (!it->is_regular_file(ec) || !hasPrefix(p.filename().string(), "core-")) {
+      continue;
+    }
+    if (p.extension() == ".pch") {
+      pchs.push_back(p.string());
     } else {
-      result = compArgs;
+      others.push_back(p);
     }
   }
 
-  return result;
+  auto unusedFor = [&](const std::string &path) {
+    std::error_code e;
+    const auto mtime = fs::last_write_time(path, e);
+    return e ? fs::file_time_type::duration::zero() : now - mtime;
+  };
+
+  size_t removed = 0;
+  for (const auto &pch : pchs) {
+    const std::string used = pch + ".used";
+    const auto age = fs::exists(used, ec) ? std::min(unusedFor(pch), unusedFor(used)) : unusedFor(pch);
+    if (age > kMaxUnusedAge) {
+      RemoveCorePchFiles(pch);
+      ++removed;
+    }
+  }
+
+  // preludes, stamps, markers and temporary files of PCHs which are gone
+  static const auto kOrphanAge = std::chrono::hours(24); // younger may be a build in progress
+  for (const auto &p : others) {
+    if (unusedFor(p.string()) <= kOrphanAge) {
+      continue;
+    }
+    std::string base;
+    const std::string ext = p.extension().string();
+    if (ext == ".h") {
+      base = fs::path(p).replace_extension(".pch").string();
+    } else if (ext == ".used" || ext == ".rejected") {
+      base = fs::path(p).replace_extension().string();
+    }
+    if (base.empty() || !fs::exists(base, ec)) {
+      fs::remove(p, ec);
+    }
+  }
+
+  APP_DEBUG_LOG("CC: core PCH cache %s - %zu of %zu PCHs evicted", pchDir.c_str(), removed, pchs.size());
 }
 
-void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, std::string filename, CompletionMetadata &metadata, wxEvtHandler *handler) {
+void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, std::string filename, const TextSnapshotFn &textSnapshot, CompletionMetadata &metadata, wxEvtHandler *handler) {
   if (!m_ready)
     return;
 
@@ -2709,8 +2925,6 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
   int line = editor->LineFromPosition(currentPos) + 1;
   int column = editor->GetColumn(currentPos) + 1;
 
-  std::string code = wxToStd(editor->GetText());
-
   int wordStart = editor->WordStartPosition(currentPos, true);
   int lengthEntered = currentPos - wordStart;
 
@@ -2726,11 +2940,8 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
   metadata.m_pendingRequestId = seq;
 
   // --- 0) I will try to use the session cache (without calling libclang) ---
-  std::vector<CompletionItem> cachedItems;
-  bool canUseCache = false;
-
-  std::vector<SketchFileBuffer> filesSnapshot;
-  CollectSketchFiles(filesSnapshot);
+  // No editor text is needed for that, so nothing is copied until we know it misses.
+  std::shared_ptr<const std::vector<CompletionItem>> cachedItems;
 
   {
     std::lock_guard<std::mutex> lock(m_completionSessionMutex);
@@ -2744,21 +2955,23 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
     if (sess.valid &&
         sess.filename == AbsoluteFilename(filename) &&
         sess.wordStart == wordStart &&
-        !sess.baseItems.empty() &&
+        sess.baseItems && !sess.baseItems->empty() &&
         (sess.basePrefix.empty() ||
          prefix.rfind(sess.basePrefix, 0) == 0)) { // prefix starts with basePrefix
-      cachedItems = sess.baseItems;                // copy - we will filter it
-      canUseCache = true;
+      cachedItems = sess.baseItems;                // shared, never modified
     }
   }
 
-  if (canUseCache) {
+  if (cachedItems) {
     // Pure memory filter - no thread, no clang.
     auto start = Clock::now();
-    auto completions = std::move(cachedItems);
+    std::vector<CompletionItem> completions;
 
-    if (!prefix.empty()) {
-      FilterAndSortCompletionsWithPrefix(prefix, completions);
+    if (prefix.empty()) {
+      completions = *cachedItems;
+    } else {
+      // copies only the items that make it into the popup
+      FilterAndSortCompletionsWithPrefix(prefix, *cachedItems, completions);
     }
 
     auto end = Clock::now();
@@ -2777,25 +2990,31 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
     return;
   }
 
+  // Cache miss - editor buffers are shared snapshots, taking them does not copy the text
+  std::shared_ptr<const std::string> code = textSnapshot();
+
+  std::vector<SketchFileBuffer> filesSnapshot;
+  CollectSketchFiles(filesSnapshot);
+
   // --- worker thread ---
-  std::thread([this,
-               weak,
-               seq,
-               filename = std::move(filename),
-               code = std::move(code),
-               line,
-               column,
-               prefix,
-               wordStart,
-               lengthEntered,
-               filesSnapshot = std::move(filesSnapshot)]() {
+  auto job = [this,
+              weak,
+              seq,
+              filename = std::move(filename),
+              code = std::move(code),
+              line,
+              column,
+              prefix,
+              wordStart,
+              lengthEntered,
+              filesSnapshot = std::move(filesSnapshot)]() {
     // Guard sets a thread-local snapshot for the entire thread run
     CcFilesSnapshotGuard guard(&filesSnapshot);
 
     // 1) Get completions from libclang
     auto start = Clock::now();
 
-    auto completions = GetCompletions(filename, code, line, column);
+    auto completions = GetCompletions(filename, *code, line, column);
 
     auto end = Clock::now();
     auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
@@ -2811,7 +3030,7 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
     }
 
     if (!sketchDir.empty()) {
-      auto symbols = GetAllSymbols(filename, code);
+      auto symbols = GetAllSymbols(filename, *code);
       for (const auto &s : symbols) {
         if (s.file.empty())
           continue;
@@ -2839,23 +3058,26 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
     }
 
     // >>> 3b) Save session cache (before prefix filter) <<<
+    auto baseItems = std::make_shared<const std::vector<CompletionItem>>(std::move(completions));
     {
       std::lock_guard<std::mutex> lock(m_completionSessionMutex);
       m_completionSession.valid = true;
       m_completionSession.filename = AbsoluteFilename(filename);
       m_completionSession.wordStart = wordStart;
-      m_completionSession.basePrefix = prefix;     // prefix at the moment of heavy completion
-      m_completionSession.baseItems = completions; // a copy that we do not modify further
+      m_completionSession.basePrefix = prefix; // prefix at the moment of heavy completion
+      m_completionSession.baseItems = baseItems;
     }
 
     end = Clock::now();
     us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
     APP_DEBUG_LOG("Fetching symbols from sketch %lld s", static_cast<long long>(us));
 
-    // 4) Prefix filter - keep only what the prefix CONTAINS (case-insensitive),
-    //    or it starts with it (which is a subset).
-    if (!prefix.empty()) {
-      FilterAndSortCompletionsWithPrefix(prefix, completions);
+    // 4) Prefix filter - keep only what fuzzy-matches the prefix (case-insensitive
+    //    subsequence), best matches first.
+    if (prefix.empty()) {
+      completions = *baseItems;
+    } else {
+      FilterAndSortCompletionsWithPrefix(prefix, *baseItems, completions);
     }
 
     // preparing event for GUI thread
@@ -2866,7 +3088,9 @@ void ArduinoCodeCompletion::ShowAutoCompletionAsync(wxStyledTextCtrl *editor, st
     evt.SetString(wxString::Format(wxT("%d"), lengthEntered)); // entered prefix length
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  };
+
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Interactive, std::move(job), ArduinoTaskScheduler::Key("cc.completion", handler));
 }
 
 bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std::string &code, int line, int column, HoverInfo &outInfo) {
@@ -2877,7 +3101,7 @@ bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std:
 
 /** Returns hover info for symbol at cursor location. */
 bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std::string &code, int line, int column, const std::vector<SketchFileBuffer> files, HoverInfo &outInfo) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   APP_DEBUG_LOG("CC: GetHoverInfo(file=%s, line=%d, column=%d)", filename.c_str(), line, column);
   ScopeTimer t("CC: GetHoverInfo()");
@@ -2925,10 +3149,30 @@ bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std:
     return false;
   }
 
+  std::unordered_map<std::string, std::string> fileTexts;
+  return FillHoverInfo(tu, cursor, target, fileTexts, outInfo);
+}
+
+// Fills outInfo from a resolved cursor (target = what the cursor referenced, may be null).
+// fileTexts caches sources read while harvesting non-Doxygen comments.
+bool ArduinoCodeCompletion::FillHoverInfo(CXTranslationUnit tu, CXCursor cursor, CXCursor target, std::unordered_map<std::string, std::string> &fileTexts, HoverInfo &outInfo) {
   outInfo.usr = GetCursorUsr(cursor);
 
   APP_DEBUG_LOG("CC: GetHoverInfo: cursorUsr='%s'", outInfo.usr.c_str());
 
+  // sources are read at most once per request (batch requests hit the same files)
+  auto loadText = [&fileTexts](const std::string &path) -> const std::string * {
+    auto it = fileTexts.find(path);
+    if (it == fileTexts.end()) {
+      std::string txt;
+      if (!LoadFileToString(path, txt)) {
+        txt.clear();
+      }
+      it = fileTexts.emplace(path, std::move(txt)).first;
+    }
+    return it->second.empty() ? nullptr : &it->second;
+  };
+
   // Filling HoverInfo
   outInfo.name = cxStringToStd(clang_getCursorSpelling(cursor));
 
@@ -3016,18 +3260,17 @@ bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std:
       if (cfile && cline > 0) {
         std::string path = NormalizeFilename(arduinoCli->GetSketchPath(), cxStringToStd(clang_getFileName(cfile)));
         if (!path.empty()) {
-          std::string txt;
-          if (LoadFileToString(path, txt)) {
-            std::string extracted = ExtractCommentBlockAboveLine(txt, (int)cline);
+          if (const std::string *txt = loadText(path)) {
+            std::string extracted = ExtractCommentBlockAboveLine(*txt, (int)cline);
             if (!extracted.empty()) {
               outInfo.fullComment = extracted;
               outInfo.briefComment = MakeBriefFromFull(extracted);
             } else {
               unsigned blFrom = 0, bcFrom = 0, blTo = 0, bcTo = 0;
               if (GetBodyRangeForCursor(tu, target, blFrom, bcFrom, blTo, bcTo)) {
-                codeBlock = ExtractBodySnippetFromText(txt, blFrom, blTo);
+                codeBlock = ExtractBodySnippetFromText(*txt, blFrom, blTo);
               } else {
-                codeBlock = ExtractBodySnippetFromText(txt, cline, cline);
+                codeBlock = ExtractBodySnippetFromText(*txt, cline, cline);
               }
             }
           }
@@ -3041,14 +3284,13 @@ bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std:
 
       if (siblingDefFound) {
         if (!siblingDef.file.empty() && siblingDef.line > 0) {
-          std::string txt;
-          if (LoadFileToString(NormalizeFilename(arduinoCli->GetSketchPath(), siblingDef.file), txt)) {
-            std::string extracted = ExtractCommentBlockAboveLine(txt, siblingDef.line);
+          if (const std::string *txt = loadText(NormalizeFilename(arduinoCli->GetSketchPath(), siblingDef.file))) {
+            std::string extracted = ExtractCommentBlockAboveLine(*txt, siblingDef.line);
             if (!extracted.empty()) {
               outInfo.fullComment = extracted;
               outInfo.briefComment = MakeBriefFromFull(extracted);
             } else if (codeBlock.empty()) {
-              codeBlock = ExtractBodySnippetFromText(txt, siblingDef.line, siblingDef.line + 3);
+              codeBlock = ExtractBodySnippetFromText(*txt, siblingDef.line, siblingDef.line + 3);
             }
           }
         }
@@ -3079,12 +3321,81 @@ bool ArduinoCodeCompletion::GetHoverInfo(const std::string &filename, const std:
   return true;
 }
 
+struct HoverBatchVisitorData {
+  const std::unordered_set<std::string> *usrs;
+  std::unordered_map<std::string, CXCursor> *found;
+};
+
+static CXChildVisitResult HoverBatchVisitor(CXCursor cursor, CXCursor WXUNUSED(parent), CXClientData client_data) {
+  auto *data = static_cast<HoverBatchVisitorData *>(client_data);
+
+  // only declarations of the file itself, the headers are not interesting
+  if (!clang_Location_isFromMainFile(clang_getCursorLocation(cursor))) {
+    return CXChildVisit_Continue;
+  }
+
+  const CXCursorKind kind = clang_getCursorKind(cursor);
+  if (clang_isDeclaration(kind) || kind == CXCursor_MacroDefinition) {
+    std::string usr = GetCursorUsr(cursor);
+    if (!usr.empty() && data->usrs->count(usr) > 0) {
+      data->found->emplace(std::move(usr), cursor); // first declaration in the file wins
+
+      if (data->found->size() == data->usrs->size()) {
+        return CXChildVisit_Break;
+      }
+    }
+  }
+
+  return CXChildVisit_Recurse;
+}
+
+/**
+ * Hover info for many symbols of one file at once (class browser). The TU is
+ * locked, resolved and walked once; every requested USR is matched against the
+ * declarations of the file on the way. USRs not declared in the file are skipped.
+ */
+std::unordered_map<std::string, HoverInfo> ArduinoCodeCompletion::GetHoverInfoBatch(const std::string &filename, const std::string &code, const std::unordered_set<std::string> &usrs, const std::vector<SketchFileBuffer> &files) {
+  std::unordered_map<std::string, HoverInfo> out;
+  if (!m_ready || usrs.empty())
+    return out;
+
+  auto lock = LockTranslationUnit(filename);
+
+  APP_DEBUG_LOG("CC: GetHoverInfoBatch(file=%s, usrs=%zu)", filename.c_str(), usrs.size());
+  ScopeTimer t("CC: GetHoverInfoBatch()");
+
+  CcFilesSnapshotGuard guard(&files);
+
+  CXTranslationUnit tu = GetTranslationUnit(filename, code);
+  if (!tu) {
+    return out;
+  }
+
+  std::unordered_map<std::string, CXCursor> found;
+  found.reserve(usrs.size());
+
+  HoverBatchVisitorData data{&usrs, &found};
+  clang_visitChildren(clang_getTranslationUnitCursor(tu), HoverBatchVisitor, &data);
+
+  std::unordered_map<std::string, std::string> fileTexts;
+  out.reserve(found.size());
+
+  for (const auto &kv : found) {
+    HoverInfo hi;
+    if (FillHoverInfo(tu, kv.second, kv.second, fileTexts, hi)) {
+      out.emplace(kv.first, std::move(hi));
+    }
+  }
+
+  return out;
+}
+
 bool ArduinoCodeCompletion::GetSymbolInfo(const std::string &filename,
                                           const std::string &code,
                                           int line,
                                           int column,
                                           SymbolInfo &outInfo) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   outInfo = SymbolInfo{};
 
@@ -3290,6 +3601,9 @@ bool ArduinoCodeCompletion::FindSiblingFunctionDefinition(CXCursor declCursor, J
   // Candidates: header -> header.cpp / header.cc / header.cxx
   static const char *exts[] = {".cpp", ".cc", ".cxx"};
 
+  // sibling TUs are shared by all callers -> exclusive for the whole lookup
+  std::lock_guard<std::mutex> siblingLock(m_siblingTuMutex);
+
   for (const char *sext : exts) {
     fs::path cppPath = hp.parent_path() / (stem + sext);
     if (!fs::exists(cppPath)) {
@@ -3352,7 +3666,7 @@ bool ArduinoCodeCompletion::FindSiblingFunctionDefinition(const std::string &fil
                                                           int line,
                                                           int column,
                                                           JumpTarget &out) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   if (!m_ready)
     return false;
@@ -3580,7 +3894,7 @@ bool ArduinoCodeCompletion::FindSiblingFunctionDefinition(const std::string &fil
 }
 
 bool ArduinoCodeCompletion::FindDefinition(const std::string &filename, const std::string &code, int line, int column, JumpTarget &out) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   if (!m_ready)
     return false;
@@ -3804,13 +4118,95 @@ static void CollectSymbolOccurrencesInTU(CXTranslationUnit tu,
       &data);
 }
 
+// All occurrences (references, declarations) located in sketch files, grouped by
+// USR of the referenced symbol. Output matches CollectSymbolOccurrencesInTU().
+// Top-level cursors outside the sketch (core, libraries) are skipped as a whole.
+static void CollectXrefsInTU(CXTranslationUnit tu,
+                             const std::string &mainFile,
+                             int addedLines,
+                             const std::string &sketchDir,
+                             XrefMap &out) {
+  struct VisitorData {
+    std::string mainFile;
+    int addedLines;
+    std::string sketchDir;
+    std::unordered_map<CXFile, int> inSketch; // -1 = no, 1 = yes
+    std::unordered_set<std::string> seen;
+    XrefMap *out;
+  } data{mainFile, addedLines, sketchDir, {}, {}, &out};
+
+  clang_visitChildren(
+      clang_getTranslationUnitCursor(tu),
+      [](CXCursor cur, CXCursor parent, CXClientData client_data) -> CXChildVisitResult {
+        auto *d = static_cast<VisitorData *>(client_data);
+
+        CXSourceLocation loc = clang_getCursorLocation(cur);
+        CXFile file = nullptr;
+        unsigned line = 0, col = 0, off = 0;
+        clang_getSpellingLocation(loc, &file, &line, &col, &off);
+
+        const bool topLevel = clang_getCursorKind(parent) == CXCursor_TranslationUnit;
+        if (!file) {
+          return topLevel ? CXChildVisit_Continue : CXChildVisit_Recurse;
+        }
+
+        int &state = d->inSketch[file];
+        if (state == 0) {
+          std::string fn = cxStringToStd(clang_getFileName(file));
+          bool ok = !hasSuffix(fn, ".ino.hpp") &&
+                    NormalizeFilename(d->sketchDir, fn).rfind(d->sketchDir, 0) == 0;
+          state = ok ? 1 : -1;
+        }
+        if (state < 0) {
+          return topLevel ? CXChildVisit_Continue : CXChildVisit_Recurse;
+        }
+
+        CXCursor ref = clang_getCursorReferenced(cur);
+        CXCursor candidate = clang_Cursor_isNull(ref) ? cur : ref;
+        candidate = clang_getCanonicalCursor(candidate);
+
+        std::string usr = cxStringToStd(clang_getCursorUSR(candidate));
+        if (usr.empty()) {
+          return CXChildVisit_Recurse;
+        }
+
+        std::string fileName = cxStringToStd(clang_getFileName(file));
+
+        if (!d->mainFile.empty() && fileName == d->mainFile) {
+          if (d->addedLines > 0) {
+            if (line <= (unsigned)d->addedLines) {
+              return CXChildVisit_Recurse;
+            }
+            line -= (unsigned)d->addedLines;
+          }
+          if (hasSuffix(fileName, ".ino.cpp")) {
+            fileName.resize(fileName.size() - 4);
+          }
+        }
+
+        std::string seenKey = usr + '\n' + fileName + ':' + std::to_string(line) + ':' + std::to_string(col);
+        if (!d->seen.insert(std::move(seenKey)).second) {
+          return CXChildVisit_Recurse;
+        }
+
+        JumpTarget jt;
+        jt.file = std::move(fileName);
+        jt.line = (int)line;
+        jt.column = (int)col;
+        (*d->out)[usr].push_back(std::move(jt));
+
+        return CXChildVisit_Recurse;
+      },
+      &data);
+}
+
 bool ArduinoCodeCompletion::FindSymbolOccurrences(const std::string &filename,
                                                   const std::string &code,
                                                   int line,
                                                   int column,
                                                   bool onlyFromSketch,
                                                   std::vector<JumpTarget> &outTargets) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   if (!m_ready) {
     return false;
@@ -3901,16 +4297,16 @@ void ArduinoCodeCompletion::FindSymbolOccurrencesAsync(const std::string &filena
   std::vector<SketchFileBuffer> filesSnapshot;
   CollectSketchFiles(filesSnapshot);
 
-  std::thread([this,
-               weak,
-               filename,
-               code,
-               line,
-               column,
-               onlyFromSketch,
-               requestId,
-               eventType,
-               filesSnapshot = std::move(filesSnapshot)]() {
+  auto job = [this,
+              weak,
+              filename,
+              code,
+              line,
+              column,
+              onlyFromSketch,
+              requestId,
+              eventType,
+              filesSnapshot = std::move(filesSnapshot)]() {
     CcFilesSnapshotGuard guard(&filesSnapshot);
 
     std::vector<JumpTarget> occurrences;
@@ -3925,7 +4321,9 @@ void ArduinoCodeCompletion::FindSymbolOccurrencesAsync(const std::string &filena
     evt.SetPayload(occurrences); // vector<JumpTarget>
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  };
+
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Interactive, std::move(job), ArduinoTaskScheduler::Key("cc.occurrences", handler));
 }
 
 bool ArduinoCodeCompletion::FindSymbolOccurrencesProjectWide(
@@ -3937,8 +4335,6 @@ bool ArduinoCodeCompletion::FindSymbolOccurrencesProjectWide(
     bool onlyFromSketch,
     std::vector<JumpTarget> &outTargets) {
 
-  std::lock_guard<std::mutex> lock(m_ccMutex);
-
   if (!m_ready)
     return false;
 
@@ -3946,97 +4342,202 @@ bool ArduinoCodeCompletion::FindSymbolOccurrencesProjectWide(
 
   outTargets.clear();
 
-  // 1) From the first TU we find out the "identity" of the symbol (canonical + USR)
-  int addedLines = 0;
-  std::string mainFile;
-  CXTranslationUnit tu0 = GetTranslationUnit(filename, code, &addedLines, &mainFile);
-  if (!tu0) {
-    return false;
+  std::string sketchDir;
+  if (arduinoCli) {
+    sketchDir = arduinoCli->GetSketchPath();
   }
 
-  std::string clangFilename = GetClangFilename(filename);
-  CXFile cxFile = clang_getFile(tu0, clangFilename.c_str());
-  if (!cxFile)
-    return false;
+  std::unordered_set<LocKey, LocKeyHash> seen;
+  std::string targetUSR;
 
-  CXSourceLocation loc =
-      clang_getLocation(tu0, cxFile, line + addedLines, column);
-  if (clang_equalLocations(loc, clang_getNullLocation())) {
-    return false;
-  }
+  // The TU of the current editor is only locked while we work with it;
+  // other files are then visited one by one (never holding two TU locks).
+  {
+    auto lock = LockTranslationUnit(filename);
 
-  CXCursor cursor = clang_getCursor(tu0, loc);
-  if (clang_Cursor_isNull(cursor)) {
-    return false;
-  }
+    // 1) From the first TU we find out the "identity" of the symbol (canonical + USR)
+    int addedLines = 0;
+    std::string mainFile;
+    CXTranslationUnit tu0 = GetTranslationUnit(filename, code, &addedLines, &mainFile);
+    if (!tu0) {
+      return false;
+    }
 
-  CXCursor ref = clang_getCursorReferenced(cursor);
-  CXCursor def = clang_getCursorDefinition(cursor);
-  CXCursor target = clang_getNullCursor();
+    std::string clangFilename = GetClangFilename(filename);
+    CXFile cxFile = clang_getFile(tu0, clangFilename.c_str());
+    if (!cxFile)
+      return false;
 
-  if (!clang_Cursor_isNull(ref))
-    target = ref;
-  if (!clang_Cursor_isNull(def))
-    target = def;
-  if (clang_Cursor_isNull(target))
-    target = cursor;
-  if (clang_Cursor_isNull(target))
-    return false;
+    CXSourceLocation loc =
+        clang_getLocation(tu0, cxFile, line + addedLines, column);
+    if (clang_equalLocations(loc, clang_getNullLocation())) {
+      return false;
+    }
 
-  CXCursor canonicalTarget = clang_getCanonicalCursor(target);
-  std::string targetUSR = cxStringToStd(clang_getCursorUSR(canonicalTarget));
+    CXCursor cursor = clang_getCursor(tu0, loc);
+    if (clang_Cursor_isNull(cursor)) {
+      return false;
+    }
 
-  std::string sketchDir;
-  if (arduinoCli) {
-    sketchDir = arduinoCli->GetSketchPath();
-  }
+    CXCursor ref = clang_getCursorReferenced(cursor);
+    CXCursor def = clang_getCursorDefinition(cursor);
+    CXCursor target = clang_getNullCursor();
+
+    if (!clang_Cursor_isNull(ref))
+      target = ref;
+    if (!clang_Cursor_isNull(def))
+      target = def;
+    if (clang_Cursor_isNull(target))
+      target = cursor;
+    if (clang_Cursor_isNull(target))
+      return false;
 
-  std::unordered_set<LocKey, LocKeyHash> seen;
+    CXCursor canonicalTarget = clang_getCanonicalCursor(target);
+    targetUSR = cxStringToStd(clang_getCursorUSR(canonicalTarget));
 
-  // 2) First collect occurrences in the first TU (current editor)
-  CollectSymbolOccurrencesInTU(tu0,
-                               canonicalTarget,
-                               targetUSR,
-                               mainFile,
-                               addedLines,
-                               sketchDir,
-                               onlyFromSketch,
-                               seen,
-                               outTargets);
+    // 2) First collect occurrences in the first TU (current editor)
+    CollectSymbolOccurrencesInTU(tu0,
+                                 canonicalTarget,
+                                 targetUSR,
+                                 mainFile,
+                                 addedLines,
+                                 sketchDir,
+                                 onlyFromSketch,
+                                 seen,
+                                 outTargets);
+  }
+
+  // 3) Other files come from the xref index; only files changed since they were
+  // indexed are parsed and walked again. Cursors are never equal across TUs,
+  // so only the USR can match there.
+  if (files.empty() || targetUSR.empty()) {
+    return !outTargets.empty();
+  }
 
-  // 3) Now go through the other files from the vector files
-  if (files.empty()) {
+  std::shared_ptr<ArduinoXrefIndex> xref = GetXrefIndex();
+  if (!xref) {
     return !outTargets.empty();
   }
 
   const std::string currentAbs = AbsoluteFilename(filename);
 
+  const std::size_t argsHash = XrefArgsHash(GetCompilerArgs(files));
+  const std::size_t headersHash = XrefHeadersHash(files);
+
+  size_t reindexed = 0;
   for (const auto &f : files) {
     std::string abs = AbsoluteFilename(f.filename);
 
-    if (abs == currentAbs)
-      continue;
+    if (abs == currentAbs)
+      continue;
+
+    const std::size_t sig = XrefSignature(HashCode(f.Code()), headersHash, argsHash);
+    if (xref->IsUpToDate(abs, sig))
+      continue;
+
+    auto lock = LockTranslationUnit(f.filename);
+
+    int addedLines2 = 0;
+    std::string mainFile2;
+    CXTranslationUnit tu =
+        GetTranslationUnit(f.filename, f.Code(), &addedLines2, &mainFile2);
+    if (!tu) {
+      continue;
+    }
+
+    XrefMap refs;
+    CollectXrefsInTU(tu, mainFile2, addedLines2, sketchDir, refs);
+    xref->UpdateFile(abs, sig, std::move(refs));
+    ++reindexed;
+  }
+
+  APP_DEBUG_LOG("CC: xref index - %zu of %zu files reindexed", reindexed, files.size());
+
+  std::vector<JumpTarget> indexed;
+  xref->FindOccurrences(targetUSR, currentAbs, indexed);
+
+  // Declarations from the symbol index cover files which are not walked above
+  // (library headers, project TUs outside files). Walked files are always fresher.
+  std::unordered_set<std::string> walked;
+  walked.insert(currentAbs);
+  for (const auto &f : files) {
+    walked.insert(AbsoluteFilename(f.filename));
+  }
+  for (const auto &s : FindSymbolsByUsr(targetUSR)) {
+    if (s.line <= 0 || hasSuffix(s.file, ".ino.hpp")) {
+      continue;
+    }
+    std::string file = StripInoGeneratedSuffix(s.file);
+    if (walked.count(AbsoluteFilename(file))) {
+      continue;
+    }
+    JumpTarget jt;
+    jt.file = std::move(file);
+    jt.line = s.line;
+    jt.column = s.column;
+    indexed.push_back(std::move(jt));
+  }
+
+  for (auto &jt : indexed) {
+    if (onlyFromSketch && NormalizeFilename(sketchDir, jt.file).rfind(sketchDir, 0) != 0) {
+      continue;
+    }
+
+    LocKey key{jt.file, (unsigned)jt.line, (unsigned)jt.column};
+    if (!seen.insert(key).second) {
+      continue;
+    }
+    outTargets.push_back(std::move(jt));
+  }
+
+  xref->SaveIfDirty();
+
+  return !outTargets.empty();
+}
+
+std::shared_ptr<ArduinoXrefIndex> ArduinoCodeCompletion::GetXrefIndex() {
+  if (!arduinoCli) {
+    return nullptr;
+  }
+
+  const std::string sketchPath = arduinoCli->GetSketchPath();
+  if (sketchPath.empty()) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lk(m_xrefMutex);
+  if (!m_xref || m_xref->GetSketchPath() != sketchPath) {
+    m_xref = std::make_shared<ArduinoXrefIndex>(sketchPath);
+    m_xref->Load();
+  }
+  return m_xref;
+}
+
+std::size_t ArduinoCodeCompletion::XrefArgsHash(const std::vector<std::string> &clangArgs) {
+  std::string text;
+  for (const auto &a : clangArgs) {
+    text += a;
+    text += '\0';
+  }
+  return HashCode(text);
+}
 
-    int addedLines2 = 0;
-    std::string mainFile2;
-    CXTranslationUnit tu =
-        GetTranslationUnit(f.filename, f.code, &addedLines2, &mainFile2);
-    if (!tu) {
-      continue;
+std::size_t ArduinoCodeCompletion::XrefHeadersHash(const std::vector<SketchFileBuffer> &files) {
+  std::size_t headers = 0;
+  for (const auto &f : files) {
+    if (isHeaderFile(f.filename)) {
+      headers += HashCode(f.filename) ^ (HashCode(f.Code()) * 1099511628211ull);
     }
-
-    CollectSymbolOccurrencesInTU(tu,
-                                 canonicalTarget,
-                                 targetUSR,
-                                 mainFile2,
-                                 addedLines2,
-                                 sketchDir,
-                                 onlyFromSketch,
-                                 seen,
-                                 outTargets);
   }
+  return headers;
+}
 
-  return !outTargets.empty();
+std::size_t ArduinoCodeCompletion::XrefSignature(std::size_t codeHash, std::size_t headersHash, std::size_t argsHash) {
+  // compiler args carry the board (FQBN defines, core include dirs) - #ifdef
+  // dependent references of the same code differ between boards
+  std::size_t sig = codeHash ^ (headersHash * 1469598103934665603ull + 0x9e3779b97f4a7c15ull);
+  sig ^= argsHash + 0x9e3779b97f4a7c15ull + (sig << 6) + (sig >> 2);
+  return sig;
 }
 
 void ArduinoCodeCompletion::FindSymbolOccurrencesProjectWideAsync(
@@ -4058,16 +4559,16 @@ void ArduinoCodeCompletion::FindSymbolOccurrencesProjectWideAsync(
 
   auto filesCopy = files;
 
-  std::thread([this,
-               weak,
-               filesCopy = std::move(filesCopy),
-               filename,
-               code,
-               line,
-               column,
-               onlyFromSketch,
-               requestId,
-               eventType]() {
+  auto job = [this,
+              weak,
+              filesCopy = std::move(filesCopy),
+              filename,
+              code,
+              line,
+              column,
+              onlyFromSketch,
+              requestId,
+              eventType]() {
     CcFilesSnapshotGuard guard(&filesCopy);
 
     std::vector<JumpTarget> occurrences;
@@ -4089,7 +4590,9 @@ void ArduinoCodeCompletion::FindSymbolOccurrencesProjectWideAsync(
     evt.SetPayload(occurrences); // vector<JumpTarget>
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  };
+
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Background, std::move(job), ArduinoTaskScheduler::Key("cc.occurrencesProjectWide", handler));
 }
 
 bool ArduinoCodeCompletion::FindEnclosingContainerInfo(const std::string &filename,
@@ -4097,7 +4600,7 @@ bool ArduinoCodeCompletion::FindEnclosingContainerInfo(const std::string &filena
                                                        int line,
                                                        int column,
                                                        AeContainerInfo &out) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   ScopeTimer t("CC: FindEnclosingContainerInfo()");
 
@@ -4231,7 +4734,7 @@ bool ArduinoCodeCompletion::FindEnclosingContainerInfo(const std::string &filena
 bool ArduinoCodeCompletion::AnalyzeIncludes(const std::string &filename,
                                             const std::string &code,
                                             std::vector<IncludeUsage> &outIncludes) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   ScopeTimer t("CC: AnalyzeIncludes()");
 
@@ -4409,7 +4912,7 @@ bool ArduinoCodeCompletion::AnalyzeExtractFunction(const std::string &filename,
                                                    int selStartLine, int selStartColumn,
                                                    int selEndLine, int selEndColumn,
                                                    ExtractFunctionAnalysis &out) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(filename);
 
   out = ExtractFunctionAnalysis{};
   out.returnType = "void";
@@ -4525,10 +5028,230 @@ bool ArduinoCodeCompletion::AnalyzeExtractFunction(const std::string &filename,
   return true;
 }
 
+// Lines [1, prefix] and the last 'suffix' lines are the same in both texts.
+static void CommonLineAffixes(std::string_view a, std::string_view b, unsigned &prefix, unsigned &suffix) {
+  auto split = [](std::string_view s) {
+    std::vector<std::string_view> lines;
+    size_t pos = 0;
+    for (;;) {
+      size_t nl = s.find('\n', pos);
+      if (nl == std::string_view::npos) {
+        lines.push_back(s.substr(pos));
+        break;
+      }
+      lines.push_back(s.substr(pos, nl - pos));
+      pos = nl + 1;
+    }
+    return lines;
+  };
+
+  const auto la = split(a);
+  const auto lb = split(b);
+  const size_t n = std::min(la.size(), lb.size());
+
+  size_t p = 0;
+  while (p < n && la[p] == lb[p])
+    ++p;
+
+  size_t q = 0;
+  while (q < n - p && la[la.size() - 1 - q] == lb[lb.size() - 1 - q])
+    ++q;
+
+  prefix = (unsigned)p;
+  suffix = (unsigned)q;
+}
+
+static unsigned CountLines(std::string_view s) {
+  return (unsigned)std::count(s.begin(), s.end(), '\n') + 1;
+}
+
+std::shared_ptr<const SymbolCacheEntry> ArduinoCodeCompletion::UpdateSymbolIndex(const std::string &cacheKey,
+                                                                                 std::size_t codeHash,
+                                                                                 CXTranslationUnit tu,
+                                                                                 const std::string &mainFile,
+                                                                                 int addedLines) {
+  ScopeTimer t("CC: UpdateSymbolIndex(%s)", cacheKey.c_str());
+
+  std::shared_ptr<const SymbolCacheEntry> old;
+  {
+    std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
+    auto it = m_symbolCache.find(cacheKey);
+    if (it != m_symbolCache.end()) {
+      old = it->second;
+    }
+  }
+
+  auto entry = std::make_shared<SymbolCacheEntry>();
+  entry->filename = cacheKey;
+  entry->codeHash = codeHash;
+  entry->mainFile = mainFile;
+  entry->addedLines = addedLines;
+
+  const std::string sketchPath = arduinoCli ? arduinoCli->GetSketchPath() : std::string();
+
+  // clang filename + content signature for each CXFile (content is only hashed
+  // for sketch files, for the rest - core, libraries - mtime and size is enough)
+  std::unordered_map<CXFile, std::string> fileNames;
+  auto fileName = [&](CXFile f) -> const std::string & {
+    auto it = fileNames.find(f);
+    if (it != fileNames.end())
+      return it->second;
+
+    std::string name = f ? cxStringToStd(clang_getFileName(f)) : std::string();
+    if (f && name != mainFile && entry->fileHashes.find(name) == entry->fileHashes.end()) {
+      uint64_t h = 0;
+      if (!sketchPath.empty() && hasPrefix(name, sketchPath.c_str())) {
+        size_t size = 0;
+        const char *data = clang_getFileContents(tu, f, &size);
+        h = data ? Fnv1a64((const uint8_t *)data, size) : 0;
+      } else {
+        h = ((uint64_t)clang_getFileTime(f) << 20) ^ (uint64_t)name.size();
+      }
+      entry->fileHashes[name] = h;
+    }
+    return fileNames.emplace(f, std::move(name)).first->second;
+  };
+
+  if (CXFile mf = clang_getFile(tu, mainFile.c_str())) {
+    size_t size = 0;
+    if (const char *data = clang_getFileContents(tu, mf, &size)) {
+      entry->mainContent.assign(data, size);
+    }
+  }
+
+  // --- What can be reused from the previous index ---
+  const bool haveOld = old && old->mainFile == mainFile;
+  unsigned prefix = 0, suffix = 0;
+  int lineDelta = 0;
+  const unsigned newLines = CountLines(entry->mainContent);
+  std::unordered_multimap<std::string, const SymbolBlock *> oldBlocks;
+
+  auto blockKey = [](const std::string &file, unsigned lf, unsigned cf, unsigned lt, unsigned ct) {
+    return file + '\n' + std::to_string(lf) + ':' + std::to_string(cf) + '-' + std::to_string(lt) + ':' + std::to_string(ct);
+  };
+
+  if (haveOld) {
+    CommonLineAffixes(old->mainContent, entry->mainContent, prefix, suffix);
+    lineDelta = (int)newLines - (int)CountLines(old->mainContent);
+
+    oldBlocks.reserve(old->blocks.size());
+    for (const auto &b : old->blocks) {
+      oldBlocks.emplace(blockKey(b.file, b.lineFrom, b.colFrom, b.lineTo, b.colTo), &b);
+    }
+  }
+
+  auto takeOld = [&](const std::string &key) -> const SymbolBlock * {
+    auto it = oldBlocks.find(key);
+    if (it == oldBlocks.end())
+      return nullptr;
+    const SymbolBlock *b = it->second;
+    oldBlocks.erase(it);
+    return b;
+  };
+
+  // --- Top-level cursors only; children are walked just for the changed ones ---
+  std::vector<CXCursor> topLevel;
+  clang_visitChildren(
+      clang_getTranslationUnitCursor(tu),
+      [](CXCursor c, CXCursor, CXClientData d) -> CXChildVisitResult {
+        static_cast<std::vector<CXCursor> *>(d)->push_back(c);
+        return CXChildVisit_Continue;
+      },
+      &topLevel);
+
+  entry->blocks.reserve(topLevel.size());
+
+  size_t reused = 0;
+  for (CXCursor c : topLevel) {
+    CXSourceRange ext = clang_getCursorExtent(c);
+    CXFile fFrom = nullptr, fTo = nullptr;
+    unsigned off = 0;
+
+    SymbolBlock block;
+    clang_getSpellingLocation(clang_getRangeStart(ext), &fFrom, &block.lineFrom, &block.colFrom, &off);
+    clang_getSpellingLocation(clang_getRangeEnd(ext), &fTo, &block.lineTo, &block.colTo, &off);
+    block.file = fileName(fFrom);
+
+    const SymbolBlock *src = nullptr;
+    int shift = 0;
+
+    if (haveOld && fFrom == fTo) {
+      if (block.file == mainFile) {
+        if (block.lineTo <= prefix) {
+          src = takeOld(blockKey(block.file, block.lineFrom, block.colFrom, block.lineTo, block.colTo));
+        } else if (block.lineFrom + suffix > newLines && (int)block.lineFrom - lineDelta > 0) {
+          src = takeOld(blockKey(block.file, block.lineFrom - lineDelta, block.colFrom, block.lineTo - lineDelta, block.colTo));
+          // symbols are stored in original (.ino) lines
+          shift = lineDelta - (addedLines - old->addedLines);
+        }
+      } else {
+        auto oh = old->fileHashes.find(block.file);
+        auto nh = entry->fileHashes.find(block.file);
+        const bool sameContent = block.file.empty() ||
+                                 (oh != old->fileHashes.end() && nh != entry->fileHashes.end() && oh->second == nh->second);
+        if (sameContent) {
+          src = takeOld(blockKey(block.file, block.lineFrom, block.colFrom, block.lineTo, block.colTo));
+        }
+      }
+    }
+
+    if (src) {
+      block.symbols = src->symbols;
+      if (shift != 0) {
+        for (auto &si : block.symbols) {
+          if (si.file != mainFile)
+            continue;
+          si.line += shift;
+          if (si.bodyLineFrom > 0) {
+            si.bodyLineFrom += shift;
+            si.bodyLineTo += shift;
+          }
+        }
+      }
+      ++reused;
+    } else {
+      CollectSymbolsInCursor(tu, c, mainFile, addedLines, block.symbols);
+    }
+
+    entry->blocks.push_back(std::move(block));
+  }
+
+  APP_DEBUG_LOG("CC: symbol index %s: %zu top-level cursors, %zu reused", cacheKey.c_str(), topLevel.size(), reused);
+
+  // --- Flat views ---
+  size_t total = 0;
+  for (const auto &b : entry->blocks) {
+    total += b.symbols.size();
+  }
+  entry->symbols.reserve(total);
+  for (const auto &b : entry->blocks) {
+    entry->symbols.insert(entry->symbols.end(), b.symbols.begin(), b.symbols.end());
+  }
+
+  std::sort(entry->symbols.begin(), entry->symbols.end(),
+            [](const SymbolInfo &a, const SymbolInfo &b) {
+              if (a.name != b.name)
+                return a.name < b.name;
+              if (a.file != b.file)
+                return a.file < b.file;
+              return a.line < b.line;
+            });
+
+  for (std::size_t i = 0; i < entry->symbols.size(); ++i) {
+    const auto &usr = entry->symbols[i].usr;
+    if (!usr.empty()) {
+      entry->byUsr[usr].push_back(i);
+    }
+  }
+
+  std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
+  m_symbolCache[cacheKey] = entry;
+
+  return entry;
+}
+
 std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols(const std::string &filename,
                                                              const std::string &code) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
-
   std::vector<SymbolInfo> symbols;
   if (!m_ready)
     return symbols;
@@ -4537,28 +5260,21 @@ std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols(const std::string &
 
   const std::string key = AbsoluteFilename(filename);
   const std::size_t codeHash = HashCode(code);
-  const auto now = std::chrono::steady_clock::now();
 
   // --- Cache ---
-  auto it = m_symbolCache.find(key);
-  if (it != m_symbolCache.end()) {
-    SymbolCacheEntry &entry = it->second;
+  {
+    std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
 
-    if (entry.codeHash == codeHash) {
+    auto it = m_symbolCache.find(key);
+    if (it != m_symbolCache.end() && it->second->codeHash == codeHash) {
       APP_DEBUG_LOG("CC: GetAllSymbols cache hit (%s, exact)", key.c_str());
-      return entry.symbols;
-    }
-
-    constexpr auto MIN_REBUILD_INTERVAL = std::chrono::seconds(10);
-    if (now - entry.lastUpdated < MIN_REBUILD_INTERVAL) {
-      APP_DEBUG_LOG("CC: GetAllSymbols cache stale but recent (%s) - using without rebuild", key.c_str());
-      return entry.symbols;
+      return it->second->symbols;
     }
-
-    APP_DEBUG_LOG("CC: GetAllSymbols cache stale & old (%s) - rebuilding", key.c_str());
   }
 
-  // --- Normal calculation ---
+  auto lock = LockTranslationUnit(filename);
+
+  // --- Incremental update of the index ---
   int addedLines = 0;
   std::string mainFile;
   CXTranslationUnit tu = GetTranslationUnit(filename, code, &addedLines, &mainFile);
@@ -4568,38 +5284,55 @@ std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols(const std::string &
 
   std::string useMainFile = !mainFile.empty() ? mainFile : GetClangFilename(filename);
 
-  symbols.clear();
-  CXCursor nullParent = clang_getNullCursor();
-  CollectSymbolsInTUForParent(tu,
-                              useMainFile,
-                              addedLines,
-                              symbols,
-                              nullParent);
+  return UpdateSymbolIndex(key, codeHash, tu, useMainFile, addedLines)->symbols;
+}
 
-  std::sort(symbols.begin(), symbols.end(),
-            [](const SymbolInfo &a, const SymbolInfo &b) {
-              if (a.name != b.name)
-                return a.name < b.name;
-              if (a.file != b.file)
-                return a.file < b.file;
-              return a.line < b.line;
-            });
+std::vector<SymbolInfo> ArduinoCodeCompletion::FindSymbolsByUsr(const std::string &usr) {
+  std::vector<SymbolInfo> out;
+  if (usr.empty())
+    return out;
 
-  // --- Cache update ---
-  SymbolCacheEntry entry;
-  entry.filename = key;
-  entry.codeHash = codeHash;
-  entry.symbols = symbols;
-  entry.lastUpdated = now;
+  std::vector<std::shared_ptr<const SymbolCacheEntry>> entries;
+  {
+    std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
+    entries.reserve(m_symbolCache.size());
+    for (const auto &kv : m_symbolCache) {
+      entries.push_back(kv.second);
+    }
+  }
+
+  std::set<std::tuple<std::string, int, int>> seen;
+  for (const auto &e : entries) {
+    auto it = e->byUsr.find(usr);
+    if (it == e->byUsr.end())
+      continue;
 
-  m_symbolCache[key] = std::move(entry);
+    for (std::size_t i : it->second) {
+      const SymbolInfo &si = e->symbols[i];
+      if (seen.emplace(si.file, si.line, si.column).second) {
+        out.push_back(si);
+      }
+    }
+  }
 
-  return symbols;
+  return out;
 }
 
-std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols() {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+bool ArduinoCodeCompletion::FindIndexedDefinition(const SymbolInfo &decl, SymbolInfo &out) {
+  if (decl.usr.empty() || decl.bodyLineFrom > 0) {
+    return false; // already the definition
+  }
+
+  for (auto &s : FindSymbolsByUsr(decl.usr)) {
+    if (s.bodyLineFrom > 0) {
+      out = std::move(s);
+      return true;
+    }
+  }
+  return false;
+}
 
+std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols() {
   std::vector<SymbolInfo> out;
   if (!m_ready || !arduinoCli)
     return out;
@@ -4613,25 +5346,61 @@ std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols() {
   std::vector<SymbolInfo> all;
   all.reserve(1024);
 
-  const CXCursor nullParent = clang_getNullCursor();
+  auto appendIndexed = [&](const std::string &cacheKey, std::size_t sig, CXTranslationUnit tu,
+                           const std::string &mainFile, int addedLines) {
+    std::shared_ptr<const SymbolCacheEntry> idx;
+    {
+      std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
+      auto it = m_symbolCache.find(cacheKey);
+      if (it != m_symbolCache.end() && it->second->codeHash == sig) {
+        idx = it->second;
+      }
+    }
+    if (!idx) {
+      idx = UpdateSymbolIndex(cacheKey, sig, tu, mainFile, addedLines);
+    }
+    all.insert(all.end(), idx->symbols.begin(), idx->symbols.end());
+  };
+
+  // Entries are never erased, so the pointers stay valid after the map lock is released.
+  std::vector<ProjectTuEntry *> projectEntries;
+  {
+    std::lock_guard<std::mutex> lk(m_projectTuCacheMutex);
+    projectEntries.reserve(m_projectTuCache.size());
+    for (auto &kv : m_projectTuCache) {
+      projectEntries.push_back(&kv.second);
+    }
+  }
 
   // Prefer project-wide TU cache; fallback to single TU cache.
-  if (!m_projectTuCache.empty()) {
-    for (const auto &kv : m_projectTuCache) {
-      const ProjectTuEntry &entry = kv.second;
-      if (!entry.tu)
-        continue;
+  bool anyProjectTu = false;
+  for (ProjectTuEntry *entry : projectEntries) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (!entry->tu)
+      continue;
+
+    // Header signature is part of the key, reparse happens on header change too.
+    appendIndexed("project:" + entry->key, entry->codeHash ^ (entry->headersSigHash * 1099511628211ull),
+                  entry->tu, entry->mainFilename, entry->addedLines);
+    anyProjectTu = true;
+  }
 
-      // Project TUs don't currently track synthetic .ino line shifts -> use addedLines = 0.
-      CollectSymbolsInTUForParent(entry.tu, entry.mainFilename, 0, all, nullParent);
+  if (!anyProjectTu) {
+    std::vector<CachedTranslationUnit *> tuEntries;
+    {
+      std::lock_guard<std::mutex> lk(m_tuCacheMutex);
+      tuEntries.reserve(m_tuCache.size());
+      for (auto &kv : m_tuCache) {
+        tuEntries.push_back(&kv.second);
+      }
     }
-  } else {
-    for (const auto &kv : m_tuCache) {
-      const CachedTranslationUnit &entry = kv.second;
-      if (!entry.tu)
+
+    for (CachedTranslationUnit *entry : tuEntries) {
+      std::lock_guard<std::mutex> lock(entry->mutex);
+      if (!entry->tu)
         continue;
 
-      CollectSymbolsInTUForParent(entry.tu, entry.mainFilename, entry.addedLines, all, nullParent);
+      appendIndexed(entry->filename, entry->codeHash, entry->tu, entry->mainFilename, entry->addedLines);
     }
   }
 
@@ -4678,40 +5447,92 @@ std::vector<SymbolInfo> ArduinoCodeCompletion::GetAllSymbols() {
   return out;
 }
 
-void ArduinoCodeCompletion::InvalidateTranslationUnit() {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+void ArduinoCodeCompletion::ResetTuEntry(CachedTranslationUnit &entry) {
+  // expects entry.mutex to be held
+  if (entry.tu) {
+    clang_disposeTranslationUnit(entry.tu);
+    entry.tu = nullptr;
+    --m_liveTuCount;
+  }
+  entry.mainFilename.clear();
+  entry.codeHash = 0;
+  entry.addedLines = 0;
+}
+
+void ArduinoCodeCompletion::ResetProjectTuEntry(ProjectTuEntry &entry) {
+  // expects entry.mutex to be held
+  if (entry.tu) {
+    clang_disposeTranslationUnit(entry.tu);
+    entry.tu = nullptr;
+  }
+  entry.codeHash = 0;
+  entry.headersSigHash = 0;
+  entry.argsHash = 0;
+  entry.addedLines = 0;
+  entry.cachedErrors.clear();
+}
 
-  for (auto &kv : m_tuCache) {
-    if (kv.second.tu) {
-      clang_disposeTranslationUnit(kv.second.tu);
-      kv.second.tu = nullptr;
+void ArduinoCodeCompletion::InvalidateTranslationUnit() {
+  // Entries stay in the maps (they own the locks), only their TUs are dropped.
+  std::vector<CachedTranslationUnit *> tuEntries;
+  {
+    std::lock_guard<std::mutex> lk(m_tuCacheMutex);
+    tuEntries.reserve(m_tuCache.size());
+    for (auto &kv : m_tuCache) {
+      tuEntries.push_back(&kv.second);
     }
   }
-  m_tuCache.clear();
 
-  for (auto &kv : m_projectTuCache) {
-    if (kv.second.tu) {
-      clang_disposeTranslationUnit(kv.second.tu);
-      kv.second.tu = nullptr;
+  for (CachedTranslationUnit *entry : tuEntries) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    ResetTuEntry(*entry);
+  }
+
+  std::vector<ProjectTuEntry *> projectEntries;
+  {
+    std::lock_guard<std::mutex> lk(m_projectTuCacheMutex);
+    projectEntries.reserve(m_projectTuCache.size());
+    for (auto &kv : m_projectTuCache) {
+      projectEntries.push_back(&kv.second);
     }
   }
-  m_projectTuCache.clear();
 
-  for (auto &kv : m_siblingTuCache) {
-    if (kv.second) {
-      clang_disposeTranslationUnit(kv.second);
+  for (ProjectTuEntry *entry : projectEntries) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    ResetProjectTuEntry(*entry);
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_siblingTuMutex);
+    for (auto &kv : m_siblingTuCache) {
+      if (kv.second) {
+        clang_disposeTranslationUnit(kv.second);
+      }
     }
+    m_siblingTuCache.clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_symbolCacheMutex);
+    m_symbolCache.clear();
   }
-  m_siblingTuCache.clear();
 
-  m_symbolCache.clear();
-  m_inoHeaderCache.clear();
-  m_inoInsertCache.clear();
+  {
+    std::lock_guard<std::mutex> lk(m_inoCacheMutex);
+    m_inoHeaderCache.clear();
+    m_inoInsertCache.clear();
+  }
 
-  m_completionSession.valid = false;
-  m_completionSession.baseItems.clear();
+  {
+    std::lock_guard<std::mutex> lk(m_completionSessionMutex);
+    m_completionSession.valid = false;
+    m_completionSession.baseItems.reset();
+  }
 
-  m_resolvedIncludesCache.clear();
+  {
+    std::lock_guard<std::mutex> lk(m_resolvedIncludesCacheMutex);
+    m_resolvedIncludesCache.clear();
+  }
 }
 
 bool ArduinoCodeCompletion::InitTranslationUnitForIno() {
@@ -4745,7 +5566,7 @@ bool ArduinoCodeCompletion::InitTranslationUnitForIno() {
   std::string code((std::istreambuf_iterator<char>(in)),
                    std::istreambuf_iterator<char>());
 
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  auto lock = LockTranslationUnit(inoFilename);
   APP_DEBUG_LOG("CC: InitTranslationUnitForIno using '%s'", inoFilename.c_str());
 
   int addedLines = 0;
@@ -4759,8 +5580,7 @@ bool ArduinoCodeCompletion::InitTranslationUnitForIno() {
 }
 
 bool ArduinoCodeCompletion::IsTranslationUnitValid() {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
-  return !m_tuCache.empty();
+  return m_liveTuCount.load() > 0;
 }
 
 std::string ArduinoCodeCompletion::GetKindSpelling(CXCursorKind kind) {
@@ -4776,22 +5596,31 @@ void ArduinoCodeCompletion::RefreshProjectDiagnosticsAsync(const std::vector<Ske
   auto filesCopy = files;
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, filesCopy = std::move(filesCopy), weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Background, [this, filesCopy = std::move(filesCopy), weak]() {
     CcFilesSnapshotGuard guard(&filesCopy);
 
-    std::lock_guard<std::mutex> lock(m_ccMutex);
+    // Only serializes deep scans among themselves; interactive requests
+    // on editor TUs are not blocked by it.
+    std::lock_guard<std::mutex> lock(m_projectDiagMutex);
 
-    // calculate multi-TU errors
-    auto errors = ComputeProjectDiagnosticsLocked(filesCopy);
+    // calculate multi-TU errors; every finished file is streamed to the UI right away
+    auto errors = ComputeProjectDiagnosticsLocked(filesCopy, [this, weak](const std::string &key, const std::vector<ArduinoParseError> &fileErrors) {
+      wxThreadEvent fevt(EVT_DIAGNOSTICS_FILE_READY);
+      fevt.SetString(wxString::FromUTF8(key));
+      fevt.SetPayload(fileErrors);
+      QueueUiEvent(weak, fevt.Clone());
+    });
 
     wxThreadEvent evt(EVT_DIAGNOSTICS_UPDATED);
     evt.SetInt(1);
     evt.SetPayload(std::move(errors));
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cc.projectDiagnostics", handler));
 }
 
-std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsLocked(const std::vector<SketchFileBuffer> &files) {
+// Expects m_projectDiagMutex to be held. Project TUs are (re)parsed in parallel on m_parsePool.
+std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsLocked(const std::vector<SketchFileBuffer> &files,
+                                                                                       const ProjectFileDiagnosticsFn &onFileDone) {
   ScopeTimer t("CC: ComputeProjectDiagnosticsLocked(%zu files)", files.size());
   std::vector<ArduinoParseError> allErrors;
 
@@ -4807,6 +5636,8 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
   // Base compiler args (common for all files in this snapshot)
   // -----------------------------
   const std::vector<std::string> clangArgs = GetCompilerArgs(files);
+  const std::size_t xrefArgsHash = XrefArgsHash(clangArgs);
+  const std::size_t xrefHeadersHash = XrefHeadersHash(files);
 
   std::vector<const char *> baseArgs;
   baseArgs.reserve(clangArgs.size() + 4);
@@ -4856,7 +5687,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
   for (const auto &h : headers) {
     headerAbsPaths.push_back(h.abs);
 
-    const std::size_t codeHash = HashCode(h.f->code);
+    const std::size_t codeHash = HashCode(h.f->Code());
 
     for (unsigned char c : headerAbsPaths.back())
       fnvMix(c);
@@ -4869,11 +5700,14 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
 
     CXUnsavedFile uf{};
     uf.Filename = headerAbsPaths.back().c_str();
-    uf.Contents = h.f->code.c_str(); // backed by files snapshot in the worker thread
-    uf.Length = h.f->code.size();
+    uf.Contents = h.f->Code().c_str(); // backed by files snapshot in the worker thread
+    uf.Length = h.f->Code().size();
     headerUnsaved.push_back(uf);
   }
 
+  // precompiled core headers for the .ino TU (empty -> plain "-include Arduino.h")
+  const std::string corePch = GetCorePch(clangArgs);
+
   // -----------------------------
   // Arg hash helper: base args + file-specific extras
   // Note: clang_reparseTranslationUnit() cannot change command line args,
@@ -4904,8 +5738,13 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
     }
 
     if (isInoMain) {
-      mixStr("-include");
-      mixStr("Arduino.h");
+      if (!corePch.empty()) {
+        mixStr("-include-pch");
+        mixStr(corePch.c_str());
+      } else {
+        mixStr("-include");
+        mixStr("Arduino.h");
+      }
     }
 
     return h;
@@ -4917,15 +5756,60 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
 
   // -----------------------------
   // Build / update per-file TUs
+  // Each file is an independent job for the parse pool; a job only holds the
+  // lock of its own ProjectTuEntry. Results are merged in file order below.
   // -----------------------------
-  for (const auto &f : files) {
-    if (!isSourceFile(f.filename))
-      continue;
+  struct FileJob {
+    const SketchFileBuffer *f = nullptr;
+    ProjectTuEntry *entry = nullptr;
+    std::string key;
+    std::vector<ArduinoParseError> errors;
+  };
+
+  std::vector<FileJob> fileJobs;
+  fileJobs.reserve(files.size());
+
+  {
+    std::lock_guard<std::mutex> lk(m_projectTuCacheMutex);
+
+    for (const auto &f : files) {
+      if (!isSourceFile(f.filename))
+        continue;
+
+      FileJob job;
+      job.f = &f;
+      job.key = AbsoluteFilename(f.filename);
+
+      if (!keepKeys.insert(job.key).second)
+        continue;
+
+      // operator[] constructs the entry in place (it holds a mutex)
+      ProjectTuEntry &entry = m_projectTuCache[job.key];
+      if (entry.key.empty()) {
+        entry.key = job.key;
+      }
+      job.entry = &entry;
+
+      fileJobs.push_back(std::move(job));
+    }
+  }
+
+  const std::vector<SketchFileBuffer> *filesSnapshot = g_ccFilesSnapshot;
+
+  std::shared_ptr<ArduinoXrefIndex> xref = GetXrefIndex();
+
+  auto processFile = [&](FileJob &job) {
+    // GetCompilerArgs() inside CreateClangUnsavedFiles relies on the thread-local snapshot
+    CcFilesSnapshotGuard guard(filesSnapshot ? filesSnapshot : &files);
 
-    const std::string key = AbsoluteFilename(f.filename);
-    keepKeys.insert(key);
+    const SketchFileBuffer &f = *job.f;
+    const std::string &key = job.key;
+    ProjectTuEntry &entry = *job.entry;
+    std::vector<ArduinoParseError> &fileErrors = job.errors;
 
-    const std::size_t codeHash = HashCode(f.code);
+    std::lock_guard<std::mutex> entryLock(entry.mutex);
+
+    const std::size_t codeHash = HashCode(f.Code());
 
     const std::string mainFilename = GetClangFilename(f.filename);
 
@@ -4940,30 +5824,15 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
       localArgs.push_back("c++-header");
     }
 
+    const size_t arduinoIncludePos = localArgs.size();
     if (isInoMain) {
-      localArgs.push_back("-include");
-      localArgs.push_back("Arduino.h");
+      AppendArduinoInclude(localArgs, corePch);
     }
 
     m_clangSettings.AppendWarningFlags(localArgs);
 
     const std::size_t argsHash = HashArgsForTU(isHeaderTU, isInoMain);
 
-    // Find or create cache entry
-    auto it = m_projectTuCache.find(key);
-    if (it == m_projectTuCache.end()) {
-      ProjectTuEntry e;
-      e.key = key;
-      e.mainFilename = mainFilename;
-      e.codeHash = 0;
-      e.headersSigHash = 0;
-      e.argsHash = 0;
-      e.tu = nullptr;
-      it = m_projectTuCache.emplace(key, std::move(e)).first;
-    }
-
-    ProjectTuEntry &entry = it->second;
-
     // Decide what to do:
     // - recreate TU if it doesn't exist or args/main file changed (reparse can't change args)
     // - otherwise, reparse if code/header signature changed
@@ -4979,7 +5848,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
 
     if (needRecreate) {
       ClangUnsavedFiles uf;
-      CreateClangUnsavedFiles(f.filename, f.code, uf);
+      CreateClangUnsavedFiles(f.filename, f.Code(), uf);
 
       if (entry.tu) {
         clang_disposeTranslationUnit(entry.tu);
@@ -5004,7 +5873,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
 
       CXTranslationUnit tu = nullptr;
       CXErrorCode err = clang_parseTranslationUnit2(
-          index,
+          CurrentIndex(),
           uf.mainFilename.c_str(),
           localArgs.empty() ? nullptr : localArgs.data(),
           (int)localArgs.size(),
@@ -5013,6 +5882,25 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
           CXTranslationUnit_KeepGoing | CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CreatePreambleOnFirstParse,
           &tu);
 
+      if (tu && isInoMain && !corePch.empty() && HasRejectedPchDiag(tu)) {
+        clang_disposeTranslationUnit(tu);
+        tu = nullptr;
+        DiscardCorePch(corePch);
+
+        localArgs[arduinoIncludePos] = "-include";
+        localArgs[arduinoIncludePos + 1] = "Arduino.h";
+
+        err = clang_parseTranslationUnit2(
+            CurrentIndex(),
+            uf.mainFilename.c_str(),
+            localArgs.data(),
+            (int)localArgs.size(),
+            unsaved.empty() ? nullptr : unsaved.data(),
+            (int)unsaved.size(),
+            CXTranslationUnit_KeepGoing | CXTranslationUnit_PrecompiledPreamble | CXTranslationUnit_CreatePreambleOnFirstParse,
+            &tu);
+      }
+
       if ((err != CXError_Success || !tu) && tu) {
         // Some libclang builds may return a TU even when err != Success.
         APP_DEBUG_LOG("CC: project parse returned TU but err=%d (%s) -> continuing",
@@ -5029,7 +5917,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
             "Failed to parse translation unit (libclang error " +
             std::to_string(static_cast<int>(err)) + " / " + ClangErrorToString(err) + ")";
         e.severity = CXDiagnostic_Error;
-        allErrors.push_back(std::move(e));
+        fileErrors.push_back(std::move(e));
 
         APP_DEBUG_LOG("CC: [PROJ TU FAIL] %s: err=%d (%s) tu=%p",
                       uf.mainFilename.c_str(), (int)err, ClangErrorToString(err), (void *)tu);
@@ -5040,7 +5928,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
         entry.headersSigHash = headersSigHash;
         entry.argsHash = argsHash;
         entry.cachedErrors.clear();
-        continue;
+        return;
       }
 
       entry.tu = tu;
@@ -5048,12 +5936,13 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
       entry.codeHash = codeHash;
       entry.headersSigHash = headersSigHash;
       entry.argsHash = argsHash;
+      entry.addedLines = uf.hppAddedLines;
 
       // refresh cached diagnostics
       entry.cachedErrors = CollectDiagnosticsLocked(entry.tu);
     } else if (needReparse) {
       ClangUnsavedFiles uf;
-      CreateClangUnsavedFiles(f.filename, f.code, uf);
+      CreateClangUnsavedFiles(f.filename, f.Code(), uf);
 
       // unsaved = main file (+ .ino.hpp) + all open headers
       std::vector<CXUnsavedFile> unsaved;
@@ -5077,6 +5966,7 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
 
       entry.codeHash = codeHash;
       entry.headersSigHash = headersSigHash;
+      entry.addedLines = uf.hppAddedLines;
 
       // refresh cached diagnostics
       entry.cachedErrors = CollectDiagnosticsLocked(entry.tu);
@@ -5085,26 +5975,85 @@ std::vector<ArduinoParseError> ArduinoCodeCompletion::ComputeProjectDiagnosticsL
     }
 
     // Append cached errors (already filtered to sketch dir by CollectDiagnosticsLocked)
-    for (const auto &e : entry.cachedErrors) {
-      allErrors.push_back(e);
+    fileErrors.insert(fileErrors.end(), entry.cachedErrors.begin(), entry.cachedErrors.end());
+
+    // the TU is parsed anyway -> keep the xref index of this file fresh
+    if (entry.tu && xref) {
+      const std::size_t sig = XrefSignature(codeHash, xrefHeadersHash, xrefArgsHash);
+      if (!xref->IsUpToDate(key, sig)) {
+        XrefMap refs;
+        CollectXrefsInTU(entry.tu, entry.mainFilename, entry.addedLines, sketchDir, refs);
+        xref->UpdateFile(key, sig, std::move(refs));
+      }
+    }
+
+    if (onFileDone) {
+      onFileDone(key, fileErrors);
+    }
+  };
+
+  // thread count may have been changed in settings; we are the only user of the pool here
+  const unsigned desiredThreads = DesiredParseThreads();
+  if (!m_parsePool || m_parsePool->GetThreadCount() != desiredThreads) {
+    m_parsePool = std::make_unique<ArduinoThreadPool>(desiredThreads);
+    APP_DEBUG_LOG("CC: parse pool with %u workers", m_parsePool->GetThreadCount());
+  }
+
+  if (m_parsePool && fileJobs.size() > 1) {
+    std::vector<std::function<void()>> jobs;
+    jobs.reserve(fileJobs.size());
+    for (auto &job : fileJobs) {
+      jobs.push_back([&processFile, &job, this]() {
+        if (m_cancelAsync.load(std::memory_order_relaxed))
+          return;
+        processFile(job);
+      });
+    }
+    m_parsePool->RunAndWait(std::move(jobs));
+  } else {
+    for (auto &job : fileJobs) {
+      processFile(job);
+    }
+  }
+
+  for (auto &job : fileJobs) {
+    for (auto &e : job.errors) {
+      allErrors.push_back(std::move(e));
     }
   }
 
   // -----------------------------
   // Evict cached TUs that no longer exist in this snapshot
+  // (entries stay in the map, they own their locks)
   // -----------------------------
-  for (auto it = m_projectTuCache.begin(); it != m_projectTuCache.end();) {
-    if (keepKeys.find(it->first) == keepKeys.end()) {
-      if (it->second.tu) {
-        clang_disposeTranslationUnit(it->second.tu);
-        it->second.tu = nullptr;
+  std::vector<ProjectTuEntry *> staleEntries;
+  {
+    std::lock_guard<std::mutex> lk(m_projectTuCacheMutex);
+    for (auto &kv : m_projectTuCache) {
+      if (keepKeys.find(kv.first) == keepKeys.end()) {
+        staleEntries.push_back(&kv.second);
       }
-      it = m_projectTuCache.erase(it);
-    } else {
-      ++it;
     }
   }
 
+  if (xref && !m_cancelAsync.load(std::memory_order_relaxed)) {
+    std::unordered_set<std::string> sketchKeys;
+    for (const auto &f : files) {
+      sketchKeys.insert(AbsoluteFilename(f.filename));
+    }
+    xref->RetainFiles(sketchKeys);
+    xref->SaveIfDirty();
+  }
+
+  for (ProjectTuEntry *entry : staleEntries) {
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->tu) {
+      std::lock_guard<std::mutex> slk(m_symbolCacheMutex);
+      m_symbolCache.erase("project:" + entry->key);
+    }
+    ResetProjectTuEntry(*entry);
+  }
+
   // -----------------------------
   // Final sort + dedup (keeps hash stable and avoids header duplicates)
   // -----------------------------
@@ -5283,8 +6232,6 @@ bool ArduinoCodeCompletion::IsClangTargetSupported(const std::string &target) {
 }
 
 long ArduinoCodeCompletion::AutoDetectSerialBaudRate(const std::vector<SketchFileBuffer> &files) {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
-
   ScopeTimer t("CC: AutoDetectSerialBaudRate(%zu files)", files.size());
 
   if (!m_ready || files.empty())
@@ -5302,9 +6249,11 @@ long ArduinoCodeCompletion::AutoDetectSerialBaudRate(const std::vector<SketchFil
 
   CcFilesSnapshotGuard guard(&files);
 
+  auto lock = LockTranslationUnit(ino->filename);
+
   int addedLines = 0;
   std::string mainFile;
-  CXTranslationUnit tu = GetTranslationUnitNoReparse(ino->filename, ino->code, &addedLines, &mainFile);
+  CXTranslationUnit tu = GetTranslationUnitNoReparse(ino->filename, ino->Code(), &addedLines, &mainFile);
   if (!tu)
     return 0;
 
@@ -5344,40 +6293,74 @@ void ArduinoCodeCompletion::ApplySettings(const ClangSettings &settings) {
   m_clangSettings = settings;
 }
 
+unsigned ArduinoCodeCompletion::DesiredParseThreads() const {
+  if (m_clangSettings.projectDiagnosticsThreads > 0) {
+    return (unsigned)m_clangSettings.projectDiagnosticsThreads;
+  }
+  return ArduinoThreadPool::DefaultThreadCount();
+}
+
+CXIndex ArduinoCodeCompletion::CurrentIndex() const {
+  int worker = ArduinoThreadPool::CurrentWorkerIndex();
+  if (worker < 0) {
+    return index;
+  }
+
+  // Parallel parsing through one shared CXIndex serializes inside libclang,
+  // so every pool worker gets its own.
+  std::lock_guard<std::mutex> lk(m_workerIndexMutex);
+  if ((size_t)worker >= m_workerIndexes.size()) {
+    m_workerIndexes.resize((size_t)worker + 1, nullptr);
+  }
+  CXIndex &idx = m_workerIndexes[(size_t)worker];
+  if (!idx) {
+    idx = clang_createIndex(0, 0);
+  }
+  return idx;
+}
+
 ArduinoCodeCompletion::ArduinoCodeCompletion(ArduinoCli *ardCli, const ClangSettings &clangSettings, CollectSketchFilesFn collectSketchFilesFn)
     : arduinoCli(ardCli), m_clangSettings(clangSettings), m_collectSketchFilesFn(std::move(collectSketchFilesFn)) {
   index = clang_createIndex(0, 0);
 
+  m_pchDir = GetAppCacheDir("pch");
+  if (!m_pchDir.empty()) {
+    ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [pchDir = m_pchDir]() {
+      EvictCorePchFiles(pchDir);
+    });
+  }
+
+  m_parsePool = std::make_unique<ArduinoThreadPool>(DesiredParseThreads());
+  APP_DEBUG_LOG("CC: parse pool with %u workers", m_parsePool->GetThreadCount());
+
   CXString v = clang_getClangVersion();
   APP_DEBUG_LOG("CC: libclang version: %s", clang_getCString(v));
   clang_disposeString(v);
 }
 
 ArduinoCodeCompletion::~ArduinoCodeCompletion() {
-  std::lock_guard<std::mutex> lock(m_ccMutex);
+  m_cancelAsync.store(true, std::memory_order_relaxed);
 
-  for (auto &kv : m_tuCache) {
-    if (kv.second.tu) {
-      clang_disposeTranslationUnit(kv.second.tu);
-      kv.second.tu = nullptr;
-    }
-  }
-  m_tuCache.clear();
+  // finish queued parse jobs before TUs go away
+  m_parsePool.reset();
 
-  for (auto &kv : m_projectTuCache) {
-    if (kv.second.tu) {
-      clang_disposeTranslationUnit(kv.second.tu);
-      kv.second.tu = nullptr;
-    }
-  }
+  InvalidateTranslationUnit();
+
+  std::lock_guard<std::mutex> lk(m_tuCacheMutex);
+  std::lock_guard<std::mutex> plk(m_projectTuCacheMutex);
+  m_tuCache.clear();
   m_projectTuCache.clear();
 
-  for (auto &kv : m_siblingTuCache) {
-    if (kv.second) {
-      clang_disposeTranslationUnit(kv.second);
+  // TUs are gone, now the indexes they were created from can follow
+  {
+    std::lock_guard<std::mutex> ilk(m_workerIndexMutex);
+    for (CXIndex idx : m_workerIndexes) {
+      if (idx) {
+        clang_disposeIndex(idx);
+      }
     }
+    m_workerIndexes.clear();
   }
-  m_siblingTuCache.clear();
 
   clang_disposeIndex(index);
 }
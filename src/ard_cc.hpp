@@ -21,13 +21,17 @@
 #include "ard_cli.hpp"
 #include "ard_ev.hpp"
 #include "ard_setdlg.hpp"
+#include "ard_tpool.hpp"
 #include "utils.hpp"
 #include <atomic>
 #include <chrono>
 #include <clang-c/Index.h>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <wx/rawbmp.h>
 #include <wx/stc/stc.h>
@@ -121,7 +125,7 @@ struct ClangUnsavedFiles {
   int hppAddedLines = 0; // added lines due to includes manipulation
 
   std::string mainFilename;
-  std::string mainCode;
+  std::string mainCode; // rewritten .ino only, other files point into the caller's code
   std::string hppFilename;
   std::string hppCode;
 };
@@ -132,6 +136,10 @@ struct CachedTranslationUnit {
   std::size_t codeHash = 0; // FNV-1a hash of the original code
   int addedLines = 0;       // line shift due to inserted .hpp
   CXTranslationUnit tu = nullptr;
+
+  // Guards this entry (and libclang calls on tu). Entries are never erased
+  // from the cache, only reset, so the lock outlives any TU it protects.
+  mutable std::mutex mutex;
 };
 
 struct ProjectTuEntry {
@@ -140,19 +148,39 @@ struct ProjectTuEntry {
   std::size_t codeHash = 0;
   std::size_t headersSigHash = 0; // hash of opened headers (unsaved)
   std::size_t argsHash = 0;       // hash clang args (+ file-specific extras)
+  int addedLines = 0;             // line shift due to inserted .hpp
   CXTranslationUnit tu = nullptr;
 
   // Diagnostics filtered/sorted (CollectDiagnosticsLocked)
   std::vector<ArduinoParseError> cachedErrors;
+
+  // Same rules as CachedTranslationUnit::mutex
+  mutable std::mutex mutex;
 };
 
+// Symbols below one top-level cursor of a TU (unit of incremental re-walk)
+struct SymbolBlock {
+  std::string file; // clang filename of the cursor
+  unsigned lineFrom = 0, colFrom = 0;
+  unsigned lineTo = 0, colTo = 0; // extent in clang coordinates
+  std::vector<SymbolInfo> symbols;
+};
+
+// Incremental symbol index of one TU. After reparse only top-level cursors whose
+// extent touches the changed lines of the main file (or which come from another
+// file with changed content) are walked again, the rest is reused.
 struct SymbolCacheEntry {
   std::string filename;     // absolute filename
   std::size_t codeHash = 0; // hash of the code when the symbols were counted
-  std::vector<SymbolInfo> symbols;
 
-  // when we last recalculated the symbols
-  std::chrono::steady_clock::time_point lastUpdated{};
+  std::string mainFile;        // clang main filename
+  std::string mainContent;     // its content the blocks were collected from
+  int addedLines = 0;          // .ino line shift used for symbols
+  std::unordered_map<std::string, uint64_t> fileHashes; // other files -> content hash
+  std::vector<SymbolBlock> blocks;                      // in TU order
+
+  std::vector<SymbolInfo> symbols;                                  // all blocks, sorted
+  std::unordered_map<std::string, std::vector<std::size_t>> byUsr; // usr -> indexes into symbols
 };
 
 struct InoHeaderCacheEntry {
@@ -165,7 +193,7 @@ struct CompletionSessionCache {
   std::string filename;                  // absolute filename
   int wordStart = -1;                    // position of the start of the word in the editor
   std::string basePrefix;                // prefix at the moment when we first called clang
-  std::vector<CompletionItem> baseItems; // completions after marking fromSketch, but before the prefix filter
+  std::shared_ptr<const std::vector<CompletionItem>> baseItems; // completions after marking fromSketch, but before the prefix filter
 };
 
 struct AeContainerInfo {
@@ -192,6 +220,9 @@ struct IncludeUsage {
 };
 
 using CollectSketchFilesFn = std::function<void(std::vector<SketchFileBuffer> &)>;
+using TextSnapshotFn = std::function<std::shared_ptr<const std::string>()>;
+
+class ArduinoXrefIndex;
 
 class ArduinoCodeCompletion {
 private:
@@ -204,14 +235,69 @@ private:
   ClangSettings m_clangSettings;
 
   CompletionMetadata m_completionMetadata;
+
+  // Locking model: each TU entry carries its own mutex which is held for the
+  // whole libclang operation on it. The *CacheMutex members below only guard the
+  // map structures and are held briefly; never wait for an entry lock while
+  // holding one of them.
+
   // Cache TU according to the "main" clang filename (.ino.cpp, .cpp, ...)
+  mutable std::mutex m_tuCacheMutex;
   std::unordered_map<std::string, CachedTranslationUnit> m_tuCache;
+  std::atomic<int> m_liveTuCount{0};
   // .. and for whole project
+  mutable std::mutex m_projectTuCacheMutex;
   std::unordered_map<std::string, ProjectTuEntry> m_projectTuCache;
-  // cache for sibling definitions
+  // serializes whole project diagnostics passes (they run in the background)
+  std::mutex m_projectDiagMutex;
+  // workers for parsing independent project TUs in parallel
+  std::unique_ptr<ArduinoThreadPool> m_parsePool;
+  // one CXIndex per pool worker (created lazily, disposed after all TUs in the destructor)
+  mutable std::mutex m_workerIndexMutex;
+  mutable std::vector<CXIndex> m_workerIndexes;
+
+  // cache for sibling definitions (held for the whole sibling lookup)
+  std::mutex m_siblingTuMutex;
   std::unordered_map<std::string, CXTranslationUnit> m_siblingTuCache;
 
-  std::unordered_map<std::string, SymbolCacheEntry> m_symbolCache;
+  // symbol index; entries are immutable once published, updates replace them
+  std::mutex m_symbolCacheMutex;
+  std::unordered_map<std::string, std::shared_ptr<const SymbolCacheEntry>> m_symbolCache;
+
+  // persistent USR -> occurrences index of the current sketch (loaded lazily)
+  std::mutex m_xrefMutex;
+  std::shared_ptr<ArduinoXrefIndex> m_xref;
+
+  std::shared_ptr<ArduinoXrefIndex> GetXrefIndex();
+  static std::size_t XrefArgsHash(const std::vector<std::string> &clangArgs);
+  // order independent mix of all sketch headers, computed once per request
+  static std::size_t XrefHeadersHash(const std::vector<SketchFileBuffer> &files);
+  // code of the file + all sketch headers + compiler args - xrefs of a TU depend on all of them
+  static std::size_t XrefSignature(std::size_t codeHash, std::size_t headersHash, std::size_t argsHash);
+
+  // Expects the lock of tu's cache entry to be held.
+  std::shared_ptr<const SymbolCacheEntry> UpdateSymbolIndex(const std::string &cacheKey, std::size_t codeHash,
+                                                            CXTranslationUnit tu, const std::string &mainFile, int addedLines);
+
+  // On-disk PCH of the core headers (what "-include Arduino.h" pulls in). It is keyed
+  // by the core part of compiler args, so it survives restarts and is shared by all
+  // sketches for the same board.
+  std::string m_pchDir;
+  std::mutex m_corePchMutex;
+  std::size_t m_corePchKey = 0;
+  std::string m_corePchPath; // empty -> no usable PCH for m_corePchKey
+
+  std::string GetCorePch(const std::vector<std::string> &clangArgs);
+  bool BuildCorePch(const std::vector<std::string> &pchArgs, const std::string &pchPath);
+  void DiscardCorePch(const std::string &pchPath);
+  // removes the PCH with its prelude, "used" stamp and "rejected" marker
+  static void RemoveCorePchFiles(const std::string &pchPath);
+  // drops PCHs (and leftovers) not used for a while, every key/core version leaves one behind
+  static void EvictCorePchFiles(const std::string &pchDir);
+  static void AppendArduinoInclude(std::vector<const char *> &args, const std::string &corePch);
+
+  // guards m_inoHeaderCache + m_inoInsertCache
+  mutable std::mutex m_inoCacheMutex;
   std::unordered_map<uint64_t, InoHeaderCacheEntry> m_inoHeaderCache;
   // cache: decls signature -> insertIdx for "#include <sketch>.hpp" replacement
   mutable std::unordered_map<uint64_t, std::size_t> m_inoInsertCache;
@@ -220,7 +306,6 @@ private:
   mutable std::mutex m_resolvedIncludesCacheMutex;
   mutable std::unordered_map<uint64_t, std::vector<std::string>> m_resolvedIncludesCache;
 
-  mutable std::mutex m_ccMutex;   // protection TU/libclang
   std::atomic<uint64_t> m_seq{0}; // sequential request counter
 
   // Completion session machinery
@@ -240,7 +325,15 @@ private:
   // FNV-1a hash of text (fast "CRC")
   static std::size_t HashCode(const std::string &code);
 
-  // Internal helper - must be called under m_ccMutex!
+  // Locks the cache entry of the given file (creating an empty one if needed).
+  // All libclang work on the interactive TU of that file must happen under it.
+  std::unique_lock<std::mutex> LockTranslationUnit(const std::string &filename);
+  CachedTranslationUnit &GetTuEntry(const std::string &key);
+  // Dispose the TU of an entry and clear its hashes (entry lock must be held).
+  void ResetTuEntry(CachedTranslationUnit &entry);
+  void ResetProjectTuEntry(ProjectTuEntry &entry);
+
+  // Internal helper - must be called under LockTranslationUnit(filename)!
   // Returns the TU for the given file + optionally the offset of added lines (.ino -> .ino.cpp)
   // and mainFilename under which the TU is in the cache.
   CXTranslationUnit GetTranslationUnit(const std::string &filename,
@@ -265,11 +358,23 @@ private:
 
   bool FindSiblingFunctionDefinition(CXCursor declCursor, JumpTarget &out);
 
-  std::vector<ArduinoParseError> ComputeProjectDiagnosticsLocked(const std::vector<SketchFileBuffer> &files);
+  // must be called under LockTranslationUnit()
+  bool FillHoverInfo(CXTranslationUnit tu, CXCursor cursor, CXCursor target, std::unordered_map<std::string, std::string> &fileTexts, HoverInfo &outInfo);
+
+  // called from parse workers as soon as diagnostics of one file are known
+  using ProjectFileDiagnosticsFn = std::function<void(const std::string &key, const std::vector<ArduinoParseError> &errors)>;
+
+  std::vector<ArduinoParseError> ComputeProjectDiagnosticsLocked(const std::vector<SketchFileBuffer> &files,
+                                                                 const ProjectFileDiagnosticsFn &onFileDone = nullptr);
+
+  // index for the calling thread - per worker index on parse pool threads, shared one otherwise
+  CXIndex CurrentIndex() const;
+  unsigned DesiredParseThreads() const;
 
   void QueueUiEvent(const wxWeakRef<wxEvtHandler> &weak, wxEvent *event);
 
-  void FilterAndSortCompletionsWithPrefix(const std::string &prefix, std::vector<CompletionItem> &inOutCompletions);
+  // Fuzzy-filters completions by prefix into out (best first, overloads grouped, capped)
+  void FilterAndSortCompletionsWithPrefix(const std::string &prefix, const std::vector<CompletionItem> &completions, std::vector<CompletionItem> &out);
 
   std::vector<std::string> GetCompilerArgs(const std::vector<SketchFileBuffer> &files) const;
   std::vector<std::string> GetCompilerArgs() const;
@@ -299,15 +404,22 @@ public:
 
   static std::string GetKindSpelling(CXCursorKind kind);
 
-  void ShowAutoCompletionAsync(wxStyledTextCtrl *editor, std::string filename, CompletionMetadata &metadata, wxEvtHandler *handler);
+  // textSnapshot is only asked for when the session cache cannot answer
+  void ShowAutoCompletionAsync(wxStyledTextCtrl *editor, std::string filename, const TextSnapshotFn &textSnapshot, CompletionMetadata &metadata, wxEvtHandler *handler);
 
   bool GetHoverInfo(const std::string &filename, const std::string &code, int line, int column, HoverInfo &outInfo);
   bool GetHoverInfo(const std::string &filename, const std::string &code, int line, int column, const std::vector<SketchFileBuffer> files, HoverInfo &outInfo);
+  // usr -> hover info for symbols declared in filename, one TU walk for all of them
+  std::unordered_map<std::string, HoverInfo> GetHoverInfoBatch(const std::string &filename, const std::string &code, const std::unordered_set<std::string> &usrs, const std::vector<SketchFileBuffer> &files);
 
   bool GetSymbolInfo(const std::string &filename, const std::string &code, int line, int column, SymbolInfo &outInfo);
   bool FindDefinition(const std::string &filename, const std::string &code, int line, int column, JumpTarget &out);
   std::vector<SymbolInfo> GetAllSymbols(const std::string &filename, const std::string &code);
   std::vector<SymbolInfo> GetAllSymbols();
+  // All indexed declarations/definitions of the symbol (from already indexed TUs only).
+  std::vector<SymbolInfo> FindSymbolsByUsr(const std::string &usr);
+  // Indexed definition of a symbol which is only declared at decl (prototype, method in a class body).
+  bool FindIndexedDefinition(const SymbolInfo &decl, SymbolInfo &out);
 
   bool FindSymbolOccurrences(const std::string &filename, const std::string &code, int line, int column, bool onlyFromSketch, std::vector<JumpTarget> &outTargets);
   void FindSymbolOccurrencesAsync(const std::string &filename,
@@ -164,6 +164,7 @@ void ArduinoClassBrowserPanel::Clear() {
   m_currentFile.clear();
   m_symbols.clear();
   m_itemByIndex.clear();
+  m_nodes.clear();
 
   m_tooltipByIndex.clear();
   m_lastTipItem = wxTreeItemId();
@@ -443,417 +444,268 @@ void ArduinoClassBrowserPanel::RebuildTree() {
     }
   };
 
-  // -----------------------------------------
-  // Full rebuild (if needed)
-  // -----------------------------------------
-  auto doFullRebuild = [&]() {
-    m_tree->Freeze();
-    m_tree->DeleteAllItems();
-
-    wxTreeItemId root = m_tree->AddRoot(wxT("root"));
-
-    m_itemByIndex.assign(m_symbols.size(), wxTreeItemId());
-    m_tooltipByIndex.assign(m_symbols.size(), std::string());
-    m_lastTipItem = wxTreeItemId();
-    m_tree->SetToolTip((wxToolTip *)nullptr);
-
-    const int n = (int)m_symbols.size();
-
-    std::vector<int> parentIdx;
-    computeParentIdx(parentIdx);
-
-    std::vector<wxTreeItemId> itemByIndex(n, wxTreeItemId());
-
-    for (int i = 0; i < n; i++) {
-      const auto &s = m_symbols[i];
-      if (s.kind == CXCursor_ParmDecl)
-        continue;
-
-      wxTreeItemId parentItem = root;
-      int p = parentIdx[i];
-      if (p >= 0 && p < n && itemByIndex[p].IsOk())
-        parentItem = itemByIndex[p];
-
-      wxString label = MakeBaseLabel(s);
-
-      // hover cache enrichment
-      HoverCacheEntry cached;
-      bool hasCached = false;
-      const std::string key = getKey(s);
-      if (!key.empty()) {
-        std::lock_guard<std::mutex> lk(m_hoverCacheMutex);
-        auto it = m_hoverCache.find(key);
-        if (it != m_hoverCache.end()) {
-          cached = it->second;
-          hasCached = true;
-        }
-      }
-
-      if (hasCached) {
-        wxString enriched = MakeLabelFromHover(s, cached.info);
-        if (!enriched.empty())
-          label = enriched;
-
-        if (!cached.tooltip.empty())
-          m_tooltipByIndex[i] = cached.tooltip;
-      }
-
-      const int img = imgFor(s);
-      wxTreeItemId item = m_tree->AppendItem(
-          parentItem,
-          label,
-          img,
-          img,
-          new ItemData(i, getKey(s), s.line, s.column));
-
-      itemByIndex[i] = item;
-      m_itemByIndex[i] = item;
-    }
-
-    m_tree->Expand(root);
-    m_tree->Thaw();
-  };
+  const int n = (int)m_symbols.size();
 
-  if (m_forceFullRebuildNext) {
-    m_forceFullRebuildNext = false;
-    doFullRebuild();
-    return;
-  }
+  std::vector<int> parentIdx;
+  computeParentIdx(parentIdx);
 
   // -----------------------------------------
-  // Diff rebuild
+  // 1) Node keys: symbol key + key of its scope. A symbol moved to another
+  //    scope is a different node; repeated keys (prototype + definition...)
+  //    get an ordinal in position order.
   // -----------------------------------------
-
-  wxTreeItemId root = m_tree->GetRootItem();
-  if (!root.IsOk()) {
-    doFullRebuild();
-    return;
-  }
-
-  // 1) remember expanded nodes
-  std::unordered_set<std::string> expandedKeys;
-  std::string selectedKey;
-
+  std::vector<std::string> nodeKeys(n);
+  std::vector<int> depth(n, -1); // -1 = not resolved yet, -2 = in progress
   {
-    wxTreeItemId sel = m_tree->GetSelection();
-    if (sel.IsOk()) {
-      if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(sel))) {
-        selectedKey = d->usr;
-      }
-    }
+    std::unordered_map<std::string, int> repeats;
+    repeats.reserve((size_t)n * 2);
 
-    auto collectExpanded = [&](auto &&self, const wxTreeItemId &item) -> void {
-      if (!item.IsOk())
+    auto resolve = [&](auto &&self, int i) -> void {
+      if (depth[i] != -1)
         return;
-
-      if (item != root && m_tree->IsExpanded(item)) {
-        if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(item))) {
-          if (!d->usr.empty())
-            expandedKeys.insert(d->usr);
+      depth[i] = -2;
+
+      std::string key = getKey(m_symbols[i]);
+      int d = 0;
+
+      const int p = parentIdx[i];
+      if (p >= 0 && p < n) {
+        self(self, p);
+        if (depth[p] >= 0) { // not a cycle
+          key.push_back('\x1f');
+          key.append(nodeKeys[p]);
+          d = depth[p] + 1;
+        } else {
+          parentIdx[i] = -1;
         }
       }
 
-      wxTreeItemIdValue cookie;
-      wxTreeItemId child = m_tree->GetFirstChild(item, cookie);
-      while (child.IsOk()) {
-        self(self, child);
-        child = m_tree->GetNextChild(item, cookie);
+      const int nth = ++repeats[key];
+      if (nth > 1) {
+        key.push_back('#');
+        key.append(std::to_string(nth));
       }
+
+      nodeKeys[i] = std::move(key);
+      depth[i] = d;
     };
 
-    collectExpanded(collectExpanded, root);
+    for (int i = 0; i < n; i++) {
+      if (m_symbols[i].kind != CXCursor_ParmDecl)
+        resolve(resolve, i);
+    }
   }
 
-  // 2) calculate parent for new symbols
-  std::vector<int> parentIdx;
-  computeParentIdx(parentIdx);
-
-  // 3) prepare keys
-  const int n = (int)m_symbols.size();
-  std::unordered_set<std::string> keepKeys;
-  keepKeys.reserve((size_t)n * 2);
-
+  // parents first, siblings in position order
+  std::vector<int> order;
+  order.reserve(n);
   for (int i = 0; i < n; i++) {
-    const auto &s = m_symbols[i];
-    if (s.kind == CXCursor_ParmDecl)
-      continue;
-    keepKeys.insert(getKey(s));
+    if (depth[i] >= 0)
+      order.push_back(i);
   }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return depth[a] < depth[b]; });
 
-  // 4) prune
-  m_tree->Freeze();
-
-  m_itemByIndex.assign(m_symbols.size(), wxTreeItemId());
-  m_tooltipByIndex.assign(m_symbols.size(), std::string());
-  m_lastTipItem = wxTreeItemId();
-  m_tree->SetToolTip((wxToolTip *)nullptr);
-
+  // -----------------------------------------
+  // 2) Labels + tooltips (one pass over the hover cache)
+  // -----------------------------------------
+  std::vector<wxString> labels(n);
+  m_tooltipByIndex.assign(n, std::string());
   {
-    auto prune = [&](auto &&self, const wxTreeItemId &item) -> void {
-      if (!item.IsOk())
-        return;
-
-      // children first (post-order)
-      std::vector<wxTreeItemId> kids;
-      kids.reserve(16);
+    std::lock_guard<std::mutex> lk(m_hoverCacheMutex);
+    for (int i : order) {
+      const auto &s = m_symbols[i];
+      labels[i] = MakeBaseLabel(s);
 
-      wxTreeItemIdValue cookie;
-      wxTreeItemId child = m_tree->GetFirstChild(item, cookie);
-      while (child.IsOk()) {
-        kids.push_back(child);
-        child = m_tree->GetNextChild(item, cookie);
+      auto it = m_hoverCache.find(getKey(s));
+      if (it != m_hoverCache.end()) {
+        wxString enriched = MakeLabelFromHover(s, it->second.info);
+        if (!enriched.empty())
+          labels[i] = enriched;
+        m_tooltipByIndex[i] = it->second.tooltip;
       }
+    }
+  }
 
-      for (auto &c : kids)
-        self(self, c);
-
-      if (item == root)
-        return;
-
-      auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(item));
-      if (!d)
-        return;
-
-      if (!d->usr.empty() && keepKeys.find(d->usr) == keepKeys.end()) {
-        m_tree->Delete(item);
-      }
-    };
+  m_itemByIndex.assign(n, wxTreeItemId());
+  m_lastTipItem = wxTreeItemId();
+  m_tree->SetToolTip((wxToolTip *)nullptr);
 
-    prune(prune, root);
+  std::unordered_set<std::string> newKeys;
+  newKeys.reserve((size_t)n * 2);
+  for (int i : order) {
+    newKeys.insert(nodeKeys[i]);
   }
 
-  // 5) map of existing items by USR
-  std::unordered_map<std::string, wxTreeItemId> itemByKey;
-  itemByKey.reserve(keepKeys.size() * 2);
-
-  {
-    auto indexExisting = [&](auto &&self, const wxTreeItemId &item) -> void {
-      if (!item.IsOk())
-        return;
+  // -----------------------------------------
+  // 3) Existing siblings keep their relative order in the tree. If the edit
+  //    reordered some of them (moved function...), start from scratch but
+  //    remember what was expanded.
+  // -----------------------------------------
+  bool fullRebuild = m_forceFullRebuildNext || !m_tree->GetRootItem().IsOk();
+  if (!fullRebuild) {
+    std::unordered_map<std::string, std::pair<int, int>> lastOldPos; // parent key -> old position
+    for (int i : order) {
+      auto it = m_nodes.find(nodeKeys[i]);
+      if (it == m_nodes.end())
+        continue;
 
-      if (item != root) {
-        if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(item))) {
-          if (!d->usr.empty())
-            itemByKey[d->usr] = item;
+      const TreeNode &node = it->second;
+      auto ins = lastOldPos.emplace(node.parentKey, std::make_pair(node.line, node.col));
+      if (!ins.second) {
+        if (posLess(node.line, node.col, ins.first->second.first, ins.first->second.second)) {
+          fullRebuild = true;
+          break;
         }
+        ins.first->second = {node.line, node.col};
       }
-
-      wxTreeItemIdValue cookie;
-      wxTreeItemId child = m_tree->GetFirstChild(item, cookie);
-      while (child.IsOk()) {
-        self(self, child);
-        child = m_tree->GetNextChild(item, cookie);
-      }
-    };
-
-    indexExisting(indexExisting, root);
+    }
   }
 
-  auto getParentItem = [&](int idx) -> wxTreeItemId {
-    int p = parentIdx[idx];
-    if (p < 0 || p >= n)
-      return root;
-
-    const std::string pk = getKey(m_symbols[p]);
-    auto it = itemByKey.find(pk);
-    if (it != itemByKey.end() && it->second.IsOk())
-      return it->second;
-
-    return root;
-  };
-
-  auto computeLabelAndTooltip = [&](int i, wxString &outLabel, std::string &outTooltip) {
-    const auto &s = m_symbols[i];
-
-    outLabel = MakeBaseLabel(s);
-    outTooltip.clear();
+  m_tree->Freeze();
 
-    const std::string key = getKey(s);
-    if (!key.empty()) {
-      HoverCacheEntry cached;
-      bool hasCached = false;
+  std::unordered_set<std::string> expandedKeys;
+  std::string selectedKey;
+  wxTreeItemId root = m_tree->GetRootItem();
 
-      {
-        std::lock_guard<std::mutex> lk(m_hoverCacheMutex);
-        auto it = m_hoverCache.find(key);
-        if (it != m_hoverCache.end()) {
-          cached = it->second;
-          hasCached = true;
-        }
+  if (fullRebuild) {
+    if (!m_forceFullRebuildNext) {
+      for (const auto &kv : m_nodes) {
+        if (kv.second.item.IsOk() && m_tree->IsExpanded(kv.second.item))
+          expandedKeys.insert(kv.first);
       }
 
-      if (hasCached) {
-        wxString enriched = MakeLabelFromHover(s, cached.info);
-        if (!enriched.empty())
-          outLabel = enriched;
-        outTooltip = cached.tooltip;
+      wxTreeItemId sel = m_tree->GetSelection();
+      if (sel.IsOk()) {
+        if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(sel)))
+          selectedKey = d->key;
       }
     }
-  };
-
-  // 6) create/update items for all symbols
-  for (int i = 0; i < n; i++) {
-    const auto &s = m_symbols[i];
-    if (s.kind == CXCursor_ParmDecl)
-      continue;
-
-    const std::string key = getKey(s);
-    wxTreeItemId parentItem = getParentItem(i);
-
-    wxString label;
-    std::string tooltip;
-    computeLabelAndTooltip(i, label, tooltip);
-    if (!tooltip.empty())
-      m_tooltipByIndex[i] = tooltip;
+    m_forceFullRebuildNext = false;
 
-    const int img = imgFor(s);
+    m_nodes.clear();
+    m_tree->DeleteAllItems();
+    root = m_tree->AddRoot(wxT("root"));
+  } else {
+    // -----------------------------------------
+    // 4) Removals - only the topmost removed node, its subtree goes with it
+    // -----------------------------------------
+    for (auto it = m_nodes.begin(); it != m_nodes.end();) {
+      if (newKeys.count(it->first) > 0) {
+        ++it;
+        continue;
+      }
 
-    wxTreeItemId item;
-    auto it = itemByKey.find(key);
-    if (it != itemByKey.end())
-      item = it->second;
-
-    // exists, but is under a different parent? -> delete + recreate
-    if (item.IsOk()) {
-      wxTreeItemId curParent = m_tree->GetItemParent(item);
-      if (curParent.IsOk() && curParent != parentItem) {
-        m_tree->Delete(item);
-        item = wxTreeItemId();
-        itemByKey.erase(key);
+      const std::string &pk = it->second.parentKey;
+      if ((pk.empty() || newKeys.count(pk) > 0) && it->second.item.IsOk()) {
+        m_tree->Delete(it->second.item);
       }
+      it = m_nodes.erase(it);
     }
 
-    if (!item.IsOk()) {
-      wxTreeItemId before = findInsertBefore(parentItem, s.line, s.column);
+    // -----------------------------------------
+    // 5) Updates of the kept nodes (before inserting, positions are compared)
+    // -----------------------------------------
+    for (int i : order) {
+      auto it = m_nodes.find(nodeKeys[i]);
+      if (it == m_nodes.end())
+        continue;
 
-      if (before.IsOk()) {
-        item = m_tree->InsertItem(
-            parentItem, before, label, img, img,
-            new ItemData(i, key, s.line, s.column));
-      } else {
-        item = m_tree->AppendItem(
-            parentItem, label, img, img,
-            new ItemData(i, key, s.line, s.column));
-      }
+      const auto &s = m_symbols[i];
+      TreeNode &node = it->second;
 
-      itemByKey[key] = item;
-    } else {
-      // update text
-      wxString old = m_tree->GetItemText(item);
-      if (old != label)
-        m_tree->SetItemText(item, label);
+      if (node.label != labels[i]) {
+        m_tree->SetItemText(node.item, labels[i]);
+        node.label = labels[i];
+      }
 
-      // update image
-      m_tree->SetItemImage(item, img, wxTreeItemIcon_Normal);
-      m_tree->SetItemImage(item, img, wxTreeItemIcon_Selected);
+      const int img = imgFor(s);
+      if (node.image != img) {
+        m_tree->SetItemImage(node.item, img, wxTreeItemIcon_Normal);
+        m_tree->SetItemImage(node.item, img, wxTreeItemIcon_Selected);
+        node.image = img;
+      }
 
-      // update data
-      if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(item))) {
+      node.line = s.line;
+      node.col = s.column;
+      if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(node.item))) {
         d->index = i;
         d->sortLine = s.line;
         d->sortCol = s.column;
-        d->usr = key;
-      } else {
-        m_tree->SetItemData(item, new ItemData(i, key, s.line, s.column));
       }
-    }
 
-    m_itemByIndex[i] = item;
+      m_itemByIndex[i] = node.item;
+    }
   }
 
-  // 6.5) if order changed (moved existing symbols), do full rebuild instead of moving nodes
-  auto dataLess = [](const ItemData *a, const ItemData *b) -> bool {
-    if (a->sortLine != b->sortLine)
-      return a->sortLine < b->sortLine;
-    if (a->sortCol != b->sortCol)
-      return a->sortCol < b->sortCol;
-    return a->usr < b->usr; // tie-breaker for stability
-  };
-
-  auto isTreeSorted = [&](auto &&self, const wxTreeItemId &parent) -> bool {
-    ItemData *prev = nullptr;
-
-    wxTreeItemIdValue cookie;
-    wxTreeItemId child = m_tree->GetFirstChild(parent, cookie);
+  // -----------------------------------------
+  // 6) Inserts
+  // -----------------------------------------
+  std::unordered_set<std::string> freshParents; // created now, children can simply be appended
+  size_t inserted = 0;
 
-    while (child.IsOk()) {
-      auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(child));
-      if (!d || d->usr.empty()) {
-        return false; // unexpected => force rebuild
-      }
+  for (int i : order) {
+    const std::string &key = nodeKeys[i];
+    if (m_itemByIndex[i].IsOk())
+      continue; // kept
 
-      if (prev && dataLess(d, prev)) {
-        return false; // inversion => ordering changed
-      }
-      prev = d;
+    const auto &s = m_symbols[i];
 
-      if (!self(self, child)) {
-        return false;
-      }
+    std::string parentKey;
+    wxTreeItemId parentItem = root;
+    bool appendOnly = fullRebuild;
 
-      child = m_tree->GetNextChild(parent, cookie);
+    const int p = parentIdx[i];
+    if (p >= 0 && p < n && m_itemByIndex[p].IsOk()) {
+      parentKey = nodeKeys[p];
+      parentItem = m_itemByIndex[p];
+      appendOnly = fullRebuild || freshParents.count(parentKey) > 0;
     }
 
-    return true;
-  };
-
-  if (!isTreeSorted(isTreeSorted, root)) {
-    // We are inside Freeze() right now; thaw first, then do a clean rebuild.
-    m_tree->Thaw();
-
-    m_forceFullRebuildNext = false;
-    doFullRebuild();
+    const int img = imgFor(s);
+    auto *data = new ItemData(i, key, s.line, s.column);
+
+    wxTreeItemId before = appendOnly ? wxTreeItemId() : findInsertBefore(parentItem, s.line, s.column);
+    wxTreeItemId item = before.IsOk()
+                            ? m_tree->InsertItem(parentItem, before, labels[i], img, img, data)
+                            : m_tree->AppendItem(parentItem, labels[i], img, img, data);
+
+    TreeNode node;
+    node.item = item;
+    node.parentKey = std::move(parentKey);
+    node.line = s.line;
+    node.col = s.column;
+    node.image = img;
+    node.label = labels[i];
+    m_nodes[key] = std::move(node);
+
+    freshParents.insert(key);
+    m_itemByIndex[i] = item;
+    ++inserted;
+  }
 
-    // restore expansion + selection after full rebuild
-    std::unordered_map<std::string, wxTreeItemId> rebuiltByKey;
-    rebuiltByKey.reserve((size_t)n * 2);
-    for (int i = 0; i < n; i++) {
-      if (m_symbols[i].kind == CXCursor_ParmDecl)
-        continue;
-      wxTreeItemId it = (i < (int)m_itemByIndex.size()) ? m_itemByIndex[i] : wxTreeItemId();
-      if (it.IsOk())
-        rebuiltByKey[getKey(m_symbols[i])] = it;
-    }
+  if (fullRebuild) {
+    m_tree->Expand(root);
 
     for (const auto &k : expandedKeys) {
-      auto it = rebuiltByKey.find(k);
-      if (it != rebuiltByKey.end() && it->second.IsOk())
-        m_tree->Expand(it->second);
+      auto it = m_nodes.find(k);
+      if (it != m_nodes.end() && it->second.item.IsOk())
+        m_tree->Expand(it->second.item);
     }
 
     if (!selectedKey.empty()) {
-      auto it = rebuiltByKey.find(selectedKey);
-      if (it != rebuiltByKey.end() && it->second.IsOk()) {
+      auto it = m_nodes.find(selectedKey);
+      if (it != m_nodes.end() && it->second.item.IsOk()) {
         m_internalSelect = true;
-        m_tree->SelectItem(it->second);
-        m_tree->EnsureVisible(it->second);
+        m_tree->SelectItem(it->second.item);
+        m_tree->EnsureVisible(it->second.item);
         m_internalSelect = false;
       }
     }
-
-    return;
-  }
-
-  // 7) refresh expanded items
-  for (const auto &k : expandedKeys) {
-    auto it = itemByKey.find(k);
-    if (it != itemByKey.end() && it->second.IsOk()) {
-      m_tree->Expand(it->second);
-    }
-  }
-
-  // 8) refresh selection
-  if (!selectedKey.empty()) {
-    auto it = itemByKey.find(selectedKey);
-    if (it != itemByKey.end() && it->second.IsOk()) {
-      m_internalSelect = true;
-      m_tree->SelectItem(it->second);
-      m_tree->EnsureVisible(it->second);
-      m_internalSelect = false;
-    }
   }
 
   m_tree->Thaw();
+
+  APP_DEBUG_LOG("CB: RebuildTree() %s, %zu nodes, %zu inserted", fullRebuild ? "full" : "diff", m_nodes.size(), inserted);
 }
 
 wxString ArduinoClassBrowserPanel::MakeBaseLabel(const SymbolInfo &s) const {
@@ -940,6 +792,13 @@ void ArduinoClassBrowserPanel::ApplyHoverInfo(uint64_t gen, int symbolIndex, con
     if (old != newLabel) {
       m_tree->SetItemText(item, newLabel);
     }
+
+    // keep the node model in sync, the next rebuild compares against it
+    if (auto *d = dynamic_cast<ItemData *>(m_tree->GetItemData(item))) {
+      auto it = m_nodes.find(d->key);
+      if (it != m_nodes.end())
+        it->second.label = newLabel;
+    }
   }
 }
 
@@ -954,7 +813,7 @@ void ArduinoClassBrowserPanel::StartHoverWorker(uint64_t gen, std::string file,
   m_worker = std::thread([this, gen, file = std::move(file), code = std::move(codeSnapshot), files = std::move(files)]() mutable {
     // batch UI updates to avoid spamming event loop
     std::vector<std::pair<int, HoverInfo>> batch;
-    batch.reserve(8);
+    batch.reserve(64);
 
     auto flush = [&]() {
       if (batch.empty())
@@ -972,7 +831,34 @@ void ArduinoClassBrowserPanel::StartHoverWorker(uint64_t gen, std::string file,
       });
     };
 
-    for (int i = 0; i < (int)m_symbols.size(); i++) {
+    // Skip items that typically don't have interesting hover, have no position
+    // or are already in the cache.
+    std::vector<int> wanted;
+    std::unordered_set<std::string> usrs;
+    {
+      std::lock_guard<std::mutex> lk(m_hoverCacheMutex);
+      for (int i = 0; i < (int)m_symbols.size(); i++) {
+        const auto &s = m_symbols[i];
+        if (s.line <= 0)
+          continue;
+        if (s.kind == CXCursor_ParmDecl)
+          continue;
+        if (!s.usr.empty() && m_hoverCache.find(s.usr) != m_hoverCache.end())
+          continue;
+
+        wanted.push_back(i);
+        if (!s.usr.empty())
+          usrs.insert(s.usr);
+      }
+    }
+
+    if (m_cancel.load(std::memory_order_relaxed) || gen != m_generation.load())
+      return;
+
+    // One TU walk for everything that has an USR...
+    auto byUsr = m_completion->GetHoverInfoBatch(file, code, usrs, files);
+
+    for (int i : wanted) {
       if (m_cancel.load(std::memory_order_relaxed))
         return;
       if (gen != m_generation.load())
@@ -980,33 +866,22 @@ void ArduinoClassBrowserPanel::StartHoverWorker(uint64_t gen, std::string file,
 
       const auto &s = m_symbols[i];
 
-      // Skip items that typically don't have interesting hover, or have no position.
-      if (s.line <= 0)
-        continue;
-      if (s.kind == CXCursor_ParmDecl)
-        continue;
-
-      // skip if hover in cache
-      const std::string &key = s.usr;
-      if (!key.empty()) {
-        bool already = false;
-        {
-          std::lock_guard<std::mutex> lk(m_hoverCacheMutex);
-          already = (m_hoverCache.find(key) != m_hoverCache.end());
-        }
-        if (already)
-          continue;
-      }
-
       HoverInfo hi;
-
-      int col = s.column > 0 ? s.column : 1;
-      if (!m_completion->GetHoverInfo(file, code, s.line, col, files, hi)) {
-        continue;
+      if (!s.usr.empty()) {
+        auto it = byUsr.find(s.usr);
+        if (it == byUsr.end())
+          continue;
+        hi = it->second;
+      } else {
+        // ...the rest is resolved from its position
+        int col = s.column > 0 ? s.column : 1;
+        if (!m_completion->GetHoverInfo(file, code, s.line, col, files, hi)) {
+          continue;
+        }
       }
 
       batch.emplace_back(i, std::move(hi));
-      if (batch.size() >= 8) {
+      if (batch.size() >= 64) {
         flush();
       }
     }
@@ -1136,12 +1011,18 @@ void ArduinoClassBrowserPanel::OnItemActivated(wxTreeEvent &e) {
   if (idx < 0 || idx >= (int)m_symbols.size())
     return;
 
-  const SymbolInfo &s = m_symbols[idx];
+  const SymbolInfo *s = &m_symbols[idx];
+
+  // a declaration (prototype, method in a class body) leads to its body
+  SymbolInfo def;
+  if (m_completion && m_completion->FindIndexedDefinition(*s, def)) {
+    s = &def;
+  }
 
   JumpTarget tgt;
-  tgt.file = s.file;
-  tgt.line = s.line;
-  tgt.column = s.column;
+  tgt.file = s->file;
+  tgt.line = s->line;
+  tgt.column = s->column;
 
   ArduinoDiagnosticsActionEvent ev(EVT_ARD_DIAG_JUMP, GetId());
   ev.SetEventObject(this);
@@ -54,10 +54,21 @@ private:
     int index = -1;
     int sortLine = 0;
     int sortCol = 0;
-    std::string usr;
+    std::string key; // node key, see TreeNode
 
-    ItemData(int idx, std::string u, int line, int col)
-        : index(idx), sortLine(line), sortCol(col), usr(std::move(u)) {}
+    ItemData(int idx, std::string k, int line, int col)
+        : index(idx), sortLine(line), sortCol(col), key(std::move(k)) {}
+  };
+
+  // What is in the tree now, keyed by symbol key (USR) + key of the parent node,
+  // so a rebuild only touches the nodes that changed.
+  struct TreeNode {
+    wxTreeItemId item;
+    std::string parentKey; // empty = top level
+    int line = 0;
+    int col = 0;
+    int image = -1;
+    wxString label;
   };
 
   struct HoverCacheEntry {
@@ -121,6 +132,7 @@ private:
   std::vector<SymbolInfo> m_symbols;
 
   std::vector<wxTreeItemId> m_itemByIndex;
+  std::unordered_map<std::string, TreeNode> m_nodes;
 
   bool m_internalSelect = false;
 };
@@ -19,16 +19,20 @@
 #include "ard_cli.hpp"
 
 #include "ard_cc.hpp"
+#include "ard_clicache.hpp"
 #include "ard_ev.hpp"
+#include "ard_sched.hpp"
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cstdio>
+#include <condition_variable>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <sstream>
@@ -323,6 +327,43 @@ static void ParseCoreRelease(const json &jr, const std::string &versionKey, Ardu
   }
 }
 
+static bool ParseCoreInfo(const json &jp, ArduinoCoreInfo &info) {
+  info.id = jp.value("id", "");
+  info.maintainer = jp.value("maintainer", "");
+  info.website = jp.value("website", "");
+  info.email = jp.value("email", "");
+  info.indexed = jp.value("indexed", false);
+
+  info.installedVersion = jp.value("installed_version", "");
+  info.latestVersion = jp.value("latest_version", "");
+
+  if (info.id.empty()) {
+    // without ID it doesn't make much sense, skip it
+    return false;
+  }
+
+  if (jp.contains("releases") && jp["releases"].is_object()) {
+    const auto &relsJson = jp["releases"];
+
+    info.availableVersions.reserve(relsJson.size());
+    info.releases.reserve(relsJson.size());
+
+    for (auto it = relsJson.begin(); it != relsJson.end(); ++it) {
+      if (!it.value().is_object()) {
+        continue;
+      }
+
+      std::string ver = it.key();
+      info.availableVersions.push_back(ver);
+
+      ArduinoCoreRelease rel;
+      ParseCoreRelease(it.value(), ver, rel);
+      info.releases.push_back(std::move(rel));
+    }
+  }
+  return true;
+}
+
 // --- simple command line splitting into arguments (respects quotes) ---
 static std::vector<std::string> SplitArgsKeepingQuotes(const std::string &s) {
   std::vector<std::string> out;
@@ -519,7 +560,8 @@ static void CollectHeadersFromSrcRoot(const fs::path &srcRoot,
 /**
  * Windows execute without cmd in hidden mode.
  */
-static int ExecWinCommandHidden(const std::string &cmdUtf8, std::string &output) {
+static int ExecWinCommandHidden(const std::string &cmdUtf8, std::string &output,
+                                const std::function<void(const ArduinoCli::ReadFn &)> &consume = nullptr) {
   output.clear();
 
   SECURITY_ATTRIBUTES sa{};
@@ -606,6 +648,18 @@ static int ExecWinCommandHidden(const std::string &cmdUtf8, std::string &output)
     return -static_cast<int>(err);
   }
 
+  if (consume) {
+    ArduinoCli::ReadFn read = [hRead](char *buf, size_t len) -> size_t {
+      DWORD n = 0;
+      if (!ReadFile(hRead, buf, (DWORD)len, &n, nullptr)) {
+        return 0;
+      }
+      return (size_t)n;
+    };
+    consume(read);
+  }
+
+  // (rest of the output when the consumer stopped early)
   char buffer[4096];
   DWORD bytesRead = 0;
   while (ReadFile(hRead, buffer, sizeof(buffer), &bytesRead, nullptr) && bytesRead > 0) {
@@ -629,6 +683,78 @@ static int ExecWinCommandHidden(const std::string &cmdUtf8, std::string &output)
 
 static unsigned int g_execCounter = 1;
 
+namespace {
+// std::istream over the output of a running command.
+class CliOutputStreamBuf : public std::streambuf {
+public:
+  explicit CliOutputStreamBuf(const ArduinoCli::ReadFn &read) : m_read(read) {}
+
+protected:
+  int_type underflow() override {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+
+    size_t n = m_read(m_buf.data(), m_buf.size());
+    if (n == 0) {
+      return traits_type::eof();
+    }
+
+    setg(m_buf.data(), m_buf.data(), m_buf.data() + n);
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  const ArduinoCli::ReadFn &m_read;
+  std::array<char, 64 * 1024> m_buf{};
+};
+
+/**
+ * Runs cmd and parses its JSON output ({ "key": [ ... ], ... }) while it is
+ * being printed. onElement gets every element of the top level arrays with
+ * the key of its array; the element is dropped right after, so the whole
+ * document is never held in memory.
+ */
+int ParseJsonArraysStreaming(const std::string &cmd,
+                             const std::function<void(const std::string &key, const json &element)> &onElement,
+                             std::string &error) {
+  error.clear();
+
+  return ArduinoCli::ExecuteCommandStreaming(cmd, [&](const ArduinoCli::ReadFn &read) {
+    CliOutputStreamBuf buf(read);
+    std::istream in(&buf);
+
+    std::string currentKey;
+    bool inArray = false;
+
+    try {
+      // only the callback matters, the returned (pruned) document is dropped
+      (void)json::parse(in, [&](int depth, json::parse_event_t event, json &parsed) -> bool {
+        if (depth == 1) {
+          if (event == json::parse_event_t::key) {
+            currentKey = parsed.get<std::string>();
+          } else if (event == json::parse_event_t::array_start) {
+            inArray = true;
+          } else if (event == json::parse_event_t::array_end) {
+            inArray = false;
+          }
+          return true;
+        }
+
+        if (depth == 2 && inArray &&
+            (event == json::parse_event_t::object_end || event == json::parse_event_t::value)) {
+          onElement(currentKey, parsed);
+          return false; // consumed, don't keep it in the document
+        }
+        return true;
+      });
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+  });
+}
+} // namespace
+
 /**
  * Synchronous execution of command. Output stored to output parameter and
  * return value of process is returned.
@@ -678,6 +804,154 @@ int ArduinoCli::ExecuteCommand(const std::string &cmd, std::string &output) {
 #endif
 }
 
+namespace {
+// Result of one read-only query, shared by every caller asking the same command.
+struct CliQueryResult {
+  bool done = false;
+  int rc = -1;
+  std::string output;
+  Clock::time_point started;
+  Clock::time_point finished;
+};
+
+// Installs done outside the editor (terminal, other IDE, copied folders) are
+// not announced, so a finished result is only reused for a short while - long
+// enough to share the burst of identical queries at startup or after an action.
+constexpr std::chrono::seconds kCliQueryTtl{30};
+
+struct CliQueryCache {
+  std::mutex mutex;
+  std::condition_variable cv;
+  // command line -> finished or still running query
+  std::unordered_map<std::string, std::shared_ptr<CliQueryResult>> entries;
+};
+
+CliQueryCache &GetCliQueryCache() {
+  static CliQueryCache cache;
+  return cache;
+}
+} // namespace
+
+/**
+ * Synchronous execution of a read-only metadata query (board/core/library
+ * listings, board details, config dump).
+ *
+ * Every arduino-cli run reloads all package and library indexes, so the
+ * successful outputs are shared by all ArduinoCli instances for kCliQueryTtl
+ * (or until InvalidateQueryCache()). Callers asking for a command which is
+ * already running wait for that run instead of spawning another process.
+ */
+int ArduinoCli::ExecuteQuery(const std::string &cmd, std::string &output, Clock::time_point *runStarted) {
+  CliQueryCache &qc = GetCliQueryCache();
+
+  std::shared_ptr<CliQueryResult> res;
+  {
+    std::unique_lock<std::mutex> lk(qc.mutex);
+    auto it = qc.entries.find(cmd);
+    if (it != qc.entries.end() && it->second->done && Clock::now() - it->second->finished > kCliQueryTtl) {
+      qc.entries.erase(it);
+      it = qc.entries.end();
+    }
+    if (it != qc.entries.end()) {
+      res = it->second;
+      qc.cv.wait(lk, [&res]() { return res->done; });
+
+      APP_DEBUG_LOG("CLI: QUERY SHARED rc=%d: %s", res->rc, cmd.c_str());
+      output = res->output;
+      if (runStarted)
+        *runStarted = res->started;
+      return res->rc;
+    }
+
+    res = std::make_shared<CliQueryResult>();
+    res->started = Clock::now();
+    qc.entries.emplace(cmd, res);
+  }
+
+  if (runStarted)
+    *runStarted = res->started;
+
+  std::string out;
+  int rc = ExecuteCommand(cmd, out);
+
+  {
+    std::lock_guard<std::mutex> lk(qc.mutex);
+    res->rc = rc;
+    res->output = out;
+    res->finished = Clock::now();
+    res->done = true;
+
+    // failures are not remembered, next caller tries again
+    if (rc != 0) {
+      auto it = qc.entries.find(cmd);
+      if (it != qc.entries.end() && it->second == res) {
+        qc.entries.erase(it);
+      }
+    }
+  }
+  qc.cv.notify_all();
+
+  output = std::move(out);
+  return rc;
+}
+
+void ArduinoCli::InvalidateQueryCache() {
+  CliQueryCache &qc = GetCliQueryCache();
+
+  std::lock_guard<std::mutex> lk(qc.mutex);
+  // Running queries are only unlinked, their waiters still get the result.
+  qc.entries.clear();
+
+  APP_DEBUG_LOG("CLI: query cache invalidated");
+}
+
+int ArduinoCli::ExecuteCommandStreaming(const std::string &cmd, const std::function<void(const ReadFn &read)> &consume) {
+  unsigned int index = (g_execCounter++);
+  ScopeTimer t("%04u ExecuteCommandStreaming (%s)", index, cmd.c_str());
+
+  APP_DEBUG_LOG("CLI: %04u EXEC SYNC STREAM: %s", index, cmd.c_str());
+
+#if defined(__WXMSW__)
+  std::string rest;
+  int rc = ExecWinCommandHidden(cmd, rest, consume);
+  APP_DEBUG_LOG("CLI: %04u EXIT %d", index, rc);
+  return rc;
+#else
+  std::string _cmd = cmd;
+  _cmd += " 2>&1";
+
+  FILE *pipe = popen(_cmd.c_str(), "r");
+  if (!pipe) {
+    wxLogWarning(wxT("CLI: %04u ERROR %s"), index, wxString::FromUTF8(_cmd));
+    return -1;
+  }
+
+  ReadFn read = [pipe](char *buf, size_t len) -> size_t {
+    return fread(buf, 1, len, pipe);
+  };
+  consume(read);
+
+  // the consumer may stop early (parse error) -> let the process finish writing
+  std::array<char, 4096> drain{};
+  while (fread(drain.data(), 1, drain.size(), pipe) > 0) {
+  }
+
+  int status = pclose(pipe);
+  int rc = -1;
+
+  if (status >= 0) {
+    if (WIFEXITED(status)) {
+      rc = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+      rc = -WTERMSIG(status);
+    }
+  }
+
+  APP_DEBUG_LOG("CLI: %04u EXIT %d", index, rc);
+  return rc;
+#endif
+}
+
 bool ArduinoCli::CancelRunning() {
   std::lock_guard<std::mutex> lk(m_cancelMtx);
 
@@ -1718,46 +1992,66 @@ bool ArduinoCli::LoadLibraries() {
   ScopeTimer t("CLI: LoadLibraries()");
   APP_DEBUG_LOG("CLI: LoadLibraries()");
 
-  std::string output;
-  std::string cmd = GetCliBaseCommand() + " lib search --format json --omit-releases-details";
-  int rc = ExecuteCommand(cmd, output);
-  if ((rc != 0) || output.empty()) {
-    return false;
-  }
-
-  json j;
-  try {
-    j = json::parse(output);
-  } catch (const std::exception &e) {
-    wxLogWarning(wxT("Failed to parse arduino-cli lib search JSON: %s"),
-                 wxString::FromUTF8(e.what()));
-    return false;
+  {
+    std::vector<ArduinoLibraryInfo> cached;
+    if (m_diskCache->LoadLibraries(cached)) {
+      libraries.swap(cached);
+      APP_DEBUG_LOG("CLI: LoadLibraries() -> %zu libraries from cache", libraries.size());
+      return true;
+    }
   }
 
-  if (!j.contains("libraries") || !j["libraries"].is_array()) {
-    wxLogWarning(wxT("arduino-cli lib search JSON does not contain 'libraries' array."));
-    return false;
-  }
+  // fingerprint first - the files may change while arduino-cli runs
+  std::string dataDir, userDir;
+  const bool hasDirs = GetCliDirectories(dataDir, userDir);
+  const auto fingerprint = m_diskCache->TakeFingerprint(ArduinoCliDiskCache::Kind::Libraries, dataDir, userDir);
 
-  const auto &libsJson = j["libraries"];
+  std::string cmd = GetCliBaseCommand() + " lib search --format json --omit-releases-details";
 
+  // The index is several MB of JSON -> libraries are converted one by one while it is printed.
   std::vector<ArduinoLibraryInfo> tmp;
-  tmp.reserve(libsJson.size());
+  bool hasLibraries = false;
+  std::string error;
+
+  auto onElement = [&](const std::string &key, const json &jl) {
+    if (key != "libraries") {
+      return;
+    }
+    hasLibraries = true;
 
-  for (const auto &jl : libsJson) {
     if (!jl.is_object()) {
-      continue;
+      return;
     }
 
     ArduinoLibraryInfo info;
-    if (!ParseLibrary(jl, info)) {
-      continue;
+    if (ParseLibrary(jl, info)) {
+      tmp.push_back(std::move(info));
     }
-    tmp.push_back(std::move(info));
+  };
+
+  int rc = ParseJsonArraysStreaming(cmd, onElement, error);
+
+  if (rc != 0) {
+    return false;
+  }
+
+  if (!error.empty()) {
+    wxLogWarning(wxT("Failed to parse arduino-cli lib search JSON: %s"),
+                 wxString::FromUTF8(error));
+    return false;
+  }
+
+  if (!hasLibraries) {
+    wxLogWarning(wxT("arduino-cli lib search JSON does not contain 'libraries' array."));
+    return false;
   }
 
   libraries.swap(tmp);
 
+  if (hasDirs) {
+    m_diskCache->StoreLibraries(libraries, fingerprint);
+  }
+
   APP_DEBUG_LOG("CLI: LoadLibraries() -> %zu libraries found...", libraries.size());
   return true;
 }
@@ -1770,75 +2064,20 @@ bool ArduinoCli::LoadOutdated() {
 
   // arduino-cli outdated --format json
   std::string cmd = GetCliBaseCommand() + " outdated --format json";
-  std::string output;
-  int rc = ExecuteCommand(cmd, output);
-
-  if (rc != 0 || output.empty()) {
-    wxLogWarning(wxT("arduino-cli outdated failed (rc=%d)."), rc);
-    outdatedItems.clear();
-    return false;
-  }
-
-  json j;
-  try {
-    j = json::parse(output);
-  } catch (const std::exception &e) {
-    wxLogWarning(wxT("Failed to parse arduino-cli outdated JSON: %s"), wxString::FromUTF8(e.what()));
-    outdatedItems.clear();
-    return false;
-  }
-
-  if (!j.is_object()) {
-    wxLogWarning(wxT("arduino-cli outdated JSON is not an object."));
-    outdatedItems.clear();
-    return false;
-  }
 
   std::vector<ArduinoCoreInfo> coresTmp;
   std::vector<ArduinoLibraryInfo> libsTmp;
+  std::string error;
 
-  // --- platforms ---
-  if (j.contains("platforms") && j["platforms"].is_array()) {
-    const auto &platformsJson = j["platforms"];
-    coresTmp.reserve(platformsJson.size());
-
-    for (const auto &jp : platformsJson) {
-      if (!jp.is_object()) {
-        continue;
-      }
+  auto onElement = [&](const std::string &key, const json &item) {
+    if (!item.is_object()) {
+      return;
+    }
 
+    if (key == "platforms") {
       ArduinoCoreInfo info;
-      info.id = jp.value("id", "");
-      info.maintainer = jp.value("maintainer", "");
-      info.website = jp.value("website", "");
-      info.email = jp.value("email", "");
-      info.indexed = jp.value("indexed", false);
-
-      info.installedVersion = jp.value("installed_version", "");
-      info.latestVersion = jp.value("latest_version", "");
-
-      if (info.id.empty()) {
-        continue;
-      }
-
-      if (jp.contains("releases") && jp["releases"].is_object()) {
-        const auto &relsJson = jp["releases"];
-
-        info.availableVersions.reserve(relsJson.size());
-        info.releases.reserve(relsJson.size());
-
-        for (auto it = relsJson.begin(); it != relsJson.end(); ++it) {
-          if (!it.value().is_object()) {
-            continue;
-          }
-
-          std::string ver = it.key();
-          info.availableVersions.push_back(ver);
-
-          ArduinoCoreRelease rel;
-          ParseCoreRelease(it.value(), ver, rel);
-          info.releases.push_back(std::move(rel));
-        }
+      if (!ParseCoreInfo(item, info)) {
+        return;
       }
 
       // Keep only truly outdated platforms (defensive; CLI should already do it).
@@ -1846,43 +2085,45 @@ bool ArduinoCli::LoadOutdated() {
           CompareVersions(info.installedVersion, info.latestVersion) < 0) {
         coresTmp.push_back(std::move(info));
       }
-    }
-
-    std::sort(coresTmp.begin(), coresTmp.end(),
-              [](const ArduinoCoreInfo &a, const ArduinoCoreInfo &b) {
-                return a.id < b.id;
-              });
-  }
-
-  // --- libraries ---
-  if (j.contains("libraries") && j["libraries"].is_array()) {
-    const auto &libsJson = j["libraries"];
-    libsTmp.reserve(libsJson.size());
-
-    for (const auto &item : libsJson) {
-      if (!item.is_object()) {
-        continue;
-      }
-
+    } else if (key == "libraries") {
       ArduinoLibraryInfo info;
       if (!ParseOutdatedLibraryItem(item, info)) {
-        continue;
+        return;
       }
 
       // Defensive: ignore broken entries without version.
       if (info.name.empty() || info.latest.version.empty()) {
-        continue;
+        return;
       }
 
       libsTmp.push_back(std::move(info));
     }
+  };
 
-    std::sort(libsTmp.begin(), libsTmp.end(),
-              [](const ArduinoLibraryInfo &a, const ArduinoLibraryInfo &b) {
-                return a.name < b.name;
-              });
+  int rc = ParseJsonArraysStreaming(cmd, onElement, error);
+
+  if (rc != 0) {
+    wxLogWarning(wxT("arduino-cli outdated failed (rc=%d)."), rc);
+    outdatedItems.clear();
+    return false;
   }
 
+  if (!error.empty()) {
+    wxLogWarning(wxT("Failed to parse arduino-cli outdated JSON: %s"), wxString::FromUTF8(error));
+    outdatedItems.clear();
+    return false;
+  }
+
+  std::sort(coresTmp.begin(), coresTmp.end(),
+            [](const ArduinoCoreInfo &a, const ArduinoCoreInfo &b) {
+              return a.id < b.id;
+            });
+
+  std::sort(libsTmp.begin(), libsTmp.end(),
+            [](const ArduinoLibraryInfo &a, const ArduinoLibraryInfo &b) {
+              return a.name < b.name;
+            });
+
   std::vector<ArduinoOutdatedItem> tmp;
   tmp.reserve(coresTmp.size() + libsTmp.size());
 
@@ -1904,16 +2145,14 @@ void ArduinoCli::LoadOutdatedAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
-    ThreadNice();
-
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     bool ok = this->LoadOutdated();
 
     wxThreadEvent evt(EVT_OUTDATED_UPDATED);
     evt.SetInt(ok ? 1 : 0);
     evt.SetPayload(this->GetOutdatedItems());
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.outdated", handler));
 }
 
 const std::vector<ArduinoOutdatedItem> &ArduinoCli::GetOutdatedItems() const {
@@ -1939,7 +2178,7 @@ bool ArduinoCli::SearchLibraryProvidingHeader(const std::string &header,
   std::string cmd = GetCliBaseCommand() + " " + args.str();
 
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
   if (rc != 0 || output.empty()) {
     return false;
   }
@@ -2007,7 +2246,7 @@ bool ArduinoCli::LoadInstalledLibraries() {
   // arduino-cli lib list --format json
   std::string cmd = GetCliBaseCommand() + " lib list --format json";
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
   if (rc != 0 || output.empty()) {
     return false;
   }
@@ -2146,7 +2385,7 @@ ArduinoCliConfig ArduinoCli::GetConfig() const {
                     " config dump --format json";
 
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
   if (rc != 0 || output.empty()) {
     wxLogWarning(wxT("arduino-cli config dump failed (rc=%d)."), rc);
     return cfg;
@@ -2244,9 +2483,27 @@ ArduinoCliConfig ArduinoCli::GetConfig() const {
     wxLogWarning(wxT("Failed to extract network.proxy: %s"), wxString::FromUTF8(e.what()));
   }
 
+  // --- directories.data / directories.user ---
+  try {
+    auto itDirs = root->find("directories");
+    if (itDirs != root->end() && itDirs->is_object()) {
+      cfg.dataDir = itDirs->value("data", "");
+      cfg.userDir = itDirs->value("user", "");
+    }
+  } catch (const std::exception &e) {
+    wxLogWarning(wxT("Failed to extract directories: %s"), wxString::FromUTF8(e.what()));
+  }
+
   return cfg;
 }
 
+bool ArduinoCli::GetCliDirectories(std::string &dataDir, std::string &userDir) const {
+  ArduinoCliConfig cfg = GetConfig();
+  dataDir = cfg.dataDir;
+  userDir = cfg.userDir;
+  return !dataDir.empty();
+}
+
 bool ArduinoCli::SetConfigValue(const std::string &key,
                                 const std::string &value) {
   std::string cmd;
@@ -2262,6 +2519,7 @@ bool ArduinoCli::SetConfigValue(const std::string &key,
 
   std::string output;
   int rc = ExecuteCommand(cmd, output);
+  InvalidateQueryCache();
   if (rc != 0) {
     wxLogWarning(wxT("arduino-cli config set/delete failed for key '%s' (rc=%d)."), wxString::FromUTF8(key), rc);
     return false;
@@ -2287,6 +2545,7 @@ bool ArduinoCli::SetConfigValue(const std::string &key,
 
   std::string output;
   int rc = ExecuteCommand(cmd, output);
+  InvalidateQueryCache();
   if (rc != 0) {
     wxLogWarning(wxT("arduino-cli config set/delete failed for multi key '%s' (rc=%d)."), wxString::FromUTF8(key), rc);
     return false;
@@ -2345,7 +2604,7 @@ bool ArduinoCli::LoadBoardParameters(std::string &errorOut) {
 
   std::string cmd = GetCliBaseCommand() + " " + args.str();
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
 
   if (rc != 0 || output.empty()) {
     if (!output.empty()) {
@@ -2395,7 +2654,7 @@ void ArduinoCli::LoadBoardParametersAsync(wxEvtHandler *handler) {
 
   APP_DEBUG_LOG("LoadBoardParametersAsync()");
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     std::string errorOut;
 
     bool ok = this->LoadBoardParameters(errorOut);
@@ -2405,7 +2664,7 @@ void ArduinoCli::LoadBoardParametersAsync(wxEvtHandler *handler) {
     evt.SetString(wxString::FromUTF8(errorOut));
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.boardParameters", handler));
 }
 
 std::vector<std::string> ArduinoCli::ResolveLibraries(const std::vector<std::string> &includes) {
@@ -2846,7 +3105,7 @@ void ArduinoCli::GetResolvedLibrariesAsync(const std::vector<SketchFileBuffer> &
   wxWeakRef<wxEvtHandler> weak(handler);
 
   // copy files into the worker thread
-  std::thread([this, weak, files]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, files]() {
     std::vector<ResolvedLibraryInfo> libs;
     bool resl = this->GetResolvedLibraries(files, libs);
 
@@ -2855,7 +3114,7 @@ void ArduinoCli::GetResolvedLibrariesAsync(const std::vector<SketchFileBuffer> &
     evt.SetPayload(libs);
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.resolvedLibraries", handler));
 }
 
 bool ArduinoCli::LoadProperties() {
@@ -2907,7 +3166,7 @@ void ArduinoCli::LoadPropertiesAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     bool ok = this->LoadProperties();
 
     wxThreadEvent evt(EVT_CLANG_ARGS_READY);
@@ -2915,7 +3174,7 @@ void ArduinoCli::LoadPropertiesAsync(wxEvtHandler *handler) {
 
     // sends event to the GUI thread
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.properties", handler));
 }
 
 /*
@@ -2962,6 +3221,7 @@ std::string ArduinoCli::GetCachedEnviromentFqbn() const {
 
 void ArduinoCli::CleanCachedEnvironment() {
   APP_DEBUG_LOG("CleanCachedEnvironment()");
+  InvalidateQueryCache();
   InvalidateLibraryCache();
   CleanBuildDirectory();
 }
@@ -2997,15 +3257,13 @@ void ArduinoCli::LoadLibrariesAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
-    ThreadNice();
-
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     bool ok = this->LoadLibraries();
 
     wxThreadEvent evt(EVT_LIBRARIES_UPDATED);
     evt.SetInt(ok ? 1 : 0);
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.libraries", handler));
 }
 
 void ArduinoCli::SearchLibraryProvidingHeaderAsync(const std::string &header, wxEvtHandler *handler) {
@@ -3015,7 +3273,7 @@ void ArduinoCli::SearchLibraryProvidingHeaderAsync(const std::string &header, wx
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak, header]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, header]() {
     std::vector<ArduinoLibraryInfo> libs;
     bool ok = this->SearchLibraryProvidingHeader(header, libs);
 
@@ -3025,7 +3283,7 @@ void ArduinoCli::SearchLibraryProvidingHeaderAsync(const std::string &header, wx
     evt.SetPayload(libs);
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  });
 }
 
 void ArduinoCli::LoadInstalledLibrariesAsync(wxEvtHandler *handler) {
@@ -3035,13 +3293,13 @@ void ArduinoCli::LoadInstalledLibrariesAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     bool ok = this->LoadInstalledLibraries();
 
     wxThreadEvent evt(EVT_INSTALLED_LIBRARIES_UPDATED);
     evt.SetInt(ok ? 1 : 0);
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.installedLibraries", handler));
 }
 
 bool ArduinoCli::GetBoardOptions(const std::string &fqbn, std::vector<ArduinoBoardOption> &outOptions) {
@@ -3054,7 +3312,7 @@ bool ArduinoCli::GetBoardOptions(const std::string &fqbn, std::vector<ArduinoBoa
 
   std::string cmd = GetCliBaseCommand() + " " + args.str();
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
   if (rc != 0 || output.empty()) {
     return false;
   }
@@ -3122,7 +3380,7 @@ void ArduinoCli::GetBoardOptionsAsync(wxEvtHandler *handler) {
     return;
   }
 
-  std::thread([this, weak, effFqbn]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, effFqbn]() {
     std::vector<ArduinoBoardOption> options;
 
     bool resl = this->GetBoardOptions(effFqbn, options);
@@ -3132,7 +3390,7 @@ void ArduinoCli::GetBoardOptionsAsync(wxEvtHandler *handler) {
     evt.SetPayload(options);
 
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.boardOptions", handler));
 }
 
 bool ArduinoCli::GetBoardOptions(std::vector<ArduinoBoardOption> &outOptions) {
@@ -3239,9 +3497,9 @@ void ArduinoCli::CompileAsync(wxEvtHandler *handler) {
   args += " --output-dir " + ShellQuote(buildPath.string());
   args += " " + ShellQuote(sketchPath);
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "compile");
-  }).detach();
+  });
 }
 
 MemUsage ArduinoCli::GetLastCompileUsage() const {
@@ -3329,9 +3587,9 @@ void ArduinoCli::UploadAsync(wxEvtHandler *handler) {
   args += " --input-dir " + ShellQuote(buildPath.string());
   args += " " + ShellQuote(sketchPath);
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "upload");
-  }).detach();
+  });
 }
 
 void ArduinoCli::UploadHexFileAsync(const std::string &hexFilePath, wxEvtHandler *handler) {
@@ -3366,9 +3624,9 @@ void ArduinoCli::UploadHexFileAsync(const std::string &hexFilePath, wxEvtHandler
     args += " --programmer " + ShellQuote(programmer);
   }
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "upload-hex");
-  }).detach();
+  });
 }
 
 void ArduinoCli::InstallLibrariesAsync(const std::vector<ArduinoLibraryInstallSpec> &specs, wxEvtHandler *handler) {
@@ -3385,7 +3643,7 @@ void ArduinoCli::InstallLibrariesAsync(const std::vector<ArduinoLibraryInstallSp
   // make a copy to ensure thread-safe capture
   auto specsCopy = specs;
 
-  std::thread([this, weak, specsCopy]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, specsCopy]() {
     // We split the requests by type so they can be processed in groups
     std::vector<std::string> repoArgs;
     std::vector<std::string> gitArgs;
@@ -3444,6 +3702,7 @@ void ArduinoCli::InstallLibrariesAsync(const std::vector<ArduinoLibraryInstallSp
     }
 
     // After completing the installations...
+    InvalidateQueryCache();
     bool okInstalled = this->LoadInstalledLibraries();
 
     if (okInstalled) {
@@ -3458,7 +3717,7 @@ void ArduinoCli::InstallLibrariesAsync(const std::vector<ArduinoLibraryInstallSp
     summaryEvt.SetInt(overallRc);
     summaryEvt.SetString(wxString::Format(wxT("[library install batch finished, rc=%d]"), overallRc));
     QueueUiEvent(weak, summaryEvt.Clone());
-  }).detach();
+  });
 }
 
 void ArduinoCli::UninstallLibrariesAsync(const std::vector<std::string> &names, wxEvtHandler *handler) {
@@ -3472,13 +3731,14 @@ void ArduinoCli::UninstallLibrariesAsync(const std::vector<std::string> &names,
 
   auto namesCopy = names;
 
-  std::thread([this, weak, namesCopy]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, namesCopy]() {
     std::string args = "-v --no-color lib uninstall";
     for (const auto &name : namesCopy) {
       args += " " + ShellQuote(name);
     }
 
     int rc = this->RunCliStreaming(args, weak, "lib uninstall");
+    InvalidateQueryCache();
 
     bool okInstalled = false;
     if (rc == 0) {
@@ -3492,7 +3752,7 @@ void ArduinoCli::UninstallLibrariesAsync(const std::vector<std::string> &names,
     wxThreadEvent evtInstalled(EVT_INSTALLED_LIBRARIES_UPDATED);
     evtInstalled.SetInt(okInstalled ? 1 : 0);
     QueueUiEvent(weak, evtInstalled.Clone());
-  }).detach();
+  });
 }
 
 void ArduinoCli::InstallCoresAsync(const std::vector<std::string> &coreIds, wxEvtHandler *handler) {
@@ -3506,7 +3766,7 @@ void ArduinoCli::InstallCoresAsync(const std::vector<std::string> &coreIds, wxEv
 
   auto idsCopy = coreIds;
 
-  std::thread([this, weak, idsCopy]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, idsCopy]() {
     // arduino-cli core install <id> <id> ...
     std::string args = "-v --no-color core install";
     for (const auto &id : idsCopy) {
@@ -3516,6 +3776,7 @@ void ArduinoCli::InstallCoresAsync(const std::vector<std::string> &coreIds, wxEv
     }
 
     int rc = this->RunCliStreaming(args, weak, "core install");
+    InvalidateQueryCache();
 
     // After installation, we load the fresh core list
     bool okCores = this->LoadCores();
@@ -3529,7 +3790,7 @@ void ArduinoCli::InstallCoresAsync(const std::vector<std::string> &coreIds, wxEv
     summaryEvt.SetInt(rc);
     summaryEvt.SetString(wxString::Format(wxT("[core install batch finished, rc=%d]"), rc));
     QueueUiEvent(weak, summaryEvt.Clone());
-  }).detach();
+  });
 }
 
 void ArduinoCli::UninstallCoresAsync(const std::vector<std::string> &coreIds, wxEvtHandler *handler) {
@@ -3543,7 +3804,7 @@ void ArduinoCli::UninstallCoresAsync(const std::vector<std::string> &coreIds, wx
 
   auto idsCopy = coreIds;
 
-  std::thread([this, weak, idsCopy]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, idsCopy]() {
     // arduino-cli core uninstall <id> <id> ...
     std::string args = "-v --no-color core uninstall";
     for (const auto &id : idsCopy) {
@@ -3553,6 +3814,7 @@ void ArduinoCli::UninstallCoresAsync(const std::vector<std::string> &coreIds, wx
     }
 
     int rc = this->RunCliStreaming(args, weak, "core uninstall");
+    InvalidateQueryCache();
 
     // After uninstall, refresh the core list
     bool okCores = this->LoadCores();
@@ -3565,7 +3827,7 @@ void ArduinoCli::UninstallCoresAsync(const std::vector<std::string> &coreIds, wx
     summaryEvt.SetInt(rc);
     summaryEvt.SetString(wxString::Format(wxT("[core uninstall batch finished, rc=%d]"), rc));
     QueueUiEvent(weak, summaryEvt.Clone());
-  }).detach();
+  });
 }
 
 void ArduinoCli::UpdateCoreIndexAsync(wxEvtHandler *handler) {
@@ -3578,9 +3840,10 @@ void ArduinoCli::UpdateCoreIndexAsync(wxEvtHandler *handler) {
   // arduino-cli --no-color core update-index
   std::string args = "--no-color core update-index";
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "core update-index");
-  }).detach();
+    InvalidateQueryCache();
+  });
 }
 
 void ArduinoCli::UpdateCoreIndexBackgroundAsync(wxEvtHandler *handler) {
@@ -3590,16 +3853,17 @@ void ArduinoCli::UpdateCoreIndexBackgroundAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     std::string cmd = GetCliBaseCommand() + " --no-color core update-index";
     std::string output;
     int rc = ExecuteCommand(cmd, output);
+    InvalidateQueryCache();
 
     wxThreadEvent evt(EVT_CORE_INDEX_UPDATED);
     evt.SetInt(rc == 0 ? 1 : 0);
     evt.SetString(wxString::FromUTF8(output));
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.coreIndex", handler));
 }
 
 void ArduinoCli::SetFQBN(const std::string &newFqbn) {
@@ -3720,9 +3984,19 @@ std::string ArduinoCli::GetSketchPath() const {
 std::vector<ArduinoCoreBoard> ArduinoCli::GetAvailableBoards() {
   std::vector<ArduinoCoreBoard> boards;
 
+  if (m_diskCache->LoadBoards(boards)) {
+    return boards;
+  }
+
+  std::string dataDir, userDir;
+  const bool hasDirs = GetCliDirectories(dataDir, userDir);
+  const auto fingerprint = m_diskCache->TakeFingerprint(ArduinoCliDiskCache::Kind::Boards, dataDir, userDir);
+  const Clock::time_point fingerprintTime = Clock::now();
+
   std::string cmd = GetCliBaseCommand() + " board listall";
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  Clock::time_point runStarted;
+  int rc = ExecuteQuery(cmd, output, &runStarted);
 
   if (rc != 0 || output.empty()) {
     return boards;
@@ -3784,6 +4058,11 @@ std::vector<ArduinoCoreBoard> ArduinoCli::GetAvailableBoards() {
               return a.fqbn < b.fqbn;
             });
 
+  // a shared result of an earlier run may predate the fingerprint
+  if (!boards.empty() && hasDirs && runStarted >= fingerprintTime) {
+    m_diskCache->StoreBoards(boards, fingerprint);
+  }
+
   return boards;
 }
 
@@ -3795,21 +4074,35 @@ void ArduinoCli::GetAvailableBoardsAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     std::vector<ArduinoCoreBoard> brds = this->GetAvailableBoards();
 
     wxThreadEvent evt(EVT_AVAILABLE_BOARDS_UPDATED);
     evt.SetInt(1);
     evt.SetPayload(brds);
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.availableBoards", handler));
 }
 
 bool ArduinoCli::LoadCores() {
+  {
+    std::vector<ArduinoCoreInfo> cached;
+    if (m_diskCache->LoadCores(cached) && !cached.empty()) {
+      cores.swap(cached);
+      return true;
+    }
+  }
+
+  std::string dataDir, userDir;
+  const bool hasDirs = GetCliDirectories(dataDir, userDir);
+  const auto fingerprint = m_diskCache->TakeFingerprint(ArduinoCliDiskCache::Kind::Cores, dataDir, userDir);
+  const Clock::time_point fingerprintTime = Clock::now();
+
   // arduino-cli core list --format json
   std::string cmd = GetCliBaseCommand() + " core list --all --format json";
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  Clock::time_point runStarted;
+  int rc = ExecuteQuery(cmd, output, &runStarted);
 
   if (rc != 0 || output.empty()) {
     wxLogWarning(wxT("arduino-cli core list failed (rc=%d)."), rc);
@@ -3839,44 +4132,20 @@ bool ArduinoCli::LoadCores() {
     }
 
     ArduinoCoreInfo info;
-    info.id = jp.value("id", "");
-    info.maintainer = jp.value("maintainer", "");
-    info.website = jp.value("website", "");
-    info.email = jp.value("email", "");
-    info.indexed = jp.value("indexed", false);
-
-    info.installedVersion = jp.value("installed_version", "");
-    info.latestVersion = jp.value("latest_version", "");
-
-    if (info.id.empty()) {
-      // without ID it doesn't make much sense, skip it
+    if (!ParseCoreInfo(jp, info)) {
       continue;
     }
 
-    if (jp.contains("releases") && jp["releases"].is_object()) {
-      const auto &relsJson = jp["releases"];
-
-      info.availableVersions.reserve(relsJson.size());
-      info.releases.reserve(relsJson.size());
-
-      for (auto it = relsJson.begin(); it != relsJson.end(); ++it) {
-        if (!it.value().is_object()) {
-          continue;
-        }
-
-        std::string ver = it.key();
-        info.availableVersions.push_back(ver);
-
-        ArduinoCoreRelease rel;
-        ParseCoreRelease(it.value(), ver, rel);
-        info.releases.push_back(std::move(rel));
-      }
-    }
-
     tmp.push_back(std::move(info));
   }
 
   cores.swap(tmp);
+
+  // a shared result of an earlier run may predate the fingerprint
+  if (!cores.empty() && hasDirs && runStarted >= fingerprintTime) {
+    m_diskCache->StoreCores(cores, fingerprint);
+  }
+
   return !cores.empty();
 }
 
@@ -3888,13 +4157,13 @@ void ArduinoCli::LoadCoresAsync(wxEvtHandler *handler) {
 
   APP_DEBUG_LOG("LoadCoresAsync()");
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     bool ok = this->LoadCores();
 
     wxThreadEvent evt(EVT_CORES_LOADED);
     evt.SetInt(ok ? 1 : 0);
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.cores", handler));
 }
 
 const std::vector<ArduinoCoreInfo> &ArduinoCli::GetCores() const {
@@ -3957,9 +4226,10 @@ void ArduinoCli::UpdateLibraryIndexAsync(wxEvtHandler *handler) {
 
   std::string args = " --no-color lib update-index";
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "lib update-index");
-  }).detach();
+    InvalidateQueryCache();
+  });
 }
 
 void ArduinoCli::UpdateLibraryIndexBackgroundAsync(wxEvtHandler *handler) {
@@ -3969,16 +4239,17 @@ void ArduinoCli::UpdateLibraryIndexBackgroundAsync(wxEvtHandler *handler) {
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak]() {
     std::string cmd = GetCliBaseCommand() + " --no-color lib update-index";
     std::string output;
     int rc = ExecuteCommand(cmd, output);
+    InvalidateQueryCache();
 
     wxThreadEvent evt(EVT_LIBRARY_INDEX_UPDATED);
     evt.SetInt(rc == 0 ? 1 : 0);
     evt.SetString(wxString::FromUTF8(output));
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.libraryIndex", handler));
 }
 
 const std::vector<ArduinoLibraryInfo> &ArduinoCli::GetLibraries() const {
@@ -4145,15 +4416,16 @@ bool ArduinoCli::GetProgrammersForFqbn(const std::string &fqbnArg, std::vector<A
     return false;
   }
 
-  // arduino-cli board details -b <fqbn> --format json
+  // arduino-cli board details --fqbn <fqbn> --format json
+  // (same arguments as GetBoardOptions() -> the query is shared)
   std::ostringstream args;
   args << " board details"
-       << " -b " << ShellQuote(effFqbn)
+       << " --fqbn " << ShellQuote(effFqbn)
        << " --format json";
 
   std::string cmd = GetCliBaseCommand() + " " + args.str();
   std::string output;
-  int rc = ExecuteCommand(cmd, output);
+  int rc = ExecuteQuery(cmd, output);
 
   if (rc != 0 || output.empty()) {
     APP_DEBUG_LOG("GetProgrammersForFqbn: board details failed (rc=%d, out='%s')", rc, output.c_str());
@@ -4204,7 +4476,7 @@ void ArduinoCli::GetProgrammersForFqbnAsync(wxEvtHandler *handler, const std::st
 
   wxWeakRef<wxEvtHandler> weak(handler);
 
-  std::thread([this, weak, fqbnArg]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, fqbnArg]() {
     std::vector<ArduinoProgrammerInfo> programmers;
 
     bool resl = this->GetProgrammersForFqbn(fqbnArg, programmers);
@@ -4213,7 +4485,7 @@ void ArduinoCli::GetProgrammersForFqbnAsync(wxEvtHandler *handler, const std::st
     evt.SetInt(resl);
     evt.SetPayload(std::move(programmers));
     QueueUiEvent(weak, evt.Clone());
-  }).detach();
+  }, ArduinoTaskScheduler::Key("cli.programmers", handler));
 }
 
 bool ArduinoCli::SetProgrammer(const std::string &id) {
@@ -4275,9 +4547,9 @@ void ArduinoCli::BurnBootloaderAsync(wxEvtHandler *handler) {
     args += " --programmer " + ShellQuote(programmer);
   }
 
-  std::thread([this, weak, args]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [this, weak, args]() {
     this->RunCliStreaming(args, weak, "burn-bootloader");
-  }).detach();
+  });
 }
 
 void ArduinoCli::InitAttachedBoard() {
@@ -4344,5 +4616,9 @@ void ArduinoCli::InitAttachedBoard() {
 ArduinoCli::ArduinoCli(const std::string &sketchPath_, const std::string &cliPath_)
     : m_hasResolveLibrariesCache(false), fqbn(""), sketchPath(sketchPath_), m_cli(cliPath_), serialPort() {
 
+  m_diskCache = std::make_unique<ArduinoCliDiskCache>(m_cli);
+
   InitAttachedBoard();
 }
+
+ArduinoCli::~ArduinoCli() = default;
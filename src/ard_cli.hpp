@@ -23,6 +23,7 @@
 #include <array>
 #include <atomic>
 #include <filesystem>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -36,6 +37,8 @@
 
 using json = nlohmann::json;
 
+class ArduinoCliDiskCache;
+
 struct SerialPortInfo {
   std::string address;  // "/dev/cu.usbmodem2101" or "COM3"
   std::string label;    // what is displayed in choice
@@ -145,6 +148,9 @@ struct ArduinoCliConfig {
   std::string networkConnectionTimeout;                // network.connection_timeout
   bool boardManagerEnableUnsafeInstall = false;
   std::string networkProxy; // expected format: user:pass@host:port OR host:port
+
+  std::string dataDir; // directories.data
+  std::string userDir; // directories.user (sketchbook)
 };
 
 struct ArduinoBoardOptionValue {
@@ -222,6 +228,9 @@ private:
   mutable std::mutex m_usageMtx;
   MemUsage m_lastCompileUsage;
 
+  // Parsed listings persisted between editor runs
+  std::unique_ptr<ArduinoCliDiskCache> m_diskCache;
+
   std::atomic<bool> m_cancelAsync{false};
 
   int RunCliStreaming(const std::string &args, const wxWeakRef<wxEvtHandler> &weak, const char *finishedLabel);
@@ -239,6 +248,7 @@ private:
   bool LoadInstalledLibraries();
 
   std::string GetCliBaseCommand() const;
+  bool GetCliDirectories(std::string &dataDir, std::string &userDir) const;
 
   void InitAttachedBoard();
 
@@ -248,12 +258,27 @@ private:
 
 public:
   ArduinoCli(const std::string &sketchPath_, const std::string &cliPath = std::string());
+  ~ArduinoCli();
 
   // Finds arduino-cli and returns the path to the cli. Inserts the version into version.
   static std::string DetectCliExecutable(const std::string &configValue, std::string *version);
 
   static int ExecuteCommand(const std::string &cmd, std::string &output);
 
+  // Reads up to len bytes of the command output, 0 = end of output.
+  using ReadFn = std::function<size_t(char *buf, size_t len)>;
+
+  // Synchronous execution; consume() reads the output while the process is running.
+  static int ExecuteCommandStreaming(const std::string &cmd, const std::function<void(const ReadFn &read)> &consume);
+
+  // ExecuteCommand() for read-only queries: successful outputs are shared by all
+  // instances for a short time or until InvalidateQueryCache() (installs, index
+  // updates, config changes, explicit refreshes).
+  // runStarted -> when the arduino-cli run that produced output was started
+  // (earlier than the call for a shared result).
+  static int ExecuteQuery(const std::string &cmd, std::string &output, Clock::time_point *runStarted = nullptr);
+  static void InvalidateQueryCache();
+
   inline std::string GetPlatformPath() const { return m_platformPath; }
   inline std::string GetCorePlatformPath() const { return m_corePlatformPath; }
 
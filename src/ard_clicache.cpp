@@ -0,0 +1,577 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_clicache.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// bump when the layout of stored structures changes
+static constexpr uint32_t CLI_CACHE_MAGIC = 0x43434541; // "AECC"
+static constexpr uint32_t CLI_CACHE_VERSION = 1;
+
+namespace {
+
+// --- binary writer / reader (little endian host order, the cache is local) ---
+
+class CacheWriter {
+public:
+  explicit CacheWriter(std::string &out) : m_out(out) {}
+
+  void U32(uint32_t v) { m_out.append((const char *)&v, sizeof(v)); }
+  void U64(uint64_t v) { m_out.append((const char *)&v, sizeof(v)); }
+  void I32(int32_t v) { m_out.append((const char *)&v, sizeof(v)); }
+  void I64(int64_t v) { m_out.append((const char *)&v, sizeof(v)); }
+  void Bool(bool v) { m_out.push_back(v ? 1 : 0); }
+
+  void Str(const std::string &s) {
+    U32((uint32_t)s.size());
+    m_out.append(s);
+  }
+
+  void StrVec(const std::vector<std::string> &v) {
+    U32((uint32_t)v.size());
+    for (const auto &s : v)
+      Str(s);
+  }
+
+private:
+  std::string &m_out;
+};
+
+class CacheReader {
+public:
+  CacheReader(const std::string &data, size_t pos) : m_data(data), m_pos(pos) {}
+
+  bool Ok() const { return m_ok; }
+  size_t Pos() const { return m_pos; }
+
+  uint32_t U32() { return Pod<uint32_t>(); }
+  uint64_t U64() { return Pod<uint64_t>(); }
+  int32_t I32() { return Pod<int32_t>(); }
+  int64_t I64() { return Pod<int64_t>(); }
+  bool Bool() { return Pod<uint8_t>() != 0; }
+
+  std::string Str() {
+    const uint32_t n = U32();
+    if (!m_ok || n > m_data.size() - m_pos) {
+      m_ok = false;
+      return std::string();
+    }
+    std::string s = m_data.substr(m_pos, n);
+    m_pos += n;
+    return s;
+  }
+
+  std::vector<std::string> StrVec() {
+    std::vector<std::string> v;
+    const uint32_t n = Count();
+    v.reserve(n);
+    for (uint32_t i = 0; i < n && m_ok; i++)
+      v.push_back(Str());
+    return v;
+  }
+
+  // element count; each element takes at least 4 bytes -> sanity limit
+  uint32_t Count() {
+    const uint32_t n = U32();
+    if (!m_ok || (size_t)n > (m_data.size() - m_pos) / 4 + 1) {
+      m_ok = false;
+      return 0;
+    }
+    return n;
+  }
+
+private:
+  template <typename T>
+  T Pod() {
+    T v{};
+    if (!m_ok || sizeof(T) > m_data.size() - m_pos) {
+      m_ok = false;
+      return v;
+    }
+    std::memcpy(&v, m_data.data() + m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return v;
+  }
+
+  const std::string &m_data;
+  size_t m_pos;
+  bool m_ok = true;
+};
+
+// --- structures ---
+
+void WriteBoard(CacheWriter &w, const ArduinoCoreBoard &b) {
+  w.Str(b.name);
+  w.Str(b.fqbn);
+}
+
+ArduinoCoreBoard ReadBoard(CacheReader &r) {
+  ArduinoCoreBoard b;
+  b.name = r.Str();
+  b.fqbn = r.Str();
+  return b;
+}
+
+void WriteLibraryRelease(CacheWriter &w, const ArduinoLibraryRelease &rel) {
+  w.Str(rel.version);
+  w.Str(rel.author);
+  w.Str(rel.maintainer);
+  w.Str(rel.sentence);
+  w.Str(rel.paragraph);
+  w.Str(rel.website);
+  w.Str(rel.category);
+  w.StrVec(rel.architectures);
+  w.StrVec(rel.types);
+  w.Str(rel.url);
+  w.Str(rel.archiveFileName);
+  w.Str(rel.checksum);
+  w.I32(rel.size);
+  w.StrVec(rel.providesIncludes);
+  w.StrVec(rel.dependencies);
+  w.Str(rel.installDir);
+  w.Str(rel.sourceDir);
+  w.Bool(rel.isLegacy);
+  w.Str(rel.location);
+  w.Str(rel.layout);
+  w.StrVec(rel.examples);
+}
+
+void ReadLibraryRelease(CacheReader &r, ArduinoLibraryRelease &rel) {
+  rel.version = r.Str();
+  rel.author = r.Str();
+  rel.maintainer = r.Str();
+  rel.sentence = r.Str();
+  rel.paragraph = r.Str();
+  rel.website = r.Str();
+  rel.category = r.Str();
+  rel.architectures = r.StrVec();
+  rel.types = r.StrVec();
+  rel.url = r.Str();
+  rel.archiveFileName = r.Str();
+  rel.checksum = r.Str();
+  rel.size = r.I32();
+  rel.providesIncludes = r.StrVec();
+  rel.dependencies = r.StrVec();
+  rel.installDir = r.Str();
+  rel.sourceDir = r.Str();
+  rel.isLegacy = r.Bool();
+  rel.location = r.Str();
+  rel.layout = r.Str();
+  rel.examples = r.StrVec();
+}
+
+void WriteLibrary(CacheWriter &w, const ArduinoLibraryInfo &lib) {
+  w.Str(lib.name);
+  WriteLibraryRelease(w, lib.latest);
+  w.StrVec(lib.availableVersions);
+  w.U32((uint32_t)lib.releases.size());
+  for (const auto &rel : lib.releases)
+    WriteLibraryRelease(w, rel);
+}
+
+void ReadLibrary(CacheReader &r, ArduinoLibraryInfo &lib) {
+  lib.name = r.Str();
+  ReadLibraryRelease(r, lib.latest);
+  lib.availableVersions = r.StrVec();
+  const uint32_t n = r.Count();
+  lib.releases.resize(n);
+  for (uint32_t i = 0; i < n && r.Ok(); i++)
+    ReadLibraryRelease(r, lib.releases[i]);
+}
+
+void WriteCore(CacheWriter &w, const ArduinoCoreInfo &core) {
+  w.Str(core.id);
+  w.Str(core.maintainer);
+  w.Str(core.website);
+  w.Str(core.email);
+  w.Bool(core.indexed);
+  w.StrVec(core.availableVersions);
+  w.Str(core.installedVersion);
+  w.Str(core.latestVersion);
+
+  w.U32((uint32_t)core.releases.size());
+  for (const auto &rel : core.releases) {
+    w.Str(rel.version);
+    w.Str(rel.name);
+    w.StrVec(rel.types);
+    w.U32((uint32_t)rel.boards.size());
+    for (const auto &b : rel.boards)
+      WriteBoard(w, b);
+    w.Bool(rel.compatible);
+    w.Bool(rel.installed);
+  }
+}
+
+void ReadCore(CacheReader &r, ArduinoCoreInfo &core) {
+  core.id = r.Str();
+  core.maintainer = r.Str();
+  core.website = r.Str();
+  core.email = r.Str();
+  core.indexed = r.Bool();
+  core.availableVersions = r.StrVec();
+  core.installedVersion = r.Str();
+  core.latestVersion = r.Str();
+
+  const uint32_t n = r.Count();
+  core.releases.resize(n);
+  for (uint32_t i = 0; i < n && r.Ok(); i++) {
+    ArduinoCoreRelease &rel = core.releases[i];
+    rel.version = r.Str();
+    rel.name = r.Str();
+    rel.types = r.StrVec();
+    const uint32_t nb = r.Count();
+    rel.boards.reserve(nb);
+    for (uint32_t b = 0; b < nb && r.Ok(); b++)
+      rel.boards.push_back(ReadBoard(r));
+    rel.compatible = r.Bool();
+    rel.installed = r.Bool();
+  }
+}
+
+// --- fingerprint ---
+
+void AddStamp(const fs::path &p, std::vector<std::string> &paths) {
+  std::error_code ec;
+  if (fs::is_regular_file(p, ec)) {
+    paths.push_back(p.string());
+  }
+}
+
+// <root>/<vendor>/hardware/<arch>/<version>/<file> or <root>/<vendor>/<arch>/<file> (sketchbook hardware)
+void AddPlatformFiles(const fs::path &root, int depth, bool boardsToo, std::vector<std::string> &paths) {
+  std::error_code ec;
+  if (!fs::is_directory(root, ec))
+    return;
+
+  if (depth == 0) {
+    AddStamp(root / "platform.txt", paths);
+    if (boardsToo) {
+      AddStamp(root / "boards.txt", paths);
+      AddStamp(root / "boards.local.txt", paths);
+    }
+    return;
+  }
+
+  for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+    if (it->is_directory(ec)) {
+      AddPlatformFiles(it->path(), depth - 1, boardsToo, paths);
+    }
+  }
+}
+
+} // namespace
+
+ArduinoCliDiskCache::ArduinoCliDiskCache(std::string cliPath)
+    : m_cliPath(std::move(cliPath)) {
+}
+
+std::string ArduinoCliDiskCache::GetEntryPath(Kind kind) const {
+  std::string dir = GetAppCacheDir("cli");
+  if (dir.empty()) {
+    return std::string();
+  }
+
+  const char *name = "libraries";
+  if (kind == Kind::Cores)
+    name = "cores";
+  else if (kind == Kind::Boards)
+    name = "boards";
+
+  char hash[17];
+  snprintf(hash, sizeof(hash), "%016llx",
+           (unsigned long long)Fnv1a64((const uint8_t *)m_cliPath.data(), m_cliPath.size()));
+
+  return (fs::path(dir) / (std::string(hash) + "-" + name + ".bin")).string();
+}
+
+std::vector<ArduinoCliDiskCache::FileStamp> ArduinoCliDiskCache::CollectStamps(Kind kind, const std::string &dataDir, const std::string &userDir) const {
+  std::vector<std::string> paths;
+
+  AddStamp(fs::path(m_cliPath), paths);
+
+  const fs::path data(dataDir);
+  AddStamp(data / "arduino-cli.yaml", paths);
+
+  if (kind == Kind::Libraries) {
+    AddStamp(data / "library_index.json", paths);
+  }
+
+  if (kind == Kind::Cores) {
+    // package_index.json + package_<3rd party>_index.json
+    std::error_code ec;
+    for (fs::directory_iterator it(data, ec), end; !ec && it != end; it.increment(ec)) {
+      const std::string name = it->path().filename().string();
+      if (hasPrefix(name, "package_") && name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0) {
+        AddStamp(it->path(), paths);
+      }
+    }
+  }
+
+  if (kind == Kind::Cores || kind == Kind::Boards) {
+    const bool boardsToo = (kind == Kind::Boards);
+    std::error_code ec;
+    for (fs::directory_iterator it(data / "packages", ec), end; !ec && it != end; it.increment(ec)) {
+      AddPlatformFiles(it->path() / "hardware", 2, boardsToo, paths);
+    }
+    if (!userDir.empty()) {
+      AddPlatformFiles(fs::path(userDir) / "hardware", 2, boardsToo, paths);
+    }
+  }
+
+  std::sort(paths.begin(), paths.end());
+
+  std::vector<FileStamp> stamps;
+  stamps.reserve(paths.size());
+  for (auto &p : paths) {
+    std::error_code ec;
+    FileStamp st;
+    st.size = (uint64_t)fs::file_size(p, ec);
+    auto mt = fs::last_write_time(p, ec);
+    st.mtime = ec ? 0 : (int64_t)mt.time_since_epoch().count();
+    st.path = std::move(p);
+    stamps.push_back(std::move(st));
+  }
+  return stamps;
+}
+
+bool ArduinoCliDiskCache::ReadEntry(Kind kind, std::string &data, size_t &payloadPos) const {
+  const std::string path = GetEntryPath(kind);
+  if (path.empty()) {
+    return false;
+  }
+
+  {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      return false;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    data = ss.str();
+  }
+
+  CacheReader r(data, 0);
+  if (r.U32() != CLI_CACHE_MAGIC || r.U32() != CLI_CACHE_VERSION || r.U32() != (uint32_t)kind) {
+    return false;
+  }
+
+  const std::string cliPath = r.Str();
+  const std::string dataDir = r.Str();
+  const std::string userDir = r.Str();
+
+  std::vector<FileStamp> stored(r.Count());
+  for (auto &st : stored) {
+    st.path = r.Str();
+    st.mtime = r.I64();
+    st.size = r.U64();
+  }
+  const uint64_t payloadSize = r.U64();
+
+  if (!r.Ok() || cliPath != m_cliPath || dataDir.empty()) {
+    return false;
+  }
+
+  if (CollectStamps(kind, dataDir, userDir) != stored) {
+    APP_DEBUG_LOG("CLICACHE: %s is outdated", path.c_str());
+    return false;
+  }
+
+  payloadPos = r.Pos();
+  return payloadSize == data.size() - payloadPos;
+}
+
+ArduinoCliDiskCache::Fingerprint ArduinoCliDiskCache::TakeFingerprint(Kind kind, const std::string &dataDir, const std::string &userDir) const {
+  Fingerprint fp;
+  fp.kind = kind;
+  fp.dataDir = dataDir;
+  fp.userDir = userDir;
+  if (!dataDir.empty()) {
+    fp.stamps = CollectStamps(kind, dataDir, userDir);
+  }
+  return fp;
+}
+
+void ArduinoCliDiskCache::WriteEntry(const Fingerprint &fp, const std::string &payload) const {
+  const std::string path = GetEntryPath(fp.kind);
+  if (path.empty() || fp.dataDir.empty()) {
+    return;
+  }
+
+  std::string data;
+  CacheWriter w(data);
+  w.U32(CLI_CACHE_MAGIC);
+  w.U32(CLI_CACHE_VERSION);
+  w.U32((uint32_t)fp.kind);
+  w.Str(m_cliPath);
+  w.Str(fp.dataDir);
+  w.Str(fp.userDir);
+
+  // stamps taken before the listing was produced - a file changed since then
+  // makes the entry outdated right away instead of being hidden by it
+  w.U32((uint32_t)fp.stamps.size());
+  for (const auto &st : fp.stamps) {
+    w.Str(st.path);
+    w.I64(st.mtime);
+    w.U64(st.size);
+  }
+  w.U64(payload.size());
+  data += payload;
+
+  // several editor windows may store the same entry at once
+  std::ostringstream tmpName;
+  tmpName << path << ".tmp" << std::this_thread::get_id();
+  const std::string tmpPath = tmpName.str();
+
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      APP_DEBUG_LOG("CLICACHE: cannot write %s", tmpPath.c_str());
+      return;
+    }
+    out.write(data.data(), (std::streamsize)data.size());
+  }
+
+  std::error_code ec;
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+    APP_DEBUG_LOG("CLICACHE: cannot replace %s: %s", path.c_str(), ec.message().c_str());
+    fs::remove(tmpPath, ec);
+  }
+}
+
+bool ArduinoCliDiskCache::LoadLibraries(std::vector<ArduinoLibraryInfo> &out) const {
+  ScopeTimer t("CLICACHE: LoadLibraries()");
+
+  std::string data;
+  size_t pos = 0;
+  if (!ReadEntry(Kind::Libraries, data, pos)) {
+    return false;
+  }
+
+  CacheReader r(data, pos);
+  std::vector<ArduinoLibraryInfo> tmp(r.Count());
+  for (auto &lib : tmp) {
+    if (!r.Ok())
+      break;
+    ReadLibrary(r, lib);
+  }
+
+  if (!r.Ok()) {
+    return false;
+  }
+
+  out.swap(tmp);
+  return true;
+}
+
+void ArduinoCliDiskCache::StoreLibraries(const std::vector<ArduinoLibraryInfo> &libs, const Fingerprint &fp) const {
+  if (fp.kind != Kind::Libraries) {
+    return;
+  }
+
+  std::string payload;
+  CacheWriter w(payload);
+  w.U32((uint32_t)libs.size());
+  for (const auto &lib : libs)
+    WriteLibrary(w, lib);
+
+  WriteEntry(fp, payload);
+}
+
+bool ArduinoCliDiskCache::LoadCores(std::vector<ArduinoCoreInfo> &out) const {
+  std::string data;
+  size_t pos = 0;
+  if (!ReadEntry(Kind::Cores, data, pos)) {
+    return false;
+  }
+
+  CacheReader r(data, pos);
+  std::vector<ArduinoCoreInfo> tmp(r.Count());
+  for (auto &core : tmp) {
+    if (!r.Ok())
+      break;
+    ReadCore(r, core);
+  }
+
+  if (!r.Ok()) {
+    return false;
+  }
+
+  out.swap(tmp);
+  return true;
+}
+
+void ArduinoCliDiskCache::StoreCores(const std::vector<ArduinoCoreInfo> &cores, const Fingerprint &fp) const {
+  if (fp.kind != Kind::Cores) {
+    return;
+  }
+
+  std::string payload;
+  CacheWriter w(payload);
+  w.U32((uint32_t)cores.size());
+  for (const auto &core : cores)
+    WriteCore(w, core);
+
+  WriteEntry(fp, payload);
+}
+
+bool ArduinoCliDiskCache::LoadBoards(std::vector<ArduinoCoreBoard> &out) const {
+  std::string data;
+  size_t pos = 0;
+  if (!ReadEntry(Kind::Boards, data, pos)) {
+    return false;
+  }
+
+  CacheReader r(data, pos);
+  std::vector<ArduinoCoreBoard> tmp;
+  const uint32_t n = r.Count();
+  tmp.reserve(n);
+  for (uint32_t i = 0; i < n && r.Ok(); i++)
+    tmp.push_back(ReadBoard(r));
+
+  if (!r.Ok()) {
+    return false;
+  }
+
+  out.swap(tmp);
+  return true;
+}
+
+void ArduinoCliDiskCache::StoreBoards(const std::vector<ArduinoCoreBoard> &boards, const Fingerprint &fp) const {
+  if (fp.kind != Kind::Boards) {
+    return;
+  }
+
+  std::string payload;
+  CacheWriter w(payload);
+  w.U32((uint32_t)boards.size());
+  for (const auto &b : boards)
+    WriteBoard(w, b);
+
+  WriteEntry(fp, payload);
+}
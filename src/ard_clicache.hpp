@@ -0,0 +1,91 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ard_cli.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Persistent cache of parsed arduino-cli listings (library index, cores,
+ * installed boards) in a compact binary format.
+ *
+ * Every entry remembers the arduino-cli data/user directories it was built
+ * with and a fingerprint (path, mtime, size) of the files the listing is
+ * derived from: the cli executable, arduino-cli.yaml, library_index.json,
+ * package_*index.json and the platform.txt / boards.txt of installed
+ * platforms. An entry is used only while the fingerprint is unchanged, so a
+ * warm start skips both the arduino-cli run and the JSON parse.
+ *
+ * Entries live in <cache>/cli, one file per listing and cli executable.
+ * Methods can be called from any thread.
+ *
+ * The fingerprint has to be taken before the listing is produced (see
+ * Fingerprint), otherwise a file changed during the arduino-cli run would be
+ * stored as if the listing reflected it.
+ */
+class ArduinoCliDiskCache {
+public:
+  enum class Kind : uint32_t {
+    Libraries = 1,
+    Cores = 2,
+    Boards = 3,
+  };
+
+  struct FileStamp {
+    std::string path;
+    int64_t mtime = 0;
+    uint64_t size = 0;
+
+    bool operator==(const FileStamp &o) const { return path == o.path && mtime == o.mtime && size == o.size; }
+  };
+
+  // Files state the stored listing is derived from.
+  struct Fingerprint {
+    Kind kind = Kind::Libraries;
+    std::string dataDir;
+    std::string userDir;
+    std::vector<FileStamp> stamps;
+  };
+
+  explicit ArduinoCliDiskCache(std::string cliPath);
+
+  Fingerprint TakeFingerprint(Kind kind, const std::string &dataDir, const std::string &userDir) const;
+
+  bool LoadLibraries(std::vector<ArduinoLibraryInfo> &out) const;
+  void StoreLibraries(const std::vector<ArduinoLibraryInfo> &libs, const Fingerprint &fp) const;
+
+  bool LoadCores(std::vector<ArduinoCoreInfo> &out) const;
+  void StoreCores(const std::vector<ArduinoCoreInfo> &cores, const Fingerprint &fp) const;
+
+  bool LoadBoards(std::vector<ArduinoCoreBoard> &out) const;
+  void StoreBoards(const std::vector<ArduinoCoreBoard> &boards, const Fingerprint &fp) const;
+
+private:
+  std::string GetEntryPath(Kind kind) const;
+  std::vector<FileStamp> CollectStamps(Kind kind, const std::string &dataDir, const std::string &userDir) const;
+
+  // Reads the entry header and validates the fingerprint; payload follows at the returned offset.
+  bool ReadEntry(Kind kind, std::string &data, size_t &payloadPos) const;
+  void WriteEntry(const Fingerprint &fp, const std::string &payload) const;
+
+  std::string m_cliPath;
+};
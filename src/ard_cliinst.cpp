@@ -222,6 +222,9 @@ bool ArduinoCliInstaller::InstallBaseToolchain(const wxString &cliPath, wxProgre
 
     worker.join();
 
+    // toolchain setup changes cores / indexes
+    ArduinoCli::InvalidateQueryCache();
+
     if (cancel.load(std::memory_order_acquire)) {
       prog->Update(100);
       ModalMsgDialog(_("Toolchain setup was cancelled."), _("Cancelled"), wxOK | wxICON_INFORMATION);
@@ -26,9 +26,34 @@
 #include "ard_edit.hpp"
 #include "utils.hpp"
 
+#include <functional>
+#include <unordered_set>
+
 wxDEFINE_EVENT(EVT_ARD_DIAG_JUMP, ArduinoDiagnosticsActionEvent);
 wxDEFINE_EVENT(EVT_ARD_DIAG_SOLVE_AI, ArduinoDiagnosticsActionEvent);
 
+namespace {
+
+struct DiagPtrHash {
+  size_t operator()(const ArduinoParseError *e) const {
+    size_t h = std::hash<std::string>()(e->file);
+    h = h * 31 + std::hash<std::string>()(e->message);
+    h = h * 31 + (size_t)e->line;
+    h = h * 31 + (size_t)e->column;
+    h = h * 31 + (size_t)e->severity;
+    return h;
+  }
+};
+
+struct DiagPtrEqual {
+  bool operator()(const ArduinoParseError *a, const ArduinoParseError *b) const {
+    return a->line == b->line && a->column == b->column && a->severity == b->severity &&
+           a->file == b->file && a->message == b->message;
+  }
+};
+
+} // namespace
+
 ArduinoDiagnosticsView::ArduinoDiagnosticsView(wxWindow *parent, wxConfigBase *config)
     : wxPanel(parent, wxID_ANY), m_config(config), m_aiEnabled(false) {
   auto *sizer = new wxBoxSizer(wxVERTICAL);
@@ -67,7 +92,7 @@ void ArduinoDiagnosticsView::ApplySettings(const EditorSettings &settings) {
   if (!m_currentMessage.IsEmpty()) {
     ShowMessage(m_currentMessage);
   } else {
-    SetDiagnostics(m_current);
+    RebuildList(m_current);
   }
 }
 
@@ -100,6 +125,8 @@ void ArduinoDiagnosticsView::ApplySettings(const AiSettings &settings) {
 
 void ArduinoDiagnosticsView::ShowMessage(const wxString &message) {
   m_current.clear();
+  m_complete.clear();
+  m_units.clear();
   m_currentMessage = message;
 
   m_list->Freeze();
@@ -161,6 +188,51 @@ bool ArduinoDiagnosticsView::GetDiagnosticsAt(const std::string &filename, unsig
 }
 
 void ArduinoDiagnosticsView::SetDiagnostics(const std::vector<ArduinoParseError> &diags) {
+  m_complete = diags;
+  m_units.clear();
+
+  RebuildList(diags);
+}
+
+void ArduinoDiagnosticsView::UpdateUnitDiagnostics(const std::string &unitKey, const std::vector<ArduinoParseError> &diags) {
+  const std::string unitFile = NormalizeFilename(m_sketchRoot, unitKey);
+  m_units[unitFile] = diags;
+
+  // fresh units first (in stable file order), then whatever of the last
+  // complete result does not belong to an already reparsed file
+  std::vector<ArduinoParseError> merged;
+  size_t total = m_complete.size();
+  for (const auto &kv : m_units) {
+    total += kv.second.size();
+  }
+  merged.reserve(total); // seen keeps pointers into merged
+
+  std::unordered_set<const ArduinoParseError *, DiagPtrHash, DiagPtrEqual> seen;
+  seen.reserve(total);
+
+  for (const auto &kv : m_units) {
+    for (const auto &e : kv.second) {
+      merged.push_back(e);
+      seen.insert(&merged.back());
+    }
+  }
+
+  for (const auto &e : m_complete) {
+    if (m_units.find(NormalizeFilename(m_sketchRoot, e.file)) != m_units.end())
+      continue;
+
+    if (seen.find(&e) != seen.end())
+      continue;
+
+    merged.push_back(e);
+    seen.insert(&merged.back());
+  }
+
+  // an empty result is valid too - the last error of the unit was just fixed
+  RebuildList(merged);
+}
+
+void ArduinoDiagnosticsView::RebuildList(const std::vector<ArduinoParseError> &diags) {
   m_current = diags;
   m_currentMessage = wxEmptyString;
 
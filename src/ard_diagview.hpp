@@ -25,6 +25,7 @@
 #include <wx/listctrl.h>
 #include <wx/panel.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -70,6 +71,13 @@ public:
 
   void SetDiagnostics(const std::vector<ArduinoParseError> &diags);
 
+  // Partial results of a running project diagnostics pass. Diagnostics of one
+  // translation unit (unitKey = its source file) replace the previous ones of that
+  // file, the rest of the last complete result stays visible until SetDiagnostics().
+  void UpdateUnitDiagnostics(const std::string &unitKey, const std::vector<ArduinoParseError> &diags);
+  // Pass finished without change of the complete result; forgets partial units.
+  void EndUnitDiagnostics() { m_units.clear(); }
+
   void ShowMessage(const wxString &message);
 
   bool GetDiagnosticsAt(const std::string &filename, unsigned row, unsigned col, std::vector<ArduinoParseError> &outDiagnostics);
@@ -89,6 +97,8 @@ private:
   void CopyAll();
   void RequestSolveAi();
 
+  void RebuildList(const std::vector<ArduinoParseError> &diags);
+
   wxString GetRowText(long row) const;
   long GetSelectedRow() const;
 
@@ -108,5 +118,8 @@ private:
   std::string m_sketchRoot;
 
   std::vector<ArduinoParseError> m_current;
+  // last complete result + partial units of the running pass
+  std::vector<ArduinoParseError> m_complete;
+  std::map<std::string, std::vector<ArduinoParseError>> m_units;
   wxString m_currentMessage;
 };
@@ -138,7 +138,7 @@ void ArduinoDiffDialog::BuildUi(const std::vector<SketchFileBuffer> &buffersOld,
   for (const auto &b : buffersOld) {
     const wxString fn = wxString::FromUTF8(b.filename.c_str());
     const wxString key = NormalizeKey(fn);
-    mapKeyToOldText[key.ToStdWstring()] = wxString::FromUTF8(b.code.c_str());
+    mapKeyToOldText[key.ToStdWstring()] = wxString::FromUTF8(b.Code().c_str());
   }
 
   for (size_t i = 0; i < buffersNew.size(); ++i) {
@@ -146,7 +146,7 @@ void ArduinoDiffDialog::BuildUi(const std::vector<SketchFileBuffer> &buffersOld,
     const wxString fn = wxString::FromUTF8(b.filename.c_str());
     const wxString key = NormalizeKey(fn);
     const std::wstring wk = key.ToStdWstring();
-    mapKeyToNewText[wk] = wxString::FromUTF8(b.code.c_str());
+    mapKeyToNewText[wk] = wxString::FromUTF8(b.Code().c_str());
     mapKeyToNewIndex[wk] = i;
   }
 
@@ -535,6 +535,8 @@ void ArduinoDiffDialog::UpdateExistingTabView(FileViewData &v) {
     v.right->SetFirstVisibleLine(rightFirst);
     v.right->SetXOffset(rightX);
   }
+
+  ApplyWordIndicators(v.left, v.right, left, right, kinds);
 }
 
 void ArduinoDiffDialog::BuildContextAlignedExistingFileView(
@@ -652,12 +654,21 @@ void ArduinoDiffDialog::SetupDiffIndicators(wxStyledTextCtrl *stc) {
   stc->IndicatorSetStyle(23, wxSTC_INDIC_STRAIGHTBOX);
   stc->IndicatorSetForeground(23, wxColour(220, 220, 220));
   stc->IndicatorSetAlpha(23, 60);
+
+  // Changed words inside modified lines (removed / added)
+  stc->IndicatorSetStyle(24, wxSTC_INDIC_STRAIGHTBOX);
+  stc->IndicatorSetForeground(24, wxColour(255, 120, 120));
+  stc->IndicatorSetAlpha(24, 110);
+
+  stc->IndicatorSetStyle(25, wxSTC_INDIC_STRAIGHTBOX);
+  stc->IndicatorSetForeground(25, wxColour(100, 210, 100));
+  stc->IndicatorSetAlpha(25, 110);
 }
 
 void ArduinoDiffDialog::ApplyLineIndicators(wxStyledTextCtrl *stc, const std::vector<DiffLineKind> &kinds) {
   // clear
   const int len = stc->GetTextLength();
-  for (int id : {20, 21, 22, 23}) {
+  for (int id : {20, 21, 22, 23, 24, 25}) {
     stc->SetIndicatorCurrent(id);
     stc->IndicatorClearRange(0, len);
   }
@@ -695,6 +706,45 @@ void ArduinoDiffDialog::ApplyLineIndicators(wxStyledTextCtrl *stc, const std::ve
   }
 }
 
+void ArduinoDiffDialog::ApplyWordIndicators(wxStyledTextCtrl *left,
+                                            wxStyledTextCtrl *right,
+                                            const wxString &leftAligned,
+                                            const wxString &rightAligned,
+                                            const std::vector<DiffLineKind> &kinds) {
+  if (!left || !right)
+    return;
+
+  const std::vector<wxString> L = SplitLinesKeepLogical(leftAligned);
+  const std::vector<wxString> R = SplitLinesKeepLogical(rightAligned);
+  const size_t n = std::min({kinds.size(), L.size(), R.size()});
+
+  std::vector<ArduinoLcsDiffAligner::WordRange> rangesL, rangesR;
+
+  // STC positions are UTF-8 byte offsets, the same as the ranges
+  auto fill = [](wxStyledTextCtrl *stc, int indic, int line, const std::vector<ArduinoLcsDiffAligner::WordRange> &ranges) {
+    const int start = stc->PositionFromLine(line);
+    stc->SetIndicatorCurrent(indic);
+    for (const auto &r : ranges) {
+      stc->IndicatorFillRange(start + r.start, r.end - r.start);
+    }
+  };
+
+  for (size_t i = 0; i < n; ++i) {
+    if (kinds[i] != DiffLineKind::Modified)
+      continue;
+
+    const wxScopedCharBuffer ua = L[i].utf8_str();
+    const wxScopedCharBuffer ub = R[i].utf8_str();
+    if (!ArduinoLcsDiffAligner::DiffWords(std::string(ua.data(), ua.length()),
+                                          std::string(ub.data(), ub.length()),
+                                          rangesL, rangesR))
+      continue;
+
+    fill(left, 24, (int)i, rangesL);
+    fill(right, 25, (int)i, rangesR);
+  }
+}
+
 static bool IsHeaderLine(const wxString &s) {
   return s.StartsWith(wxT("-------- "));
 }
@@ -124,6 +124,11 @@ private:
   void SetupDiffIndicators(wxStyledTextCtrl *stc);
   std::vector<DiffLineKind> ComputeLineKindsFromAlignedText(const wxString &leftAligned, const wxString &rightAligned);
   void ApplyLineIndicators(wxStyledTextCtrl *stc, const std::vector<DiffLineKind> &kinds);
+  void ApplyWordIndicators(wxStyledTextCtrl *left,
+                           wxStyledTextCtrl *right,
+                           const wxString &leftAligned,
+                           const wxString &rightAligned,
+                           const std::vector<DiffLineKind> &kinds);
 
 private:
   wxNotebook *m_notebook = nullptr;
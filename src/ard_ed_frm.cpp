@@ -1346,7 +1346,7 @@ void ArduinoEditorFrame::OnFindSymbol(wxCommandEvent &WXUNUSED(event)) {
 }
 
 void ArduinoEditorFrame::OnSymbolActivated(ArduinoSymbolActivatedEvent &evt) {
-  const SymbolInfo &s = evt.GetSymbol();
+  SymbolInfo s = evt.GetSymbol();
 
   if (auto *editor = GetCurrentEditor()) {
     int line, column;
@@ -1354,6 +1354,12 @@ void ArduinoEditorFrame::OnSymbolActivated(ArduinoSymbolActivatedEvent &evt) {
     PushNavLocation(editor->GetFilePath(), line, column);
   }
 
+  // a prototype leads to its body when the symbol index knows it
+  SymbolInfo def;
+  if (completion && completion->FindIndexedDefinition(s, def)) {
+    s = std::move(def);
+  }
+
   JumpTarget tgt;
   tgt.file = s.file;
   tgt.line = s.line;
@@ -1852,6 +1858,35 @@ void ArduinoEditorFrame::ShowSingleDiagMessage(const wxString &message) {
   }
 }
 
+// Partial project diagnostics - one file finished while the rest is still being parsed.
+void ArduinoEditorFrame::OnDiagnosticsFileReady(wxThreadEvent &evt) {
+  if (!completion || !m_diagView || !completion->IsReady()) {
+    return;
+  }
+
+  if (m_clangSettings.diagnosticMode != completeProject) {
+    return;
+  }
+
+  ArduinoEditor *ed = GetCurrentEditor();
+  if (ed && ed->IsAutoCompActive()) {
+    return;
+  }
+
+  auto errors = evt.GetPayload<std::vector<ArduinoParseError>>();
+
+  std::vector<ArduinoParseError> dispDiagnostic;
+  for (auto &diag : errors) {
+    dispDiagnostic.push_back(diag);
+    for (auto &child : diag.childs) {
+      dispDiagnostic.push_back(child);
+    }
+  }
+
+  m_diagView->SetSketchRoot(arduinoCli->GetSketchPath());
+  m_diagView->UpdateUnitDiagnostics(wxToStd(evt.GetString()), dispDiagnostic);
+}
+
 void ArduinoEditorFrame::OnDiagnosticsUpdated(wxThreadEvent &evt) {
   StopProcess(ID_PROCESS_DIAG_EVAL);
 
@@ -1868,6 +1903,7 @@ void ArduinoEditorFrame::OnDiagnosticsUpdated(wxThreadEvent &evt) {
   size_t newHash = ArduinoCodeCompletion::ComputeDiagHash(errors);
   if ((m_lastDiagHash != 0) && (m_lastDiagHash == newHash)) {
     // Diagnostic not changed
+    m_diagView->EndUnitDiagnostics();
     return;
   }
 
@@ -1984,9 +2020,9 @@ void ArduinoEditorFrame::CollectEditorSources(std::vector<SketchFileBuffer> &fil
   // 1) Collect buffers from all open editors (these override disk content)
   for (auto *e : GetAllEditors(/*onlyEditable=*/true)) {
     std::string filename = e->GetFilePath();
-    std::string code = e->GetText();
+    std::shared_ptr<const std::string> code = e->GetTextSnapshot();
 
-    APP_DEBUG_LOG("FRM: - added %s with code size %d", filename.c_str(), code.size());
+    APP_DEBUG_LOG("FRM: - added %s with code size %d", filename.c_str(), code->size());
 
     files.push_back(SketchFileBuffer{filename, std::move(code)});
   }
@@ -2395,6 +2431,11 @@ void ArduinoEditorFrame::OnShowLibraryManager(wxCommandEvent &WXUNUSED(evt)) {
     }
 
     m_libManager = new ArduinoLibraryManagerFrame(this, arduinoCli, m_availableBoards, config, _("All"));
+  } else {
+    // reopening is the user's refresh - pick up libraries changed outside the editor
+    ArduinoCli::InvalidateQueryCache();
+    StartProcess(_("Loading installed libraries..."), ID_PROCESS_LOAD_INSTALLED_LIBRARIES, ArduinoActivityState::Background);
+    arduinoCli->LoadInstalledLibrariesAsync(this);
   }
   m_libManager->Show();
   m_libManager->Raise();
@@ -2705,6 +2746,7 @@ void ArduinoEditorFrame::BindEvents() {
 
   Bind(wxEVT_CLOSE_WINDOW, &ArduinoEditorFrame::OnClose, this);
   Bind(EVT_DIAGNOSTICS_UPDATED, &ArduinoEditorFrame::OnDiagnosticsUpdated, this);
+  Bind(EVT_DIAGNOSTICS_FILE_READY, &ArduinoEditorFrame::OnDiagnosticsFileReady, this);
   Bind(EVT_FILE_MONITOR_CHANGED, &ArduinoEditorFrame::OnFileMonitorChanged, this);
   Bind(wxEVT_TIMER, &ArduinoEditorFrame::OnDiagTimer, this, m_diagTimer.GetId());
   Bind(wxEVT_TIMER, &ArduinoEditorFrame::OnReturnBottomPageTimer, this, m_returnBottomPageTimer.GetId());
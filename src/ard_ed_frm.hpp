@@ -236,6 +236,7 @@ private:
 
   void ShowSingleDiagMessage(const wxString &message);
   void OnDiagnosticsUpdated(wxThreadEvent &evt);
+  void OnDiagnosticsFileReady(wxThreadEvent &evt);
   void OnDiagTimer(wxTimerEvent &event);
   void RefreshDiagnostics();
   void OnDiagItemActivated(wxListEvent &event);
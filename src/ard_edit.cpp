@@ -410,7 +410,18 @@ bool ArduinoEditor::IsReadOnly() const {
 }
 
 std::string ArduinoEditor::GetText() const {
-  return wxToStd(m_editor->GetText());
+  return *GetTextSnapshot();
+}
+
+std::shared_ptr<const std::string> ArduinoEditor::GetTextSnapshot() const {
+  if (!m_textSnapshot || m_textSnapshotVersion != m_textVersion) {
+    // Scintilla keeps the document as UTF-8 already, no need for a wxString round trip
+    const char *data = m_editor->GetCharacterPointer();
+    const int len = m_editor->GetLength();
+    m_textSnapshot = std::make_shared<const std::string>(data ? data : "", data ? (size_t)len : 0);
+    m_textSnapshotVersion = m_textVersion;
+  }
+  return m_textSnapshot;
 }
 
 void ArduinoEditor::SetText(const std::string &text) {
@@ -715,7 +726,7 @@ void ArduinoEditor::FindSymbolUsagesAtCursor() {
   int column = 0;
   GetCurrentCursor(line, column); // 1-based
 
-  std::string code = wxToStd(m_editor->GetText());
+  std::string code = GetText();
 
   // new request ID
   uint64_t seq = ++m_usagesSeq;
@@ -727,7 +738,7 @@ void ArduinoEditor::FindSymbolUsagesAtCursor() {
   completion->FindSymbolOccurrencesProjectWideAsync(
       files,
       m_filePath,
-      wxToStd(m_editor->GetText()),
+      GetText(),
       line,
       column,
       /*onlyFromSketch=*/false,
@@ -785,7 +796,7 @@ static wxString MakeUsageContext(const SketchFileBuffer &buf,
     return wxString();
   }
 
-  const std::string &code = buf.code;
+  const std::string &code = buf.Code();
   if (code.empty() || line == 0) {
     return wxString();
   }
@@ -1942,7 +1953,8 @@ void ArduinoEditor::ShowAutoCompletion() {
   if (completion) {
     APP_DEBUG_LOG("EDIT: ShowAutoCompletion()");
     m_popupMode = PopupMode::Completion;
-    completion->ShowAutoCompletionAsync(m_editor, m_filePath, m_completionMetadata, this);
+    completion->ShowAutoCompletionAsync(
+        m_editor, m_filePath, [this]() { return GetTextSnapshot(); }, m_completionMetadata, this);
   }
 }
 
@@ -2138,6 +2150,8 @@ void ArduinoEditor::OnChanged(wxStyledTextEvent &event) {
     return;
   }
 
+  ++m_textVersion;
+
   ArduinoEditorFrame *frame = GetOwnerFrame();
   if (frame && !m_clangSettings.resolveDiagOnlyAfterSave) {
     frame->ScheduleDiagRefresh();
@@ -2244,7 +2258,7 @@ void ArduinoEditor::OnSymbolTimer(wxTimerEvent &WXUNUSED(event)) {
   const int line = m_editor->LineFromPosition(symPos) + 1;
   const int column = m_editor->GetColumn(symPos) + 1;
 
-  std::string code = wxToStd(m_editor->GetText());
+  std::string code = GetText();
 
   // new request id
   uint64_t seq = ++m_symbolHighlightSeq;
@@ -2528,7 +2542,7 @@ void ArduinoEditor::OnDwellStart(wxStyledTextEvent &event) {
   int line = m_editor->LineFromPosition(pos) + 1; // 1-based
   int column = m_editor->GetColumn(pos) + 1;      // 1-based
 
-  std::string code = wxToStd(m_editor->GetText());
+  std::string code = GetText();
 
   HoverInfo info;
   if (!completion->GetHoverInfo(m_filename, code, line, column, info)) {
@@ -2622,7 +2636,7 @@ void ArduinoEditor::OnEditorLeftDown(wxMouseEvent &event) {
 
 void ArduinoEditor::GotoSymbolDefinition() {
   // Find the definition using libclang
-  std::string code = wxToStd(m_editor->GetText());
+  std::string code = GetText();
 
   int line, column;
   GetCurrentCursor(line, column); // 1-based
@@ -52,6 +52,12 @@ private:
 
   wxStyledTextCtrl *m_editor;
 
+  // Text snapshot shared with completion/diagnostics workers, taken at most
+  // once per document version (bumped by every text modification).
+  uint64_t m_textVersion = 0;
+  mutable uint64_t m_textSnapshotVersion = 0;
+  mutable std::shared_ptr<const std::string> m_textSnapshot;
+
   SymbolOverviewBar *m_symbolOverview = nullptr;
 
   ArduinoCodeCompletion *completion;
@@ -219,6 +225,7 @@ public:
   std::string GetFileName() const;
   std::string GetFilePath() const;
   std::string GetText() const;
+  std::shared_ptr<const std::string> GetTextSnapshot() const;
   void SetText(const std::string &text);
   bool ReloadFromDisk();
 
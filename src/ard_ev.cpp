@@ -24,6 +24,8 @@ wxDEFINE_EVENT(EVT_COMPLETION_READY, wxThreadEvent);
 
 wxDEFINE_EVENT(EVT_DIAGNOSTICS_UPDATED, wxThreadEvent);
 
+wxDEFINE_EVENT(EVT_DIAGNOSTICS_FILE_READY, wxThreadEvent);
+
 wxDEFINE_EVENT(EVT_COMMANDLINE_OUTPUT_MSG, wxCommandEvent);
 
 wxDEFINE_EVENT(EVT_LIBRARIES_UPDATED, wxThreadEvent);
@@ -40,6 +42,10 @@ wxDEFINE_EVENT(wxEVT_SERIAL_MONITOR_DATA, wxThreadEvent);
 
 wxDEFINE_EVENT(wxEVT_SERIAL_MONITOR_ERROR, wxThreadEvent);
 
+wxDEFINE_EVENT(wxEVT_SERIAL_LOG_SCROLLED, wxCommandEvent);
+
+wxDEFINE_EVENT(wxEVT_SERIAL_PLOT_READY, wxThreadEvent);
+
 wxDEFINE_EVENT(EVT_BOARD_OPTIONS_READY, wxThreadEvent);
 
 wxDEFINE_EVENT(EVT_AVAILABLE_BOARDS_UPDATED, wxThreadEvent);
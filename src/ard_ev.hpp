@@ -28,6 +28,8 @@ wxDECLARE_EVENT(EVT_COMPLETION_READY, wxThreadEvent);
 
 // Event for error notification
 wxDECLARE_EVENT(EVT_DIAGNOSTICS_UPDATED, wxThreadEvent);
+// Partial result of project diagnostics (one source file, key in GetString())
+wxDECLARE_EVENT(EVT_DIAGNOSTICS_FILE_READY, wxThreadEvent);
 
 // Event for cmdline
 wxDECLARE_EVENT(EVT_COMMANDLINE_OUTPUT_MSG, wxCommandEvent);
@@ -44,6 +46,10 @@ wxDECLARE_EVENT(EVT_CORES_LOADED, wxThreadEvent);
 // Serial monitor
 wxDECLARE_EVENT(wxEVT_SERIAL_MONITOR_DATA, wxThreadEvent);
 wxDECLARE_EVENT(wxEVT_SERIAL_MONITOR_ERROR, wxThreadEvent);
+// User scrolled the serial log view (GetInt() != 0 -> last line visible)
+wxDECLARE_EVENT(wxEVT_SERIAL_LOG_SCROLLED, wxCommandEvent);
+// Plot parse stage has samples ready (posted once until they are taken)
+wxDECLARE_EVENT(wxEVT_SERIAL_PLOT_READY, wxThreadEvent);
 
 // Asynchronous event on GetBoardOptions/Programmers
 wxDECLARE_EVENT(EVT_BOARD_OPTIONS_READY, wxThreadEvent);
@@ -0,0 +1,144 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_fuzzy.hpp"
+
+#include <algorithm>
+
+namespace {
+
+constexpr int kScoreMatch = 16;
+constexpr int kPenaltyGapStart = 3;
+constexpr int kPenaltyGapExtension = 1;
+constexpr int kPenaltyLeading = 1; // per skipped char before the window (capped)
+constexpr int kMaxLeadingPenalty = 8;
+constexpr int kBonusBoundary = 8;
+constexpr int kBonusCamel = 7;
+constexpr int kBonusConsecutive = 4;
+constexpr int kBonusFirstCharMultiplier = 2;
+constexpr int kBonusCaseMatch = 1;
+
+inline char Lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+inline bool IsLowerAlpha(char c) { return c >= 'a' && c <= 'z'; }
+inline bool IsUpperAlpha(char c) { return c >= 'A' && c <= 'Z'; }
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+inline bool IsAlnum(char c) { return IsLowerAlpha(c) || IsUpperAlpha(c) || IsDigit(c); }
+
+// bonus for a match at text[i] depending on what precedes it
+int PositionBonus(std::string_view text, size_t i) {
+  const char c = text[i];
+  if (i == 0) {
+    return kBonusBoundary;
+  }
+  const char prev = text[i - 1];
+  if (!IsAlnum(prev) && IsAlnum(c)) {
+    return kBonusBoundary; // "_x", "::x"
+  }
+  if (IsLowerAlpha(prev) && IsUpperAlpha(c)) {
+    return kBonusCamel; // camelHump
+  }
+  if (IsAlnum(c) && IsDigit(prev) != IsDigit(c)) {
+    return kBonusCamel; // "x2", "2x"
+  }
+  return 0;
+}
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher(std::string_view pattern)
+    : m_pattern(pattern) {
+  m_lower.resize(m_pattern.size());
+  std::transform(m_pattern.begin(), m_pattern.end(), m_lower.begin(), Lower);
+}
+
+bool FuzzyMatcher::Match(std::string_view text, int &score) const {
+  score = 0;
+
+  const size_t m = m_lower.size();
+  if (m == 0) {
+    return true;
+  }
+  if (text.size() < m) {
+    return false;
+  }
+
+  // 1) forward: end of the first full match
+  size_t pi = 0;
+  size_t end = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (Lower(text[i]) == m_lower[pi] && ++pi == m) {
+      end = i + 1;
+      break;
+    }
+  }
+  if (pi < m) {
+    return false;
+  }
+
+  // 2) backward: the latest start still matching the whole pattern before end
+  size_t start = end;
+  pi = m;
+  while (start > 0) {
+    --start;
+    if (Lower(text[start]) == m_lower[pi - 1] && --pi == 0) {
+      break;
+    }
+  }
+
+  // 3) score the window [start, end)
+  int s = -std::min<int>((int)start * kPenaltyLeading, kMaxLeadingPenalty);
+  int run = 0;        // length of the current consecutive run
+  int runBonus = 0;   // bonus of the first char of the run
+  bool inGap = false;
+
+  pi = 0;
+  for (size_t i = start; i < end; ++i) {
+    const char c = text[i];
+    if (pi < m && Lower(c) == m_lower[pi]) {
+      int bonus = PositionBonus(text, i);
+      if (run == 0) {
+        runBonus = bonus;
+      } else {
+        // a run keeps the bonus of its start ("digitalWr" after "dig...")
+        bonus = std::max(bonus, std::max(runBonus, kBonusConsecutive));
+      }
+      if (pi == 0) {
+        bonus *= kBonusFirstCharMultiplier;
+      }
+
+      s += kScoreMatch + bonus;
+      if (c == m_pattern[pi]) {
+        s += kBonusCaseMatch;
+      }
+
+      ++run;
+      ++pi;
+      inGap = false;
+    } else {
+      s -= inGap ? kPenaltyGapExtension : kPenaltyGapStart;
+      inGap = true;
+      run = 0;
+    }
+  }
+
+  score = s;
+  return true;
+}
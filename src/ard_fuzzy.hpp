@@ -0,0 +1,47 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * Subsequence matcher used to filter completions (fzf / VS Code style).
+ *
+ * The pattern is lowercased once; every candidate is matched in a single
+ * forward pass plus a backward pass that shrinks the match window to the
+ * shortest one ending at the first full match. The window is then scored:
+ * matched characters, word starts ("_x", camelHumps, "x" after a digit)
+ * and consecutive runs are rewarded, gaps are penalized. Case-insensitive,
+ * an exact case match only adds a small bonus. ASCII only, other bytes
+ * must match exactly.
+ */
+class FuzzyMatcher {
+public:
+  explicit FuzzyMatcher(std::string_view pattern);
+
+  bool IsEmpty() const { return m_pattern.empty(); }
+
+  // false -> the pattern is not a subsequence of text; higher score = better
+  bool Match(std::string_view text, int &score) const;
+
+private:
+  std::string m_pattern;
+  std::string m_lower;
+};
@@ -0,0 +1,117 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_httppool.hpp"
+#include "utils.hpp"
+
+ArduinoHttpPool::Handle &ArduinoHttpPool::Handle::operator=(Handle &&o) noexcept {
+  if (this != &o) {
+    if (m_curl)
+      m_pool->Release(m_curl);
+    m_pool = o.m_pool;
+    m_curl = o.m_curl;
+    o.m_curl = nullptr;
+  }
+  return *this;
+}
+
+ArduinoHttpPool::Handle::~Handle() {
+  if (m_curl)
+    m_pool->Release(m_curl);
+}
+
+std::shared_ptr<ArduinoHttpPool> ArduinoHttpPool::Shared() {
+  static std::shared_ptr<ArduinoHttpPool> pool = std::make_shared<ArduinoHttpPool>();
+  return pool;
+}
+
+ArduinoHttpPool::ArduinoHttpPool() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+  });
+
+  m_share = curl_share_init();
+  if (m_share) {
+    curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &ArduinoHttpPool::LockShare);
+    curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &ArduinoHttpPool::UnlockShare);
+    curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // The connection cache stays per handle: sharing it between threads
+    // is not safe with every libcurl version.
+  }
+}
+
+ArduinoHttpPool::~ArduinoHttpPool() {
+  for (CURL *curl : m_idle) {
+    curl_easy_cleanup(curl);
+  }
+  m_idle.clear();
+
+  if (m_share)
+    curl_share_cleanup(m_share);
+}
+
+ArduinoHttpPool::Handle ArduinoHttpPool::Acquire() {
+  CURL *curl = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (!m_idle.empty()) {
+      curl = m_idle.back();
+      m_idle.pop_back();
+    }
+  }
+
+  if (!curl) {
+    curl = curl_easy_init();
+    if (!curl)
+      return Handle();
+    APP_DEBUG_LOG("HTTP: new pooled handle %p", (void *)curl);
+  }
+
+  if (m_share)
+    curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+
+  return Handle(this, curl);
+}
+
+void ArduinoHttpPool::Release(CURL *curl) {
+  // drops the options (incl. the share), keeps the connections
+  curl_easy_reset(curl);
+
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_idle.size() < kMaxIdle) {
+      m_idle.push_back(curl);
+      return;
+    }
+  }
+
+  curl_easy_cleanup(curl);
+}
+
+void ArduinoHttpPool::LockShare(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+  auto *self = static_cast<ArduinoHttpPool *>(userptr);
+  self->m_shareLocks[data].lock();
+}
+
+void ArduinoHttpPool::UnlockShare(CURL *, curl_lock_data data, void *userptr) {
+  auto *self = static_cast<ArduinoHttpPool *>(userptr);
+  self->m_shareLocks[data].unlock();
+}
@@ -0,0 +1,85 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <curl/curl.h>
+
+/**
+ * Process-wide pool of libcurl easy handles.
+ *
+ * Every handle is attached to one share handle holding the DNS cache and the
+ * TLS session cache, so even a fresh handle skips name resolution and does an
+ * abbreviated TLS handshake. Finished handles are only reset (curl_easy_reset
+ * keeps their live connections), so back-to-back requests to the same host
+ * reuse a warm connection.
+ *
+ * Holders keep the pool alive with the shared_ptr, detached workers included.
+ */
+class ArduinoHttpPool {
+public:
+  // Easy handle borrowed from the pool, returned (reset) on destruction.
+  class Handle {
+  public:
+    Handle() = default;
+    Handle(Handle &&o) noexcept : m_pool(o.m_pool), m_curl(o.m_curl) { o.m_curl = nullptr; }
+    Handle &operator=(Handle &&o) noexcept;
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+    ~Handle();
+
+    CURL *get() const { return m_curl; }
+    explicit operator bool() const { return m_curl != nullptr; }
+
+  private:
+    friend class ArduinoHttpPool;
+    Handle(ArduinoHttpPool *pool, CURL *curl) : m_pool(pool), m_curl(curl) {}
+
+    ArduinoHttpPool *m_pool = nullptr;
+    CURL *m_curl = nullptr;
+  };
+
+  static std::shared_ptr<ArduinoHttpPool> Shared();
+
+  ArduinoHttpPool();
+  ~ArduinoHttpPool();
+
+  ArduinoHttpPool(const ArduinoHttpPool &) = delete;
+  ArduinoHttpPool &operator=(const ArduinoHttpPool &) = delete;
+
+  // Empty handle when libcurl fails to create one.
+  Handle Acquire();
+
+private:
+  static constexpr size_t kMaxIdle = 4;
+
+  CURLSH *m_share = nullptr;
+  std::mutex m_shareLocks[CURL_LOCK_DATA_LAST];
+
+  std::mutex m_mutex;
+  std::vector<CURL *> m_idle; // most recently used at the back
+
+  void Release(CURL *curl);
+
+  static void LockShare(CURL *, curl_lock_data data, curl_lock_access, void *userptr);
+  static void UnlockShare(CURL *, curl_lock_data data, void *userptr);
+};
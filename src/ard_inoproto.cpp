@@ -0,0 +1,580 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_inoproto.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct Token {
+  enum Kind { Ident,
+              Number,
+              Literal,
+              Punct };
+
+  Kind kind;
+  std::string_view text;
+  unsigned line;
+  bool spaceBefore; // whitespace or comment between this and the previous token
+};
+
+static bool IsIdentStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (unsigned char)c >= 0x80;
+}
+
+static bool IsIdentChar(char c) {
+  return IsIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+class InoTokenizer {
+public:
+  explicit InoTokenizer(std::string_view code) : m_code(code) {}
+
+  // false at the end of the code
+  bool Next(Token &out) {
+    while (m_pos < m_code.size()) {
+      const char c = m_code[m_pos];
+
+      if (c == '\n') {
+        ++m_line;
+        ++m_pos;
+        m_lineStart = true;
+        m_space = true;
+        continue;
+      }
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+        ++m_pos;
+        m_space = true;
+        continue;
+      }
+      if (c == '\\' && m_pos + 1 < m_code.size() && m_code[m_pos + 1] == '\n') {
+        m_pos += 2;
+        ++m_line;
+        continue;
+      }
+      if (c == '/' && Peek(1) == '/') {
+        SkipLineComment();
+        continue;
+      }
+      if (c == '/' && Peek(1) == '*') {
+        SkipBlockComment();
+        continue;
+      }
+      if (c == '#' && m_lineStart) {
+        Directive();
+        continue;
+      }
+
+      m_lineStart = false;
+      const size_t start = m_pos;
+      const unsigned line = m_line;
+      Token::Kind kind;
+
+      if (IsIdentStart(c)) {
+        while (m_pos < m_code.size() && IsIdentChar(m_code[m_pos])) {
+          ++m_pos;
+        }
+        kind = Token::Ident;
+        // R"delim(...)delim", also with u8/u/U/L prefix
+        const std::string_view word = m_code.substr(start, m_pos - start);
+        if (Peek(0) == '"' && (word == "R" || word == "u8R" || word == "uR" || word == "UR" || word == "LR")) {
+          SkipRawString();
+          kind = Token::Literal;
+        }
+      } else if ((c >= '0' && c <= '9') || (c == '.' && Peek(1) >= '0' && Peek(1) <= '9')) {
+        Number();
+        kind = Token::Number;
+      } else if (c == '"' || c == '\'') {
+        SkipQuoted(c);
+        kind = Token::Literal;
+      } else {
+        kind = Token::Punct;
+        if ((c == ':' && Peek(1) == ':') || (c == '-' && Peek(1) == '>')) {
+          m_pos += 2;
+        } else if (c == '.' && Peek(1) == '.' && Peek(2) == '.') {
+          m_pos += 3;
+        } else {
+          ++m_pos;
+        }
+      }
+
+      out = Token{kind, m_code.substr(start, m_pos - start), line, m_space};
+      m_space = false;
+      return true;
+    }
+    return false;
+  }
+
+private:
+  std::string_view m_code;
+  size_t m_pos = 0;
+  unsigned m_line = 1;
+  bool m_lineStart = true;
+  bool m_space = false;
+
+  char Peek(size_t off) const {
+    return m_pos + off < m_code.size() ? m_code[m_pos + off] : '\0';
+  }
+
+  void SkipLineComment() {
+    // a backslash-newline continues the comment
+    while (m_pos < m_code.size() && m_code[m_pos] != '\n') {
+      if (m_code[m_pos] == '\\' && Peek(1) == '\n') {
+        ++m_line;
+        ++m_pos;
+      }
+      ++m_pos;
+    }
+    m_space = true;
+  }
+
+  void SkipBlockComment() {
+    m_pos += 2;
+    while (m_pos < m_code.size() && !(m_code[m_pos] == '*' && Peek(1) == '/')) {
+      if (m_code[m_pos] == '\n') {
+        ++m_line;
+      }
+      ++m_pos;
+    }
+    m_pos = std::min(m_pos + 2, m_code.size());
+    m_space = true;
+  }
+
+  void SkipQuoted(char quote) {
+    ++m_pos;
+    while (m_pos < m_code.size()) {
+      const char c = m_code[m_pos];
+      if (c == '\\') {
+        if (Peek(1) == '\n') {
+          ++m_line;
+        }
+        m_pos += 2;
+        continue;
+      }
+      if (c == '\n') {
+        return; // unterminated, the newline ends it
+      }
+      ++m_pos;
+      if (c == quote) {
+        return;
+      }
+    }
+  }
+
+  void SkipRawString() {
+    const size_t open = m_code.find('(', m_pos);
+    if (open == std::string_view::npos) {
+      m_pos = m_code.size();
+      return;
+    }
+
+    std::string terminator = ")";
+    terminator.append(m_code.substr(m_pos + 1, open - m_pos - 1));
+    terminator.push_back('"');
+
+    size_t close = m_code.find(terminator, open + 1);
+    close = (close == std::string_view::npos) ? m_code.size() : close + terminator.size();
+    for (size_t i = m_pos; i < close; ++i) {
+      if (m_code[i] == '\n') {
+        ++m_line;
+      }
+    }
+    m_pos = close;
+  }
+
+  void Number() {
+    ++m_pos;
+    while (m_pos < m_code.size()) {
+      const char c = m_code[m_pos];
+      if ((c == '+' || c == '-') && std::strchr("eEpP", m_code[m_pos - 1])) {
+        ++m_pos;
+      } else if (c == '\'' && IsIdentChar(Peek(1))) {
+        m_pos += 2; // digit separator
+      } else if (IsIdentChar(c) || c == '.') {
+        ++m_pos;
+      } else {
+        break;
+      }
+    }
+  }
+
+  // Reads one logical preprocessor line (without comments) into out.
+  void ReadDirectiveLine(std::string &out) {
+    out.clear();
+    while (m_pos < m_code.size() && m_code[m_pos] != '\n') {
+      const char c = m_code[m_pos];
+      if (c == '\\' && Peek(1) == '\n') {
+        m_pos += 2;
+        ++m_line;
+        out.push_back(' ');
+      } else if (c == '/' && Peek(1) == '/') {
+        SkipLineComment();
+      } else if (c == '/' && Peek(1) == '*') {
+        SkipBlockComment();
+        out.push_back(' ');
+      } else {
+        out.push_back(c);
+        ++m_pos;
+      }
+    }
+  }
+
+  static std::string_view Word(std::string_view s, size_t &pos) {
+    while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\r' || s[pos] == '#')) {
+      ++pos;
+    }
+    const size_t start = pos;
+    while (pos < s.size() && IsIdentChar(s[pos])) {
+      ++pos;
+    }
+    if (pos == start && pos < s.size()) {
+      ++pos;
+    }
+    return s.substr(start, pos - start);
+  }
+
+  // Skips the directive, for "#if 0" also the whole disabled group.
+  void Directive() {
+    std::string text;
+    ReadDirectiveLine(text);
+    m_space = true;
+
+    size_t pos = 0;
+    if (Word(text, pos) != "if") {
+      return;
+    }
+    const std::string_view cond = Word(text, pos);
+    if ((cond != "0" && cond != "false") || !Word(text, pos).empty()) {
+      return;
+    }
+
+    int depth = 0;
+    while (m_pos < m_code.size()) {
+      // at '\n' or at the end
+      ++m_pos;
+      ++m_line;
+
+      size_t p = m_pos;
+      while (p < m_code.size() && (m_code[p] == ' ' || m_code[p] == '\t')) {
+        ++p;
+      }
+      if (p >= m_code.size() || m_code[p] != '#') {
+        m_pos = m_code.find('\n', m_pos);
+        if (m_pos == std::string_view::npos) {
+          m_pos = m_code.size();
+        }
+        continue;
+      }
+
+      m_pos = p;
+      ReadDirectiveLine(text);
+      size_t wp = 0;
+      const std::string_view d = Word(text, wp);
+      if (d == "if" || d == "ifdef" || d == "ifndef") {
+        ++depth;
+      } else if (d == "endif") {
+        if (depth-- == 0) {
+          return;
+        }
+      } else if (depth == 0 && (d == "else" || d == "elif" || d == "elifdef" || d == "elifndef")) {
+        return; // the rest of the group is live code
+      }
+    }
+  }
+};
+
+static bool Is(const Token &t, const char *text) {
+  return t.text == text;
+}
+
+static bool IsPunct(const Token &t, char c) {
+  return t.kind == Token::Punct && t.text.size() == 1 && t.text[0] == c;
+}
+
+// Index of the token closing the group opened at open, or end.
+static size_t MatchGroup(const std::vector<Token> &toks, size_t open, size_t end) {
+  const char o = toks[open].text[0];
+  const char c = (o == '(') ? ')' : (o == '[') ? ']' : '}';
+  int depth = 0;
+  for (size_t i = open; i < end; ++i) {
+    if (IsPunct(toks[i], o)) {
+      ++depth;
+    } else if (IsPunct(toks[i], c) && --depth == 0) {
+      return i;
+    }
+  }
+  return end;
+}
+
+static void AppendTokens(const std::vector<Token> &toks, size_t from, size_t to, std::string &out) {
+  for (size_t i = from; i < to; ++i) {
+    if (toks[i].spaceBefore && !out.empty() && out.back() != ' ' && out.back() != '(') {
+      out.push_back(' ');
+    }
+    out.append(toks[i].text);
+  }
+}
+
+// Parenthesized groups which belong to a declaration specifier, not to the declarator.
+static bool IsSpecifierWithArgs(const Token &t) {
+  return t.kind == Token::Ident &&
+         (Is(t, "decltype") || Is(t, "__attribute__") || Is(t, "__declspec") ||
+          Is(t, "alignas") || Is(t, "noexcept") || Is(t, "throw"));
+}
+
+// "(a, int b = 1)" -> "(a, int b)", "(void)" -> "()"
+static std::string FormatParams(const std::vector<Token> &toks, size_t open, size_t close) {
+  std::vector<std::string> params;
+  std::string cur;
+  int depth = 0;
+  int angle = 0;
+  bool inDefault = false;
+
+  for (size_t i = open + 1; i < close; ++i) {
+    const Token &t = toks[i];
+    if (t.kind == Token::Punct) {
+      const char c = t.text[0];
+      if (c == '(' || c == '[' || c == '{') {
+        ++depth;
+      } else if (c == ')' || c == ']' || c == '}') {
+        --depth;
+      } else if (c == '<' && !inDefault) {
+        ++angle;
+      } else if (c == '>' && !inDefault && angle > 0) {
+        --angle;
+      } else if (c == ',' && depth == 0 && angle == 0) {
+        params.push_back(std::move(cur));
+        cur.clear();
+        inDefault = false;
+        continue;
+      } else if (c == '=' && depth == 0 && angle == 0) {
+        inDefault = true;
+      }
+    }
+    if (!inDefault) {
+      AppendTokens(toks, i, i + 1, cur);
+    }
+  }
+  if (!cur.empty() || !params.empty()) {
+    params.push_back(std::move(cur));
+  }
+
+  std::string out = "(";
+  if (!(params.size() == 1 && params[0] == "void")) {
+    for (size_t i = 0; i < params.size(); ++i) {
+      if (i > 0) {
+        out += ", ";
+      }
+      std::string &p = params[i];
+      while (!p.empty() && p.back() == ' ') {
+        p.pop_back();
+      }
+      out += p;
+    }
+  }
+  out += ")";
+  return out;
+}
+
+// Declaration tokens [begin, end) followed by '{' -> function definition?
+static bool ParseDefinition(const std::vector<Token> &toks, size_t begin, size_t end, InoFnProto &out) {
+  if (begin >= end) {
+    return false;
+  }
+
+  const Token &first = toks[begin];
+  if (Is(first, "template") || Is(first, "namespace") || Is(first, "typedef") || Is(first, "using") ||
+      Is(first, "extern") || (Is(first, "inline") && begin + 1 < end && Is(toks[begin + 1], "namespace"))) {
+    return false;
+  }
+
+  // find the declarator: the first '(' which is not part of a specifier
+  size_t nameBegin = end;
+  size_t open = end;
+  for (size_t i = begin; i < end; ++i) {
+    const Token &t = toks[i];
+    if (IsSpecifierWithArgs(t) && i + 1 < end && IsPunct(toks[i + 1], '(')) {
+      i = MatchGroup(toks, i + 1, end);
+      continue;
+    }
+    if (IsPunct(t, '[') && i + 1 < end && IsPunct(toks[i + 1], '[')) {
+      i = MatchGroup(toks, i, end); // [[attribute]]
+      continue;
+    }
+    if (Is(t, "operator")) {
+      nameBegin = i;
+      // operator() - the first group is part of the name
+      size_t j = i + 1;
+      if (j + 1 < end && IsPunct(toks[j], '(') && IsPunct(toks[j + 1], ')')) {
+        j += 2;
+      }
+      while (j < end && !IsPunct(toks[j], '(')) {
+        ++j;
+      }
+      open = j;
+      break;
+    }
+    if (IsPunct(t, '=')) {
+      return false; // variable with an initializer
+    }
+    if (IsPunct(t, '(')) {
+      if (i == begin || toks[i - 1].kind != Token::Ident) {
+        return false; // "(*fp)(...)" and other declarators
+      }
+      nameBegin = i - 1;
+      open = i;
+      break;
+    }
+  }
+
+  if (open >= end || nameBegin == begin) {
+    return false; // no return type -> constructor or macro invocation
+  }
+  if (Is(toks[nameBegin - 1], "::") || Is(toks[nameBegin - 1], "~")) {
+    return false; // method or a function from a namespace
+  }
+
+  const size_t close = MatchGroup(toks, open, end);
+  if (close >= end) {
+    return false;
+  }
+
+  // after ')' only specifiers are allowed ("const", ": init" ... -> not a free function)
+  std::string trailing;
+  for (size_t i = close + 1; i < end; ++i) {
+    const Token &t = toks[i];
+    if (IsSpecifierWithArgs(t)) {
+      if (i + 1 < end && IsPunct(toks[i + 1], '(')) {
+        i = MatchGroup(toks, i + 1, end);
+      }
+      continue;
+    }
+    if (IsPunct(t, '[') && i + 1 < end && IsPunct(toks[i + 1], '[')) {
+      i = MatchGroup(toks, i, end);
+      continue;
+    }
+    if (Is(t, "->")) {
+      trailing = " ";
+      AppendTokens(toks, i, end, trailing);
+      break;
+    }
+    return false;
+  }
+
+  std::string ret;
+  AppendTokens(toks, begin, nameBegin, ret);
+
+  out.ret = std::move(ret);
+  out.name.clear();
+  for (size_t i = nameBegin; i < open; ++i) {
+    out.name.append(toks[i].text);
+  }
+  out.params = FormatParams(toks, open, close) + trailing;
+  out.line = toks[nameBegin].line;
+  return true;
+}
+
+// Declaration tokens [begin, end) with a "(...)" group of its own before any '=':
+// a function-like block (method, template, ISR(...) or another macro), not a class body.
+static bool HasParamGroup(const std::vector<Token> &toks, size_t begin, size_t end) {
+  size_t i = begin;
+  if (i < end && Is(toks[i], "template")) {
+    // the template parameter list may contain "sizeof(...)" etc.
+    int angle = 0;
+    for (++i; i < end; ++i) {
+      if (IsPunct(toks[i], '(')) {
+        i = MatchGroup(toks, i, end);
+      } else if (IsPunct(toks[i], '<')) {
+        ++angle;
+      } else if (IsPunct(toks[i], '>') && --angle <= 0) {
+        ++i;
+        break;
+      }
+    }
+  }
+
+  for (; i < end; ++i) {
+    const Token &t = toks[i];
+    if (IsSpecifierWithArgs(t) && i + 1 < end && IsPunct(toks[i + 1], '(')) {
+      i = MatchGroup(toks, i + 1, end);
+      continue;
+    }
+    if (IsPunct(t, '[') && i + 1 < end && IsPunct(toks[i + 1], '[')) {
+      i = MatchGroup(toks, i, end);
+      continue;
+    }
+    if (IsPunct(t, '=')) {
+      return false; // "= {...}" or a lambda in an initializer
+    }
+    if (IsPunct(t, '(')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+std::vector<InoFnProto> ExtractInoPrototypes(std::string_view code) {
+  std::vector<InoFnProto> out;
+
+  // only the top-level tokens of the current declaration are kept, blocks are skipped
+  InoTokenizer tokenizer(code);
+  std::vector<Token> decl;
+  Token t;
+
+  while (tokenizer.Next(t)) {
+    if (IsPunct(t, ';') || IsPunct(t, '}')) {
+      decl.clear();
+      continue;
+    }
+    if (!IsPunct(t, '{')) {
+      decl.push_back(t);
+      continue;
+    }
+
+    bool declEnds = false;
+    InoFnProto fp;
+    if (ParseDefinition(decl, 0, decl.size(), fp)) {
+      out.push_back(std::move(fp));
+      declEnds = true;
+    } else if (!decl.empty() && (Is(decl[0], "namespace") || Is(decl[0], "extern") || Is(decl[0], "inline"))) {
+      declEnds = true; // a block without trailing ';'
+    } else if (HasParamGroup(decl, 0, decl.size())) {
+      declEnds = true; // a rejected function body: method, template, ISR(...)
+    }
+    // otherwise a class body or an initializer: the declaration goes on up to ';'
+
+    int depth = 1;
+    while (depth > 0 && tokenizer.Next(t)) {
+      if (IsPunct(t, '{')) {
+        ++depth;
+      } else if (IsPunct(t, '}')) {
+        --depth;
+      }
+    }
+
+    if (declEnds) {
+      decl.clear();
+    }
+  }
+
+  return out;
+}
@@ -0,0 +1,40 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct InoFnProto {
+  std::string ret;    // return type incl. specifiers as written ("static int")
+  std::string name;
+  std::string params; // "(type name, ...)" without default arguments
+  unsigned line = 0;  // 1-based line of the function name
+};
+
+/**
+ * Finds top-level free function definitions of an .ino file.
+ *
+ * A token scanner, not a parser: no includes are processed and function bodies
+ * are skipped by brace matching. Like the libclang scan it replaces, it ignores
+ * templates, methods and qualified names and functions inside namespaces or
+ * extern "C" blocks. "#if 0" blocks are skipped, other conditionals are not evaluated.
+ */
+std::vector<InoFnProto> ExtractInoPrototypes(std::string_view code);
@@ -0,0 +1,118 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include "ard_libindex.hpp"
+
+#include "ard_cli.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+void ArduinoLibrarySearchIndex::Clear() {
+  m_texts.clear();
+  m_postings.clear();
+}
+
+void ArduinoLibrarySearchIndex::Build(const std::vector<ArduinoLibraryInfo> &libs) {
+  ScopeTimer t("LIBMAN: search index build (%zu libraries)", libs.size());
+
+  Clear();
+  m_texts.reserve(libs.size());
+
+  for (size_t i = 0; i < libs.size(); ++i) {
+    const auto &lib = libs[i];
+    const auto &rel = lib.latest;
+
+    std::string text;
+    auto add = [&](const std::string &s) {
+      if (!s.empty()) {
+        text += s;
+        text += ' ';
+      }
+    };
+
+    add(lib.name);
+    add(rel.author);
+    add(rel.maintainer);
+    add(rel.sentence);
+    add(rel.paragraph);
+    add(rel.website);
+
+    for (auto &c : text) {
+      c = (char)std::tolower((unsigned char)c);
+    }
+
+    // libraries are visited in order, so the lists stay sorted and
+    // a repeated trigram of the same library is always at the back
+    const uint32_t doc = (uint32_t)i;
+    for (size_t p = 0; p + 3 <= text.size(); ++p) {
+      auto &list = m_postings[TrigramKey(text.data() + p)];
+      if (list.empty() || list.back() != doc) {
+        list.push_back(doc);
+      }
+    }
+
+    m_texts.push_back(std::move(text));
+  }
+}
+
+void ArduinoLibrarySearchIndex::Search(const std::string &needle, std::vector<uint8_t> &mask) const {
+  mask.assign(m_texts.size(), 0);
+
+  if (needle.size() < 3) {
+    for (size_t i = 0; i < m_texts.size(); ++i) {
+      mask[i] = m_texts[i].find(needle) != std::string::npos;
+    }
+    return;
+  }
+
+  std::vector<const std::vector<uint32_t> *> lists;
+  lists.reserve(needle.size() - 2);
+
+  for (size_t p = 0; p + 3 <= needle.size(); ++p) {
+    auto it = m_postings.find(TrigramKey(needle.data() + p));
+    if (it == m_postings.end()) {
+      return; // some trigram does not occur anywhere
+    }
+    lists.push_back(&it->second);
+  }
+
+  std::sort(lists.begin(), lists.end(),
+            [](const auto *a, const auto *b) {
+              return a->size() != b->size() ? a->size() < b->size() : a < b;
+            });
+  lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+  std::vector<uint32_t> candidates = *lists.front();
+  std::vector<uint32_t> next;
+  for (size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+    next.clear();
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          lists[l]->begin(), lists[l]->end(),
+                          std::back_inserter(next));
+    candidates.swap(next);
+  }
+
+  // trigrams only say "maybe", the order of them is not checked
+  for (uint32_t doc : candidates) {
+    mask[doc] = m_texts[doc].find(needle) != std::string::npos;
+  }
+}
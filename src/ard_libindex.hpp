@@ -0,0 +1,59 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ArduinoLibraryInfo;
+
+/**
+ * Substring search index over the library catalog of the library manager.
+ *
+ * Name, author, maintainer, sentence, paragraph and website of every library
+ * are lowercased and joined into one text once, when the catalog is loaded.
+ * Every distinct trigram of that text keeps an ascending list of library
+ * indexes. A query of three or more bytes intersects the lists of its
+ * trigrams (rarest first) and only the remaining candidates are verified
+ * with a substring search. Shorter queries match most of the catalog anyway
+ * and just scan the prebuilt texts. ASCII case folding, like ToLower().
+ */
+class ArduinoLibrarySearchIndex {
+public:
+  void Build(const std::vector<ArduinoLibraryInfo> &libs);
+  void Clear();
+
+  size_t Size() const { return m_texts.size(); }
+
+  // mask[i] = 1 if the text of library i contains needle (already lowercased).
+  void Search(const std::string &needle, std::vector<uint8_t> &mask) const;
+
+private:
+  std::vector<std::string> m_texts;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+
+  static uint32_t TrigramKey(const char *p) {
+    return ((uint32_t)(unsigned char)p[0] << 16) |
+           ((uint32_t)(unsigned char)p[1] << 8) |
+           (uint32_t)(unsigned char)p[2];
+  }
+};
@@ -28,6 +28,7 @@
 #include <cctype>
 #include <functional>
 #include <set>
+#include <unordered_map>
 
 #include <wx/button.h>
 #include <wx/filedlg.h>
@@ -70,6 +71,20 @@ static std::string ExtractArchFromFqbn(const std::string &fqbn) {
   return fqbn.substr(first + 1, second - first - 1);
 }
 
+ArduinoLibraryListCtrl::ArduinoLibraryListCtrl(ArduinoLibraryManagerFrame *owner, wxWindowID id)
+    : wxListCtrl(owner, id, wxDefaultPosition, wxDefaultSize,
+                 wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL | wxBORDER_SUNKEN),
+      m_owner(owner) {
+}
+
+wxString ArduinoLibraryListCtrl::OnGetItemText(long item, long column) const {
+  return m_owner->GetRowText(item, column);
+}
+
+wxListItemAttr *ArduinoLibraryListCtrl::OnGetItemAttr(long item) const {
+  return m_owner->GetRowAttr(item);
+}
+
 ArduinoLibraryManagerFrame::ArduinoLibraryManagerFrame(wxWindow *parent, ArduinoCli *cli, const std::vector<ArduinoCoreBoard> &availableBoards, wxConfigBase *config, const wxString &initialType)
     : wxFrame(parent, wxID_ANY, _("Arduino Libraries"),
               wxDefaultPosition, wxSize(800, 600),
@@ -167,9 +182,7 @@ void ArduinoLibraryManagerFrame::BuildUi() {
 
   // list
   {
-    m_listCtrl = new wxListCtrl(this, ID_LIB_LIST_CTRL,
-                                wxDefaultPosition, wxDefaultSize,
-                                wxLC_REPORT | wxLC_SINGLE_SEL | wxBORDER_SUNKEN);
+    m_listCtrl = new ArduinoLibraryListCtrl(this, ID_LIB_LIST_CTRL);
 
     m_listCtrl->SetImageList(CreateListCtrlSortIndicatorImageList(m_listCtrl->GetForegroundColour()), wxIMAGE_LIST_SMALL);
 
@@ -187,6 +200,10 @@ void ArduinoLibraryManagerFrame::BuildUi() {
     m_listCtrl->AppendColumn(m_colLabels[4], wxLIST_FORMAT_LEFT, 220);
 
     topSizer->Add(m_listCtrl, 1, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 8);
+
+    EditorSettings settings;
+    settings.Load(m_config);
+    UpdateStateColors(settings.GetColors());
   }
 
   // bottom line: Install (Git/Zip) on the left, Close on the right
@@ -215,6 +232,8 @@ void ArduinoLibraryManagerFrame::InitData() {
   m_allLibraries = m_cli->GetLibraries();
   m_installedLibraries = m_cli->GetInstalledLibraries();
 
+  OnLibrariesChanged();
+
   if (m_allLibraries.empty()) {
     DisplayLibsLoading();
     return;
@@ -224,6 +243,47 @@ void ArduinoLibraryManagerFrame::InitData() {
   ApplyFilter();
 }
 
+void ArduinoLibraryManagerFrame::OnLibrariesChanged() {
+  m_searchIndex.Build(m_allLibraries);
+  RebuildLibraryStates();
+}
+
+void ArduinoLibraryManagerFrame::RebuildLibraryStates() {
+  std::unordered_map<std::string, int> installedByName;
+  installedByName.reserve(m_installedLibraries.size());
+  for (size_t i = 0; i < m_installedLibraries.size(); ++i) {
+    // first installed variant wins
+    installedByName.emplace(m_installedLibraries[i].name, (int)i);
+  }
+
+  m_libStates.assign(m_allLibraries.size(), LibraryState{});
+
+  for (size_t i = 0; i < m_allLibraries.size(); ++i) {
+    const auto &lib = m_allLibraries[i];
+
+    auto it = installedByName.find(lib.name);
+    if (it == installedByName.end())
+      continue;
+
+    const auto &inst = m_installedLibraries[(size_t)it->second];
+    auto &state = m_libStates[i];
+
+    state.installedIndex = it->second;
+    state.legacy = inst.latest.isLegacy;
+
+    const std::string &latestVer = lib.latest.version;
+    const std::string &instVer = inst.latest.version;
+    if (!latestVer.empty() && !instVer.empty()) {
+      state.updatable = CompareVersions(instVer, latestVer) < 0;
+    }
+  }
+
+  for (auto &order : m_sortOrders) {
+    order.clear();
+  }
+  m_baseMask.clear();
+}
+
 void ArduinoLibraryManagerFrame::RebuildTopicChoices() {
   std::set<std::string> topics;
 
@@ -246,10 +306,10 @@ void ArduinoLibraryManagerFrame::RebuildTopicChoices() {
 
 void ArduinoLibraryManagerFrame::DisplayLibsLoading() {
   if (m_listCtrl) {
-    m_listCtrl->Freeze();
-    m_listCtrl->DeleteAllItems();
-    m_listCtrl->InsertItem(0, _("Loading libraries..."));
-    m_listCtrl->Thaw();
+    m_filteredIndices.clear();
+    m_showLoading = true;
+    m_listCtrl->SetItemCount(1);
+    m_listCtrl->Refresh();
   }
 }
 
@@ -260,143 +320,189 @@ void ArduinoLibraryManagerFrame::ApplyFilter() {
   APP_DEBUG_LOG("LIBMAN: m_allLibraries.size=%d", m_allLibraries.size());
   APP_DEBUG_LOG("LIBMAN: m_installedLibraries.size=%d", m_installedLibraries.size());
 
+  if (m_libStates.size() != m_allLibraries.size()) {
+    RebuildLibraryStates();
+  }
+
   wxString topicSel = m_topicChoice ? m_topicChoice->GetStringSelection() : _("All topics");
   wxString typeSel = m_typeChoice ? m_typeChoice->GetStringSelection() : _("All");
-  wxString searchText = m_searchCtrl->GetValue();
 
-  m_listCtrl->Freeze();
-  m_listCtrl->DeleteAllItems();
-  m_filteredIndices.clear();
+  std::string topic;
+  if (!topicSel.empty() && topicSel != _("All topics")) {
+    topic = wxToStd(topicSel);
+  }
+
+  TypeFilter type = TypeFilter::All;
+  if (typeSel == _("Installed")) {
+    type = TypeFilter::Installed;
+  } else if (typeSel == _("Updatable")) {
+    type = TypeFilter::Updatable;
+  }
+
+  // everything except the search text, which is resolved by UpdateRows()
+  m_baseMask.assign(m_allLibraries.size(), 0);
 
-  // 1) collect the indexes that pass the filters
   for (size_t i = 0; i < m_allLibraries.size(); ++i) {
     const auto &lib = m_allLibraries[i];
 
-    if (!MatchesArchitecture(lib))
-      continue;
-    if (!MatchesTopic(lib, topicSel))
-      continue;
-    if (!MatchesType(lib, typeSel))
-      continue;
-    if (!MatchesSearch(lib, searchText))
-      continue;
-    if (!MatchesExplicitLib(lib))
-      continue;
+    m_baseMask[i] = MatchesArchitecture(lib) &&
+                    MatchesTopic(lib, topic) &&
+                    MatchesType(i, type) &&
+                    MatchesExplicitLib(lib);
+  }
 
-    m_filteredIndices.push_back((int)i);
-  }
-
-  // 2) sort according to m_sortColumn / m_sortAscending
-  std::sort(m_filteredIndices.begin(), m_filteredIndices.end(),
-            [&](int ia, int ib) {
-              const auto &A = m_allLibraries[(size_t)ia];
-              const auto &B = m_allLibraries[(size_t)ib];
-
-              std::string sa, sb;
-
-              switch (m_sortColumn) {
-                case 0:
-                  sa = A.name;
-                  break;
-                case 1:
-                  sa = A.latest.category;
-                  break;
-                case 2:
-                  sa = A.latest.version;
-                  break;
-                case 3:
-                  for (const auto &inst : m_installedLibraries) {
-                    if (inst.name == A.name) {
-                      sa = inst.latest.version;
-                      break;
-                    }
-                  }
-                  break;
-                case 4:
-                  sa = A.latest.maintainer;
-                  break;
-                default:
-                  sa = A.name;
-                  break;
-              }
-
-              switch (m_sortColumn) {
-                case 0:
-                  sb = B.name;
-                  break;
-                case 1:
-                  sb = B.latest.category;
-                  break;
-                case 2:
-                  sb = B.latest.version;
-                  break;
-                case 3:
-                  for (const auto &inst : m_installedLibraries) {
-                    if (inst.name == B.name) {
-                      sb = inst.latest.version;
-                      break;
-                    }
-                  }
-                  break;
-                case 4:
-                  sb = B.latest.maintainer;
-                  break;
-                default:
-                  sb = B.name;
-                  break;
-              }
-
-              if (sa == sb)
-                return false;
-
-              if (m_sortAscending)
-                return sa < sb;
-              else
-                return sa > sb;
-            });
-
-  EditorSettings settings;
-  settings.Load(m_config);
-  EditorColorScheme colors = settings.GetColors();
-
-  // 3) fill the list in sorted order
-  for (size_t row = 0; row < m_filteredIndices.size(); ++row) {
-    int libIndex = m_filteredIndices[row];
-    const auto &lib = m_allLibraries[(size_t)libIndex];
-    wxString installedVersion;
+  UpdateRows();
 
-    for (const auto &inst : m_installedLibraries) {
-      if (inst.name == lib.name) {
-        installedVersion = wxString::FromUTF8(inst.latest.version.c_str());
-        break;
-      }
+  // auto-resize columns after filling (only here, not on every keystroke)
+  m_listCtrl->Freeze();
+  for (int col = 0; col < 5; ++col) {
+    m_listCtrl->SetColumnWidth(col, wxLIST_AUTOSIZE_USEHEADER);
+  }
+  m_listCtrl->Thaw();
+
+  UpdateColumnHeaders();
+}
+
+void ArduinoLibraryManagerFrame::UpdateRows() {
+  if (!m_listCtrl)
+    return;
+
+  if (m_baseMask.size() != m_allLibraries.size()) {
+    ApplyFilter();
+    return;
+  }
+
+  ScopeTimer t("LIBMAN: UpdateRows()");
+
+  std::string needle = ToLower(wxToStd(m_searchCtrl->GetValue()));
+  const bool searching = !needle.empty();
+  if (searching) {
+    m_searchIndex.Search(needle, m_searchMask);
+  }
+
+  // keep the selected library selected if it survives the filter
+  int selectedLib = -1;
+  long selectedRow = m_listCtrl->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+  if (selectedRow != -1) {
+    selectedLib = GetLibIndex(selectedRow);
+    m_listCtrl->SetItemState(selectedRow, 0, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+  }
+
+  // walking the presorted order yields the rows already sorted
+  const std::vector<int> &order = GetSortOrder(m_sortColumn);
+
+  m_filteredIndices.clear();
+  auto take = [&](int libIndex) {
+    if (m_baseMask[(size_t)libIndex] && (!searching || m_searchMask[(size_t)libIndex])) {
+      m_filteredIndices.push_back(libIndex);
     }
+  };
 
-    long item = m_listCtrl->InsertItem((long)row,
-                                       wxString::FromUTF8(lib.name.c_str()));
-    m_listCtrl->SetItem(item, 1,
-                        wxString::FromUTF8(lib.latest.category.c_str()));
-    m_listCtrl->SetItem(item, 2,
-                        wxString::FromUTF8(lib.latest.version.c_str()));
-    m_listCtrl->SetItem(item, 3,
-                        installedVersion);
-    m_listCtrl->SetItem(item, 4,
-                        wxString::FromUTF8(lib.latest.maintainer.c_str()));
+  if (m_sortAscending) {
+    for (auto it = order.begin(); it != order.end(); ++it)
+      take(*it);
+  } else {
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+      take(*it);
+  }
 
-    m_listCtrl->SetItemData(item, (long)libIndex);
+  m_showLoading = false;
+  m_listCtrl->SetItemCount((long)m_filteredIndices.size());
 
-    // --- color highlighting legacy / updatable ---
-    UpdateStateColors(lib, item, colors);
+  if (selectedLib >= 0) {
+    auto it = std::find(m_filteredIndices.begin(), m_filteredIndices.end(), selectedLib);
+    if (it != m_filteredIndices.end()) {
+      long row = (long)(it - m_filteredIndices.begin());
+      m_listCtrl->SetItemState(row, wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED,
+                               wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
+      m_listCtrl->EnsureVisible(row);
+    }
   }
 
-  // 4) auto-resize columns after filling (point 4)
-  for (int col = 0; col < 5; ++col) {
-    m_listCtrl->SetColumnWidth(col, wxLIST_AUTOSIZE_USEHEADER);
+  m_listCtrl->Refresh();
+}
+
+const std::vector<int> &ArduinoLibraryManagerFrame::GetSortOrder(int column) {
+  if (column < 0 || column >= 5)
+    column = 0;
+
+  auto &order = m_sortOrders[column];
+  if (order.size() == m_allLibraries.size())
+    return order;
+
+  order.resize(m_allLibraries.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = (int)i;
   }
 
-  m_listCtrl->Thaw();
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return GetColumnValue((size_t)a, column) < GetColumnValue((size_t)b, column);
+  });
 
-  UpdateColumnHeaders();
+  return order;
+}
+
+// order: Name, Category, Version, Installed, Maintainer
+const std::string &ArduinoLibraryManagerFrame::GetColumnValue(size_t libIndex, int column) const {
+  static const std::string empty;
+
+  const auto &lib = m_allLibraries[libIndex];
+
+  switch (column) {
+    case 1:
+      return lib.latest.category;
+    case 2:
+      return lib.latest.version;
+    case 3: {
+      int inst = libIndex < m_libStates.size() ? m_libStates[libIndex].installedIndex : -1;
+      return inst >= 0 ? m_installedLibraries[(size_t)inst].latest.version : empty;
+    }
+    case 4:
+      return lib.latest.maintainer;
+    default:
+      return lib.name;
+  }
+}
+
+int ArduinoLibraryManagerFrame::GetLibIndex(long row) const {
+  if (row < 0 || row >= (long)m_filteredIndices.size())
+    return -1;
+
+  int libIndex = m_filteredIndices[(size_t)row];
+  if (libIndex < 0 || libIndex >= (int)m_allLibraries.size())
+    return -1;
+
+  return libIndex;
+}
+
+wxString ArduinoLibraryManagerFrame::GetRowText(long row, long column) const {
+  if (m_showLoading) {
+    return column == 0 ? _("Loading libraries...") : wxString();
+  }
+
+  int libIndex = GetLibIndex(row);
+  if (libIndex < 0)
+    return wxEmptyString;
+
+  return wxString::FromUTF8(GetColumnValue((size_t)libIndex, (int)column).c_str());
+}
+
+wxListItemAttr *ArduinoLibraryManagerFrame::GetRowAttr(long row) const {
+  int libIndex = GetLibIndex(row);
+  if (libIndex < 0 || libIndex >= (int)m_libStates.size())
+    return nullptr;
+
+  const auto &state = m_libStates[(size_t)libIndex];
+
+  // updatable has priority over legacy
+  if (state.updatable)
+    return &m_updatableAttr;
+  if (state.legacy)
+    return &m_deprecatedAttr;
+  if (state.installedIndex >= 0)
+    return &m_installedAttr;
+
+  return nullptr;
 }
 
 void ArduinoLibraryManagerFrame::UpdateColumnHeaders() {
@@ -447,88 +553,27 @@ bool ArduinoLibraryManagerFrame::MatchesArchitecture(const ArduinoLibraryInfo &l
 }
 
 bool ArduinoLibraryManagerFrame::MatchesTopic(const ArduinoLibraryInfo &lib,
-                                              const wxString &topic) const {
-  if (topic.empty() || topic == _("All topics"))
+                                              const std::string &topic) const {
+  // empty = all topics
+  if (topic.empty())
     return true;
 
-  wxString cat = wxString::FromUTF8(lib.latest.category.c_str());
-  return cat == topic;
+  return lib.latest.category == topic;
 }
 
-bool ArduinoLibraryManagerFrame::MatchesType(const ArduinoLibraryInfo &lib,
-                                             const wxString &type) const {
-  // All (or empty) -> no restriction
-  if (type.IsEmpty() || type == _("All"))
-    return true;
-
-  // we check if this library is installed and what version it has
-  std::string installedVersion;
-  bool installed = false;
-
-  for (const auto &inst : m_installedLibraries) {
-    if (inst.name == lib.name) { // match by name
-      installed = true;
-      installedVersion = inst.latest.version;
-      break;
-    }
-  }
-
-  if (type == _("Installed")) {
-    // we want only those that are installed
-    return installed;
-  }
-
-  if (type == _("Updatable")) {
-    // Updatable = installed and latest > installed
-    if (!installed)
-      return false;
-
-    const std::string &latestVer = lib.latest.version;
-
-    if (latestVer.empty() || installedVersion.empty())
-      return false; // we don't have info -> better not mark as updatable
-
-    int cmp = CompareVersions(installedVersion, latestVer);
-    if (cmp >= 0) {
-      // installed == latest or installed > latest -> not updatable
-      return false;
-    }
-
-    // latest > installed -> updatable
-    return true;
+bool ArduinoLibraryManagerFrame::MatchesType(size_t libIndex, TypeFilter type) const {
+  const auto &state = m_libStates[libIndex];
+
+  switch (type) {
+    case TypeFilter::Installed:
+      // we want only those that are installed
+      return state.installedIndex >= 0;
+    case TypeFilter::Updatable:
+      // Updatable = installed and latest > installed
+      return state.updatable;
+    default:
+      return true;
   }
-
-  // unknown type -> behave like All
-  return true;
-}
-
-bool ArduinoLibraryManagerFrame::MatchesSearch(const ArduinoLibraryInfo &lib,
-                                               const wxString &text) const {
-  if (text.empty())
-    return true;
-
-  std::string needle = ToLower(std::string(text.utf8_str()));
-
-  const auto &rel = lib.latest;
-
-  std::string haystack;
-  auto add = [&](const std::string &s) {
-    if (!s.empty()) {
-      haystack += s;
-      haystack += ' ';
-    }
-  };
-
-  add(lib.name);
-  add(rel.author);
-  add(rel.maintainer);
-  add(rel.sentence);
-  add(rel.paragraph);
-  add(rel.website);
-
-  haystack = ToLower(haystack);
-
-  return haystack.find(needle) != std::string::npos;
 }
 
 bool ArduinoLibraryManagerFrame::MatchesExplicitLib(const ArduinoLibraryInfo &lib) const {
@@ -601,13 +646,14 @@ void ArduinoLibraryManagerFrame::OnSearchText(wxCommandEvent &WXUNUSED(evt)) {
     DisplayLibsLoading();
     return;
   }
-  // debounce - restart the timer
-  m_searchTimer.Start(500, true); // 300 ms since the last press
+  // the index answers within a frame, the timer only coalesces bursts of
+  // text events (paste, SetValue...)
+  m_searchTimer.Start(15, true);
 }
 
 void ArduinoLibraryManagerFrame::OnSearchTimer(wxTimerEvent &evt) {
   (void)evt;
-  ApplyFilter();
+  UpdateRows();
 }
 
 void ArduinoLibraryManagerFrame::OnItemActivated(wxListEvent &evt) {
@@ -615,8 +661,8 @@ void ArduinoLibraryManagerFrame::OnItemActivated(wxListEvent &evt) {
   if (row < 0)
     return;
 
-  long libIndex = m_listCtrl->GetItemData(row);
-  if (libIndex < 0 || libIndex >= (long)m_allLibraries.size())
+  int libIndex = GetLibIndex(row);
+  if (libIndex < 0)
     return;
 
   const auto &lib = m_allLibraries[(size_t)libIndex];
@@ -649,7 +695,7 @@ void ArduinoLibraryManagerFrame::OnColClick(wxListEvent &evt) {
     m_sortAscending = true;
   }
 
-  ApplyFilter();
+  UpdateRows();
   UpdateColumnHeaders();
 }
 
@@ -663,11 +709,11 @@ void ArduinoLibraryManagerFrame::OnListContextMenu(wxContextMenuEvent &WXUNUSED(
     return;
   }
 
-  long libIndex = m_listCtrl->GetItemData(item);
-  if (libIndex < 0 || libIndex >= (long)m_allLibraries.size())
+  int libIndex = GetLibIndex(item);
+  if (libIndex < 0)
     return;
 
-  m_contextLibIndex = (int)libIndex;
+  m_contextLibIndex = libIndex;
   m_versionMenuMap.clear();
 
   const auto &lib = m_allLibraries[(size_t)libIndex];
@@ -850,7 +896,9 @@ void ArduinoLibraryManagerFrame::RefreshLibraries() {
   }
 
   m_allLibraries = m_cli->GetLibraries();
+  OnLibrariesChanged();
   if (m_allLibraries.empty()) {
+    DisplayLibsLoading();
     return;
   }
 
@@ -864,6 +912,8 @@ void ArduinoLibraryManagerFrame::RefreshInstalledLibraries() {
   }
 
   m_installedLibraries = m_cli->GetInstalledLibraries();
+  // rows hold indexes into m_installedLibraries, resolve them even if nothing is refiltered
+  RebuildLibraryStates();
   if (m_installedLibraries.empty()) {
     return;
   }
@@ -871,52 +921,17 @@ void ArduinoLibraryManagerFrame::RefreshInstalledLibraries() {
   ApplyFilter();
 }
 
-void ArduinoLibraryManagerFrame::UpdateStateColors(const ArduinoLibraryInfo &lib, long item, const EditorColorScheme &colors) {
-  bool installed = false;
-  bool isLegacy = false;
-  bool isUpdatable = false;
-  std::string instVer;
-
-  // find any installed variant
-  for (const auto &inst : m_installedLibraries) {
-    if (inst.name == lib.name) {
-      installed = true;
-      instVer = inst.latest.version;
-      isLegacy = inst.latest.isLegacy;
-      break;
-    }
-  }
-
-  const std::string &latestVer = lib.latest.version;
-  if (installed && !latestVer.empty() && !instVer.empty()) {
-    if (CompareVersions(instVer, latestVer) < 0) {
-      isUpdatable = true;
-    }
-  }
-
-  // updatable has priority over legacy
-  if (isUpdatable) {
-    m_listCtrl->SetItemBackgroundColour(item, colors.updatable);
-  } else if (isLegacy) {
-    m_listCtrl->SetItemBackgroundColour(item, colors.deprecated);
-  } else if (installed) {
-    m_listCtrl->SetItemBackgroundColour(item, colors.installed);
-  }
+void ArduinoLibraryManagerFrame::UpdateStateColors(const EditorColorScheme &colors) {
+  m_installedAttr.SetBackgroundColour(colors.installed);
+  m_deprecatedAttr.SetBackgroundColour(colors.deprecated);
+  m_updatableAttr.SetBackgroundColour(colors.updatable);
 }
 
 void ArduinoLibraryManagerFrame::ApplySettings(const EditorSettings &settings) {
-  EditorColorScheme colors = settings.GetColors();
-
-  long itemIndex = -1;
+  UpdateStateColors(settings.GetColors());
 
-  while ((itemIndex = m_listCtrl->GetNextItem(itemIndex, wxLIST_NEXT_ALL, wxLIST_STATE_DONTCARE)) != wxNOT_FOUND) {
-    long libIndex = m_listCtrl->GetItemData(itemIndex);
-    if (libIndex < 0 || libIndex >= (long)m_allLibraries.size())
-      continue;
-
-    const auto &lib = m_allLibraries[(size_t)libIndex];
-
-    UpdateStateColors(lib, itemIndex, colors);
+  if (m_listCtrl) {
+    m_listCtrl->Refresh();
   }
 }
 
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
@@ -32,6 +33,8 @@
 #include <wx/textctrl.h>
 #include <wx/timer.h>
 
+#include "ard_libindex.hpp"
+
 class ArduinoCli;
 struct ArduinoLibraryInfo;
 struct ArduinoCoreBoard;
@@ -39,6 +42,21 @@ struct ArduinoLibraryInstallSpec;
 struct EditorSettings;
 struct EditorColorScheme;
 
+class ArduinoLibraryManagerFrame;
+
+// Virtual list of the library manager, rows are served by the frame.
+class ArduinoLibraryListCtrl : public wxListCtrl {
+public:
+  ArduinoLibraryListCtrl(ArduinoLibraryManagerFrame *owner, wxWindowID id);
+
+protected:
+  wxString OnGetItemText(long item, long column) const override;
+  wxListItemAttr *OnGetItemAttr(long item) const override;
+
+private:
+  ArduinoLibraryManagerFrame *m_owner;
+};
+
 class ArduinoLibraryManagerFrame : public wxFrame {
 public:
   ArduinoLibraryManagerFrame(wxWindow *parent, ArduinoCli *cli, const std::vector<ArduinoCoreBoard> &availableBoards, wxConfigBase *config, const wxString &initialType);
@@ -61,6 +79,21 @@ public:
   void InstallLibrariesWithDeps(const std::vector<ArduinoLibraryInfo> &libs);
 
 private:
+  friend class ArduinoLibraryListCtrl;
+
+  enum class TypeFilter {
+    All,
+    Updatable,
+    Installed
+  };
+
+  // per m_allLibraries entry, resolved against m_installedLibraries
+  struct LibraryState {
+    int installedIndex = -1; // index into m_installedLibraries
+    bool legacy = false;
+    bool updatable = false;
+  };
+
   ArduinoCli *m_cli;
   wxConfigBase *m_config = nullptr;
 
@@ -87,22 +120,44 @@ private:
   std::vector<ArduinoLibraryInfo> m_allLibraries;
   std::vector<ArduinoLibraryInfo> m_installedLibraries;
   std::set<std::string> m_supportedArchitectures;
-  std::vector<int> m_filteredIndices; // mapping leaf index -> m_allLibraries
+  std::vector<int> m_filteredIndices; // mapping list row -> m_allLibraries
+  std::vector<LibraryState> m_libStates;
+
+  // Search text is looked up in the index, the other filters only change on
+  // user actions and are kept in m_baseMask, so typing does not re-evaluate them.
+  ArduinoLibrarySearchIndex m_searchIndex;
+  std::vector<uint8_t> m_baseMask;
+  std::vector<uint8_t> m_searchMask;
+  std::vector<int> m_sortOrders[5]; // all libraries ascending by column, built lazily
+  bool m_showLoading = false;
+
+  // handed out by OnGetItemAttr(), which is const
+  mutable wxListItemAttr m_installedAttr;
+  mutable wxListItemAttr m_deprecatedAttr;
+  mutable wxListItemAttr m_updatableAttr;
 
   void BuildUi();
   void InitData();
   void RebuildTopicChoices();
   void DisplayLibsLoading();
   void ApplyFilter();
+  void UpdateRows();
   void UpdateColumnHeaders();
-  void UpdateStateColors(const ArduinoLibraryInfo &lib, long item, const EditorColorScheme &colors);
+  void UpdateStateColors(const EditorColorScheme &colors);
+
+  void OnLibrariesChanged();
+  void RebuildLibraryStates();
+  const std::vector<int> &GetSortOrder(int column);
+  const std::string &GetColumnValue(size_t libIndex, int column) const;
+  int GetLibIndex(long row) const;
+  wxString GetRowText(long row, long column) const;
+  wxListItemAttr *GetRowAttr(long row) const;
 
   void StartInstallSpecs(const std::vector<ArduinoLibraryInstallSpec> &specs);
 
   bool MatchesArchitecture(const ArduinoLibraryInfo &lib) const;
-  bool MatchesTopic(const ArduinoLibraryInfo &lib, const wxString &topic) const;
-  bool MatchesType(const ArduinoLibraryInfo &lib, const wxString &type) const;
-  bool MatchesSearch(const ArduinoLibraryInfo &lib, const wxString &text) const;
+  bool MatchesTopic(const ArduinoLibraryInfo &lib, const std::string &topic) const;
+  bool MatchesType(size_t libIndex, TypeFilter type) const;
   bool MatchesExplicitLib(const ArduinoLibraryInfo &lib) const;
 
   void OnClose(wxCloseEvent &evt);
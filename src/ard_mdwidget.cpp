@@ -19,14 +19,19 @@
 #include "ard_mdwidget.hpp"
 #include "ard_setdlg.hpp"
 #include "utils.hpp"
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <string>
 
 #include "maddy/parser.h"
 
+#include <wx/dcclient.h>
+#include <wx/html/htmlcell.h>
 #include <wx/html/htmlwin.h>
+#include <wx/html/winpars.h>
 #include <wx/platform.h>
+#include <wx/utils.h>
 
 static wxString ArduinoMarkdown_HtmlEscape(const wxString &s) {
   wxString out;
@@ -55,21 +60,73 @@ static wxString ArduinoMarkdown_HtmlEscape(const wxString &s) {
   return out;
 }
 
-wxString ArduinoMarkdown_MarkdownToHtmlFragment(const wxString &input) {
-  std::stringstream markdownInput("");
-
+static std::shared_ptr<maddy::ParserConfig> CreateMarkdownParserConfig() {
   std::shared_ptr<maddy::ParserConfig> config = std::make_shared<maddy::ParserConfig>();
   config->enabledParsers &= ~maddy::types::EMPHASIZED_PARSER; // disable emphasized parser
+  return config;
+}
 
-  std::shared_ptr<maddy::Parser> parser = std::make_shared<maddy::Parser>(config);
+wxString ArduinoMarkdown_MarkdownToHtmlFragment(const wxString &input) {
+  // The line parsers compile their regexes in the constructor, so the parser
+  // is built once (per thread) and reused.
+  thread_local const maddy::Parser parser(CreateMarkdownParserConfig());
 
   std::string md = wxToStd(ArduinoMarkdown_HtmlEscape(input));
   std::istringstream iss(md);
-  std::string htmlOutput = parser->Parse(iss);
+  std::string htmlOutput = parser.Parse(iss);
 
   return wxString::FromUTF8(htmlOutput);
 }
 
+// -------------------------------------------------------------------------------------------------
+//  ArduinoMarkdownHtmlWindow
+// -------------------------------------------------------------------------------------------------
+
+// wxHtmlWindow which can append / remove top level fragments without
+// re-parsing the rest of the page (wxHtmlWindow::AppendToPage re-parses
+// the whole source).
+class ArduinoMarkdownHtmlWindow : public wxHtmlWindow {
+public:
+  using wxHtmlWindow::wxHtmlWindow;
+
+  // Parses html and adds it as the last child of the page.
+  wxHtmlContainerCell *AppendFragment(const wxString &html) {
+    if (!m_Cell)
+      return nullptr;
+
+    // same parser setup as wxHtmlWindow::DoSetPage()
+    wxClientDC dc(this);
+    dc.SetMapMode(wxMM_TEXT);
+#if wxCHECK_VERSION(3, 2, 0) && !defined(wxHAS_DPI_INDEPENDENT_PIXELS)
+    m_Parser->SetDC(&dc, GetDPIScaleFactor(), 1.0);
+#else
+    m_Parser->SetDC(&dc);
+#endif
+
+    auto *cell = static_cast<wxHtmlContainerCell *>(m_Parser->Parse(html));
+    m_Cell->InsertCell(cell);
+    return cell;
+  }
+
+  void RemoveFragment(wxHtmlContainerCell *cell) {
+    if (!m_Cell || !cell)
+      return;
+    m_Cell->Detach(cell);
+    delete cell;
+  }
+
+  // Removing cells is not safe while a selection (or a selection drag)
+  // still points into them.
+  bool CanRemoveFragments() {
+    return SelectionToText().empty() && !wxGetMouseState().LeftIsDown();
+  }
+
+  void Relayout() {
+    CreateLayout();
+    Refresh();
+  }
+};
+
 // -------------------------------------------------------------------------------------------------
 //  ArduinoMarkdownPanel
 // -------------------------------------------------------------------------------------------------
@@ -84,10 +141,10 @@ ArduinoMarkdownPanel::ArduinoMarkdownPanel(wxWindow *parent,
     : wxPanel(parent, id, pos, size, style) {
   auto *sizer = new wxBoxSizer(wxVERTICAL);
 
-  m_html = new wxHtmlWindow(this, wxID_ANY,
-                            wxDefaultPosition,
-                            wxDefaultSize,
-                            wxHW_SCROLLBAR_AUTO);
+  m_html = new ArduinoMarkdownHtmlWindow(this, wxID_ANY,
+                                         wxDefaultPosition,
+                                         wxDefaultSize,
+                                         wxHW_SCROLLBAR_AUTO);
 
   InitHtmlCtrl();
 
@@ -116,20 +173,37 @@ void ArduinoMarkdownPanel::InitHtmlCtrl() {
   m_html->SetFonts(wxEmptyString, wxEmptyString, sizes);
 
   m_html->Bind(wxEVT_HTML_LINK_CLICKED, &ArduinoMarkdownPanel::OnHtmlLinkClicked, this);
+
+#if wxCHECK_VERSION(3, 1, 3)
+  // wxHtmlWindow re-parses its last parsed source on DPI change, which is
+  // only the last appended fragment -> the page has to be rebuilt.
+  auto onDpiChanged = [this](wxDPIChangedEvent &event) {
+    m_fullRender = true;
+    CallAfter([this]() { Render(false); });
+    event.Skip();
+  };
+  m_html->Bind(wxEVT_DPI_CHANGED, onDpiChanged);
+#endif
 }
 
 void ArduinoMarkdownPanel::SetBaseFonts(const wxString &normalFace,
                                         const wxString &fixedFace,
                                         const int *sizes) {
   m_html->SetFonts(normalFace, fixedFace, sizes);
-  m_html->SetPage(BuildFullHtmlFromMessages());
+  m_fullRender = true;
+  Render(false);
 }
 
 void ArduinoMarkdownPanel::Clear() {
   m_msgs.clear();
+  m_fullRender = true;
   Render(false);
 }
 
+void ArduinoMarkdownPanel::MarkDirty(size_t index) {
+  m_firstDirty = std::min(m_firstDirty, index);
+}
+
 wxString ArduinoMarkdownPanel::GetRoleLabel(AiMarkdownRole role) const {
   switch (role) {
     case AiMarkdownRole::User:
@@ -150,15 +224,10 @@ wxString ArduinoMarkdownPanel::GetRoleLabel(AiMarkdownRole role) const {
 wxString ArduinoMarkdownPanel::WrapMessage(const wxString &msgHtml,
                                            AiMarkdownRole role,
                                            const wxString &info,
-                                           const wxString &time) const {
+                                           const wxString &time,
+                                           const EditorColorScheme &colors) const {
   wxString label = GetRoleLabel(role);
 
-  wxConfigBase *config = wxConfigBase::Get();
-  EditorSettings settings;
-  settings.Load(config);
-
-  EditorColorScheme colors = settings.GetColors();
-
   wxColour headerBg;
   switch (role) {
     case AiMarkdownRole::User:
@@ -214,52 +283,111 @@ wxString ArduinoMarkdownPanel::WrapMessage(const wxString &msgHtml,
   return html;
 }
 
-wxString ArduinoMarkdownPanel::BuildFullHtmlFromMessages() const {
-  wxConfigBase *config = wxConfigBase::Get();
-  EditorSettings settings;
-  settings.Load(config);
-  EditorColorScheme colors = settings.GetColors();
-
-  // zvol si textovou barvu podle toho co v scheme máš:
-  // wxColour fg = colors.foreground;  // pokud existuje
-  wxColour bg = colors.background;
-  wxColour fg = colors.text;
+const wxString &ArduinoMarkdownPanel::GetMessageHtml(MdMsg &m, const EditorColorScheme &colors) const {
+  std::string key = wxToStd(m.markdown);
+  key.push_back('\x1f');
+  key += wxToStd(m.info);
+  key.push_back('\x1f');
+  key += wxToStd(m.time);
+  key.push_back((char)m.role);
+
+  const uint64_t hash = Fnv1a64((const uint8_t *)key.data(), key.size());
+  if (hash == m.htmlHash && !m.html.empty()) {
+    return m.html;
+  }
 
-  wxString body;
-  for (const auto &m : m_msgs) {
-    wxString frag;
-    if (m.role == AiMarkdownRole::User) {
-      frag = m.markdown;
-    } else {
-      frag = ArduinoMarkdown_MarkdownToHtmlFragment(m.markdown);
-    }
+  wxString frag;
+  if (m.role == AiMarkdownRole::User) {
+    frag = m.markdown;
+  } else {
+    frag = ArduinoMarkdown_MarkdownToHtmlFragment(m.markdown);
+  }
 
 #ifdef __APPLE__
-    // On Apple, widgets cannot display pictorial emojis and it crashes with SigBus somewhere
-    // in CopyImage. Therefore, it is specially filtered here and replaced with ' '.
-    for (size_t i = 0; i < frag.length(); ++i) {
-      if (IsDangerousEmoji(frag[i])) {
-        frag[i] = ' ';
-      }
+  // On Apple, widgets cannot display pictorial emojis and it crashes with SigBus somewhere
+  // in CopyImage. Therefore, it is specially filtered here and replaced with ' '.
+  for (size_t i = 0; i < frag.length(); ++i) {
+    if (IsDangerousEmoji(frag[i])) {
+      frag[i] = ' ';
     }
+  }
 #endif
 
-    body << WrapMessage(frag, m.role, m.info, m.time) << wxT("\n");
-  }
+  // Fragments are parsed on their own (outside of <body>), so the text
+  // colour is given explicitly.
+  m.html.clear();
+  m.html << wxT("<font color=\"") << ColorToHex(colors.text) << wxT("\">")
+         << WrapMessage(frag, m.role, m.info, m.time, colors)
+         << wxT("</font>\n");
+  m.htmlHash = hash;
+  return m.html;
+}
+
+wxString ArduinoMarkdownPanel::BuildDocumentHtml(const EditorColorScheme &colors) const {
+  wxColour bg = colors.background;
+  wxColour fg = colors.text;
 
   wxString html;
   html << wxT("<html><body bgcolor=\"") << ColorToHex(bg)
        << wxT("\" text=\"") << ColorToHex(fg)
        << wxT("\">")
-       << body
        << wxT("</body></html>");
-
-  APP_DEBUG_LOG("MDW: HTML=\n%s", wxToStd(html).c_str());
   return html;
 }
 
 void ArduinoMarkdownPanel::Render(bool scrollToEnd) {
-  m_html->SetPage(BuildFullHtmlFromMessages());
+  wxConfigBase *config = wxConfigBase::Get();
+  EditorSettings settings;
+  settings.Load(config);
+  EditorColorScheme colors = settings.GetColors();
+
+  wxString styleKey;
+  styleKey << ColorToHex(colors.background) << ColorToHex(colors.text)
+           << ColorToHex(colors.aiUserBg) << ColorToHex(colors.aiAssistantBg)
+           << ColorToHex(colors.aiSystemBg) << ColorToHex(colors.aiInfoBg)
+           << ColorToHex(colors.aiErrorBg);
+  if (styleKey != m_styleKey) {
+    m_styleKey = styleKey;
+    for (auto &m : m_msgs) {
+      m.html.clear();
+    }
+    m_fullRender = true;
+  }
+
+  // Changed messages are removed from the document and added again. That
+  // is only possible at the end and when no selection points into them.
+  if (!m_fullRender) {
+    bool removing = false;
+    for (size_t i = m_firstDirty; i < m_msgs.size(); ++i) {
+      removing |= (m_msgs[i].cell != nullptr);
+    }
+    if (removing && !m_html->CanRemoveFragments()) {
+      m_fullRender = true;
+    }
+  }
+
+  if (m_fullRender) {
+    m_html->SetPage(BuildDocumentHtml(colors));
+    for (auto &m : m_msgs) {
+      m.cell = nullptr;
+    }
+    m_firstDirty = 0;
+    m_fullRender = false;
+  } else {
+    for (size_t i = m_msgs.size(); i-- > m_firstDirty;) {
+      m_html->RemoveFragment(m_msgs[i].cell);
+      m_msgs[i].cell = nullptr;
+    }
+  }
+
+  for (size_t i = m_firstDirty; i < m_msgs.size(); ++i) {
+    const wxString &html = GetMessageHtml(m_msgs[i], colors);
+    APP_DEBUG_LOG("MDW: HTML[%zu]=\n%s", i, wxToStd(html).c_str());
+    m_msgs[i].cell = m_html->AppendFragment(html);
+  }
+  m_firstDirty = m_msgs.size();
+
+  m_html->Relayout();
 
   if (scrollToEnd) {
     m_html->CallAfter([this]() {
@@ -277,7 +405,6 @@ void ArduinoMarkdownPanel::Render(bool scrollToEnd) {
       }
     });
   } else {
-    m_html->Refresh();
     m_html->Update();
   }
 }
@@ -287,6 +414,44 @@ void ArduinoMarkdownPanel::AppendMarkdown(const wxString &markdown,
                                           const wxString &info,
                                           const wxString &time) {
   m_msgs.push_back({markdown, role, info, time});
+  MarkDirty(m_msgs.size() - 1);
+  Render(true);
+}
+
+void ArduinoMarkdownPanel::AppendToLastMarkdown(const wxString &markdown) {
+  if (m_msgs.empty())
+    return;
+  m_msgs.back().markdown += markdown;
+  MarkDirty(m_msgs.size() - 1);
+  Render(true);
+}
+
+void ArduinoMarkdownPanel::ReplaceLastMarkdown(const wxString &markdown,
+                                               const wxString &info,
+                                               const wxString &time) {
+  if (m_msgs.empty())
+    return;
+  MdMsg &msg = m_msgs.back();
+  msg.markdown = markdown;
+  msg.info = info;
+  msg.time = time;
+  MarkDirty(m_msgs.size() - 1);
+  Render(true);
+}
+
+void ArduinoMarkdownPanel::RemoveLastMarkdown() {
+  if (m_msgs.empty())
+    return;
+  MdMsg &msg = m_msgs.back();
+  if (msg.cell) {
+    if (m_html && m_html->CanRemoveFragments()) {
+      m_html->RemoveFragment(msg.cell);
+    } else {
+      m_fullRender = true;
+    }
+  }
+  m_msgs.pop_back();
+  m_firstDirty = std::min(m_firstDirty, m_msgs.size());
   Render(true);
 }
 
@@ -18,11 +18,16 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <wx/html/htmlwin.h>
 #include <wx/panel.h>
 #include <wx/string.h>
 
 class wxHtmlWindow;
+class wxHtmlContainerCell;
+class ArduinoMarkdownHtmlWindow;
+struct EditorColorScheme;
 
 enum class AiMarkdownRole {
   User,
@@ -35,6 +40,9 @@ enum class AiMarkdownRole {
 wxString ArduinoMarkdown_MarkdownToHtmlFragment(const wxString &input);
 
 // Simple markdown panel.
+// Each message is converted to HTML once (cached by a hash of its content)
+// and lives in its own cell container of the document, so adding a message
+// or streaming into the last one only parses the new content.
 class ArduinoMarkdownPanel : public wxPanel {
 public:
   ArduinoMarkdownPanel(wxWindow *parent,
@@ -49,6 +57,11 @@ public:
 
   void AppendMarkdown(const wxString &markdown, AiMarkdownRole role, const wxString &info = wxEmptyString, const wxString &time = wxEmptyString);
 
+  // Streamed answers: text is added to / replaces / drops the last message.
+  void AppendToLastMarkdown(const wxString &markdown);
+  void ReplaceLastMarkdown(const wxString &markdown, const wxString &info = wxEmptyString, const wxString &time = wxEmptyString);
+  void RemoveLastMarkdown();
+
   void SetBaseFonts(const wxString &normalFace,
                     const wxString &fixedFace,
                     const int *sizes = nullptr);
@@ -59,14 +72,23 @@ private:
     AiMarkdownRole role;
     wxString info;
     wxString time;
+
+    uint64_t htmlHash = 0;               // content hash the html was built from
+    wxString html;                       // cached message HTML
+    wxHtmlContainerCell *cell = nullptr; // in the document, owned by m_html
   };
 
-  wxHtmlWindow *m_html{nullptr};
+  ArduinoMarkdownHtmlWindow *m_html{nullptr};
   std::vector<MdMsg> m_msgs;
+  size_t m_firstDirty = 0; // messages from here on are not in the document yet
+  bool m_fullRender = true;
+  wxString m_styleKey; // colours the document was built with
 
   void InitHtmlCtrl();
-  wxString BuildFullHtmlFromMessages() const;
-  wxString WrapMessage(const wxString &msgHtml, AiMarkdownRole role, const wxString &info, const wxString &time) const;
+  void MarkDirty(size_t index);
+  const wxString &GetMessageHtml(MdMsg &m, const EditorColorScheme &colors) const;
+  wxString BuildDocumentHtml(const EditorColorScheme &colors) const;
+  wxString WrapMessage(const wxString &msgHtml, AiMarkdownRole role, const wxString &info, const wxString &time, const EditorColorScheme &colors) const;
   wxString GetRoleLabel(AiMarkdownRole role) const;
   void OnHtmlLinkClicked(wxHtmlLinkEvent &event);
 };
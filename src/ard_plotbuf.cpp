@@ -0,0 +1,144 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_plotbuf.hpp"
+
+#include <algorithm>
+
+void ArduinoPlotSeriesBuffer::Append(double t_ms, double value) {
+  const uint64_t idx = End();
+
+  m_t.PushBack(t_ms);
+  m_v.PushBack(value);
+
+  for (size_t l = 0; l < kLevels; l++) {
+    Level &lv = m_levels[l];
+    const uint64_t block = idx >> LevelShift(l);
+
+    if (lv.blocks.Size() == 0) {
+      lv.firstBlock = block;
+    }
+
+    if (lv.firstBlock + lv.blocks.Size() == block) {
+      lv.blocks.PushBack(MinMax{value, value});
+    } else {
+      MinMax &mm = lv.blocks.Back();
+      mm.min = std::min(mm.min, value);
+      mm.max = std::max(mm.max, value);
+    }
+  }
+}
+
+void ArduinoPlotSeriesBuffer::DropFront(size_t count) {
+  if (count == 0)
+    return;
+
+  if (count >= Size()) {
+    // keep absolute numbering, blocks restart with the next sample
+    m_first = End();
+    m_t.PopFront(count);
+    m_v.PopFront(count);
+    for (auto &lv : m_levels) {
+      lv.blocks.PopFront(lv.blocks.Size());
+    }
+    return;
+  }
+
+  m_first += count;
+  m_t.PopFront(count);
+  m_v.PopFront(count);
+
+  // Blocks starting before m_first are never used by GetMinMax() -> drop them.
+  for (size_t l = 0; l < kLevels; l++) {
+    Level &lv = m_levels[l];
+    const unsigned shift = LevelShift(l);
+
+    uint64_t firstUsable = m_first >> shift;
+    if ((firstUsable << shift) < m_first)
+      firstUsable++;
+
+    if (firstUsable > lv.firstBlock) {
+      lv.blocks.PopFront((size_t)(firstUsable - lv.firstBlock));
+      lv.firstBlock = firstUsable;
+    }
+  }
+}
+
+void ArduinoPlotSeriesBuffer::Clear() {
+  m_t.Clear();
+  m_v.Clear();
+  m_first = 0;
+  for (auto &lv : m_levels) {
+    lv.blocks.Clear();
+    lv.firstBlock = 0;
+  }
+}
+
+uint64_t ArduinoPlotSeriesBuffer::LowerBound(double t_ms, uint64_t from) const {
+  size_t lo = (size_t)(std::max(from, m_first) - m_first);
+  size_t hi = m_t.Size();
+
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (m_t[mid] < t_ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return m_first + lo;
+}
+
+ArduinoPlotSeriesBuffer::MinMax ArduinoPlotSeriesBuffer::GetMinMax(uint64_t from, uint64_t to) const {
+  from = std::max(from, m_first);
+  to = std::min(to, End());
+
+  MinMax res{m_v[(size_t)(from - m_first)], m_v[(size_t)(from - m_first)]};
+
+  uint64_t i = from;
+  while (i < to) {
+    // largest complete block starting at i and fitting into [i, to)
+    bool used = false;
+    for (size_t l = kLevels; l-- > 0;) {
+      const unsigned shift = LevelShift(l);
+      const uint64_t size = (uint64_t)1 << shift;
+      if ((i & (size - 1)) != 0 || i + size > to)
+        continue;
+
+      const Level &lv = m_levels[l];
+      const uint64_t block = i >> shift;
+      if (block < lv.firstBlock || block >= lv.firstBlock + lv.blocks.Size())
+        continue;
+
+      const MinMax &mm = lv.blocks[(size_t)(block - lv.firstBlock)];
+      res.min = std::min(res.min, mm.min);
+      res.max = std::max(res.max, mm.max);
+      i += size;
+      used = true;
+      break;
+    }
+
+    if (!used) {
+      const double v = m_v[(size_t)(i - m_first)];
+      res.min = std::min(res.min, v);
+      res.max = std::max(res.max, v);
+      i++;
+    }
+  }
+
+  return res;
+}
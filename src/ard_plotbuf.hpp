@@ -0,0 +1,134 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Samples of one plotted series: timestamps and values in two contiguous
+ * ring buffers plus a min/max pyramid over fixed blocks of samples
+ * (16, 256, 4096, 65536 samples per block).
+ *
+ * Samples are addressed by absolute indices which don't change when old
+ * samples are dropped from the front. Min/max of any index range costs a few
+ * block lookups, so the plot can reduce an arbitrarily dense range of samples
+ * to a couple of points per pixel.
+ *
+ * Timestamps are expected to be non-decreasing.
+ */
+class ArduinoPlotSeriesBuffer {
+public:
+  struct MinMax {
+    double min;
+    double max;
+  };
+
+  void Append(double t_ms, double value);
+  void DropFront(size_t count);
+  void Clear();
+
+  size_t Size() const { return m_t.Size(); }
+  bool Empty() const { return m_t.Size() == 0; }
+
+  // valid absolute indices are [Begin(), End())
+  uint64_t Begin() const { return m_first; }
+  uint64_t End() const { return m_first + m_t.Size(); }
+
+  double TimeAt(uint64_t idx) const { return m_t[(size_t)(idx - m_first)]; }
+  double ValueAt(uint64_t idx) const { return m_v[(size_t)(idx - m_first)]; }
+
+  // First index in [from, End()) with time >= t_ms (End() if none).
+  uint64_t LowerBound(double t_ms, uint64_t from) const;
+  uint64_t LowerBound(double t_ms) const { return LowerBound(t_ms, m_first); }
+
+  // Min/max of values in [from, to); the range must not be empty.
+  MinMax GetMinMax(uint64_t from, uint64_t to) const;
+
+private:
+  // Power-of-two ring, grows by doubling.
+  template <typename T>
+  class Ring {
+  public:
+    size_t Size() const { return m_size; }
+
+    const T &operator[](size_t i) const { return m_data[(m_head + i) & m_mask]; }
+    T &operator[](size_t i) { return m_data[(m_head + i) & m_mask]; }
+    T &Back() { return (*this)[m_size - 1]; }
+
+    void PushBack(const T &v) {
+      if (m_size == m_data.size())
+        Grow();
+      m_data[(m_head + m_size) & m_mask] = v;
+      m_size++;
+    }
+
+    void PopFront(size_t n) {
+      if (n >= m_size) {
+        m_head = 0;
+        m_size = 0;
+        return;
+      }
+      m_head = (m_head + n) & m_mask;
+      m_size -= n;
+    }
+
+    void Clear() {
+      m_data.clear();
+      m_data.shrink_to_fit();
+      m_head = 0;
+      m_size = 0;
+      m_mask = 0;
+    }
+
+  private:
+    void Grow() {
+      const size_t cap = m_data.empty() ? 64 : m_data.size() * 2;
+      std::vector<T> data(cap);
+      for (size_t i = 0; i < m_size; i++)
+        data[i] = (*this)[i];
+      m_data.swap(data);
+      m_head = 0;
+      m_mask = cap - 1;
+    }
+
+    std::vector<T> m_data;
+    size_t m_head = 0;
+    size_t m_size = 0;
+    size_t m_mask = 0;
+  };
+
+  static constexpr unsigned kBlockBits = 4; // 16x fan-out per level
+  static constexpr size_t kLevels = 4;
+
+  struct Level {
+    Ring<MinMax> blocks;
+    uint64_t firstBlock = 0; // absolute block number of blocks[0]
+  };
+
+  static unsigned LevelShift(size_t level) { return (unsigned)(kBlockBits * (level + 1)); }
+
+  Ring<double> m_t;
+  Ring<double> m_v;
+  uint64_t m_first = 0; // absolute index of m_t[0]
+
+  std::array<Level, kLevels> m_levels;
+};
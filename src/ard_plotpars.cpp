@@ -21,11 +21,33 @@
 
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 
-ArduinoPlotParser::ArduinoPlotParser(ArduinoPlotSink *sink)
-    : m_sink(sink) {
+namespace {
+// Longest unfinished line kept between chunks.
+constexpr size_t kMaxLineBytes = 50000;
+// Text waiting for the stage thread (it only grows when parsing can't keep up).
+constexpr size_t kMaxPendingInputBytes = 8 * 1024 * 1024;
+
+inline bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v';
+}
+
+std::string_view TrimView(std::string_view s) {
+  size_t b = 0;
+  size_t e = s.size();
+  while (b < e && IsSpace(s[b]))
+    b++;
+  while (e > b && IsSpace(s[e - 1]))
+    e--;
+  return s.substr(b, e - b);
+}
+} // namespace
+
+ArduinoPlotParser::ArduinoPlotParser() {
   Reset();
 }
 
@@ -33,26 +55,28 @@ void ArduinoPlotParser::Reset() {
   m_mode = Mode::Unknown;
   m_probe.clear();
   m_columnNames.clear();
+  m_columnIds.clear();
   m_pendingHeaderNames.clear();
   m_lastColumnCount = 0;
   m_columnsDelimHint = '\0';
+  m_seriesIds.clear();
 }
 
-bool ArduinoPlotParser::HasAnyDigit(const std::string &s) {
+bool ArduinoPlotParser::HasAnyDigit(std::string_view s) {
   for (unsigned char c : s)
     if (std::isdigit(c))
       return true;
   return false;
 }
 
-bool ArduinoPlotParser::HasLetter(const std::string &s) {
+bool ArduinoPlotParser::HasLetter(std::string_view s) {
   for (unsigned char c : s)
     if (std::isalpha(c))
       return true;
   return false;
 }
 
-bool ArduinoPlotParser::LooksLikeIdentifier(const std::string &tok) {
+bool ArduinoPlotParser::LooksLikeIdentifier(std::string_view tok) {
   if (tok.empty())
     return false;
   unsigned char c0 = (unsigned char)tok[0];
@@ -67,47 +91,28 @@ bool ArduinoPlotParser::LooksLikeIdentifier(const std::string &tok) {
   return true;
 }
 
-std::vector<std::string> ArduinoPlotParser::SplitTokensByDelims(const std::string &line, const char *delims) {
-  std::vector<std::string> out;
-  std::string cur;
-  auto isDelim = [&](char c) -> bool {
-    for (const char *d = delims; *d; ++d)
-      if (c == *d)
-        return true;
-    return false;
-  };
+void ArduinoPlotParser::SplitTokensByDelims(std::string_view line, const char *delims, std::vector<std::string_view> &out) {
+  out.clear();
 
-  for (char c : line) {
-    if (isDelim(c)) {
-      if (!cur.empty()) {
-        out.push_back(cur);
-        cur.clear();
-      }
-    } else {
-      cur.push_back(c);
+  size_t start = 0;
+  for (size_t i = 0; i <= line.size(); ++i) {
+    if (i == line.size() || std::strchr(delims, line[i]) != nullptr) {
+      if (i > start)
+        out.push_back(line.substr(start, i - start));
+      start = i + 1;
     }
   }
-  if (!cur.empty())
-    out.push_back(cur);
-  return out;
 }
 
 // Loose tokenization for mixed logs: split on whitespace and common separators, but keep "a=1.2" intact.
-std::vector<std::string> ArduinoPlotParser::SplitTokensLoose(const std::string &line) {
+void ArduinoPlotParser::SplitTokensLoose(std::string_view line, std::vector<std::string_view> &out) {
   // Split on whitespace, comma, semicolon, tabs.
-  auto toks = SplitTokensByDelims(line, " \t\r\n,;");
-  // Trim each token (paranoia)
-  for (auto &t : toks)
-    t = Trim(t);
-  toks.erase(std::remove_if(toks.begin(), toks.end(),
-                            [](const std::string &s) { return s.empty(); }),
-             toks.end());
-  return toks;
+  SplitTokensByDelims(line, " \t\r\n,;", out);
 }
 
 // Parses a numeric prefix of token, ignoring trailing units.
 // Supports: [+/-]?\d+(\.\d+)?([eE][+/-]?\d+)? and also comma-decimals if enabled.
-bool ArduinoPlotParser::ParseNumberPrefix(const std::string &tok, bool acceptCommaDecimal, double &out) {
+bool ArduinoPlotParser::ParseNumberPrefix(std::string_view tok, bool acceptCommaDecimal, double &out) {
   if (tok.empty())
     return false;
 
@@ -119,12 +124,14 @@ bool ArduinoPlotParser::ParseNumberPrefix(const std::string &tok, bool acceptCom
     i++;
 
   bool anyDigit = false;
+  bool comma = false;
   while (std::isdigit((unsigned char)peek(i))) {
     anyDigit = true;
     i++;
   }
 
   if (peek(i) == '.' || (acceptCommaDecimal && peek(i) == ',')) {
+    comma = (peek(i) == ',');
     i++;
     while (std::isdigit((unsigned char)peek(i))) {
       anyDigit = true;
@@ -149,16 +156,37 @@ bool ArduinoPlotParser::ParseNumberPrefix(const std::string &tok, bool acceptCom
   if (!anyDigit)
     return false;
 
-  std::string num = tok.substr(0, i);
-  if (acceptCommaDecimal) {
-    // Convert comma decimal to dot for strtod
-    std::replace(num.begin(), num.end(), ',', '.');
+  // from_chars does not take a leading '+'
+  std::string_view num = tok.substr(0, i);
+  if (num[0] == '+')
+    num.remove_prefix(1);
+
+  // Comma decimal -> dot. Numbers are short, a stack buffer is enough.
+  char buf[128];
+  if (comma || num.size() >= sizeof(buf)) {
+    if (num.size() >= sizeof(buf))
+      return false;
+    std::memcpy(buf, num.data(), num.size());
+    std::replace(buf, buf + num.size(), ',', '.');
+    num = std::string_view(buf, num.size());
   }
 
+  double v = 0.0;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  const auto res = std::from_chars(num.data(), num.data() + num.size(), v);
+  if (res.ec != std::errc() || res.ptr == num.data())
+    return false;
+#else
+  // strtod needs a terminated string (and is locale dependent, the scanned prefix only has '.')
+  if (num.data() != buf) {
+    std::memcpy(buf, num.data(), num.size());
+  }
+  buf[num.size()] = '\0';
   char *endp = nullptr;
-  const double v = std::strtod(num.c_str(), &endp);
-  if (endp == num.c_str())
+  v = std::strtod(buf, &endp);
+  if (endp == buf)
     return false;
+#endif
 
   if (!std::isfinite(v))
     return false; // in 1st phase ignore NaN/Inf
@@ -166,11 +194,11 @@ bool ArduinoPlotParser::ParseNumberPrefix(const std::string &tok, bool acceptCom
   return true;
 }
 
-bool ArduinoPlotParser::HeuristicAcceptCommaDecimal(const std::string &line) {
+bool ArduinoPlotParser::HeuristicAcceptCommaDecimal(std::string_view line) {
   // Safe-ish heuristic:
   // - If semicolon present AND there is digit ',' digit somewhere => comma is likely decimal.
   // - If commas are used as separators, we do NOT treat them as decimal here.
-  if (line.find(';') == std::string::npos)
+  if (line.find(';') == std::string_view::npos)
     return false;
 
   for (size_t i = 1; i + 1 < line.size(); i++) {
@@ -184,24 +212,24 @@ bool ArduinoPlotParser::HeuristicAcceptCommaDecimal(const std::string &line) {
 }
 
 // Returns number of parsed pairs from explicit "name=value" / "name:value" / "name = value" etc.
-size_t ArduinoPlotParser::ParseTaggedPairs(const std::string &line,
+size_t ArduinoPlotParser::ParseTaggedPairs(std::string_view line,
                                            bool acceptCommaDecimal,
-                                           std::vector<std::pair<std::string, double>> &out) {
+                                           std::vector<NamedValue> &out) {
   out.clear();
 
   // Tokenize loosely.
-  std::vector<std::string> toks = SplitTokensLoose(line);
-  if (toks.empty())
+  SplitTokensLoose(line, m_toks);
+  if (m_toks.empty())
     return 0;
 
   // 1) inline operators inside token: name=value or name:value
-  for (const std::string &t : toks) {
+  for (std::string_view t : m_toks) {
     size_t p = t.find('=');
-    if (p == std::string::npos)
+    if (p == std::string_view::npos)
       p = t.find(':');
-    if (p != std::string::npos && p > 0 && p + 1 < t.size()) {
-      std::string name = Trim(t.substr(0, p));
-      std::string valT = Trim(t.substr(p + 1));
+    if (p != std::string_view::npos && p > 0 && p + 1 < t.size()) {
+      std::string_view name = TrimView(t.substr(0, p));
+      std::string_view valT = TrimView(t.substr(p + 1));
       if (!LooksLikeIdentifier(name))
         continue;
       double v = 0.0;
@@ -214,10 +242,10 @@ size_t ArduinoPlotParser::ParseTaggedPairs(const std::string &line,
     return out.size();
 
   // 2) 3-token patterns: name = value / name : value
-  for (size_t i = 0; i + 2 < toks.size(); i++) {
-    const std::string &a = toks[i];
-    const std::string &op = toks[i + 1];
-    const std::string &b = toks[i + 2];
+  for (size_t i = 0; i + 2 < m_toks.size(); i++) {
+    std::string_view a = m_toks[i];
+    std::string_view op = m_toks[i + 1];
+    std::string_view b = m_toks[i + 2];
     if (!LooksLikeIdentifier(a))
       continue;
     if (!(op == "=" || op == ":"))
@@ -233,9 +261,9 @@ size_t ArduinoPlotParser::ParseTaggedPairs(const std::string &line,
 }
 
 // Implicit pairs: name value name value (alternating), common in serial prints.
-size_t ArduinoPlotParser::ParseImplicitPairs(const std::vector<std::string> &toks,
+size_t ArduinoPlotParser::ParseImplicitPairs(const std::vector<std::string_view> &toks,
                                              bool acceptCommaDecimal,
-                                             std::vector<std::pair<std::string, double>> &out) {
+                                             std::vector<NamedValue> &out) {
   out.clear();
   if (toks.size() < 2)
     return 0;
@@ -244,11 +272,15 @@ size_t ArduinoPlotParser::ParseImplicitPairs(const std::vector<std::string> &tok
 
   // Must be mostly alternating identifier + number
   for (size_t i = 0; i < toks.size(); i += 2) {
-    if (!LooksLikeIdentifier(toks[i]))
+    if (!LooksLikeIdentifier(toks[i])) {
+      out.clear();
       return 0;
+    }
     double v = 0.0;
-    if (!ParseNumberPrefix(toks[i + 1], acceptCommaDecimal, v))
+    if (!ParseNumberPrefix(toks[i + 1], acceptCommaDecimal, v)) {
+      out.clear();
       return 0;
+    }
     out.emplace_back(toks[i], v);
   }
   return out.size();
@@ -256,7 +288,7 @@ size_t ArduinoPlotParser::ParseImplicitPairs(const std::vector<std::string> &tok
 
 // Columns: parse a list of numbers separated by common delimiters.
 // Returns count of numbers. Also returns a delimiter hint (',' ';' or ' ').
-size_t ArduinoPlotParser::ParseColumns(const std::string &line,
+size_t ArduinoPlotParser::ParseColumns(std::string_view line,
                                        bool acceptCommaDecimal,
                                        std::vector<double> &outValues,
                                        char &outDelimiterHint) {
@@ -264,8 +296,8 @@ size_t ArduinoPlotParser::ParseColumns(const std::string &line,
   outDelimiterHint = '\0';
 
   // Determine delimiter preference
-  bool hasComma = (line.find(',') != std::string::npos);
-  bool hasSemi = (line.find(';') != std::string::npos);
+  bool hasComma = (line.find(',') != std::string_view::npos);
+  bool hasSemi = (line.find(';') != std::string_view::npos);
 
   const char *delims = nullptr;
   if (hasSemi) {
@@ -279,11 +311,11 @@ size_t ArduinoPlotParser::ParseColumns(const std::string &line,
     outDelimiterHint = ' ';
   }
 
-  auto toks = SplitTokensByDelims(line, delims);
+  SplitTokensByDelims(line, delims, m_toks);
   size_t parsed = 0;
 
-  for (auto &t : toks) {
-    t = Trim(t);
+  for (std::string_view t : m_toks) {
+    t = TrimView(t);
     if (t.empty())
       continue;
     double v = 0.0;
@@ -311,17 +343,17 @@ size_t ArduinoPlotParser::ParseColumns(const std::string &line,
 }
 
 // Header detection: line without numbers, looks like identifiers separated by delimiters.
-bool ArduinoPlotParser::IsLikelyHeaderLine(const std::string &line, std::vector<std::string> &outNames) {
+bool ArduinoPlotParser::IsLikelyHeaderLine(std::string_view line, std::vector<std::string_view> &outNames) {
   outNames.clear();
-  std::string s = Trim(line);
+  std::string_view s = TrimView(line);
   if (s.empty())
     return false;
   if (HasAnyDigit(s))
     return false; // header should not have digits (simple rule)
 
   // Split by common delimiters
-  bool hasComma = (s.find(',') != std::string::npos);
-  bool hasSemi = (s.find(';') != std::string::npos);
+  bool hasComma = (s.find(',') != std::string_view::npos);
+  bool hasSemi = (s.find(';') != std::string_view::npos);
 
   const char *delims = nullptr;
   if (hasSemi)
@@ -331,27 +363,37 @@ bool ArduinoPlotParser::IsLikelyHeaderLine(const std::string &line, std::vector<
   else
     delims = " \t\r\n";
 
-  auto toks = SplitTokensByDelims(s, delims);
-  for (auto &t : toks) {
-    t = Trim(t);
-    if (t.empty())
-      continue;
-    if (!LooksLikeIdentifier(t))
+  SplitTokensByDelims(s, delims, outNames);
+  for (std::string_view t : outNames) {
+    if (!LooksLikeIdentifier(t)) {
+      outNames.clear();
       return false;
-    outNames.push_back(t);
+    }
   }
   return outNames.size() >= 1;
 }
 
-void ArduinoPlotParser::EmitSample(const std::string &name, double value) {
-  if (!m_sink)
-    return;
-  m_sink->AddSampleAt(name, value, m_time, /*refresh=*/true);
+uint32_t ArduinoPlotParser::SeriesId(std::string_view name, PlotSampleBatch &out) {
+  m_nameKey.assign(name.data(), name.size());
+
+  auto it = m_seriesIds.find(m_nameKey);
+  if (it != m_seriesIds.end())
+    return it->second;
+
+  const uint32_t id = (uint32_t)m_seriesIds.size();
+  m_seriesIds.emplace(m_nameKey, id);
+
+  if (out.newSeries.empty())
+    out.firstNewSeries = id;
+  out.newSeries.push_back(m_nameKey);
+  return id;
 }
 
-void ArduinoPlotParser::EmitColumns(const std::vector<double> &values) {
-  if (!m_sink)
-    return;
+void ArduinoPlotParser::EmitSample(std::string_view name, double value, PlotSampleBatch &out) {
+  out.samples.push_back(PlotSample{SeriesId(name, out), m_time, value});
+}
+
+void ArduinoPlotParser::EmitColumns(const std::vector<double> &values, PlotSampleBatch &out) {
   if (values.empty())
     return;
 
@@ -362,180 +404,47 @@ void ArduinoPlotParser::EmitColumns(const std::vector<double> &values) {
     for (size_t i = 0; i < values.size(); i++) {
       m_columnNames.push_back("v" + std::to_string(i));
     }
+    m_columnIds.clear();
+  }
+
+  if (m_columnIds.size() != m_columnNames.size()) {
+    m_columnIds.clear();
+    for (const auto &name : m_columnNames)
+      m_columnIds.push_back(SeriesId(name, out));
   }
 
   for (size_t i = 0; i < values.size(); i++) {
-    EmitSample(m_columnNames[i], values[i]);
+    out.samples.push_back(PlotSample{m_columnIds[i], m_time, values[i]});
   }
 }
 
-void ArduinoPlotParser::ApplyLine(const std::string &lineRaw, double time) {
+void ArduinoPlotParser::ApplyLine(std::string_view lineRaw, double time, PlotSampleBatch &out) {
   m_time = time;
 
-  std::string line = Trim(lineRaw);
+  std::string_view line = TrimView(lineRaw);
   if (line.empty())
     return;
 
   switch (m_mode) {
     case Mode::Unknown:
-      ProcessLine_Unknown(line);
+      ProcessLine_Unknown(line, out);
       break;
     case Mode::Tagged:
-      ProcessLine_Tagged(line);
+      ProcessLine_Tagged(line, out);
       break;
     case Mode::Columns:
-      ProcessLine_Columns(line);
+      ProcessLine_Columns(line, out);
       break;
   }
 }
 
-void ArduinoPlotParser::ApplyBatch(const std::vector<BufferedPlotLine> &lines) {
-  if (lines.empty())
-    return;
-
-  bool anyEmitted = false;
-
-  // Reused scratch buffers (reduce allocations).
-  std::vector<std::pair<std::string, double>> pairs;
-  pairs.reserve(16);
-
-  std::vector<double> colVals;
-  colVals.reserve(16);
-
-  std::vector<std::string> header;
-  header.reserve(16);
-
-  auto emitSampleNR = [&](const std::string &name, double value, double t_ms) {
-    if (!m_sink)
-      return;
-
-    m_sink->AddSampleAt(name, value, t_ms, /*refresh=*/false);
-    anyEmitted = true;
-  };
-
-  auto processTaggedNR = [&](const std::string &line, double t_ms) {
-    const bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(line);
-
-    if (ParseTaggedPairs(line, acceptComma, pairs) >= 1) {
-      for (auto &kv : pairs)
-        emitSampleNR(kv.first, kv.second, t_ms);
-      return;
-    }
-
-    auto toks = SplitTokensLoose(line);
-    if (ParseImplicitPairs(toks, acceptComma, pairs) >= 1) {
-      for (auto &kv : pairs)
-        emitSampleNR(kv.first, kv.second, t_ms);
-      return;
-    }
-
-    // In tagged mode: if not parseable, ignore.
-  };
-
-  auto processColumnsNR = [&](const std::string &line, double t_ms) {
-    header.clear();
-    if (IsLikelyHeaderLine(line, header)) {
-      m_columnNames = header;
-      m_lastColumnCount = (int)m_columnNames.size();
-      return;
-    }
-
-    const bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(line);
-
-    char delim = '\0';
-    const size_t n = ParseColumns(line, acceptComma, colVals, delim);
-    if (n == 0)
-      return;
-
-    m_columnsDelimHint = delim;
-
-    // Adopt pending header (from probing) if it matches.
-    if (!m_pendingHeaderNames.empty() && (int)m_pendingHeaderNames.size() == (int)n) {
-      m_columnNames = m_pendingHeaderNames;
-      m_pendingHeaderNames.clear();
-    }
-
-    // Ensure names count matches.
-    if ((int)m_columnNames.size() != (int)n) {
-      m_columnNames.clear();
-      m_columnNames.reserve(n);
-      for (size_t i = 0; i < n; i++)
-        m_columnNames.push_back("v" + std::to_string(i));
-    }
-
-    m_lastColumnCount = (int)n;
-
-    if (!m_sink)
-      return;
-
-    for (size_t i = 0; i < n; i++) {
-      m_sink->AddSampleAt(m_columnNames[i], colVals[i], t_ms, /*refresh=*/false);
-      anyEmitted = true;
-    }
-  };
-
-  auto processUnknownNR = [&](const std::string &line, double t_ms) {
-    header.clear();
-    if (IsLikelyHeaderLine(line, header)) {
-      m_pendingHeaderNames = header;
-      m_probe.push_back({line});
-    } else {
-      m_probe.push_back({line});
-    }
-
-    while (m_probe.size() > m_maxProbeLines)
-      m_probe.pop_front();
-
-    DecideModeFromProbe();
-
-    if (m_mode != Mode::Unknown) {
-      // Flush probe in decided mode.
-      // NOTE: This matches the existing behavior: flushed probe lines get the current time.
-      for (const auto &pl : m_probe) {
-        if (m_mode == Mode::Tagged)
-          processTaggedNR(pl.raw, t_ms);
-        else if (m_mode == Mode::Columns)
-          processColumnsNR(pl.raw, t_ms);
-      }
-      m_probe.clear();
-    }
-  };
-
-  for (const auto &bl : lines) {
-    m_time = bl.time;
-
-    std::string line = Trim(bl.line);
-    if (line.empty())
-      continue;
-
-    switch (m_mode) {
-      case Mode::Unknown:
-        processUnknownNR(line, bl.time);
-        break;
-      case Mode::Tagged:
-        processTaggedNR(line, bl.time);
-        break;
-      case Mode::Columns:
-        processColumnsNR(line, bl.time);
-        break;
-    }
-  }
-
-  if (anyEmitted && m_sink) {
-    m_sink->Refresh(false);
-  }
-}
-
-void ArduinoPlotParser::ProcessLine_Unknown(const std::string &line) {
+void ArduinoPlotParser::ProcessLine_Unknown(std::string_view line, PlotSampleBatch &out) {
   // Collect header candidate if it looks like header
-  std::vector<std::string> header;
-  if (IsLikelyHeaderLine(line, header)) {
-    m_pendingHeaderNames = header;
-    // Still keep it in probe to allow flush if we decide Columns mode.
-    m_probe.push_back({line});
-  } else {
-    m_probe.push_back({line});
+  if (IsLikelyHeaderLine(line, m_header)) {
+    m_pendingHeaderNames.assign(m_header.begin(), m_header.end());
   }
+  // Still keep it in probe to allow flush if we decide Columns mode.
+  m_probe.push_back({std::string(line)});
 
   // Keep probe bounded
   while (m_probe.size() > m_maxProbeLines)
@@ -545,7 +454,8 @@ void ArduinoPlotParser::ProcessLine_Unknown(const std::string &line) {
   DecideModeFromProbe();
 
   if (m_mode != Mode::Unknown) {
-    FlushProbeAsCurrentMode();
+    // NOTE: flushed probe lines get the current time.
+    FlushProbeAsCurrentMode(out);
     m_probe.clear();
   }
 }
@@ -555,15 +465,13 @@ void ArduinoPlotParser::DecideModeFromProbe() {
   for (const auto &pl : m_probe) {
     bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(pl.raw);
 
-    std::vector<std::pair<std::string, double>> pairs;
-    if (ParseTaggedPairs(pl.raw, acceptComma, pairs) >= 1) {
+    if (ParseTaggedPairs(pl.raw, acceptComma, m_pairs) >= 1) {
       m_mode = Mode::Tagged;
       return;
     }
 
-    // implicit pairs? (name value name value)
-    auto toks = SplitTokensLoose(pl.raw);
-    if (ParseImplicitPairs(toks, acceptComma, pairs) >= 1) {
+    // implicit pairs? (name value name value) - m_toks still holds the loose tokens
+    if (ParseImplicitPairs(m_toks, acceptComma, m_pairs) >= 1) {
       m_mode = Mode::Tagged;
       return;
     }
@@ -574,9 +482,8 @@ void ArduinoPlotParser::DecideModeFromProbe() {
   for (const auto &pl : m_probe) {
     bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(pl.raw);
 
-    std::vector<double> vals;
     char delim = '\0';
-    size_t n = ParseColumns(pl.raw, acceptComma, vals, delim);
+    size_t n = ParseColumns(pl.raw, acceptComma, m_values, delim);
     if ((int)n > bestCount) {
       bestCount = (int)n;
     }
@@ -592,33 +499,30 @@ void ArduinoPlotParser::DecideModeFromProbe() {
   m_mode = Mode::Unknown;
 }
 
-void ArduinoPlotParser::FlushProbeAsCurrentMode() {
+void ArduinoPlotParser::FlushProbeAsCurrentMode(PlotSampleBatch &out) {
   // When switching from Unknown -> mode, interpret buffered lines in that mode.
   for (const auto &pl : m_probe) {
     if (m_mode == Mode::Tagged)
-      ProcessLine_Tagged(pl.raw);
+      ProcessLine_Tagged(pl.raw, out);
     else if (m_mode == Mode::Columns)
-      ProcessLine_Columns(pl.raw);
+      ProcessLine_Columns(pl.raw, out);
   }
 }
 
-void ArduinoPlotParser::ProcessLine_Tagged(const std::string &line) {
+void ArduinoPlotParser::ProcessLine_Tagged(std::string_view line, PlotSampleBatch &out) {
   bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(line);
 
-  std::vector<std::pair<std::string, double>> pairs;
-
   // Try explicit tagged
-  if (ParseTaggedPairs(line, acceptComma, pairs) >= 1) {
-    for (auto &kv : pairs)
-      EmitSample(kv.first, kv.second);
+  if (ParseTaggedPairs(line, acceptComma, m_pairs) >= 1) {
+    for (auto &kv : m_pairs)
+      EmitSample(kv.first, kv.second, out);
     return;
   }
 
-  // Try implicit tagged: name value name value
-  auto toks = SplitTokensLoose(line);
-  if (ParseImplicitPairs(toks, acceptComma, pairs) >= 1) {
-    for (auto &kv : pairs)
-      EmitSample(kv.first, kv.second);
+  // Try implicit tagged: name value name value (m_toks holds the loose tokens)
+  if (ParseImplicitPairs(m_toks, acceptComma, m_pairs) >= 1) {
+    for (auto &kv : m_pairs)
+      EmitSample(kv.first, kv.second, out);
     return;
   }
 
@@ -626,20 +530,19 @@ void ArduinoPlotParser::ProcessLine_Tagged(const std::string &line) {
   // (Common when logs mix messages.)
 }
 
-void ArduinoPlotParser::ProcessLine_Columns(const std::string &line) {
+void ArduinoPlotParser::ProcessLine_Columns(std::string_view line, PlotSampleBatch &out) {
   // Header line? (used to name channels)
-  std::vector<std::string> header;
-  if (IsLikelyHeaderLine(line, header)) {
-    m_columnNames = header;
+  if (IsLikelyHeaderLine(line, m_header)) {
+    m_columnNames.assign(m_header.begin(), m_header.end());
+    m_columnIds.clear();
     m_lastColumnCount = (int)m_columnNames.size();
     return;
   }
 
   bool acceptComma = m_acceptDecimalCommaUser || HeuristicAcceptCommaDecimal(line);
 
-  std::vector<double> vals;
   char delim = '\0';
-  size_t n = ParseColumns(line, acceptComma, vals, delim);
+  size_t n = ParseColumns(line, acceptComma, m_values, delim);
   if (n == 0)
     return;
 
@@ -648,18 +551,183 @@ void ArduinoPlotParser::ProcessLine_Columns(const std::string &line) {
   // If we had a pending header from probing and it matches, adopt it now.
   if (!m_pendingHeaderNames.empty() && (int)m_pendingHeaderNames.size() == (int)n) {
     m_columnNames = m_pendingHeaderNames;
+    m_columnIds.clear();
     m_pendingHeaderNames.clear();
   }
 
-  // If current column name count doesn't match, regenerate (or shrink/expand)
-  if ((int)m_columnNames.size() != (int)n) {
-    // If existing names were from header but count changed, regenerate to avoid wrong mapping.
-    m_columnNames.clear();
-    m_columnNames.reserve(n);
-    for (size_t i = 0; i < n; i++)
-      m_columnNames.push_back("v" + std::to_string(i));
+  // If current column name count doesn't match, EmitColumns() regenerates v0..vN
+  m_lastColumnCount = (int)n;
+  EmitColumns(m_values, out);
+}
+
+// ---------------------------------------------------------------------------
+// ArduinoPlotStage
+// ---------------------------------------------------------------------------
+
+ArduinoPlotStage::ArduinoPlotStage(std::function<void()> onReady)
+    : m_onReady(std::move(onReady)) {
+  m_thread = std::thread([this]() { ThreadLoop(); });
+}
+
+ArduinoPlotStage::~ArduinoPlotStage() {
+  {
+    std::lock_guard<std::mutex> lk(m_inMutex);
+    m_stopping = true;
   }
+  m_inCv.notify_all();
 
-  m_lastColumnCount = (int)n;
-  EmitColumns(vals);
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+void ArduinoPlotStage::Feed(const std::string &chunkUtf8, double t_ms) {
+  if (chunkUtf8.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_inMutex);
+    m_in.push_back(Chunk{chunkUtf8, t_ms});
+    m_inBytes += chunkUtf8.size();
+
+    while (m_inBytes > kMaxPendingInputBytes && m_in.size() > 1) {
+      m_inBytes -= m_in.front().text.size();
+      m_in.pop_front();
+    }
+  }
+  m_inCv.notify_one();
+}
+
+void ArduinoPlotStage::Reset() {
+  {
+    std::lock_guard<std::mutex> lk(m_inMutex);
+    m_in.clear();
+    m_inBytes = 0;
+    // The stage thread resets the parser when it notices the new generation;
+    // anything it is parsing right now will not be published.
+    ++m_generation;
+  }
+
+  std::lock_guard<std::mutex> lk(m_outMutex);
+  m_out.clear();
+  m_notified = false;
+}
+
+bool ArduinoPlotStage::Take(PlotSampleBatch &out) {
+  out.clear();
+
+  std::lock_guard<std::mutex> lk(m_outMutex);
+  std::swap(out, m_out);
+  m_notified = false;
+  return !out.empty();
+}
+
+void ArduinoPlotStage::ThreadLoop() {
+  std::deque<Chunk> work;
+  PlotSampleBatch local;
+
+  for (;;) {
+    uint64_t generation = 0;
+    {
+      std::unique_lock<std::mutex> lk(m_inMutex);
+      m_inCv.wait(lk, [this]() { return m_stopping || !m_in.empty(); });
+      if (m_stopping) {
+        return;
+      }
+
+      work.swap(m_in);
+      m_inBytes = 0;
+      generation = m_generation.load();
+    }
+
+    if (generation != m_parserGeneration) {
+      m_parser.Reset();
+      m_lineBuf.clear();
+      m_parserGeneration = generation;
+    }
+
+    local.clear();
+    local.firstNewSeries = m_parser.GetSeriesCount();
+    for (const auto &chunk : work) {
+      ParseChunk(chunk, local);
+    }
+    work.clear();
+
+    Publish(local, generation);
+  }
+}
+
+void ArduinoPlotStage::ParseChunk(const Chunk &chunk, PlotSampleBatch &out) {
+  const char *data = chunk.text.data();
+  const size_t size = chunk.text.size();
+  size_t pos = 0;
+
+  while (pos < size) {
+    const char *nl = (const char *)std::memchr(data + pos, '\n', size - pos);
+    if (!nl)
+      break;
+
+    const size_t end = (size_t)(nl - data);
+
+    if (m_lineBuf.empty()) {
+      m_parser.ApplyLine(std::string_view(data + pos, end - pos), chunk.t_ms, out);
+    } else {
+      // complete line = unfinished tail of the previous chunk + this part
+      m_lineBuf.append(data + pos, end - pos);
+      m_parser.ApplyLine(m_lineBuf, chunk.t_ms, out);
+      m_lineBuf.clear();
+    }
+
+    pos = end + 1;
+  }
+
+  m_lineBuf.append(data + pos, size - pos);
+
+  // Keep tail bounded (in case line never ends)
+  if (m_lineBuf.size() > kMaxLineBytes) {
+    m_lineBuf.erase(0, m_lineBuf.size() - kMaxLineBytes);
+  }
+}
+
+void ArduinoPlotStage::Publish(PlotSampleBatch &local, uint64_t generation) {
+  if (local.empty()) {
+    return;
+  }
+
+  bool notify = false;
+  {
+    std::lock_guard<std::mutex> lk(m_outMutex);
+    if (generation != m_generation.load()) {
+      return; // Reset() in the meantime
+    }
+
+    if (m_out.empty()) {
+      std::swap(m_out, local);
+    } else {
+      if (m_out.newSeries.empty()) {
+        m_out.firstNewSeries = local.firstNewSeries;
+      }
+      m_out.newSeries.insert(m_out.newSeries.end(),
+                             std::make_move_iterator(local.newSeries.begin()),
+                             std::make_move_iterator(local.newSeries.end()));
+      m_out.samples.insert(m_out.samples.end(), local.samples.begin(), local.samples.end());
+    }
+
+    // Nobody takes the samples (paused GUI) -> drop the oldest ones in bulk.
+    const size_t maxPending = m_maxPendingSamples.load();
+    if (m_out.samples.size() > maxPending + maxPending / 4) {
+      m_out.samples.erase(m_out.samples.begin(),
+                          m_out.samples.begin() + (ptrdiff_t)(m_out.samples.size() - maxPending));
+    }
+
+    if (!m_notified) {
+      m_notified = true;
+      notify = true;
+    }
+  }
+
+  if (notify && m_onReady) {
+    m_onReady();
+  }
 }
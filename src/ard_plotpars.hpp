@@ -18,42 +18,54 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-struct BufferedPlotLine {
-  std::string line;
-  double time;
+struct PlotSample {
+  uint32_t series; // series id assigned by ArduinoPlotParser
+  double t_ms;
+  double value;
 };
 
-class ArduinoPlotSink {
-public:
-  virtual ~ArduinoPlotSink() = default;
-
-  // Called for each sample. If refresh=false, the sink should batch and repaint on Refresh().
-  virtual void AddSampleAt(const std::string &name, double value, double t_ms, bool refresh) = 0;
-
-  // Called after a batch (or when the parser wants the sink to repaint).
-  // Semantics match wxWindow::Refresh(eraseBackground).
-  virtual void Refresh(bool eraseBackground) = 0;
+// Output of the parser. Series ids are assigned in order of appearance, so
+// newSeries holds names of ids firstNewSeries, firstNewSeries + 1, ...
+struct PlotSampleBatch {
+  size_t firstNewSeries = 0;
+  std::vector<std::string> newSeries;
+  std::vector<PlotSample> samples;
+
+  bool empty() const { return newSeries.empty() && samples.empty(); }
+  void clear() {
+    firstNewSeries = 0;
+    newSeries.clear();
+    samples.clear();
+  }
 };
 
 class ArduinoPlotParser {
 public:
-  explicit ArduinoPlotParser(ArduinoPlotSink *sink = nullptr);
-
-  void SetSink(ArduinoPlotSink *sink) { m_sink = sink; }
-  ArduinoPlotSink *GetSink() const { return m_sink; }
+  ArduinoPlotParser();
 
   // Feed one serial line (UTF-8 expected). Stateful autodetection.
-  void ApplyLine(const std::string &line, double time);
-  void ApplyBatch(const std::vector<BufferedPlotLine> &lines);
+  // Parsed samples are appended to out.
+  void ApplyLine(std::string_view line, double time, PlotSampleBatch &out);
 
+  // Forgets the detected format and all series ids.
   void Reset();
 
+  size_t GetSeriesCount() const { return m_seriesIds.size(); }
+
   // Optional knobs (defaults are sane)
   void SetAcceptDecimalComma(bool enabled) { m_acceptDecimalCommaUser = enabled; }
   void SetMaxProbeLines(size_t n) { m_maxProbeLines = (n < 1 ? 1 : n); }
@@ -70,47 +82,46 @@ private:
     std::string raw;
   };
 
+  using NamedValue = std::pair<std::string_view, double>;
+
   // Main decision helpers
-  void ProcessLine_Unknown(const std::string &line);
-  void ProcessLine_Tagged(const std::string &line);
-  void ProcessLine_Columns(const std::string &line);
+  void ProcessLine_Unknown(std::string_view line, PlotSampleBatch &out);
+  void ProcessLine_Tagged(std::string_view line, PlotSampleBatch &out);
+  void ProcessLine_Columns(std::string_view line, PlotSampleBatch &out);
 
   void DecideModeFromProbe();
-  void FlushProbeAsCurrentMode();
+  void FlushProbeAsCurrentMode(PlotSampleBatch &out);
 
-  // Parsing primitives
-  static bool IsLikelyHeaderLine(const std::string &line, std::vector<std::string> &outNames);
-  static bool LooksLikeIdentifier(const std::string &tok);
-  static bool HasAnyDigit(const std::string &s);
-  static bool HasLetter(const std::string &s);
+  // Parsing primitives (tokens are views into the parsed line)
+  static bool IsLikelyHeaderLine(std::string_view line, std::vector<std::string_view> &outNames);
+  static bool LooksLikeIdentifier(std::string_view tok);
+  static bool HasAnyDigit(std::string_view s);
+  static bool HasLetter(std::string_view s);
 
-  static std::vector<std::string> SplitTokensLoose(const std::string &line);
-  static std::vector<std::string> SplitTokensByDelims(const std::string &line, const char *delims);
+  static void SplitTokensLoose(std::string_view line, std::vector<std::string_view> &out);
+  static void SplitTokensByDelims(std::string_view line, const char *delims, std::vector<std::string_view> &out);
 
-  static bool ParseNumberPrefix(const std::string &tok, bool acceptCommaDecimal, double &out);
-  static bool HeuristicAcceptCommaDecimal(const std::string &line);
+  static bool ParseNumberPrefix(std::string_view tok, bool acceptCommaDecimal, double &out);
+  static bool HeuristicAcceptCommaDecimal(std::string_view line);
 
-  static size_t ParseTaggedPairs(const std::string &line,
-                                 bool acceptCommaDecimal,
-                                 std::vector<std::pair<std::string, double>> &out);
-  static size_t ParseImplicitPairs(const std::vector<std::string> &toks,
+  size_t ParseTaggedPairs(std::string_view line, bool acceptCommaDecimal, std::vector<NamedValue> &out);
+  static size_t ParseImplicitPairs(const std::vector<std::string_view> &toks,
                                    bool acceptCommaDecimal,
-                                   std::vector<std::pair<std::string, double>> &out);
-  static size_t ParseColumns(const std::string &line,
-                             bool acceptCommaDecimal,
-                             std::vector<double> &outValues,
-                             char &outDelimiterHint);
+                                   std::vector<NamedValue> &out);
+  size_t ParseColumns(std::string_view line,
+                      bool acceptCommaDecimal,
+                      std::vector<double> &outValues,
+                      char &outDelimiterHint);
 
   // Output
-  void EmitSample(const std::string &name, double value);
-  void EmitColumns(const std::vector<double> &values);
+  uint32_t SeriesId(std::string_view name, PlotSampleBatch &out);
+  void EmitSample(std::string_view name, double value, PlotSampleBatch &out);
+  void EmitColumns(const std::vector<double> &values, PlotSampleBatch &out);
 
 private:
-  ArduinoPlotSink *m_sink = nullptr;
-
   Mode m_mode = Mode::Unknown;
 
-  double m_time;
+  double m_time = 0.0;
 
   // Probe/buffering while in Unknown (so we can start plotting only after confidence)
   std::deque<ProbeLine> m_probe;
@@ -118,9 +129,20 @@ private:
 
   // Columns-mode names (from header or autogenerated v0..)
   std::vector<std::string> m_columnNames;
+  std::vector<uint32_t> m_columnIds;             // resolved m_columnNames, empty = not yet
   std::vector<std::string> m_pendingHeaderNames; // detected header before mode lock
   int m_lastColumnCount = 0;
 
+  // Series name -> id
+  std::unordered_map<std::string, uint32_t> m_seriesIds;
+  std::string m_nameKey; // lookup scratch
+
+  // Scratch buffers reused between lines (no per-line allocations once warmed up)
+  std::vector<std::string_view> m_toks;
+  std::vector<std::string_view> m_header;
+  std::vector<NamedValue> m_pairs;
+  std::vector<double> m_values;
+
   // Settings
   bool m_acceptDecimalCommaUser = false; // explicit user preference (off by default)
   bool m_strictStart = true;             // start plotting only after mode decided
@@ -128,3 +150,66 @@ private:
   // Minor state: last delimiter hint in columns mode
   char m_columnsDelimHint = '\0';
 };
+
+/**
+ * Streaming plot parse stage.
+ *
+ * Normalized serial text is fed from the GUI thread; a dedicated thread
+ * splits it into lines, runs ArduinoPlotParser and accumulates samples.
+ * onReady is called (from the stage thread) when samples become available
+ * and not again until the GUI picks them up with Take(). While nobody takes
+ * them (e.g. the monitor is paused) the oldest samples are dropped above
+ * the pending limit.
+ */
+class ArduinoPlotStage {
+public:
+  explicit ArduinoPlotStage(std::function<void()> onReady);
+  ~ArduinoPlotStage();
+
+  ArduinoPlotStage(const ArduinoPlotStage &) = delete;
+  ArduinoPlotStage &operator=(const ArduinoPlotStage &) = delete;
+
+  // Any split of the text is fine, lines may continue in the next chunk.
+  void Feed(const std::string &chunkUtf8, double t_ms);
+
+  // Drops pending text and samples and resets the parser (series ids start from 0).
+  void Reset();
+
+  // Moves accumulated output to out; false when there was nothing.
+  bool Take(PlotSampleBatch &out);
+
+  void SetMaxPendingSamples(size_t n) { m_maxPendingSamples = (n < 1 ? 1 : n); }
+
+private:
+  struct Chunk {
+    std::string text;
+    double t_ms;
+  };
+
+  void ThreadLoop();
+  void ParseChunk(const Chunk &chunk, PlotSampleBatch &out);
+  void Publish(PlotSampleBatch &local, uint64_t generation);
+
+  std::function<void()> m_onReady;
+
+  // input (GUI -> stage)
+  std::mutex m_inMutex;
+  std::condition_variable m_inCv;
+  std::deque<Chunk> m_in;
+  size_t m_inBytes = 0;
+  bool m_stopping = false;
+  std::atomic<uint64_t> m_generation{0};
+
+  // stage thread only
+  ArduinoPlotParser m_parser;
+  std::string m_lineBuf; // unfinished line
+  uint64_t m_parserGeneration = 0;
+
+  // output (stage -> GUI)
+  std::mutex m_outMutex;
+  PlotSampleBatch m_out;
+  bool m_notified = false;
+  std::atomic<size_t> m_maxPendingSamples{500000};
+
+  std::thread m_thread;
+};
@@ -287,6 +287,7 @@ void ArduinoPlotView::SetHiddenSignals(const std::vector<wxString> &hiddenNames)
 void ArduinoPlotView::Clear() {
   m_series.clear();
   m_seriesOrder.clear();
+  m_batchSeries.clear();
   m_nextColorIndex = 0;
   m_clock.Start();
   RequestRefresh();
@@ -324,15 +325,14 @@ void ArduinoPlotView::TrimSeries(Series &s, double now_ms) {
 
   // Keep ONE sample before t_min as an anchor, so the line reaches the left edge
   // (otherwise the first visible point may start later e.g. at -9.5s when sampling is 2Hz).
-  while (s.samples.size() >= 2 && s.samples[1].t_ms < t_min) {
-    s.samples.pop_front();
+  const uint64_t firstInWindow = s.samples.LowerBound(t_min);
+  if (firstInWindow > s.samples.Begin() + 1) {
+    s.samples.DropFront((size_t)(firstInWindow - s.samples.Begin() - 1));
   }
 
   // Hard cap (optional)
-  if (m_maxSamplesPerSeries > 0) {
-    while (s.samples.size() > m_maxSamplesPerSeries) {
-      s.samples.pop_front();
-    }
+  if (m_maxSamplesPerSeries > 0 && s.samples.Size() > m_maxSamplesPerSeries) {
+    s.samples.DropFront(s.samples.Size() - m_maxSamplesPerSeries);
   }
 }
 
@@ -355,7 +355,7 @@ void ArduinoPlotView::AddSample(const wxString &name, double value, bool refresh
 
 void ArduinoPlotView::AddSampleAt(const wxString &name, double value, double t_ms, bool refresh) {
   Series &s = GetOrCreateSeries(name);
-  s.samples.push_back(Sample{t_ms, value});
+  s.samples.Append(t_ms, value);
 
   // Trim per-series; cheap and keeps memory bounded.
   const double now_ms = (double)m_clock.Time();
@@ -365,6 +365,37 @@ void ArduinoPlotView::AddSampleAt(const wxString &name, double value, double t_m
     RequestRefresh();
 }
 
+void ArduinoPlotView::AddSamples(const std::vector<wxString> &names, const std::vector<PlotSample> &samples, double timeOffsetMs) {
+  if (samples.empty())
+    return;
+
+  if (m_batchSeries.size() < names.size())
+    m_batchSeries.resize(names.size(), nullptr);
+
+  // Series references in m_series stay valid on rehash, only Clear() drops them.
+  std::vector<Series *> touched;
+  for (const auto &smp : samples) {
+    if (smp.series >= m_batchSeries.size())
+      continue;
+
+    Series *&s = m_batchSeries[smp.series];
+    if (!s) {
+      s = &GetOrCreateSeries(names[smp.series]);
+    }
+
+    if (std::find(touched.begin(), touched.end(), s) == touched.end())
+      touched.push_back(s);
+
+    s->samples.Append(smp.t_ms + timeOffsetMs, smp.value);
+  }
+
+  const double now_ms = (double)m_clock.Time();
+  for (Series *s : touched)
+    TrimSeries(*s, now_ms);
+
+  RequestRefresh();
+}
+
 wxRect ArduinoPlotView::ComputePlotRect(const wxRect &rcClient) const {
   // Margins for axes labels + legend breathing room.
   const int marginL = 55;
@@ -764,29 +795,19 @@ bool ArduinoPlotView::ComputeVisibleRanges(double now_ms, double &t0, double &t1
     if (!s.visible)
       continue;
 
-    const Sample *prev = nullptr;
-    bool usedPrev = false;
-
-    for (const Sample &sm : s.samples) {
-      if (sm.t_ms < t0) {
-        prev = &sm;
-        continue;
-      }
-      if (sm.t_ms > t1)
-        break;
+    uint64_t from = s.samples.LowerBound(t0);
+    const uint64_t to = s.samples.LowerBound(std::nextafter(t1, std::numeric_limits<double>::infinity()), from);
+    if (from >= to)
+      continue;
 
-      // Include one anchor point just before t0 (so autoscale matches the drawn line)
-      if (prev && !usedPrev) {
-        any = true;
-        minV = std::min(minV, prev->value);
-        maxV = std::max(maxV, prev->value);
-        usedPrev = true;
-      }
+    // Include one anchor point just before t0 (so autoscale matches the drawn line)
+    if (from > s.samples.Begin())
+      from--;
 
-      any = true;
-      minV = std::min(minV, sm.value);
-      maxV = std::max(maxV, sm.value);
-    }
+    const ArduinoPlotSeriesBuffer::MinMax mm = s.samples.GetMinMax(from, to);
+    any = true;
+    minV = std::min(minV, mm.min);
+    maxV = std::max(maxV, mm.max);
   }
 
   if (!any)
@@ -871,7 +892,8 @@ void ArduinoPlotView::DrawAxesAndGrid(wxGraphicsContext &gc, const wxRect &rcPlo
 
 void ArduinoPlotView::DrawSeries(wxGraphicsContext &gc, const wxRect &rcPlot,
                                  const Series &s, double t0, double t1, double y0, double y1) {
-  if (s.samples.size() < 2)
+  const ArduinoPlotSeriesBuffer &buf = s.samples;
+  if (buf.Size() < 2 || rcPlot.width <= 0)
     return;
 
   auto xOf = [&](double t_ms) -> double {
@@ -883,32 +905,56 @@ void ArduinoPlotView::DrawSeries(wxGraphicsContext &gc, const wxRect &rcPlot,
     return rcPlot.y + (1.0 - a) * rcPlot.height;
   };
 
-  // Find first sample >= t0
-  size_t idx = 0;
-  while (idx < s.samples.size() && s.samples[idx].t_ms < t0)
-    idx++;
+  // First sample >= t0
+  const uint64_t idx = buf.LowerBound(t0);
 
-  std::vector<wxPoint2DDouble> pts;
-  pts.reserve(s.samples.size() + 2);
+  std::vector<wxPoint2DDouble> &pts = m_drawPoints;
+  pts.clear();
 
   // Add interpolated point at t0 (if we have a sample before and after)
-  if (idx > 0 && idx < s.samples.size()) {
-    const Sample &a = s.samples[idx - 1];
-    const Sample &b = s.samples[idx];
-    if (a.t_ms < t0 && b.t_ms > a.t_ms) {
-      double alpha = (t0 - a.t_ms) / (b.t_ms - a.t_ms);
+  if (idx > buf.Begin() && idx < buf.End()) {
+    const double ta = buf.TimeAt(idx - 1);
+    const double tb = buf.TimeAt(idx);
+    if (ta < t0 && tb > ta) {
+      double alpha = (t0 - ta) / (tb - ta);
       alpha = std::clamp(alpha, 0.0, 1.0);
-      double v = a.value + alpha * (b.value - a.value);
+      const double va = buf.ValueAt(idx - 1);
+      double v = va + alpha * (buf.ValueAt(idx) - va);
       pts.emplace_back(xOf(t0), yOf(v));
     }
   }
 
-  // Add points inside [t0, t1]
-  for (size_t i = idx; i < s.samples.size(); i++) {
-    const Sample &sm = s.samples[i];
-    if (sm.t_ms > t1)
-      break;
-    pts.emplace_back(xOf(sm.t_ms), yOf(sm.value));
+  // Points inside [t0, t1], one pixel column at a time. A column with a few
+  // samples is drawn as is, a denser one only by its min and max, so the cost
+  // depends on the plot width instead of the number of samples.
+  const int columns = rcPlot.width;
+  const double colMs = (t1 - t0) / columns;
+  const size_t kMaxRawPerColumn = 4;
+
+  uint64_t i = idx;
+  for (int c = 0; c < columns && i < buf.End(); c++) {
+    const double colEnd = (c + 1 < columns) ? t0 + (c + 1) * colMs : std::nextafter(t1, std::numeric_limits<double>::infinity());
+
+    const uint64_t end = buf.LowerBound(colEnd, i);
+    if (end == i)
+      continue;
+
+    if (end - i <= kMaxRawPerColumn) {
+      for (uint64_t k = i; k < end; k++)
+        pts.emplace_back(xOf(buf.TimeAt(k)), yOf(buf.ValueAt(k)));
+    } else {
+      const ArduinoPlotSeriesBuffer::MinMax mm = buf.GetMinMax(i, end);
+      const double x = rcPlot.x + c + 0.5;
+      const double yMin = yOf(mm.min);
+      const double yMax = yOf(mm.max);
+
+      // start with the extreme closer to the previous point -> no extra zig-zag
+      const bool minFirst = pts.empty() || std::abs(pts.back().m_y - yMin) <= std::abs(pts.back().m_y - yMax);
+      pts.emplace_back(x, minFirst ? yMin : yMax);
+      pts.emplace_back(x, minFirst ? yMax : yMin);
+    }
+
+    i = end;
   }
 
   if (pts.size() < 2)
@@ -23,7 +23,9 @@
 #include <wx/spinctrl.h>
 #include <wx/wx.h>
 
-#include <deque>
+#include "ard_plotbuf.hpp"
+#include "ard_plotpars.hpp"
+
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -31,11 +33,6 @@
 
 class ArduinoPlotView : public wxPanel {
 public:
-  struct Sample {
-    double t_ms;  // time in milliseconds since view start
-    double value; // numeric value
-  };
-
   explicit ArduinoPlotView(wxWindow *parent,
                            wxWindowID id = wxID_ANY,
                            const wxPoint &pos = wxDefaultPosition,
@@ -49,6 +46,10 @@ public:
   // Add sample with explicit timestamp (ms since view start)
   void AddSampleAt(const wxString &name, double value, double t_ms, bool refresh = true);
 
+  // Add samples produced by ArduinoPlotStage. names[series id] is the series
+  // name, sample times are shifted by timeOffsetMs into the view time base.
+  void AddSamples(const std::vector<wxString> &names, const std::vector<PlotSample> &samples, double timeOffsetMs);
+
   double GetCurrentTime() const { return (double)m_clock.Time(); }
 
   void Clear();
@@ -78,7 +79,7 @@ private:
   struct Series {
     wxString name;
     wxColour color;
-    std::deque<Sample> samples;
+    ArduinoPlotSeriesBuffer samples; // t_ms since view start + value
     bool visible = true;
   };
 
@@ -134,6 +135,7 @@ private:
 private:
   std::unordered_map<std::string, Series> m_series;
   std::vector<std::string> m_seriesOrder; // stable legend + draw ordering
+  std::vector<Series *> m_batchSeries;     // plot stage series id -> series (filled lazily)
 
   std::vector<wxColour> m_palette;
   size_t m_nextColorIndex = 0;
@@ -152,6 +154,9 @@ private:
   wxStaticText *m_spinSuffix = nullptr;
   bool m_updatingControls = false;
 
+  // Rendering scratch buffer, reused by DrawSeries
+  std::vector<wxPoint2DDouble> m_drawPoints;
+
   // Legend interactivity
   std::vector<LegendHit> m_legendHits;
 
@@ -424,7 +424,7 @@ ArduinoPatchStraightener::ArduinoPatchStraightener(const std::string &sketchPath
   // Build file cache from buffers
   for (const auto &b : buffers) {
     FileLines fl;
-    fl.text = wxString::FromUTF8(b.code.c_str());
+    fl.text = wxString::FromUTF8(b.Code().c_str());
     fl.text = NormalizeNewlinesToLF(fl.text);
     SplitLinesLF(fl.text, fl.rawLines);
 
@@ -0,0 +1,174 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_sched.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+ArduinoTaskScheduler &ArduinoTaskScheduler::Get() {
+  // never destroyed, see the class comment
+  static ArduinoTaskScheduler *scheduler = new ArduinoTaskScheduler();
+  return *scheduler;
+}
+
+ArduinoTaskScheduler::ArduinoTaskScheduler() {
+  unsigned hw = std::thread::hardware_concurrency();
+  if (hw == 0) {
+    hw = 2;
+  }
+
+  // project parsing has its own pool, these are for the single-shot jobs
+  m_cpuWorkers = std::clamp(hw / 2, 2u, 4u);
+
+  m_threads.reserve(m_cpuWorkers + kIoWorkers);
+  for (unsigned i = 0; i < m_cpuWorkers; ++i) {
+    m_threads.emplace_back([this]() { CpuWorkerLoop(); });
+  }
+  for (unsigned i = 0; i < kIoWorkers; ++i) {
+    m_threads.emplace_back([this]() { IoWorkerLoop(); });
+  }
+
+  APP_DEBUG_LOG("SCHED: %u cpu workers, %u io workers", m_cpuWorkers, kIoWorkers);
+}
+
+std::string ArduinoTaskScheduler::Key(const char *what, const void *owner) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), ":%p", owner);
+  return std::string(what) + buf;
+}
+
+std::shared_ptr<ArduinoTaskToken> ArduinoTaskScheduler::Submit(TaskLane lane, Job job, const std::string &coalesceKey) {
+  auto token = std::make_shared<ArduinoTaskToken>();
+  if (!job) {
+    token->Cancel();
+    return token;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+
+    if (!coalesceKey.empty()) {
+      auto it = m_latest.find(coalesceKey);
+      if (it != m_latest.end()) {
+        std::shared_ptr<ArduinoTaskToken> previous = it->second;
+        previous->Cancel();
+
+        for (auto &queue : m_queues) {
+          auto qit = std::find_if(queue.begin(), queue.end(), [&](const Task &t) { return t.token == previous; });
+          if (qit != queue.end()) {
+            queue.erase(qit);
+            break;
+          }
+        }
+      }
+      m_latest[coalesceKey] = token;
+    }
+
+    m_queues[(int)lane].push_back(Task{std::move(job), token, coalesceKey});
+  }
+
+  if (lane == TaskLane::Io) {
+    m_ioCv.notify_one();
+  } else {
+    m_cpuCv.notify_one();
+  }
+  return token;
+}
+
+std::shared_ptr<ArduinoTaskToken> ArduinoTaskScheduler::Submit(TaskLane lane, std::function<void()> job, const std::string &coalesceKey) {
+  if (!job) {
+    return Submit(lane, Job(), coalesceKey);
+  }
+  return Submit(lane, Job([job = std::move(job)](const ArduinoTaskToken &) { job(); }), coalesceKey);
+}
+
+void ArduinoTaskScheduler::Run(Task &task) {
+  if (!task.token->IsCancelled()) {
+    try {
+      task.job(*task.token);
+    } catch (const std::exception &e) {
+      APP_DEBUG_LOG("SCHED: job failed: %s", e.what());
+    } catch (...) {
+      APP_DEBUG_LOG("SCHED: job failed");
+    }
+  }
+
+  // release captured state outside of the lock
+  task.job = nullptr;
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (!task.key.empty()) {
+    auto it = m_latest.find(task.key);
+    if (it != m_latest.end() && it->second == task.token) {
+      m_latest.erase(it);
+    }
+  }
+}
+
+void ArduinoTaskScheduler::CpuWorkerLoop() {
+  auto &interactive = m_queues[(int)TaskLane::Interactive];
+  auto &background = m_queues[(int)TaskLane::Background];
+
+  // one worker always stays free for interactive jobs
+  const unsigned backgroundLimit = m_cpuWorkers - 1;
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  for (;;) {
+    m_cpuCv.wait(lk, [&]() {
+      return !interactive.empty() || (!background.empty() && m_backgroundRunning < backgroundLimit);
+    });
+
+    const bool isBackground = interactive.empty();
+    auto &queue = isBackground ? background : interactive;
+
+    Task task = std::move(queue.front());
+    queue.pop_front();
+    if (isBackground) {
+      ++m_backgroundRunning;
+    }
+
+    lk.unlock();
+    Run(task);
+    lk.lock();
+
+    if (isBackground) {
+      --m_backgroundRunning;
+      if (!background.empty()) {
+        m_cpuCv.notify_one();
+      }
+    }
+  }
+}
+
+void ArduinoTaskScheduler::IoWorkerLoop() {
+  auto &io = m_queues[(int)TaskLane::Io];
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  for (;;) {
+    m_ioCv.wait(lk, [&]() { return !io.empty(); });
+
+    Task task = std::move(io.front());
+    io.pop_front();
+
+    lk.unlock();
+    Run(task);
+    lk.lock();
+  }
+}
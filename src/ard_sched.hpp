@@ -0,0 +1,104 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class TaskLane {
+  Interactive = 0, // short CPU jobs the user waits for (completion, hover, ...)
+  Background = 1,  // CPU jobs which can wait (diagnostics, project parse, ...)
+  Io = 2           // blocking jobs (arduino-cli processes, network)
+};
+
+class ArduinoTaskToken {
+public:
+  bool IsCancelled() const { return m_cancelled.load(std::memory_order_relaxed); }
+  void Cancel() { m_cancelled.store(true, std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> m_cancelled{false};
+};
+
+/**
+ * Application-wide scheduler for asynchronous work.
+ *
+ * CPU jobs run on a small set of workers shared by the interactive and the
+ * background lane. Interactive jobs are always taken first and background jobs
+ * never occupy the last worker, so a long diagnostics parse cannot delay a
+ * completion request. Blocking jobs have their own bounded IO lane.
+ *
+ * Jobs submitted with the same coalesce key supersede each other: the token of
+ * the previous job is cancelled and, if it did not start yet, the job is dropped.
+ * Running jobs may poll the token to stop early.
+ *
+ * The scheduler lives until the process exits (jobs may still be blocked in
+ * arduino-cli at that time), its workers are never joined.
+ */
+class ArduinoTaskScheduler {
+public:
+  using Job = std::function<void(const ArduinoTaskToken &)>;
+
+  static ArduinoTaskScheduler &Get();
+
+  ArduinoTaskScheduler(const ArduinoTaskScheduler &) = delete;
+  ArduinoTaskScheduler &operator=(const ArduinoTaskScheduler &) = delete;
+
+  std::shared_ptr<ArduinoTaskToken> Submit(TaskLane lane, Job job, const std::string &coalesceKey = {});
+  std::shared_ptr<ArduinoTaskToken> Submit(TaskLane lane, std::function<void()> job, const std::string &coalesceKey = {});
+
+  unsigned GetCpuWorkerCount() const { return m_cpuWorkers; }
+
+  // Coalesce key for requests of one kind from one owner, e.g. Key("cli.cores", handler).
+  static std::string Key(const char *what, const void *owner);
+
+private:
+  static constexpr unsigned kIoWorkers = 6;
+
+  struct Task {
+    Job job;
+    std::shared_ptr<ArduinoTaskToken> token;
+    std::string key;
+  };
+
+  ArduinoTaskScheduler();
+
+  std::mutex m_mutex;
+  std::condition_variable m_cpuCv;
+  std::condition_variable m_ioCv;
+  std::deque<Task> m_queues[3]; // indexed by TaskLane
+  std::unordered_map<std::string, std::shared_ptr<ArduinoTaskToken>> m_latest; // coalesce key -> newest job
+
+  unsigned m_cpuWorkers = 0;
+  unsigned m_backgroundRunning = 0;
+
+  std::vector<std::thread> m_threads;
+
+  void CpuWorkerLoop();
+  void IoWorkerLoop();
+  void Run(Task &task);
+};
@@ -0,0 +1,838 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_serlog.hpp"
+#include "ard_ev.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <wx/clipbrd.h>
+#include <wx/dcbuffer.h>
+
+namespace {
+constexpr size_t kTabWidth = 8;
+constexpr int kMarginX = 2;
+
+inline bool IsUtf8Lead(char c) {
+  return ((unsigned char)c & 0xC0) != 0x80;
+}
+
+// Byte offset after advancing 'cols' code points from the start of d.
+size_t Utf8Advance(const char *d, size_t len, size_t cols) {
+  size_t off = 0;
+  while (off < len && cols > 0) {
+    ++off;
+    while (off < len && !IsUtf8Lead(d[off])) {
+      ++off;
+    }
+    --cols;
+  }
+  return off;
+}
+
+size_t Utf8Count(const char *d, size_t len) {
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (IsUtf8Lead(d[i])) {
+      ++n;
+    }
+  }
+  return n;
+}
+
+inline char AsciiLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// First match of needle starting in [lo, hi], npos if none.
+size_t FindInLine(const char *d, size_t len, const std::string &needle, size_t lo, size_t hi) {
+  if (needle.size() > len || lo > len - needle.size()) {
+    return std::string::npos;
+  }
+  hi = std::min(hi, len - needle.size());
+
+  auto eq = [](char a, char b) { return AsciiLower(a) == AsciiLower(b); };
+  const char *end = d + hi + needle.size();
+  const char *it = std::search(d + lo, end, needle.begin(), needle.end(), eq);
+  return (it == end) ? std::string::npos : (size_t)(it - d);
+}
+
+// Last match of needle starting in [lo, hi], npos if none.
+size_t FindLastInLine(const char *d, size_t len, const std::string &needle, size_t lo, size_t hi) {
+  size_t last = std::string::npos;
+  for (size_t p = FindInLine(d, len, needle, lo, hi); p != std::string::npos; p = FindInLine(d, len, needle, p + 1, hi)) {
+    last = p;
+  }
+  return last;
+}
+
+// Expands tabs and masks control characters. map[i] = display column of text[i],
+// map[text.length()] = display width.
+wxString ExpandLine(const wxString &text, std::vector<size_t> &map) {
+  wxString disp;
+  disp.reserve(text.length());
+  map.resize(text.length() + 1);
+
+  size_t i = 0;
+  for (wxString::const_iterator it = text.begin(); it != text.end(); ++it, ++i) {
+    map[i] = disp.length();
+    wxUniChar ch = *it;
+    if (ch == '\t') {
+      size_t w = kTabWidth - (disp.length() % kTabWidth);
+      disp.append(w, wxUniChar(' '));
+    } else if (ch.GetValue() < 0x20) {
+      disp += wxUniChar(0x00B7);
+    } else {
+      disp += ch;
+    }
+  }
+  map[i] = disp.length();
+  return disp;
+}
+
+} // namespace
+
+ArduinoSerialLogView::ArduinoSerialLogView(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size, long style)
+    : wxWindow(parent, id, pos, size, style | wxVSCROLL | wxHSCROLL | wxWANTS_CHARS | wxFULL_REPAINT_ON_RESIZE) {
+  SetBackgroundStyle(wxBG_STYLE_PAINT);
+  SetCursor(wxCursor(wxCURSOR_IBEAM));
+
+  m_textColour = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT);
+  m_bgColour = wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW);
+  m_selColour = wxSystemSettings::GetColour(wxSYS_COLOUR_HIGHLIGHT);
+  m_highlightColour = wxColour(255, 230, 120);
+
+  ResetStorage();
+  UpdateMetrics();
+
+  Bind(wxEVT_PAINT, &ArduinoSerialLogView::OnPaint, this);
+  Bind(wxEVT_SIZE, &ArduinoSerialLogView::OnSize, this);
+  Bind(wxEVT_SCROLLWIN_TOP, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_BOTTOM, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_LINEUP, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_LINEDOWN, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_PAGEUP, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_PAGEDOWN, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_THUMBTRACK, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_SCROLLWIN_THUMBRELEASE, &ArduinoSerialLogView::OnScrollWin, this);
+  Bind(wxEVT_MOUSEWHEEL, &ArduinoSerialLogView::OnMouseWheel, this);
+  Bind(wxEVT_LEFT_DOWN, &ArduinoSerialLogView::OnLeftDown, this);
+  Bind(wxEVT_LEFT_UP, &ArduinoSerialLogView::OnLeftUp, this);
+  Bind(wxEVT_LEFT_DCLICK, &ArduinoSerialLogView::OnLeftDClick, this);
+  Bind(wxEVT_MOTION, &ArduinoSerialLogView::OnMotion, this);
+  Bind(wxEVT_MOUSE_CAPTURE_LOST, &ArduinoSerialLogView::OnCaptureLost, this);
+  Bind(wxEVT_KEY_DOWN, &ArduinoSerialLogView::OnKeyDown, this);
+}
+
+void ArduinoSerialLogView::SetColours(const wxColour &text, const wxColour &background, const wxColour &selection, const wxColour &highlight) {
+  m_textColour = text;
+  m_bgColour = background;
+  m_selColour = selection;
+  m_highlightColour = highlight;
+  SetBackgroundColour(background);
+  Refresh();
+}
+
+bool ArduinoSerialLogView::SetFont(const wxFont &font) {
+  if (!wxWindow::SetFont(font)) {
+    return false;
+  }
+  UpdateMetrics();
+  UpdateScrollbars();
+  Refresh();
+  return true;
+}
+
+void ArduinoSerialLogView::SetLimits(size_t maxLines, size_t maxBytes) {
+  m_maxLines = maxLines;
+  m_maxBytes = maxBytes;
+  if (Trim()) {
+    Refresh();
+  }
+  UpdateScrollbars();
+}
+
+// ---------------------------------------------------------------------------
+// Storage
+// ---------------------------------------------------------------------------
+
+void ArduinoSerialLogView::ResetStorage() {
+  m_chunks.clear();
+  m_chunks.emplace_back();
+  m_chunks.back().starts.push_back(0); // the open (last) line
+  m_firstLine = 0;
+  m_totalBytes = 0;
+  m_openCols = 0;
+  m_maxCols = 0;
+}
+
+size_t ArduinoSerialLogView::GetLineCount() const {
+  if (m_chunks.empty()) {
+    return 0;
+  }
+  return (m_chunks.size() - 1) * kLinesPerChunk + m_chunks.back().starts.size();
+}
+
+bool ArduinoSerialLogView::GetLineUtf8(uint64_t line, const char *&data, size_t &len) const {
+  if (line < m_firstLine || line > LastLine()) {
+    return false;
+  }
+
+  const uint64_t idx = line - m_firstLine;
+  const Chunk &c = m_chunks[(size_t)(idx / kLinesPerChunk)];
+  const size_t li = (size_t)(idx % kLinesPerChunk);
+
+  const size_t start = c.starts[li];
+  const size_t end = (li + 1 < c.starts.size()) ? c.starts[li + 1] : c.text.size();
+  data = c.text.data() + start;
+  len = end - start;
+  return true;
+}
+
+wxString ArduinoSerialLogView::GetLineText(uint64_t line) const {
+  const char *d = nullptr;
+  size_t len = 0;
+  if (!GetLineUtf8(line, d, len) || len == 0) {
+    return wxString();
+  }
+  return wxString::FromUTF8(d, len);
+}
+
+void ArduinoSerialLogView::AppendText(const wxString &text) {
+  if (text.empty()) {
+    return;
+  }
+
+  const wxScopedCharBuffer buf = text.ToUTF8();
+  AppendUtf8(buf.data(), buf.length());
+}
+
+void ArduinoSerialLogView::AppendUtf8(const char *data, size_t len) {
+  if (!data || len == 0) {
+    return;
+  }
+
+  const uint64_t lastBefore = LastLine();
+
+  const char *p = data;
+  const char *end = p + len;
+
+  while (p < end) {
+    const char *nl = (const char *)memchr(p, '\n', (size_t)(end - p));
+    const char *segEnd = nl ? nl : end;
+
+    // A device streaming without '\n' would grow the open line (and its chunk)
+    // forever and the byte limit could never drop it -> force a break.
+    bool forcedBreak = false;
+    {
+      const Chunk &c = m_chunks.back();
+      const size_t room = kMaxLineBytes - std::min(kMaxLineBytes, c.text.size() - c.starts.back());
+      if ((size_t)(segEnd - p) > room) {
+        segEnd = p + room;
+        for (int i = 0; i < 3 && segEnd > p && !IsUtf8Lead(*segEnd); ++i) {
+          --segEnd; // never split a UTF-8 sequence
+        }
+        forcedBreak = true;
+      }
+    }
+
+    if (segEnd > p) {
+      Chunk &c = m_chunks.back();
+      c.text.append(p, (size_t)(segEnd - p));
+      m_totalBytes += (size_t)(segEnd - p);
+
+      for (const char *q = p; q < segEnd; ++q) {
+        if (*q == '\t') {
+          m_openCols = (m_openCols / kTabWidth + 1) * kTabWidth;
+        } else if (IsUtf8Lead(*q)) {
+          ++m_openCols;
+        }
+      }
+      m_maxCols = std::max(m_maxCols, m_openCols);
+    }
+
+    if (!nl && !forcedBreak) {
+      break;
+    }
+
+    // start a new line
+    if (m_chunks.back().starts.size() >= kLinesPerChunk) {
+      m_chunks.emplace_back();
+    }
+    Chunk &c = m_chunks.back();
+    c.starts.push_back((uint32_t)c.text.size());
+    m_openCols = 0;
+
+    p = forcedBreak ? segEnd : nl + 1;
+  }
+
+  const bool topMoved = Trim();
+  UpdateScrollbars();
+
+  // Rows above the previous last line did not change - no repaint needed
+  // when the user looks at older output.
+  if (topMoved || lastBefore < m_topLine + (uint64_t)RowsOnScreen() + 1) {
+    Refresh();
+  }
+}
+
+bool ArduinoSerialLogView::Trim() {
+  bool topMoved = false;
+
+  while (m_chunks.size() > 1 &&
+         ((m_maxLines > 0 && GetLineCount() > m_maxLines) ||
+          (m_maxBytes > 0 && m_totalBytes > m_maxBytes))) {
+    m_totalBytes -= m_chunks.front().text.size();
+    m_chunks.pop_front();
+    m_firstLine += kLinesPerChunk;
+  }
+
+  if (m_topLine < m_firstLine) {
+    m_topLine = m_firstLine;
+    topMoved = true;
+  }
+  m_anchor = ClampPos(m_anchor);
+  m_caret = ClampPos(m_caret);
+
+  return topMoved;
+}
+
+void ArduinoSerialLogView::Clear() {
+  ResetStorage();
+  m_topLine = 0;
+  m_xOffset = 0;
+  m_anchor = Pos();
+  m_caret = Pos();
+  m_selecting = false;
+  UpdateScrollbars();
+  Refresh();
+}
+
+ArduinoSerialLogView::Pos ArduinoSerialLogView::ClampPos(const Pos &p) const {
+  if (p.line < m_firstLine) {
+    return Pos{m_firstLine, 0};
+  }
+  if (p.line > LastLine()) {
+    return Pos{LastLine(), 0};
+  }
+  return p;
+}
+
+void ArduinoSerialLogView::AppendRangeUtf8(const Pos &from, const Pos &to, std::string &out) const {
+  for (uint64_t line = from.line; line <= to.line; ++line) {
+    const char *d = nullptr;
+    size_t len = 0;
+    if (!GetLineUtf8(line, d, len)) {
+      continue;
+    }
+
+    const size_t b0 = (line == from.line) ? Utf8Advance(d, len, from.col) : 0;
+    const size_t b1 = (line == to.line) ? Utf8Advance(d, len, to.col) : len;
+    if (b1 > b0) {
+      out.append(d + b0, b1 - b0);
+    }
+    if (line < to.line) {
+      out += '\n';
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Selection / clipboard
+// ---------------------------------------------------------------------------
+
+void ArduinoSerialLogView::SelectAll() {
+  m_anchor = Pos{m_firstLine, 0};
+  m_caret = Pos{LastLine(), (size_t)-1};
+  Refresh();
+}
+
+std::string ArduinoSerialLogView::GetSelectedTextUtf8() const {
+  std::string out;
+  if (!HasSelection()) {
+    return out;
+  }
+  const Pos a = std::min(m_anchor, m_caret);
+  const Pos b = std::max(m_anchor, m_caret);
+  AppendRangeUtf8(a, b, out);
+  return out;
+}
+
+wxString ArduinoSerialLogView::GetSelectedText() const {
+  const std::string s = GetSelectedTextUtf8();
+  return wxString::FromUTF8(s.data(), s.size());
+}
+
+std::string ArduinoSerialLogView::GetTextUtf8() const {
+  std::string out;
+  out.reserve(m_totalBytes + GetLineCount());
+  AppendRangeUtf8(Pos{m_firstLine, 0}, Pos{LastLine(), (size_t)-1}, out);
+  return out;
+}
+
+void ArduinoSerialLogView::Copy() {
+  if (!HasSelection()) {
+    return;
+  }
+
+  if (wxTheClipboard->Open()) {
+    wxTheClipboard->SetData(new wxTextDataObject(GetSelectedText()));
+    wxTheClipboard->Close();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Search
+// ---------------------------------------------------------------------------
+
+bool ArduinoSerialLogView::FindText(const wxString &text, bool forward, bool incremental) {
+  if (text.empty()) {
+    return false;
+  }
+
+  // Matching is done directly on the stored UTF-8, ASCII letters case-insensitive.
+  const wxScopedCharBuffer nbuf = text.ToUTF8();
+  const std::string needle(nbuf.data(), nbuf.length());
+
+  const Pos selStart = std::min(m_anchor, m_caret);
+  const Pos selEnd = std::max(m_anchor, m_caret);
+
+  const Pos from = ClampPos((forward && !incremental) ? selEnd : selStart);
+
+  const char *d = nullptr;
+  size_t len = 0;
+  GetLineUtf8(from.line, d, len);
+  const size_t fromByte = Utf8Advance(d, len, from.col);
+
+  const uint64_t count = GetLineCount();
+  const uint64_t startIdx = from.line - m_firstLine;
+
+  // n == 0 -> rest of the start line, n == count -> wrapped around to the start line again
+  for (uint64_t n = 0; n <= count; ++n) {
+    const uint64_t idx = forward ? (startIdx + n) % count : (startIdx + count - (n % count)) % count;
+    const uint64_t line = m_firstLine + idx;
+
+    if (!GetLineUtf8(line, d, len)) {
+      continue;
+    }
+
+    size_t pos = std::string::npos;
+    if (forward) {
+      if (n == 0) {
+        pos = FindInLine(d, len, needle, fromByte, len);
+      } else if (n == count) {
+        pos = (fromByte > 0) ? FindInLine(d, len, needle, 0, fromByte - 1) : std::string::npos;
+      } else {
+        pos = FindInLine(d, len, needle, 0, len);
+      }
+    } else {
+      if (n == 0) {
+        pos = (fromByte > 0) ? FindLastInLine(d, len, needle, 0, fromByte - 1) : std::string::npos;
+      } else if (n == count) {
+        pos = FindLastInLine(d, len, needle, fromByte, len);
+      } else {
+        pos = FindLastInLine(d, len, needle, 0, len);
+      }
+    }
+
+    if (pos == std::string::npos) {
+      continue;
+    }
+
+    Pos a{line, Utf8Count(d, pos)};
+    Pos b{line, a.col + Utf8Count(d + pos, needle.size())};
+    m_anchor = a;
+    m_caret = b;
+
+    EnsureVisible(b);
+    EnsureVisible(a);
+    Refresh();
+    return true;
+  }
+
+  return false;
+}
+
+void ArduinoSerialLogView::SetHighlight(const wxString &text) {
+  wxString lower = text.Lower();
+  if (lower == m_highlightLower) {
+    return;
+  }
+  m_highlightLower = lower;
+  Refresh();
+}
+
+// ---------------------------------------------------------------------------
+// Geometry
+// ---------------------------------------------------------------------------
+
+void ArduinoSerialLogView::UpdateMetrics() {
+  wxClientDC dc(this);
+  dc.SetFont(GetFont());
+  m_lineHeight = std::max(1, dc.GetCharHeight());
+  m_charWidth = std::max(1, dc.GetTextExtent(wxT("M")).x);
+}
+
+int ArduinoSerialLogView::RowsOnScreen() const {
+  return std::max(1, GetClientSize().y / m_lineHeight);
+}
+
+int ArduinoSerialLogView::ColsOnScreen() const {
+  return std::max(1, (GetClientSize().x - kMarginX) / m_charWidth);
+}
+
+uint64_t ArduinoSerialLogView::MaxTopLine() const {
+  const uint64_t count = GetLineCount();
+  const uint64_t rows = (uint64_t)RowsOnScreen();
+  return (count > rows) ? m_firstLine + count - rows : m_firstLine;
+}
+
+bool ArduinoSerialLogView::IsAtBottom() const {
+  return m_topLine >= MaxTopLine();
+}
+
+void ArduinoSerialLogView::UpdateScrollbars() {
+  const uint64_t count = GetLineCount();
+  const int range = (int)std::min<uint64_t>(count, INT_MAX);
+  const int pos = (int)std::min<uint64_t>(m_topLine - m_firstLine, INT_MAX);
+  SetScrollbar(wxVERTICAL, pos, RowsOnScreen(), range);
+
+  const int hrange = (int)std::min<size_t>(m_maxCols + 1, INT_MAX);
+  SetScrollbar(wxHORIZONTAL, (int)m_xOffset, ColsOnScreen(), hrange);
+}
+
+void ArduinoSerialLogView::ScrollTo(uint64_t topLine, size_t xOffset, bool byUser) {
+  topLine = std::max(m_firstLine, std::min(topLine, MaxTopLine()));
+
+  const size_t cols = (size_t)ColsOnScreen();
+  const size_t maxX = (m_maxCols + 1 > cols) ? m_maxCols + 1 - cols : 0;
+  xOffset = std::min(xOffset, maxX);
+
+  if (topLine != m_topLine || xOffset != m_xOffset) {
+    m_topLine = topLine;
+    m_xOffset = xOffset;
+    UpdateScrollbars();
+    Refresh();
+  }
+
+  if (byUser) {
+    wxCommandEvent evt(wxEVT_SERIAL_LOG_SCROLLED, GetId());
+    evt.SetEventObject(this);
+    evt.SetInt(IsAtBottom() ? 1 : 0);
+    ProcessWindowEvent(evt);
+  }
+}
+
+void ArduinoSerialLogView::ScrollToEnd() {
+  ScrollTo(MaxTopLine(), m_xOffset, false);
+}
+
+void ArduinoSerialLogView::EnsureVisible(const Pos &p) {
+  uint64_t top = m_topLine;
+  const uint64_t rows = (uint64_t)RowsOnScreen();
+  if (p.line < m_topLine || p.line >= m_topLine + rows) {
+    top = (p.line > rows / 2) ? p.line - rows / 2 : 0;
+  }
+
+  std::vector<size_t> map;
+  ExpandLine(GetLineText(p.line), map);
+  const size_t dcol = map[std::min(p.col, map.size() - 1)];
+
+  size_t x = m_xOffset;
+  const size_t cols = (size_t)ColsOnScreen();
+  if (dcol < m_xOffset || dcol >= m_xOffset + cols) {
+    x = (dcol > cols / 2) ? dcol - cols / 2 : 0;
+  }
+
+  ScrollTo(top, x, true);
+}
+
+ArduinoSerialLogView::Pos ArduinoSerialLogView::HitTest(const wxPoint &pt) const {
+  const int row = (pt.y >= 0) ? pt.y / m_lineHeight : -1 - (-pt.y / m_lineHeight);
+
+  uint64_t line = m_topLine;
+  if (row < 0) {
+    line = (m_topLine - m_firstLine >= (uint64_t)(-row)) ? m_topLine - (uint64_t)(-row) : m_firstLine;
+  } else {
+    line = std::min(m_topLine + (uint64_t)row, LastLine());
+  }
+
+  const wxString text = GetLineText(line);
+  const int x = pt.x - kMarginX + m_charWidth / 2;
+  const size_t target = m_xOffset + (size_t)std::max(0, x / m_charWidth);
+
+  size_t disp = 0;
+  size_t col = 0;
+  for (wxString::const_iterator it = text.begin(); it != text.end(); ++it, ++col) {
+    const size_t w = (*it == '\t') ? kTabWidth - (disp % kTabWidth) : 1;
+    if (target < disp + (w + 1) / 2) {
+      break;
+    }
+    disp += w;
+  }
+
+  return Pos{line, col};
+}
+
+// ---------------------------------------------------------------------------
+// Events
+// ---------------------------------------------------------------------------
+
+void ArduinoSerialLogView::OnPaint(wxPaintEvent &WXUNUSED(evt)) {
+  wxAutoBufferedPaintDC dc(this);
+
+  dc.SetBackground(wxBrush(m_bgColour));
+  dc.Clear();
+
+  dc.SetFont(GetFont());
+  dc.SetTextForeground(m_textColour);
+  dc.SetBackgroundMode(wxTRANSPARENT);
+  dc.SetPen(*wxTRANSPARENT_PEN);
+
+  const bool hasSel = HasSelection();
+  const Pos selA = std::min(m_anchor, m_caret);
+  const Pos selB = std::max(m_anchor, m_caret);
+
+  const int rows = RowsOnScreen() + 1;
+  const size_t cols = (size_t)ColsOnScreen() + 1;
+  const uint64_t last = LastLine();
+
+  std::vector<size_t> map;
+
+  auto colX = [this](size_t dcol) {
+    return kMarginX + ((int)dcol - (int)m_xOffset) * m_charWidth;
+  };
+
+  for (int r = 0; r < rows; ++r) {
+    const uint64_t line = m_topLine + (uint64_t)r;
+    if (line > last) {
+      break;
+    }
+
+    const wxString text = GetLineText(line);
+    const wxString disp = ExpandLine(text, map);
+    const int y = r * m_lineHeight;
+
+    // search matches
+    if (!m_highlightLower.empty() && !text.empty()) {
+      const wxString lower = text.Lower();
+      dc.SetBrush(wxBrush(m_highlightColour));
+      for (size_t p = lower.find(m_highlightLower); p != wxString::npos && p < text.length(); p = lower.find(m_highlightLower, p + 1)) {
+        const size_t e = std::min(p + m_highlightLower.length(), text.length());
+        dc.DrawRectangle(colX(map[p]), y, (int)(map[e] - map[p]) * m_charWidth, m_lineHeight);
+      }
+    }
+
+    // selection
+    if (hasSel && line >= selA.line && line <= selB.line) {
+      const size_t c0 = (line == selA.line) ? std::min(selA.col, text.length()) : 0;
+      const size_t c1 = (line == selB.line) ? std::min(selB.col, text.length()) : text.length();
+      size_t d0 = map[c0];
+      size_t d1 = map[c1];
+      if (line < selB.line) {
+        ++d1; // line break is selected too
+      }
+      if (d1 > d0) {
+        dc.SetBrush(wxBrush(m_selColour));
+        dc.DrawRectangle(colX(d0), y, (int)(d1 - d0) * m_charWidth, m_lineHeight);
+      }
+    }
+
+    if (disp.length() > m_xOffset) {
+      dc.DrawText(disp.Mid(m_xOffset, cols), kMarginX, y);
+    }
+  }
+}
+
+void ArduinoSerialLogView::OnSize(wxSizeEvent &evt) {
+  const bool atBottom = IsAtBottom();
+  UpdateScrollbars();
+  if (atBottom) {
+    ScrollTo(MaxTopLine(), m_xOffset, false);
+  } else {
+    ScrollTo(m_topLine, m_xOffset, false);
+  }
+  evt.Skip();
+}
+
+void ArduinoSerialLogView::OnScrollWin(wxScrollWinEvent &evt) {
+  const wxEventType t = evt.GetEventType();
+  const bool vertical = (evt.GetOrientation() == wxVERTICAL);
+
+  const int64_t page = vertical ? RowsOnScreen() : ColsOnScreen();
+  const int64_t cur = vertical ? (int64_t)(m_topLine - m_firstLine) : (int64_t)m_xOffset;
+  const int64_t max = vertical ? (int64_t)(MaxTopLine() - m_firstLine) : (int64_t)m_maxCols;
+
+  int64_t pos = cur;
+  if (t == wxEVT_SCROLLWIN_TOP) {
+    pos = 0;
+  } else if (t == wxEVT_SCROLLWIN_BOTTOM) {
+    pos = max;
+  } else if (t == wxEVT_SCROLLWIN_LINEUP) {
+    pos = cur - 1;
+  } else if (t == wxEVT_SCROLLWIN_LINEDOWN) {
+    pos = cur + 1;
+  } else if (t == wxEVT_SCROLLWIN_PAGEUP) {
+    pos = cur - page;
+  } else if (t == wxEVT_SCROLLWIN_PAGEDOWN) {
+    pos = cur + page;
+  } else {
+    pos = evt.GetPosition();
+  }
+  pos = std::max<int64_t>(0, pos);
+
+  if (vertical) {
+    ScrollTo(m_firstLine + (uint64_t)pos, m_xOffset, true);
+  } else {
+    ScrollTo(m_topLine, (size_t)pos, true);
+  }
+}
+
+void ArduinoSerialLogView::OnMouseWheel(wxMouseEvent &evt) {
+  const int delta = std::max(1, evt.GetWheelDelta());
+
+  // touchpads send many small steps - accumulate them into whole lines
+  m_wheelRotation += evt.GetWheelRotation();
+  const int steps = m_wheelRotation / delta;
+  if (steps == 0) {
+    return;
+  }
+  m_wheelRotation -= steps * delta;
+
+  if (evt.GetWheelAxis() == wxMOUSE_WHEEL_HORIZONTAL) {
+    const int64_t x = (int64_t)m_xOffset + (int64_t)steps * 4;
+    ScrollTo(m_topLine, (size_t)std::max<int64_t>(0, x), true);
+    return;
+  }
+
+  const int64_t lines = -(int64_t)steps * std::max(1, evt.GetLinesPerAction());
+  const int64_t top = (int64_t)(m_topLine - m_firstLine) + lines;
+  ScrollTo(m_firstLine + (uint64_t)std::max<int64_t>(0, top), m_xOffset, true);
+}
+
+void ArduinoSerialLogView::OnLeftDown(wxMouseEvent &evt) {
+  SetFocus();
+
+  const Pos p = HitTest(evt.GetPosition());
+  m_caret = p;
+  if (!evt.ShiftDown()) {
+    m_anchor = p;
+  }
+
+  m_selecting = true;
+  if (!HasCapture()) {
+    CaptureMouse();
+  }
+  Refresh();
+}
+
+void ArduinoSerialLogView::OnLeftUp(wxMouseEvent &WXUNUSED(evt)) {
+  m_selecting = false;
+  if (HasCapture()) {
+    ReleaseMouse();
+  }
+}
+
+void ArduinoSerialLogView::OnLeftDClick(wxMouseEvent &evt) {
+  const Pos p = HitTest(evt.GetPosition());
+  const wxString text = GetLineText(p.line);
+
+  auto isWord = [](wxUniChar c) { return wxIsalnum(c) || c == '_'; };
+
+  size_t b = std::min(p.col, text.length());
+  size_t e = b;
+  while (b > 0 && isWord(text[b - 1])) {
+    --b;
+  }
+  while (e < text.length() && isWord(text[e])) {
+    ++e;
+  }
+
+  m_anchor = Pos{p.line, b};
+  m_caret = Pos{p.line, e};
+  Refresh();
+}
+
+void ArduinoSerialLogView::OnMotion(wxMouseEvent &evt) {
+  if (!m_selecting || !evt.LeftIsDown()) {
+    return;
+  }
+
+  const wxPoint pt = evt.GetPosition();
+  if (pt.y < 0 && m_topLine > m_firstLine) {
+    ScrollTo(m_topLine - 1, m_xOffset, true);
+  } else if (pt.y >= GetClientSize().y) {
+    ScrollTo(m_topLine + 1, m_xOffset, true);
+  }
+
+  const Pos p = HitTest(pt);
+  if (p != m_caret) {
+    m_caret = p;
+    Refresh();
+  }
+}
+
+void ArduinoSerialLogView::OnCaptureLost(wxMouseCaptureLostEvent &WXUNUSED(evt)) {
+  m_selecting = false;
+}
+
+void ArduinoSerialLogView::OnKeyDown(wxKeyEvent &evt) {
+  const int key = evt.GetKeyCode();
+  const bool ctrl = evt.ControlDown();
+  const uint64_t rows = (uint64_t)RowsOnScreen();
+
+  if (ctrl && (key == 'C' || key == WXK_INSERT)) {
+    Copy();
+    return;
+  }
+  if (ctrl && key == 'A') {
+    SelectAll();
+    return;
+  }
+
+  switch (key) {
+    case WXK_UP:
+      ScrollTo(m_topLine > m_firstLine ? m_topLine - 1 : m_firstLine, m_xOffset, true);
+      break;
+    case WXK_DOWN:
+      ScrollTo(m_topLine + 1, m_xOffset, true);
+      break;
+    case WXK_PAGEUP:
+      ScrollTo(m_topLine - m_firstLine > rows ? m_topLine - rows : m_firstLine, m_xOffset, true);
+      break;
+    case WXK_PAGEDOWN:
+      ScrollTo(m_topLine + rows, m_xOffset, true);
+      break;
+    case WXK_HOME:
+      ScrollTo(ctrl ? m_firstLine : m_topLine, 0, true);
+      break;
+    case WXK_END:
+      ScrollTo(ctrl ? MaxTopLine() : m_topLine, ctrl ? m_xOffset : m_maxCols, true);
+      break;
+    case WXK_LEFT:
+      ScrollTo(m_topLine, m_xOffset > 0 ? m_xOffset - 1 : 0, true);
+      break;
+    case WXK_RIGHT:
+      ScrollTo(m_topLine, m_xOffset + 1, true);
+      break;
+    default:
+      evt.Skip();
+      break;
+  }
+}
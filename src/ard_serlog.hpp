@@ -0,0 +1,158 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <wx/wx.h>
+
+/**
+ * Read-only, virtualized log view used by the serial monitor.
+ *
+ * Lines are kept as UTF-8 in a deque of fixed-size chunks (one text buffer
+ * + line offsets per chunk). Appending only touches the last chunk and
+ * trimming drops whole chunks from the front, so both are O(1) regardless
+ * of how many lines are retained. Only the visible rows are converted to
+ * wxString and painted.
+ *
+ * Lines are addressed by absolute numbers which never change while the line
+ * is retained, so the viewport and selection stay put when old lines are trimmed.
+ * Input is expected with normalized line endings ('\n' only), a line longer
+ * than kMaxLineBytes is wrapped, so a chunk stays bounded. User scrolling
+ * is reported with wxEVT_SERIAL_LOG_SCROLLED.
+ */
+class ArduinoSerialLogView : public wxWindow {
+public:
+  struct Pos {
+    uint64_t line = 0; // absolute line number
+    size_t col = 0;    // index into the wxString of the line
+
+    bool operator==(const Pos &o) const { return line == o.line && col == o.col; }
+    bool operator!=(const Pos &o) const { return !(*this == o); }
+    bool operator<(const Pos &o) const { return line < o.line || (line == o.line && col < o.col); }
+  };
+
+  ArduinoSerialLogView(wxWindow *parent,
+                       wxWindowID id = wxID_ANY,
+                       const wxPoint &pos = wxDefaultPosition,
+                       const wxSize &size = wxDefaultSize,
+                       long style = wxBORDER_NONE);
+
+  void SetColours(const wxColour &text, const wxColour &background, const wxColour &selection, const wxColour &highlight);
+  bool SetFont(const wxFont &font) override;
+
+  // Oldest chunks are dropped when either limit is exceeded (0 = unlimited).
+  void SetLimits(size_t maxLines, size_t maxBytes);
+
+  void AppendText(const wxString &text);
+  void AppendUtf8(const char *data, size_t len);
+  void Clear();
+
+  size_t GetLineCount() const;
+  bool IsEmpty() const { return m_totalBytes == 0 && GetLineCount() <= 1; }
+
+  // --- viewport ---
+  void ScrollToEnd();
+  bool IsAtBottom() const;
+
+  // --- selection / clipboard ---
+  bool HasSelection() const { return m_anchor != m_caret; }
+  void SelectAll();
+  void Copy();
+  wxString GetSelectedText() const;
+  std::string GetSelectedTextUtf8() const;
+  std::string GetTextUtf8() const;
+
+  // --- search ---
+  // Searches from the current selection (wrapping around the log), selects
+  // and shows the match. incremental -> the match may start at the selection start.
+  bool FindText(const wxString &text, bool forward, bool incremental = false);
+
+  // Matches of text are highlighted in the visible rows (empty = off).
+  void SetHighlight(const wxString &text);
+
+private:
+  static constexpr size_t kLinesPerChunk = 4096;
+  static constexpr size_t kMaxLineBytes = 16 * 1024; // longer lines get a forced break
+
+  struct Chunk {
+    std::string text;             // lines without '\n'
+    std::vector<uint32_t> starts; // byte offset of each line in text
+  };
+
+  std::deque<Chunk> m_chunks;
+  uint64_t m_firstLine = 0; // absolute number of m_chunks.front().starts[0]
+  size_t m_totalBytes = 0;
+  size_t m_maxLines = 0;
+  size_t m_maxBytes = 0;
+
+  size_t m_openCols = 0; // display columns of the (unfinished) last line
+  size_t m_maxCols = 0;  // widest line seen since Clear()
+
+  uint64_t m_topLine = 0; // absolute number of the first visible line
+  size_t m_xOffset = 0;   // first visible display column
+
+  Pos m_anchor;
+  Pos m_caret;
+  bool m_selecting = false;
+
+  wxString m_highlightLower;
+
+  wxColour m_textColour;
+  wxColour m_bgColour;
+  wxColour m_selColour;
+  wxColour m_highlightColour;
+
+  int m_lineHeight = 1;
+  int m_charWidth = 1;
+  int m_wheelRotation = 0;
+
+  // --- storage ---
+  void ResetStorage();
+  bool Trim(); // true -> the first visible line was trimmed
+  uint64_t LastLine() const { return m_firstLine + GetLineCount() - 1; }
+  bool GetLineUtf8(uint64_t line, const char *&data, size_t &len) const;
+  wxString GetLineText(uint64_t line) const;
+  void AppendRangeUtf8(const Pos &from, const Pos &to, std::string &out) const;
+  Pos ClampPos(const Pos &p) const;
+
+  // --- geometry ---
+  void UpdateMetrics();
+  void UpdateScrollbars();
+  int RowsOnScreen() const;
+  int ColsOnScreen() const;
+  uint64_t MaxTopLine() const;
+  void ScrollTo(uint64_t topLine, size_t xOffset, bool byUser);
+  void EnsureVisible(const Pos &p);
+  Pos HitTest(const wxPoint &pt) const;
+
+  // --- events ---
+  void OnPaint(wxPaintEvent &evt);
+  void OnSize(wxSizeEvent &evt);
+  void OnScrollWin(wxScrollWinEvent &evt);
+  void OnMouseWheel(wxMouseEvent &evt);
+  void OnLeftDown(wxMouseEvent &evt);
+  void OnLeftUp(wxMouseEvent &evt);
+  void OnLeftDClick(wxMouseEvent &evt);
+  void OnMotion(wxMouseEvent &evt);
+  void OnCaptureLost(wxMouseCaptureLostEvent &evt);
+  void OnKeyDown(wxKeyEvent &evt);
+};
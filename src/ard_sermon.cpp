@@ -22,10 +22,15 @@
 #include "ard_ev.hpp"
 #include "ard_plotpars.hpp"
 #include "ard_plotview.hpp"
+#include "ard_serlog.hpp"
 #include "ard_setdlg.hpp"
 #include "ard_valsview.hpp"
 #include "utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <errno.h>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <wx/datetime.h>
@@ -33,8 +38,15 @@
 #include <wx/filedlg.h>
 #include <wx/notebook.h>
 #include <wx/numdlg.h>
-#include <wx/stc/stc.h>
-#include <wx/wupdlock.h>
+#include <wx/srchctrl.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AE_SERMON_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AE_SERMON_NEON 1
+#endif
 
 #if defined(__unix__) || defined(__APPLE__)
 #include <fcntl.h>
@@ -58,6 +70,7 @@ enum {
   ID_ClearButton,
   ID_ResetButton,
   ID_OutputMenuCopy,
+  ID_OutputMenuFind,
   ID_OutputMenuSaveSelection,
   ID_OutputMenuSaveAll,
   ID_OutputMenuDisplayValues,
@@ -69,10 +82,9 @@ enum {
 
 // Limits to prevent uncontrollable growth.
 namespace {
-constexpr int kMaxOutputLines = 20000;              // safe number of rows
-constexpr int kMaxOutputChars = 4 * 1024 * 1024;    // cca 4 MB inner stc buffer in bytes
-constexpr size_t kMaxPausedTextChars = 1024 * 1024; // 1 MB paused text buffer (in "wxChar" length)
-constexpr size_t kMaxPausedPlotLines = 50000;       // paused plot buffer limie
+constexpr size_t kMaxOutputLines = 2000000;         // log view drops whole chunks, so this can be big
+constexpr size_t kMaxOutputBytes = 128 * 1024 * 1024; // cca 128 MB of UTF-8 text in the log view
+constexpr size_t kMaxPausedTextBytes = 2 * 1024 * 1024; // 2 MB paused text buffer (UTF-8)
 
 static inline bool IsLatin1Printable(unsigned char b) {
   // 0x20..0x7E = ASCII printable
@@ -80,108 +92,90 @@ static inline bool IsLatin1Printable(unsigned char b) {
   return (b >= 0x20 && b <= 0x7E) || (b >= 0xA0);
 }
 
-static inline wxString BytesToLatin1(const std::string &s) {
-  wxString out;
-  out.reserve(s.size());
-  for (unsigned char b : s) {
-    out += wxUniChar((wchar_t)b); // maps 0..255 to U+0000..U+00FF
+// Appends byte b as the Latin-1 character U+0000..U+00FF encoded in UTF-8.
+static inline void AppendLatin1AsUtf8(std::string &out, unsigned char b) {
+  if (b < 0x80) {
+    out += (char)b;
+  } else {
+    out += (char)(0xC0 | (b >> 6));
+    out += (char)(0x80 | (b & 0x3F));
   }
-  return out;
 }
 
-} // namespace
-
-// --- Telemetry sinks (Plot parser -> UI consumers) ---
-class ArduinoFanoutSink final : public ArduinoPlotSink {
-public:
-  ArduinoFanoutSink(ArduinoPlotSink *a = nullptr, ArduinoPlotSink *b = nullptr)
-      : m_a(a), m_b(b) {}
-
-  void Set(ArduinoPlotSink *a, ArduinoPlotSink *b) {
-    m_a = a;
-    m_b = b;
-  }
-
-  void AddSampleAt(const std::string &name, double value, double t_ms, bool refresh) override {
-    if (m_a)
-      m_a->AddSampleAt(name, value, t_ms, refresh);
-    if (m_b)
-      m_b->AddSampleAt(name, value, t_ms, refresh);
-  }
-
-  void Refresh(bool eraseBackground) override {
-    if (m_a)
-      m_a->Refresh(eraseBackground);
-    if (m_b)
-      m_b->Refresh(eraseBackground);
-  }
-
-private:
-  ArduinoPlotSink *m_a = nullptr;
-  ArduinoPlotSink *m_b = nullptr;
-};
-
-class ArduinoPlotViewSink final : public ArduinoPlotSink {
-public:
-  explicit ArduinoPlotViewSink(ArduinoPlotView *view) : m_view(view) {}
-
-  // Map external time base (serial monitor clock) to the plot view internal clock.
-  void SetTimeOffset(double offsetMs) { m_timeOffsetMs = offsetMs; }
-
-  void AddSampleAt(const std::string &name, double value, double t_ms, bool refresh) override {
-    if (!m_view)
-      return;
-    const wxString &wxName = ToWxCached(name);
-    m_view->AddSampleAt(wxName, value, t_ms + m_timeOffsetMs, refresh);
-  }
+static inline void AppendWxAsUtf8(std::string &out, const wxString &s) {
+  const wxScopedCharBuffer buf = s.ToUTF8();
+  out.append(buf.data(), buf.length());
+}
 
-  void Refresh(bool eraseBackground) override {
-    if (m_view)
-      m_view->Refresh(eraseBackground);
-  }
+// Length of the UTF-8 sequence started by lead byte b, 0 = not a valid lead.
+static inline size_t Utf8SequenceLength(unsigned char b) {
+  if (b >= 0xC2 && b <= 0xDF)
+    return 2;
+  if (b >= 0xE0 && b <= 0xEF)
+    return 3;
+  if (b >= 0xF0 && b <= 0xF4)
+    return 4;
+  return 0;
+}
 
-private:
-  const wxString &ToWxCached(const std::string &name) {
-    auto it = m_cache.find(name);
-    if (it != m_cache.end())
-      return it->second;
-    auto ins = m_cache.emplace(name, wxString::FromUTF8(name.c_str()));
-    return ins.first->second;
+// Checks continuation bytes of a complete sequence (rejects overlongs and surrogates).
+static inline bool IsValidUtf8Sequence(const unsigned char *s, size_t len) {
+  for (size_t i = 1; i < len; ++i) {
+    if ((s[i] & 0xC0) != 0x80)
+      return false;
+  }
+  if (len == 3) {
+    if (s[0] == 0xE0 && s[1] < 0xA0)
+      return false;
+    if (s[0] == 0xED && s[1] >= 0xA0)
+      return false;
+  } else if (len == 4) {
+    if (s[0] == 0xF0 && s[1] < 0x90)
+      return false;
+    if (s[0] == 0xF4 && s[1] >= 0x90)
+      return false;
   }
+  return true;
+}
 
-  ArduinoPlotView *m_view = nullptr;
-  std::unordered_map<std::string, wxString> m_cache;
-  double m_timeOffsetMs = 0.0;
-};
-
-class ArduinoValuesViewSink final : public ArduinoPlotSink {
-public:
-  explicit ArduinoValuesViewSink(ArduinoValuesView *view) : m_view(view) {}
+// Number of leading bytes which can be copied as they are: ASCII except '\r'.
+// This is the hot loop of the text mode, so it looks at 16 bytes at once when possible.
+static inline size_t ScanPlainAscii(const unsigned char *s, size_t n) {
+  size_t i = 0;
 
-  void AddSampleAt(const std::string &name, double value, double /*t_ms*/, bool refresh) override {
-    if (!m_view)
-      return;
-    const wxString &wxName = ToWxCached(name);
-    m_view->AddSample(wxName, value, refresh);
+#if defined(AE_SERMON_SSE2)
+  const __m128i cr = _mm_set1_epi8('\r');
+  for (; i + 16 <= n; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    unsigned mask = (unsigned)(_mm_movemask_epi8(v) | _mm_movemask_epi8(_mm_cmpeq_epi8(v, cr)));
+    if (mask) {
+      while ((mask & 1u) == 0) {
+        mask >>= 1;
+        ++i;
+      }
+      return i;
+    }
   }
-
-  void Refresh(bool eraseBackground) override {
-    if (m_view)
-      m_view->Refresh(eraseBackground);
+#elif defined(AE_SERMON_NEON)
+  const uint8x16_t cr = vdupq_n_u8('\r');
+  const uint8x16_t high = vdupq_n_u8(0x80);
+  for (; i + 16 <= n; i += 16) {
+    const uint8x16_t v = vld1q_u8(s + i);
+    const uint8x16_t hit = vorrq_u8(vcgeq_u8(v, high), vceqq_u8(v, cr));
+    if (vmaxvq_u8(hit) != 0) {
+      break; // exact position is found by the scalar loop below
+    }
   }
+#endif
 
-private:
-  const wxString &ToWxCached(const std::string &name) {
-    auto it = m_cache.find(name);
-    if (it != m_cache.end())
-      return it->second;
-    auto ins = m_cache.emplace(name, wxString::FromUTF8(name.c_str()));
-    return ins.first->second;
+  for (; i < n; ++i) {
+    if (s[i] >= 0x80 || s[i] == '\r')
+      break;
   }
+  return i;
+}
 
-  ArduinoValuesView *m_view = nullptr;
-  std::unordered_map<std::string, wxString> m_cache;
-};
+} // namespace
 
 #if defined(__unix__) || defined(__APPLE__)
 
@@ -276,11 +270,61 @@ static wxArrayString BuildBaudChoicesPosix() {
 
 #endif
 
+SerialRingBuffer::SerialRingBuffer(size_t capacityPow2) {
+  size_t cap = 1024;
+  while (cap < capacityPow2) {
+    cap <<= 1;
+  }
+  m_buf.resize(cap);
+  m_mask = cap - 1;
+}
+
+size_t SerialRingBuffer::Write(const char *data, size_t len) {
+  const size_t head = m_head.load(std::memory_order_relaxed);
+  const size_t tail = m_tail.load(std::memory_order_acquire);
+
+  const size_t freeBytes = m_buf.size() - (head - tail);
+  const size_t n = std::min(len, freeBytes);
+
+  const size_t pos = head & m_mask;
+  const size_t first = std::min(n, m_buf.size() - pos);
+  memcpy(m_buf.data() + pos, data, first);
+  memcpy(m_buf.data(), data + first, n - first);
+
+  m_head.store(head + n, std::memory_order_release);
+
+  if (n < len) {
+    m_dropped.fetch_add(len - n, std::memory_order_relaxed);
+  }
+  return n;
+}
+
+size_t SerialRingBuffer::Read(std::string &out, size_t maxBytes) {
+  const size_t tail = m_tail.load(std::memory_order_relaxed);
+  const size_t head = m_head.load(std::memory_order_acquire);
+
+  const size_t n = std::min(head - tail, maxBytes);
+
+  const size_t pos = tail & m_mask;
+  const size_t first = std::min(n, m_buf.size() - pos);
+  out.append(m_buf.data() + pos, first);
+  out.append(m_buf.data(), n - first);
+
+  m_tail.store(tail + n, std::memory_order_release);
+  return n;
+}
+
+size_t SerialRingBuffer::Size() const {
+  return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+}
+
 SerialMonitorWorker::SerialMonitorWorker(wxEvtHandler *handler,
+                                         std::shared_ptr<SerialRingBuffer> ring,
                                          const wxString &port,
                                          long baud)
     : wxThread(wxTHREAD_JOINABLE),
       m_handler(handler),
+      m_ring(std::move(ring)),
       m_port(port),
       m_baud(baud),
       m_stopRequested(false),
@@ -471,6 +515,16 @@ bool SerialMonitorWorker::Write(const std::string &data) {
 #endif
 }
 
+void SerialMonitorWorker::PushData(const char *data, size_t len) {
+  m_ring->SetLastRxTime(wxDateTime::Now().GetTicks());
+  m_ring->Write(data, len);
+
+  // at most one wake-up in the GUI queue, it drains everything available
+  if (m_ring->RequestWake()) {
+    wxQueueEvent(m_handler, new wxThreadEvent(wxEVT_SERIAL_MONITOR_DATA));
+  }
+}
+
 wxThread::ExitCode SerialMonitorWorker::Entry() {
   if (!OpenPort()) {
     auto *evt = new wxThreadEvent(wxEVT_SERIAL_MONITOR_ERROR);
@@ -479,8 +533,10 @@ wxThread::ExitCode SerialMonitorWorker::Entry() {
     return nullptr;
   }
 
-  const size_t BUF_SIZE = 256;
-  char buf[BUF_SIZE];
+  // large reads - at high baud rates the driver has plenty of data between wake-ups
+  const size_t BUF_SIZE = 64 * 1024;
+  std::vector<char> readBuf(BUF_SIZE);
+  char *buf = readBuf.data();
 
   while (true) {
     {
@@ -551,14 +607,7 @@ wxThread::ExitCode SerialMonitorWorker::Entry() {
 
     ssize_t n = ::read(fd, buf, BUF_SIZE);
     if (n > 0) {
-      auto *evt = new wxThreadEvent(wxEVT_SERIAL_MONITOR_DATA);
-
-      SerialChunkPayload p;
-      p.sec = wxDateTime::Now().GetTicks();
-      p.bytes.assign(buf, buf + n);
-
-      evt->SetPayload<SerialChunkPayload>(p);
-      wxQueueEvent(m_handler, evt);
+      PushData(buf, (size_t)n);
     } else if (n == 0) {
       auto *evt = new wxThreadEvent(wxEVT_SERIAL_MONITOR_ERROR);
       evt->SetString(_("Serial port closed"));
@@ -599,14 +648,7 @@ wxThread::ExitCode SerialMonitorWorker::Entry() {
     DWORD bytesRead = 0;
     BOOL ok = ReadFile(h, buf, BUF_SIZE, &bytesRead, nullptr);
     if (ok && bytesRead > 0) {
-      auto *evt = new wxThreadEvent(wxEVT_SERIAL_MONITOR_DATA);
-
-      SerialChunkPayload p;
-      p.sec = wxDateTime::Now().GetTicks();
-      p.bytes.assign(buf, buf + bytesRead);
-
-      evt->SetPayload<SerialChunkPayload>(p);
-      wxQueueEvent(m_handler, evt);
+      PushData(buf, (size_t)bytesRead);
     } else if (!ok) {
       DWORD err = GetLastError();
       if (err == ERROR_OPERATION_ABORTED) {
@@ -663,12 +705,16 @@ ArduinoSerialMonitorFrame::ArduinoSerialMonitorFrame(wxWindow *parent,
   // ---- Bindings for thread events ----
   Bind(wxEVT_SERIAL_MONITOR_DATA, &ArduinoSerialMonitorFrame::OnData, this);
   Bind(wxEVT_SERIAL_MONITOR_ERROR, &ArduinoSerialMonitorFrame::OnError, this);
+  Bind(wxEVT_SERIAL_PLOT_READY, &ArduinoSerialMonitorFrame::OnPlotReady, this);
 
   m_textFlushScheduled = false;
   Bind(wxEVT_TIMER, &ArduinoSerialMonitorFrame::OnTextFlushTimer, this);
 
   // ---- User scrolling ----
-  m_outputCtrl->Bind(wxEVT_STC_UPDATEUI, &ArduinoSerialMonitorFrame::OnOutputUpdateUI, this);
+  m_outputCtrl->Bind(wxEVT_SERIAL_LOG_SCROLLED, &ArduinoSerialMonitorFrame::OnOutputScrolled, this);
+
+  // ---- Find in log (Ctrl+F, F3) ----
+  Bind(wxEVT_CHAR_HOOK, &ArduinoSerialMonitorFrame::OnCharHook, this);
 
   m_notebook->Bind(wxEVT_NOTEBOOK_PAGE_CHANGED, &ArduinoSerialMonitorFrame::OnNotebookPageChanged, this);
 
@@ -679,31 +725,16 @@ ArduinoSerialMonitorFrame::ArduinoSerialMonitorFrame(wxWindow *parent,
 }
 
 ArduinoSerialMonitorFrame::~ArduinoSerialMonitorFrame() {
+  // joins the stage thread, no more events after this
+  m_plotStage.reset();
   StopWorker();
 }
 
 void ArduinoSerialMonitorFrame::SetupOutputCtrl(const EditorSettings &settings) {
   EditorColorScheme c = settings.GetColors();
 
-  // Serial output behaves like a log: no wrapping and no undo stack.
-  m_outputCtrl->SetWrapMode(wxSTC_WRAP_NONE);
-  m_outputCtrl->SetUndoCollection(false);
-  m_outputCtrl->SetReadOnly(true);
-
-  // Hide all margins (line numbers, folding, etc.)
-  for (int i = 0; i < 5; ++i) {
-    m_outputCtrl->SetMarginWidth(i, 0);
-  }
-
-  // ---- Default style: fonts + colors ----
-  m_outputCtrl->StyleSetFont(wxSTC_STYLE_DEFAULT, settings.GetFont());
-  m_outputCtrl->StyleSetForeground(wxSTC_STYLE_DEFAULT, c.text);
-  m_outputCtrl->StyleSetBackground(wxSTC_STYLE_DEFAULT, c.background);
-
-  m_outputCtrl->StyleClearAll();
-
-  m_outputCtrl->SetBackgroundColour(c.background);
-  m_outputCtrl->SetCaretForeground(c.text);
+  m_outputCtrl->SetFont(settings.GetFont());
+  m_outputCtrl->SetColours(c.text, c.background, c.selection, c.symbolHighlight);
 }
 
 void ArduinoSerialMonitorFrame::CreateControls() {
@@ -837,21 +868,20 @@ void ArduinoSerialMonitorFrame::CreateControls() {
   m_logPage = new wxPanel(m_notebook);
   auto *logSizer = new wxBoxSizer(wxVERTICAL);
 
-  m_outputCtrl = new wxStyledTextCtrl(m_logPage, wxID_ANY, wxDefaultPosition,
-                                      wxDefaultSize, wxBORDER_NONE);
+  m_outputCtrl = new ArduinoSerialLogView(m_logPage, wxID_ANY, wxDefaultPosition,
+                                          wxDefaultSize, wxBORDER_NONE);
+  m_outputCtrl->SetLimits(kMaxOutputLines, kMaxOutputBytes);
 
   EditorSettings settings;
   settings.Load(m_config);
   SetupOutputCtrl(settings);
 
   // --- Custom popup menu for the output control ---
-  m_outputCtrl->UsePopUp(false); // disable the default STC popup menu
-
   m_outputCtrl->Bind(wxEVT_CONTEXT_MENU, [this](wxContextMenuEvent &e) {
     if (!m_outputCtrl)
       return;
 
-    const bool hasSel = (m_outputCtrl->GetSelectionStart() != m_outputCtrl->GetSelectionEnd());
+    const bool hasSel = m_outputCtrl->HasSelection();
 
     wxMenu menu;
     AddMenuItemWithArt(&menu,
@@ -859,6 +889,11 @@ void ArduinoSerialMonitorFrame::CreateControls() {
                        _("Copy\tCtrl+C"),
                        wxEmptyString,
                        wxAEArt::Copy);
+    AddMenuItemWithArt(&menu,
+                       ID_OutputMenuFind,
+                       _("Find...\tCtrl+F"),
+                       wxEmptyString,
+                       wxAEArt::Find);
     menu.AppendSeparator();
 
     menu.AppendCheckItem(ID_OutputMenuDisplayValues, _("Display values"));
@@ -907,7 +942,7 @@ void ArduinoSerialMonitorFrame::CreateControls() {
       return s;
     };
 
-    auto saveText = [this, &sanitizeFilePart](const wxString &text, bool selectionOnly) {
+    auto saveText = [this, &sanitizeFilePart](const std::string &text, bool selectionOnly) {
       if (text.empty()) {
         wxBell();
         return;
@@ -937,10 +972,7 @@ void ArduinoSerialMonitorFrame::CreateControls() {
         return;
       }
 
-      const wxCharBuffer buf = text.ToUTF8();
-      if (buf.data() && buf.length() > 0) {
-        file.Write(buf.data(), buf.length());
-      }
+      file.Write(text.data(), text.size());
       file.Close();
     };
 
@@ -949,15 +981,17 @@ void ArduinoSerialMonitorFrame::CreateControls() {
       if (m_outputCtrl)
         m_outputCtrl->Copy(); }, ID_OutputMenuCopy);
 
+    menu.Bind(wxEVT_MENU, [this](wxCommandEvent &) { ShowFindBar(); }, ID_OutputMenuFind);
+
     menu.Bind(wxEVT_MENU, [this, &saveText](wxCommandEvent &) {
       if (!m_outputCtrl)
         return;
-      saveText(m_outputCtrl->GetSelectedText(), true); }, ID_OutputMenuSaveSelection);
+      saveText(m_outputCtrl->GetSelectedTextUtf8(), true); }, ID_OutputMenuSaveSelection);
 
     menu.Bind(wxEVT_MENU, [this, &saveText](wxCommandEvent &) {
       if (!m_outputCtrl)
         return;
-      saveText(m_outputCtrl->GetText(), false); }, ID_OutputMenuSaveAll);
+      saveText(m_outputCtrl->GetTextUtf8(), false); }, ID_OutputMenuSaveAll);
 
     menu.Bind(wxEVT_MENU, [this](wxCommandEvent &) {
       wxCommandEvent dummy(wxEVT_BUTTON, ID_ClearButton);
@@ -1017,6 +1051,24 @@ void ArduinoSerialMonitorFrame::CreateControls() {
 
   logSizer->Add(m_outputCtrl, 1, wxEXPAND);
 
+  // Find bar (hidden until Ctrl+F)
+  m_findCtrl = new wxSearchCtrl(m_logPage, wxID_ANY, wxEmptyString, wxDefaultPosition,
+                                wxDefaultSize, wxTE_PROCESS_ENTER);
+  m_findCtrl->ShowCancelButton(true);
+  m_findCtrl->SetDescriptiveText(_("Find in log"));
+  m_findCtrl->Hide();
+  logSizer->Add(m_findCtrl, 0, wxEXPAND | wxALL, 2);
+
+  m_findCtrl->Bind(wxEVT_TEXT, [this](wxCommandEvent &) {
+    if (!m_outputCtrl)
+      return;
+    m_outputCtrl->SetHighlight(m_findCtrl->GetValue());
+    FindInOutput(true, true);
+  });
+  m_findCtrl->Bind(wxEVT_TEXT_ENTER, [this](wxCommandEvent &) { FindInOutput(!wxGetKeyState(WXK_SHIFT), false); });
+  m_findCtrl->Bind(wxEVT_SEARCH, [this](wxCommandEvent &) { FindInOutput(true, false); });
+  m_findCtrl->Bind(wxEVT_SEARCH_CANCEL, [this](wxCommandEvent &) { HideFindBar(); });
+
   m_logPage->SetSizer(logSizer);
 
   m_notebook->AddPage(m_logPage, _("Log"), true);
@@ -1060,11 +1112,11 @@ void ArduinoSerialMonitorFrame::CreateControls() {
 
   SetSizer(topSizer);
 
-  // Telemetry parser (always-on) + sinks
+  // Telemetry parser (always-on, feeds values view + plot)
   m_telemetryWatch.Start();
-  m_valuesSink = std::make_unique<ArduinoValuesViewSink>(m_valuesView);
-  m_telemetrySink = std::make_unique<ArduinoFanoutSink>(m_valuesSink.get(), nullptr);
-  m_plotParser = std::make_unique<ArduinoPlotParser>(m_telemetrySink.get());
+  m_plotStage = std::make_unique<ArduinoPlotStage>([this]() {
+    wxQueueEvent(this, new wxThreadEvent(wxEVT_SERIAL_PLOT_READY));
+  });
 
   topSizer->SetSizeHints(this);
 
@@ -1076,7 +1128,9 @@ void ArduinoSerialMonitorFrame::CreateControls() {
 void ArduinoSerialMonitorFrame::StartWorker() {
   StopWorker();
 
-  m_worker = new SerialMonitorWorker(this, m_portName, m_baudRate);
+  // fresh ring - wake-ups of the previous worker may still be queued
+  m_serialRing = std::make_shared<SerialRingBuffer>();
+  m_worker = new SerialMonitorWorker(this, m_serialRing, m_portName, m_baudRate);
   if (m_worker->Run() != wxTHREAD_NO_ERROR) {
     wxLogWarning(_("Failed to start serial monitor thread"));
     delete m_worker;
@@ -1288,22 +1342,22 @@ void ArduinoSerialMonitorFrame::OnPause(wxCommandEvent &WXUNUSED(event)) {
   // 1) Flush text in one shot
   bool didAppendText = false;
   if (m_outputCtrl && !m_pausedBuffer.empty()) {
-    wxString all;
     for (const auto &s : m_pausedBuffer) {
-      all += s;
+      QueueTextAppendUtf8(s.data(), s.size());
     }
 
-    QueueTextAppend(all);
     m_pausedBuffer.clear();
-    m_pausedTextChars = 0;
+    m_pausedTextBytes = 0;
     didAppendText = true;
   }
 
-  // 2) Flush plot batch (independent of text)
-  if (m_plotStarted && m_plotParser && m_plotView && !m_pausedPlotBuffer.empty()) {
-    wxWindowUpdateLocker lock(m_plotView);
-    m_plotParser->ApplyBatch(m_pausedPlotBuffer);
-    m_pausedPlotBuffer.clear();
+  // 2) Take what the plot stage collected meanwhile (independent of text)
+  if (m_plotView) {
+    m_plotView->Freeze();
+  }
+  DrainPlotStage();
+  if (m_plotView) {
+    m_plotView->Thaw();
   }
 
   // 3) Autoscroll
@@ -1330,9 +1384,7 @@ void ArduinoSerialMonitorFrame::OnReset(wxCommandEvent &) {
 
 void ArduinoSerialMonitorFrame::ClearLog() {
   if (m_outputCtrl) {
-    m_outputCtrl->SetReadOnly(false);
-    m_outputCtrl->ClearAll();
-    m_outputCtrl->SetReadOnly(true);
+    m_outputCtrl->Clear();
   }
   if (m_textFlushTimer.IsRunning()) {
     m_textFlushTimer.Stop();
@@ -1340,6 +1392,7 @@ void ArduinoSerialMonitorFrame::ClearLog() {
   m_textFlushScheduled = false;
   m_textPending.clear();
   m_pendingCR = false;
+  m_utf8Tail.clear();
   m_pausedBuffer.clear();
   m_tsAtLineStart = true;
   m_tsPending = false;
@@ -1356,11 +1409,10 @@ void ArduinoSerialMonitorFrame::ClearChart() {
     m_plotView->Clear();
     AlignPlotTimeBase();
   }
-  if (m_plotParser) {
-    m_plotParser->Reset();
+  if (m_plotStage) {
+    m_plotStage->Reset();
   }
-  m_plotLineBuf.clear();
-  m_pausedPlotBuffer.clear();
+  m_plotSeriesNames.clear();
 }
 
 void ArduinoSerialMonitorFrame::OnClear(wxCommandEvent &WXUNUSED(event)) {
@@ -1475,127 +1527,152 @@ void ArduinoSerialMonitorFrame::EnsurePlotterStarted() {
     m_notebook->Layout();
   }
 
-  m_plotSink = std::make_unique<ArduinoPlotViewSink>(m_plotView);
   AlignPlotTimeBase();
 
-  // Attach plot sink to the always-on parser (fanout values + plot).
-  m_telemetrySink = std::make_unique<ArduinoFanoutSink>(m_valuesSink.get(), m_plotSink.get());
-  if (m_plotParser) {
-    m_plotParser->SetSink(m_telemetrySink.get());
-  }
-
   m_plotPage->Thaw();
 }
 
 void ArduinoSerialMonitorFrame::AlignPlotTimeBase() {
-  if (!m_plotView || !m_plotSink)
-    return;
-
-  auto *vsink = dynamic_cast<ArduinoPlotViewSink *>(m_plotSink.get());
-  if (!vsink)
+  if (!m_plotView)
     return;
 
+  // Map external time base (serial monitor clock) to the plot view internal clock.
   const double nowMonMs = (double)m_telemetryWatch.Time();
   const double nowViewMs = (double)m_plotView->GetCurrentTime();
-  vsink->SetTimeOffset(nowViewMs - nowMonMs);
+  m_plotTimeOffsetMs = nowViewMs - nowMonMs;
 }
 
-void ArduinoSerialMonitorFrame::FeedPlotChunkUtf8(const std::string &chunkUtf8, double time) {
-  if (!m_plotParser) {
+void ArduinoSerialMonitorFrame::OnPlotReady(wxThreadEvent &WXUNUSED(event)) {
+  // paused -> samples wait in the stage until resume
+  if (m_paused) {
     return;
   }
+  DrainPlotStage();
+}
 
-  // Hard cap to avoid pathological growth on missing newlines.
-  if (chunkUtf8.size() > 16 * 1024) {
-    // If someone spams a megabyte without newlines, just drop it.
+void ArduinoSerialMonitorFrame::DrainPlotStage() {
+  if (!m_plotStage || !m_plotStage->Take(m_plotBatch)) {
     return;
   }
 
-  m_plotLineBuf += chunkUtf8;
-
-  // Consume complete lines
-  size_t pos = 0;
-  while ((pos = m_plotLineBuf.find('\n')) != std::string::npos) {
-    std::string line = m_plotLineBuf.substr(0, pos);
-    // Normalize any stray CR (shouldn't happen after OnData normalization, but harmless)
-    if (!line.empty() && line.back() == '\r') {
-      line.pop_back();
+  // Names of series first seen in this batch (ids are dense and ascending).
+  if (!m_plotBatch.newSeries.empty() && m_plotBatch.firstNewSeries == m_plotSeriesNames.size()) {
+    for (const auto &name : m_plotBatch.newSeries) {
+      m_plotSeriesNames.push_back(wxString::FromUTF8(name.c_str()));
     }
+  }
 
-    m_plotParser->ApplyLine(line, time);
-    m_plotLineBuf.erase(0, pos + 1);
+  if (m_plotStarted && m_plotView) {
+    m_plotView->AddSamples(m_plotSeriesNames, m_plotBatch.samples, m_plotTimeOffsetMs);
   }
 
-  // Keep tail bounded (in case line never ends)
-  if (m_plotLineBuf.size() > kMaxPausedPlotLines) {
-    m_plotLineBuf.erase(0, m_plotLineBuf.size() - kMaxPausedPlotLines);
+  // Values view shows only the latest value of each series.
+  if (m_valuesView) {
+    const double kNoValue = std::numeric_limits<double>::quiet_NaN();
+    m_plotLastValues.assign(m_plotSeriesNames.size(), kNoValue);
+    for (const auto &smp : m_plotBatch.samples) {
+      if (smp.series < m_plotLastValues.size()) {
+        m_plotLastValues[smp.series] = smp.value;
+      }
+    }
+    for (size_t i = 0; i < m_plotLastValues.size(); i++) {
+      if (!std::isnan(m_plotLastValues[i])) {
+        m_valuesView->AddSample(m_plotSeriesNames[i], m_plotLastValues[i], true);
+      }
+    }
   }
 }
 
-void ArduinoSerialMonitorFrame::BufferPlotChunkUtf8(const std::string &chunkUtf8, double time) {
-  if (!m_plotParser)
-    return;
-
-  m_plotLineBuf += chunkUtf8;
-
-  size_t pos = 0;
-  while ((pos = m_plotLineBuf.find('\n')) != std::string::npos) {
-    std::string line = m_plotLineBuf.substr(0, pos);
+// Single pass over the raw bytes: UTF-8 is copied through, bytes which do not
+// form valid UTF-8 are taken as Latin-1 (nothing disappears) and CR / CRLF become LF.
+// Sequences and CRLF pairs split between chunks are carried over to the next call.
+void ArduinoSerialMonitorFrame::DecodeTextChunk(const std::string &bytes, std::string &out) {
+  out.clear();
+  out.reserve(bytes.size() + 8);
 
-    // Normalize any stray CR
-    if (!line.empty() && line.back() == '\r')
-      line.pop_back();
+  const unsigned char *s = (const unsigned char *)bytes.data();
+  const size_t n = bytes.size();
+  size_t i = 0;
 
-    // Push ONLY complete lines
-    BufferedPlotLine bpl;
-    bpl.line = std::move(line);
-    bpl.time = time;
-    m_pausedPlotBuffer.push_back(std::move(bpl));
+  if (!m_utf8Tail.empty()) {
+    const unsigned char lead = (unsigned char)m_utf8Tail[0];
+    const size_t need = Utf8SequenceLength(lead);
 
-    m_plotLineBuf.erase(0, pos + 1);
-  }
+    while (m_utf8Tail.size() < need && i < n && (s[i] & 0xC0) == 0x80) {
+      m_utf8Tail += (char)s[i++];
+    }
 
-  // Keep tail bounded (same as FeedPlotChunkUtf8)
-  if (m_plotLineBuf.size() > kMaxPausedPlotLines) {
-    m_plotLineBuf.erase(0, m_plotLineBuf.size() - kMaxPausedPlotLines);
+    if (m_utf8Tail.size() == need && IsValidUtf8Sequence((const unsigned char *)m_utf8Tail.data(), need)) {
+      out += m_utf8Tail;
+      m_utf8Tail.clear();
+    } else if (i < n || m_utf8Tail.size() == need) {
+      for (unsigned char b : m_utf8Tail) {
+        AppendLatin1AsUtf8(out, b);
+      }
+      m_utf8Tail.clear();
+    } else {
+      return; // still incomplete, wait for more bytes
+    }
   }
-}
-
-void ArduinoSerialMonitorFrame::NormalizeLineEndings(wxString &chunk) {
-  wxString out;
-  out.reserve(chunk.length() + 1);
-
-  size_t i = 0;
 
   if (m_pendingCR) {
     m_pendingCR = false;
-    if (i < chunk.length() && chunk[i] == '\n') {
+    if (i < n && s[i] == '\n') {
       i++;
     }
     out += '\n';
   }
 
-  for (; i < chunk.length(); ++i) {
-    wxUniChar c = chunk[i];
+  while (i < n) {
+    const size_t run = ScanPlainAscii(s + i, n - i);
+    out.append((const char *)(s + i), run);
+    i += run;
+    if (i >= n)
+      break;
 
-    if (c == '\r') {
-      if (i + 1 < chunk.length()) {
-        if (chunk[i + 1] == '\n') {
-          out += '\n';
-          i++; // skip '\n'
-        } else {
-          out += '\n';
-        }
+    const unsigned char b = s[i];
+
+    if (b == '\r') {
+      if (i + 1 < n) {
+        out += '\n';
+        i += (s[i + 1] == '\n') ? 2 : 1;
       } else {
         m_pendingCR = true;
+        i++;
       }
       continue;
     }
 
-    out += c;
-  }
+    const size_t len = Utf8SequenceLength(b);
+    if (len == 0) {
+      AppendLatin1AsUtf8(out, b);
+      i++;
+      continue;
+    }
 
-  chunk.swap(out);
+    if (i + len > n) {
+      // truncated at the end of the chunk?
+      bool cont = true;
+      for (size_t k = i + 1; k < n; ++k) {
+        cont = cont && ((s[k] & 0xC0) == 0x80);
+      }
+      if (cont) {
+        m_utf8Tail.assign((const char *)(s + i), n - i);
+        break;
+      }
+      AppendLatin1AsUtf8(out, b);
+      i++;
+      continue;
+    }
+
+    if (IsValidUtf8Sequence(s + i, len)) {
+      out.append((const char *)(s + i), len);
+      i += len;
+    } else {
+      AppendLatin1AsUtf8(out, b);
+      i++;
+    }
+  }
 }
 
 void ArduinoSerialMonitorFrame::OnTextFlushTimer(wxTimerEvent &) {
@@ -1603,67 +1680,26 @@ void ArduinoSerialMonitorFrame::OnTextFlushTimer(wxTimerEvent &) {
   FlushPendingText(false);
 }
 
-static int TrimStyledTextCtrl(wxStyledTextCtrl *stc, int maxLines, int maxChars, bool keepAtEnd) {
-  if (!stc)
-    return 0;
-
-  const int firstVisibleBefore = stc->GetFirstVisibleLine();
-
-  bool wasRO = stc->GetReadOnly();
-  if (wasRO)
-    stc->SetReadOnly(false);
-
-  int removedLines = 0;
-
-  // --- 1) limit rows ---
-  const int lineCount = stc->GetLineCount();
-  if (maxLines > 0 && lineCount > maxLines) {
-    removedLines = lineCount - maxLines;
-    const int cutPos = stc->PositionFromLine(removedLines);
-    stc->SetTargetStart(0);
-    stc->SetTargetEnd(cutPos);
-    stc->ReplaceTarget(wxEmptyString);
-  }
-
-  // --- 2) limit bytes ---
-  const int len = stc->GetTextLength();
-  if (maxChars > 0 && len > maxChars) {
-    const int start = len - maxChars;
-    const int cutLine = stc->LineFromPosition(start);
-    const int cutPos = stc->PositionFromLine(cutLine);
-    stc->SetTargetStart(0);
-    stc->SetTargetEnd(cutPos);
-    stc->ReplaceTarget(wxEmptyString);
-
-    removedLines = wxMax(removedLines, cutLine);
-  }
-
-  if (wasRO)
-    stc->SetReadOnly(true);
-
-  if (keepAtEnd) {
-    stc->GotoPos(stc->GetTextLength());
-    stc->EnsureCaretVisible();
-  } else if (removedLines > 0) {
-    const int newFirst = wxMax(0, firstVisibleBefore - removedLines);
-    stc->ScrollToLine(newFirst);
-  }
+void ArduinoSerialMonitorFrame::QueueTextAppend(const wxString &s) {
+  if (!m_outputCtrl || s.empty())
+    return;
 
-  return removedLines;
+  const wxScopedCharBuffer buf = s.ToUTF8();
+  QueueTextAppendUtf8(buf.data(), buf.length());
 }
 
-void ArduinoSerialMonitorFrame::QueueTextAppend(const wxString &s) {
-  if (!m_outputCtrl || s.empty())
+void ArduinoSerialMonitorFrame::QueueTextAppendUtf8(const char *data, size_t len) {
+  if (!m_outputCtrl || len == 0)
     return;
 
-  m_textPending += s;
+  m_textPending.append(data, len);
 
   if (!m_textFlushScheduled) {
     m_textFlushScheduled = true;
     m_textFlushTimer.StartOnce(250);
   }
 
-  if (m_textPending.length() > 256 * 1024) {
+  if (m_textPending.size() > 256 * 1024) {
     FlushPendingText(true);
   }
 }
@@ -1678,147 +1714,167 @@ void ArduinoSerialMonitorFrame::FlushPendingText(bool force) {
     m_textFlushScheduled = false;
   }
 
-  const bool autoscroll = m_autoScroll;
-
-  // Save view/caret state when autoscroll is OFF.
-  int firstLine = 0;
-  int xOffset = 0;
-  int curPos = 0;
-  int anchorPos = 0;
-  int selStart = 0;
-  int selEnd = 0;
-  bool hadSel = false;
+  // The log view keeps its viewport and selection on its own and trims
+  // the oldest lines in whole chunks.
+  m_outputCtrl->AppendUtf8(m_textPending.data(), m_textPending.size());
+  m_textPending.clear();
 
-  if (!autoscroll) {
-    firstLine = m_outputCtrl->GetFirstVisibleLine();
-    xOffset = m_outputCtrl->GetXOffset();
-    curPos = m_outputCtrl->GetCurrentPos();
-    anchorPos = m_outputCtrl->GetAnchor();
-    selStart = m_outputCtrl->GetSelectionStart();
-    selEnd = m_outputCtrl->GetSelectionEnd();
-    hadSel = (selStart != selEnd);
+  if (m_autoScroll) {
+    ScrollOutputToEnd();
   }
+}
 
-  wxString toAppend;
-  toAppend.swap(m_textPending);
-
-  wxWindowUpdateLocker lock(m_outputCtrl);
-
-  m_outputCtrl->SetReadOnly(false);
-  m_programmaticScroll = true;
-
-  // Insert at the end without touching the user's caret/viewport.
-  const int insertPos = m_outputCtrl->GetTextLength();
-  m_outputCtrl->InsertText(insertPos, toAppend);
-
-  m_programmaticScroll = false;
-  m_outputCtrl->SetReadOnly(true);
+void ArduinoSerialMonitorFrame::OnOutputScrolled(wxCommandEvent &event) {
+  event.Skip();
 
-  if (autoscroll) {
-    ScrollOutputToEnd();
+  const bool atBottom = (event.GetInt() != 0);
+  const bool autoOn = m_autoScroll;
 
-    m_programmaticScroll = true;
-    TrimStyledTextCtrl(m_outputCtrl, kMaxOutputLines, kMaxOutputChars, autoscroll /*keepAtEnd*/);
-    m_programmaticScroll = false;
-    return;
+  if (autoOn && !atBottom) {
+    m_autoScroll = false;
+  } else if (!autoOn && atBottom) {
+    m_autoScroll = true;
   }
+}
 
-  // ---- no autoscroll path ----
-  // Restore caret/selection.
-  m_outputCtrl->SetCurrentPos(curPos);
-  m_outputCtrl->SetAnchor(anchorPos);
-  if (hadSel) {
-    m_outputCtrl->SetSelection(selStart, selEnd);
-  } else {
-    m_outputCtrl->SetSelection(curPos, curPos);
+void ArduinoSerialMonitorFrame::ScrollOutputToEnd() {
+  if (m_outputCtrl) {
+    m_outputCtrl->ScrollToEnd();
   }
+}
 
-  // Restore viewport (line & horizontal offset).
-  const int newFirstLine = m_outputCtrl->GetFirstVisibleLine();
-  if (newFirstLine != firstLine) {
-    m_programmaticScroll = true;
-    m_outputCtrl->LineScroll(0, firstLine - newFirstLine);
-    m_programmaticScroll = false;
+void ArduinoSerialMonitorFrame::ShowFindBar() {
+  if (!m_findCtrl)
+    return;
+
+  if (!m_findCtrl->IsShown()) {
+    m_findCtrl->Show();
+    m_logPage->Layout();
   }
 
-  if (m_outputCtrl->GetXOffset() != xOffset) {
-    m_outputCtrl->SetXOffset(xOffset);
+  if (m_outputCtrl && m_outputCtrl->HasSelection()) {
+    wxString sel = m_outputCtrl->GetSelectedText();
+    if (!sel.empty() && sel.Find('\n') == wxNOT_FOUND) {
+      m_findCtrl->ChangeValue(sel);
+      m_outputCtrl->SetHighlight(sel);
+    }
   }
 
-  // --- Safety trim (avoid unbounded growth) ---
-  m_programmaticScroll = true;
-  TrimStyledTextCtrl(m_outputCtrl, kMaxOutputLines, kMaxOutputChars, autoscroll /*keepAtEnd*/);
-  m_programmaticScroll = false;
+  m_findCtrl->SetFocus();
+  m_findCtrl->SelectAll();
 }
 
-bool ArduinoSerialMonitorFrame::IsOutputAtBottom() const {
-  if (!m_outputCtrl)
-    return true;
-
-  const int lastLine = m_outputCtrl->GetLineCount() - 1;
-  if (lastLine < 0)
-    return true;
+void ArduinoSerialMonitorFrame::HideFindBar() {
+  if (!m_findCtrl || !m_findCtrl->IsShown())
+    return;
 
-  const int first = m_outputCtrl->GetFirstVisibleLine();
-  const int onScreen = m_outputCtrl->LinesOnScreen();
-  const int bottomVisible = first + onScreen;
+  m_findCtrl->Hide();
+  m_logPage->Layout();
 
-  return bottomVisible >= lastLine;
+  if (m_outputCtrl) {
+    m_outputCtrl->SetHighlight(wxEmptyString);
+    m_outputCtrl->SetFocus();
+  }
 }
 
-void ArduinoSerialMonitorFrame::OnOutputUpdateUI(wxStyledTextEvent &event) {
-  event.Skip();
-
-  if (!m_outputCtrl)
+void ArduinoSerialMonitorFrame::FindInOutput(bool forward, bool incremental) {
+  if (!m_outputCtrl || !m_findCtrl)
     return;
 
-  if ((event.GetUpdated() & wxSTC_UPDATE_V_SCROLL) == 0)
+  const wxString text = m_findCtrl->GetValue();
+  if (text.empty())
     return;
 
-  if (m_programmaticScroll)
-    return;
+  if (!m_outputCtrl->FindText(text, forward, incremental)) {
+    wxBell();
+  }
+}
 
-  const int first = m_outputCtrl->GetFirstVisibleLine();
-  if (m_lastFirstVisibleLine < 0) {
-    m_lastFirstVisibleLine = first;
-    return;
+void ArduinoSerialMonitorFrame::OnCharHook(wxKeyEvent &event) {
+  const int key = event.GetKeyCode();
+
+  if (m_notebook && m_notebook->GetCurrentPage() == m_logPage) {
+    if (event.ControlDown() && key == 'F') {
+      ShowFindBar();
+      return;
+    }
+    if (key == WXK_F3 && m_findCtrl && !m_findCtrl->GetValue().empty()) {
+      FindInOutput(!event.ShiftDown(), false);
+      return;
+    }
+    if (key == WXK_ESCAPE && m_findCtrl && m_findCtrl->IsShown()) {
+      HideFindBar();
+      return;
+    }
   }
 
-  const bool moved = (first != m_lastFirstVisibleLine);
-  m_lastFirstVisibleLine = first;
+  event.Skip();
+}
 
-  if (!moved) {
+void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &WXUNUSED(event)) {
+  if (!m_serialRing) {
     return;
   }
 
-  const bool atBottom = IsOutputAtBottom();
-  const bool autoOn = m_autoScroll;
+  // Clear first: data written after this point re-arms the wake-up.
+  m_serialRing->ClearWake();
 
-  if (autoOn && !atBottom) {
-    m_autoScroll = false;
-  } else if (!autoOn && atBottom) {
-    m_autoScroll = true;
+  // Bounded amount per wake-up so the UI stays responsive; the rest is
+  // handled by the next wake-up queued behind pending UI events.
+  constexpr size_t kMaxDrainBytes = 256 * 1024;
+
+  m_drainChunk.bytes.clear();
+  m_serialRing->Read(m_drainChunk.bytes, kMaxDrainBytes);
+  m_drainChunk.sec = m_serialRing->GetLastRxTime();
+
+  if (m_serialRing->Size() > 0 && m_serialRing->RequestWake()) {
+    wxQueueEvent(this, new wxThreadEvent(wxEVT_SERIAL_MONITOR_DATA));
+  }
+
+  if (uint64_t dropped = m_serialRing->TakeDroppedBytes()) {
+    wxLogDebug(wxT("SerialMonitor: %llu bytes dropped (GUI too slow)"), (unsigned long long)dropped);
+    if (m_outputCtrl && !m_paused) {
+      QueueTextAppend(wxString::Format(_("\n[%llu bytes dropped]\n"), (unsigned long long)dropped));
+    }
+  }
+
+  if (!m_drainChunk.bytes.empty()) {
+    ProcessChunk(m_drainChunk);
   }
 }
 
-void ArduinoSerialMonitorFrame::ScrollOutputToEnd() {
-  m_programmaticScroll = true;
+void ArduinoSerialMonitorFrame::BufferPausedText(std::string &text) {
+  if (text.size() > kMaxPausedTextBytes) {
+    // keep the newest part, starting at a UTF-8 lead byte
+    size_t cut = text.size() - kMaxPausedTextBytes;
+    while (cut < text.size() && ((unsigned char)text[cut] & 0xC0) == 0x80) {
+      ++cut;
+    }
+    text.erase(0, cut);
+  }
 
-  const int endPos = m_outputCtrl->GetTextLength();
-  m_outputCtrl->SetCurrentPos(endPos);
-  m_outputCtrl->SetAnchor(endPos);
+  const size_t add = text.size();
+  if (m_pausedTextBytes + add > kMaxPausedTextBytes) {
+    const size_t need = (m_pausedTextBytes + add) - kMaxPausedTextBytes;
 
-  // This keeps the view at the end without forcing horizontal repositioning.
-  const int endLine = m_outputCtrl->LineFromPosition(endPos);
-  m_outputCtrl->ScrollToLine(endLine);
-  m_outputCtrl->EnsureCaretVisible();
+    size_t freed = 0;
+    size_t count = 0;
+    while (count < m_pausedBuffer.size() && freed < need) {
+      freed += m_pausedBuffer[count].size();
+      ++count;
+    }
+    if (count > 0) {
+      m_pausedBuffer.erase(m_pausedBuffer.begin(),
+                           m_pausedBuffer.begin() + (ptrdiff_t)count);
+      m_pausedTextBytes -= freed;
+    }
+  }
 
-  m_programmaticScroll = false;
+  m_pausedBuffer.push_back(std::move(text));
+  m_pausedTextBytes += add;
 }
 
-void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
-  const SerialChunkPayload p = event.GetPayload<SerialChunkPayload>();
-
+void ArduinoSerialMonitorFrame::ProcessChunk(const SerialChunkPayload &p) {
   // 0=Text, 1=Hex, 2=Hex+text
   int fmt = 0;
   if (m_outputFormatChoice) {
@@ -1829,22 +1885,13 @@ void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
       fmt = 2;
   }
 
-  wxString textToAppend;
-
   // ---------- TEXT MODE ----------
   if (fmt == 0) {
-    // Decode UTF-8 "best effort". If it collapses, fallback to Latin-1 so nothing disappears.
-    wxString chunk(p.bytes.data(), wxConvUTF8, (int)p.bytes.size());
-    if (chunk.empty() && !p.bytes.empty()) {
-      chunk = BytesToLatin1(p.bytes);
-    }
-
-    NormalizeLineEndings(chunk);
-
-    // plot chunks only make sense in text mode
-    const std::string plotChunkUtf8 = wxToStd(chunk);
+    // Normalized UTF-8 - the same buffer feeds the log and the plot parser.
+    DecodeTextChunk(p.bytes, m_decodedText);
+    const std::string &text = m_decodedText;
 
-    // timestamps: same behavior as before (only at line start)
+    // timestamps: only at line start
     if (m_timestamps) {
       if (m_tsLastPrintedSec != p.sec) {
         m_tsPending = true;
@@ -1854,94 +1901,92 @@ void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
       m_tsPending = false;
     }
 
-    auto flushTimestampIfNeeded = [&]() {
-      if (!m_timestamps)
-        return;
-      if (!m_tsPending)
-        return;
-      if (!m_tsAtLineStart)
-        return;
-
-      wxDateTime t((time_t)m_tsPendingSec);
-      textToAppend += t.Format(wxT("[%H:%M:%S]"));
-      textToAppend += wxT("\n");
+    // Without a pending timestamp the decoded buffer goes to the log as it is.
+    std::string stamped;
+    const std::string *logText = &text;
 
-      m_tsLastPrintedSec = m_tsPendingSec;
-      m_tsPending = false;
-      m_tsAtLineStart = true;
-    };
+    if (!m_tsPending) {
+      if (!text.empty()) {
+        m_tsAtLineStart = (text.back() == '\n');
+      }
+    } else {
+      std::string &textToAppend = stamped;
+      textToAppend.reserve(text.size() + 16);
 
-    flushTimestampIfNeeded();
+      auto flushTimestampIfNeeded = [&]() {
+        if (!m_tsPending || !m_tsAtLineStart)
+          return;
 
-    for (size_t i = 0; i < chunk.length(); ++i) {
-      wxUniChar c = chunk[i];
-      textToAppend += c;
+        wxDateTime t((time_t)m_tsPendingSec);
+        AppendWxAsUtf8(textToAppend, t.Format(wxT("[%H:%M:%S]")));
+        textToAppend += '\n';
 
-      if (c == '\n') {
+        m_tsLastPrintedSec = m_tsPendingSec;
+        m_tsPending = false;
         m_tsAtLineStart = true;
-        flushTimestampIfNeeded();
-      } else {
-        m_tsAtLineStart = false;
-      }
-    }
+      };
 
-    // paused buffering / output / plot (text mode)
-    if (m_paused) {
-      if (textToAppend.length() > kMaxPausedTextChars) {
-        textToAppend = textToAppend.Right(kMaxPausedTextChars);
-      }
+      flushTimestampIfNeeded();
 
-      const size_t add = (size_t)textToAppend.length();
-      if (m_pausedTextChars + add > kMaxPausedTextChars) {
-        const size_t need = (m_pausedTextChars + add) - kMaxPausedTextChars;
+      // copy whole lines, the timestamp can only go in front of one
+      size_t pos = 0;
+      while (pos < text.size()) {
+        const char *nl = (const char *)memchr(text.data() + pos, '\n', text.size() - pos);
+        const size_t end = nl ? (size_t)(nl - text.data()) : text.size();
 
-        size_t freed = 0;
-        size_t count = 0;
-        while (count < m_pausedBuffer.size() && freed < need) {
-          freed += (size_t)m_pausedBuffer[count].length();
-          ++count;
-        }
-        if (count > 0) {
-          m_pausedBuffer.erase(m_pausedBuffer.begin(),
-                               m_pausedBuffer.begin() + (ptrdiff_t)count);
-          m_pausedTextChars -= freed;
+        if (end > pos) {
+          textToAppend.append(text, pos, end - pos);
+          m_tsAtLineStart = false;
         }
+        if (!nl)
+          break;
+
+        textToAppend += '\n';
+        m_tsAtLineStart = true;
+        flushTimestampIfNeeded();
+        pos = end + 1;
       }
 
-      m_pausedBuffer.push_back(textToAppend);
-      m_pausedTextChars += add;
+      logText = &stamped;
+    }
 
-      if (m_plotParser) {
-        const double t_ms = (double)m_telemetryWatch.Time();
-        BufferPlotChunkUtf8(plotChunkUtf8, t_ms);
-      }
-      return;
+    // paused buffering / output / plot (text mode)
+    // plot stage is fed even when paused, the samples are taken on resume
+    if (m_plotStage) {
+      const double t_ms = (double)m_telemetryWatch.Time();
+      m_plotStage->Feed(text, t_ms);
     }
 
-    if (m_outputCtrl) {
-      QueueTextAppend(textToAppend);
+    if (m_paused) {
+      std::string paused = *logText;
+      BufferPausedText(paused);
+      return;
     }
 
-    if (m_plotParser) {
-      const double t_ms = (double)m_telemetryWatch.Time();
-      FeedPlotChunkUtf8(plotChunkUtf8, t_ms);
+    if (m_outputCtrl) {
+      QueueTextAppendUtf8(logText->data(), logText->size());
     }
     return;
   }
 
   // ---------- HEX / HEX+LATIN1 MODE ----------
+  static const char kHexDigits[] = "0123456789ABCDEF";
+
   int wrap = (m_hexWrapBytes > 0) ? m_hexWrapBytes : 16;
   if (wrap < 2)
     wrap = 2;
   if (wrap > 256)
     wrap = 256;
 
+  std::string textToAppend;
+  textToAppend.reserve(p.bytes.size() * ((fmt == 2) ? 5 : 3) + 32);
+
   // Timestamp in hex modes: only when we are at the beginning of the line and the second has changed
   // (i.e. it won't jump to the middle of the line)
   if (m_timestamps && m_hexCol == 0 && m_tsLastPrintedSec != p.sec) {
     wxDateTime t((time_t)p.sec);
-    textToAppend += t.Format(wxT("[%H:%M:%S]"));
-    textToAppend += wxT("\n");
+    AppendWxAsUtf8(textToAppend, t.Format(wxT("[%H:%M:%S]")));
+    textToAppend += '\n';
     m_tsLastPrintedSec = p.sec;
   }
   m_tsPending = false;
@@ -1955,15 +2000,15 @@ void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
       // align the hex part so that the ASCII column fits
       const int missing = wrap - m_hexCol;
       if (missing > 0) {
-        textToAppend += wxString(' ', missing * 3);
+        textToAppend.append((size_t)missing * 3, ' ');
       }
-      textToAppend += wxT(" |");
+      textToAppend += " |";
       textToAppend += m_hexAsciiBuf;
-      textToAppend += wxT("|");
+      textToAppend += '|';
       m_hexAsciiBuf.clear();
     }
 
-    textToAppend += wxT("\n");
+    textToAppend += '\n';
     m_hexCol = 0;
   };
 
@@ -1972,12 +2017,13 @@ void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
       flushHexLine();
     }
 
-    textToAppend += wxString::Format(wxT("%02X "), (unsigned)b);
+    textToAppend += kHexDigits[b >> 4];
+    textToAppend += kHexDigits[b & 0x0F];
+    textToAppend += ' ';
 
     if (fmt == 2) {
       // Latin-1 character to the right column: ASCII + 0xA0..0xFF, otherwise '.'
-      wxChar ch = (IsLatin1Printable(b) ? (wxChar)b : (wxChar)'.');
-      m_hexAsciiBuf += ch;
+      AppendLatin1AsUtf8(m_hexAsciiBuf, IsLatin1Printable(b) ? b : (unsigned char)'.');
     }
 
     m_hexCol++;
@@ -1985,34 +2031,12 @@ void ArduinoSerialMonitorFrame::OnData(wxThreadEvent &event) {
 
   // paused buffering / output (no plot in hex modes)
   if (m_paused) {
-    if (textToAppend.length() > kMaxPausedTextChars) {
-      textToAppend = textToAppend.Right(kMaxPausedTextChars);
-    }
-
-    const size_t add = (size_t)textToAppend.length();
-    if (m_pausedTextChars + add > kMaxPausedTextChars) {
-      const size_t need = (m_pausedTextChars + add) - kMaxPausedTextChars;
-
-      size_t freed = 0;
-      size_t count = 0;
-      while (count < m_pausedBuffer.size() && freed < need) {
-        freed += (size_t)m_pausedBuffer[count].length();
-        ++count;
-      }
-      if (count > 0) {
-        m_pausedBuffer.erase(m_pausedBuffer.begin(),
-                             m_pausedBuffer.begin() + (ptrdiff_t)count);
-        m_pausedTextChars -= freed;
-      }
-    }
-
-    m_pausedBuffer.push_back(textToAppend);
-    m_pausedTextChars += add;
+    BufferPausedText(textToAppend);
     return;
   }
 
   if (m_outputCtrl) {
-    QueueTextAppend(textToAppend);
+    QueueTextAppendUtf8(textToAppend.data(), textToAppend.size());
   }
 }
 
@@ -2038,7 +2062,8 @@ void ArduinoSerialMonitorFrame::Block() {
     m_pauseButton->Refresh();
   }
   m_pausedBuffer.clear();
-  m_pausedTextChars = 0;
+  m_pausedTextBytes = 0;
+  DrainPlotStage();
 
   // disconnect worker -> release port
   StopWorker();
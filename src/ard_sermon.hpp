@@ -18,23 +18,25 @@
 
 #pragma once
 
+#include <atomic>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <vector>
 #include <wx/config.h>
-#include <wx/stc/stc.h>
 #include <wx/stopwatch.h>
 #include <wx/wx.h>
 
+#include "ard_plotpars.hpp"
+
 class wxNotebook;
 class wxPanel;
 class wxBookCtrlEvent;
+class wxSearchCtrl;
 
 class ArduinoPlotView;
-class ArduinoPlotSink;
+class ArduinoSerialLogView;
 class ArduinoValuesView;
-class ArduinoPlotParser;
-struct BufferedPlotLine;
 struct EditorSettings;
 
 enum class SerialOutputFormat {
@@ -48,9 +50,49 @@ struct SerialChunkPayload {
   std::string bytes;
 };
 
+/**
+ * Lock-free single-producer / single-consumer byte ring between the serial
+ * worker (producer) and the GUI (consumer).
+ *
+ * The worker only posts a wake-up event when none is pending, so a chatty
+ * device cannot flood the GUI event queue. When the GUI is not able to keep
+ * up, new bytes are dropped (and counted) instead of growing memory.
+ */
+class SerialRingBuffer {
+public:
+  explicit SerialRingBuffer(size_t capacityPow2 = 1u << 20);
+
+  // producer: returns number of bytes stored, the rest is dropped
+  size_t Write(const char *data, size_t len);
+  void SetLastRxTime(time_t sec) { m_lastRxSec.store(sec, std::memory_order_relaxed); }
+  // producer: true if the caller has to post a wake-up event
+  bool RequestWake() { return !m_wakePending.exchange(true, std::memory_order_acq_rel); }
+
+  // consumer: appends up to maxBytes to out, returns number of bytes read
+  size_t Read(std::string &out, size_t maxBytes);
+  size_t Size() const;
+  time_t GetLastRxTime() const { return m_lastRxSec.load(std::memory_order_relaxed); }
+  uint64_t TakeDroppedBytes() { return m_dropped.exchange(0, std::memory_order_relaxed); }
+  // consumer: must be called before draining
+  void ClearWake() { m_wakePending.store(false, std::memory_order_release); }
+
+private:
+  std::vector<char> m_buf;
+  size_t m_mask;
+
+  // monotonic positions, index = pos & m_mask
+  alignas(64) std::atomic<size_t> m_head{0}; // written by producer
+  alignas(64) std::atomic<size_t> m_tail{0}; // written by consumer
+
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<bool> m_wakePending{false};
+  std::atomic<time_t> m_lastRxSec{0};
+};
+
 class SerialMonitorWorker : public wxThread {
 public:
   SerialMonitorWorker(wxEvtHandler *handler,
+                      std::shared_ptr<SerialRingBuffer> ring,
                       const wxString &port,
                       long baud);
   ~SerialMonitorWorker() override;
@@ -68,8 +110,10 @@ protected:
 private:
   bool OpenPort();
   void ClosePort();
+  void PushData(const char *data, size_t len);
 
   wxEvtHandler *m_handler;
+  std::shared_ptr<SerialRingBuffer> m_ring;
   wxString m_port;
   long m_baud;
 
@@ -108,9 +152,10 @@ private:
   void OnNotebookPageChanged(wxBookCtrlEvent &event);
   void EnsurePlotterStarted();
   void AlignPlotTimeBase();
-  void FeedPlotChunkUtf8(const std::string &chunkUtf8, double time);
-  void BufferPlotChunkUtf8(const std::string &chunkUtf8, double time);
-  void NormalizeLineEndings(wxString &chunk);
+  void OnPlotReady(wxThreadEvent &event);
+  void DrainPlotStage();
+  void DecodeTextChunk(const std::string &bytes, std::string &out);
+  void BufferPausedText(std::string &text);
 
   void CreateControls();
   void StartWorker();
@@ -121,6 +166,7 @@ private:
   void OnInputEnter(wxCommandEvent &event);
   void OnBaudChanged(wxCommandEvent &event);
   void OnData(wxThreadEvent &event);
+  void ProcessChunk(const SerialChunkPayload &p);
   void OnError(wxThreadEvent &event);
 
   void ClearLog();
@@ -133,12 +179,15 @@ private:
 
   void SetupOutputCtrl(const EditorSettings &settings);
 
-  void OnOutputUpdateUI(wxStyledTextEvent &event);
+  void OnOutputScrolled(wxCommandEvent &event);
 
   void ScrollOutputToEnd();
-  bool IsOutputAtBottom() const;
-  bool m_programmaticScroll = false;
-  int m_lastFirstVisibleLine = -1;
+
+  // --- find bar of the log ---
+  void ShowFindBar();
+  void HideFindBar();
+  void FindInOutput(bool forward, bool incremental);
+  void OnCharHook(wxKeyEvent &event);
 
   void OnSysColourChanged(wxSysColourChangedEvent &event);
 
@@ -147,7 +196,8 @@ private:
   wxString m_portName;
   long m_baudRate{115200};
 
-  wxStyledTextCtrl *m_outputCtrl = nullptr;
+  ArduinoSerialLogView *m_outputCtrl = nullptr;
+  wxSearchCtrl *m_findCtrl = nullptr;
   wxTextCtrl *m_inputCtrl = nullptr;
   wxComboBox *m_baudCombo = nullptr;
   wxComboBox *m_lineEndCombo = nullptr;
@@ -161,44 +211,47 @@ private:
   wxPanel *m_plotPage = nullptr;
 
   SerialMonitorWorker *m_worker{nullptr};
+  std::shared_ptr<SerialRingBuffer> m_serialRing;
+  SerialChunkPayload m_drainChunk; // reused between drains
 
   LineEndingMode m_lineEndingMode{LineEndingMode::LF};
 
-  std::vector<wxString> m_pausedBuffer;
-  size_t m_pausedTextChars = 0;
+  std::vector<std::string> m_pausedBuffer; // UTF-8
+  size_t m_pausedTextBytes = 0;
   bool m_isBlocked = false;
   bool m_paused = false;
   bool m_pendingCR = false;
+  std::string m_utf8Tail;    // incomplete UTF-8 sequence at the end of the last chunk
+  std::string m_decodedText; // reused by DecodeTextChunk()
   bool m_autoScroll = true;
   bool m_timestamps = false;
 
   // --- text output throttling ---
   wxTimer m_textFlushTimer;
   bool m_textFlushScheduled = false;
-  wxString m_textPending;
+  std::string m_textPending; // UTF-8
   void QueueTextAppend(const wxString &s);
+  void QueueTextAppendUtf8(const char *data, size_t len);
   void FlushPendingText(bool force = false);
   void OnTextFlushTimer(wxTimerEvent &);
 
   // plot / telemetry
   ArduinoPlotView *m_plotView = nullptr;
-  std::unique_ptr<ArduinoPlotSink> m_plotSink;
-
   ArduinoValuesView *m_valuesView = nullptr;
-  std::unique_ptr<ArduinoPlotSink> m_valuesSink;
 
-  std::unique_ptr<ArduinoPlotSink> m_telemetrySink;
-  std::unique_ptr<ArduinoPlotParser> m_plotParser;
+  // Lines are parsed on the stage thread, the GUI only takes the samples.
+  // While paused nothing is taken, the stage keeps the newest samples.
+  std::unique_ptr<ArduinoPlotStage> m_plotStage;
+  PlotSampleBatch m_plotBatch;             // reused between drains
+  std::vector<wxString> m_plotSeriesNames; // stage series id -> name
+  std::vector<double> m_plotLastValues;    // reused between drains
+  double m_plotTimeOffsetMs = 0.0;         // monitor clock -> plot view clock
 
   bool m_plotStarted = false;
   bool m_displayValues = false;
 
   wxStopWatch m_telemetryWatch;
 
-  // buffering for plot line parsing
-  std::string m_plotLineBuf;
-  std::vector<BufferedPlotLine> m_pausedPlotBuffer;
-
   // --- timestamps state ---
   bool m_tsAtLineStart = true;
   bool m_tsPending = false;
@@ -211,6 +264,6 @@ private:
 
   // hex layout
   int m_hexWrapBytes = 16;
-  wxString m_hexAsciiBuf;
+  std::string m_hexAsciiBuf; // UTF-8
   int m_hexCol = 0;
 };
@@ -508,6 +508,7 @@ void ClangSettings::Load(wxConfigBase *cfg) {
 
   ConfigReadInt(cfg, wxT("Clang/AutocompletionDelay"), autocompletionDelay, 1500);
   ConfigReadInt(cfg, wxT("Clang/ResolveDiagnosticsDelay"), resolveDiagnosticsDelay, 5000);
+  ConfigReadInt(cfg, wxT("Clang/ProjectDiagnosticsThreads"), projectDiagnosticsThreads, 0);
   ConfigReadBool(cfg, wxT("Clang/ResolveOnlyAfterSave"), resolveDiagOnlyAfterSave, true);
   ConfigReadBool(cfg, wxT("Clang/DisplayDiagnosticsOnlyFromSketch"), displayDiagnosticsOnlyFromSketch, true);
   ConfigReadString(cfg, wxT("Clang/ExtSourceOpenCommand"), extSourceOpenCommand, wxEmptyString);
@@ -533,6 +534,7 @@ void ClangSettings::Save(wxConfigBase *cfg) const {
   cfg->Write(wxT("Clang/WarningMode"), (long)warningMode);
   cfg->Write(wxT("Clang/AutocompletionDelay"), (long)autocompletionDelay);
   cfg->Write(wxT("Clang/ResolveDiagnosticsDelay"), (long)resolveDiagnosticsDelay);
+  cfg->Write(wxT("Clang/ProjectDiagnosticsThreads"), (long)projectDiagnosticsThreads);
   cfg->Write(wxT("Clang/ResolveOnlyAfterSave"), resolveDiagOnlyAfterSave);
   cfg->Write(wxT("Clang/DisplayDiagnosticsOnlyFromSketch"), displayDiagnosticsOnlyFromSketch);
   cfg->Write(wxT("Clang/ExtSourceOpenCommand"), extSourceOpenCommand);
@@ -1735,6 +1737,16 @@ ArduinoEditorSettingsDialog::ArduinoEditorSettingsDialog(wxWindow *parent,
   m_clangDiagDelay->SetValue((int)m_clangSettings.resolveDiagnosticsDelay);
   behaviorGrid->Add(m_clangDiagDelay, 1, wxEXPAND);
 
+  // --- Project diagnostics threads ---
+  behaviorGrid->Add(new wxStaticText(clangPage, wxID_ANY, _("Project diagnostics threads (0 = auto):")),
+                    0, wxALIGN_CENTER_VERTICAL);
+
+  m_clangDiagThreads = new wxSpinCtrl(clangPage, wxID_ANY);
+  m_clangDiagThreads->SetRange(0, 64);
+  m_clangDiagThreads->SetValue((int)m_clangSettings.projectDiagnosticsThreads);
+  m_clangDiagThreads->SetToolTip(_("Number of source files parsed in parallel when diagnostics are evaluated for the whole project."));
+  behaviorGrid->Add(m_clangDiagThreads, 1, wxEXPAND);
+
   behaviorBox->Add(behaviorGrid, 1, wxALL | wxEXPAND, 5);
   clangPageSizer->Add(behaviorBox, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 10);
 
@@ -2299,6 +2311,13 @@ ClangSettings ArduinoEditorSettingsDialog::GetClangSettings() const {
     s.resolveDiagnosticsDelay = (unsigned)v;
   }
 
+  if (m_clangDiagThreads) {
+    int v = m_clangDiagThreads->GetValue();
+    if (v < 0)
+      v = 0;
+    s.projectDiagnosticsThreads = v;
+  }
+
   if (m_resolveAfterSave) {
     s.resolveDiagOnlyAfterSave = m_resolveAfterSave->GetValue();
   }
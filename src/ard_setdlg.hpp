@@ -134,6 +134,7 @@ struct ClangSettings {
   ClangWarningMode warningMode = warningDefault;
   int autocompletionDelay = 1500;     // minimum 250ms, maximum unlimited
   int resolveDiagnosticsDelay = 5000; // minimum 1000ms, maximum unlimited
+  int projectDiagnosticsThreads = 0;  // parallel TU parsing for whole-project diagnostics, 0 = auto
   bool resolveDiagOnlyAfterSave = true;
   bool displayDiagnosticsOnlyFromSketch = true; // display errors/warnings only from sketch files
 
@@ -347,6 +348,7 @@ private:
   wxButton *m_cliPathBrowse = nullptr;
   wxSpinCtrl *m_clangAutoDelay = nullptr;
   wxSpinCtrl *m_clangDiagDelay = nullptr;
+  wxSpinCtrl *m_clangDiagThreads = nullptr;
 
   // General
   wxChoice *m_languageChoice = nullptr;
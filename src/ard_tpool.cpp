@@ -0,0 +1,128 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_tpool.hpp"
+#include <algorithm>
+
+namespace {
+thread_local int g_poolWorkerIndex = -1;
+} // namespace
+
+unsigned ArduinoThreadPool::DefaultThreadCount() {
+  unsigned hw = std::thread::hardware_concurrency();
+  if (hw == 0) {
+    hw = 2;
+  }
+
+  // Each parsed TU can take hundreds of MB, so do not go wild on big machines.
+  return std::clamp(hw, 1u, 8u);
+}
+
+int ArduinoThreadPool::CurrentWorkerIndex() {
+  return g_poolWorkerIndex;
+}
+
+ArduinoThreadPool::ArduinoThreadPool(unsigned threadCount) {
+  if (threadCount == 0) {
+    threadCount = DefaultThreadCount();
+  }
+
+  m_workers.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; ++i) {
+    m_workers.emplace_back([this, i]() { WorkerLoop((int)i); });
+  }
+}
+
+ArduinoThreadPool::~ArduinoThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stopping = true;
+  }
+  m_cv.notify_all();
+
+  for (auto &t : m_workers) {
+    if (t.joinable()) {
+      t.join();
+    }
+  }
+}
+
+void ArduinoThreadPool::Submit(std::function<void()> job) {
+  if (!job) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_queue.push_back(std::move(job));
+  }
+  m_cv.notify_one();
+}
+
+void ArduinoThreadPool::RunAndWait(std::vector<std::function<void()>> jobs) {
+  if (jobs.empty()) {
+    return;
+  }
+
+  struct Latch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t remaining = 0;
+  } latch;
+
+  latch.remaining = jobs.size();
+
+  for (auto &job : jobs) {
+    Submit([&latch, job = std::move(job)]() {
+      if (job) {
+        job();
+      }
+
+      std::lock_guard<std::mutex> lk(latch.mutex);
+      if (--latch.remaining == 0) {
+        latch.cv.notify_all();
+      }
+    });
+  }
+
+  std::unique_lock<std::mutex> lk(latch.mutex);
+  latch.cv.wait(lk, [&latch]() { return latch.remaining == 0; });
+}
+
+void ArduinoThreadPool::WorkerLoop(int workerIndex) {
+  g_poolWorkerIndex = workerIndex;
+
+  for (;;) {
+    std::function<void()> job;
+
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_cv.wait(lk, [this]() { return m_stopping || !m_queue.empty(); });
+
+      // drain the queue even when stopping - RunAndWait() callers rely on it
+      if (m_queue.empty()) {
+        return;
+      }
+
+      job = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+
+    job();
+  }
+}
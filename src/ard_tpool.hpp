@@ -0,0 +1,68 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads.
+ *
+ * Used for CPU heavy work which can be split into independent jobs
+ * (e.g. parsing of project translation units). Jobs are executed in FIFO order.
+ * Pending jobs are still executed when the pool is being destroyed, so
+ * RunAndWait() callers never hang.
+ */
+class ArduinoThreadPool {
+public:
+  // threadCount == 0 -> derived from hardware concurrency
+  explicit ArduinoThreadPool(unsigned threadCount = 0);
+  ~ArduinoThreadPool();
+
+  ArduinoThreadPool(const ArduinoThreadPool &) = delete;
+  ArduinoThreadPool &operator=(const ArduinoThreadPool &) = delete;
+
+  unsigned GetThreadCount() const { return (unsigned)m_workers.size(); }
+
+  // Queues a job; returns immediately.
+  void Submit(std::function<void()> job);
+
+  // Queues all jobs and blocks until every one of them has finished.
+  // Must not be called from a pool worker (it would wait for itself).
+  void RunAndWait(std::vector<std::function<void()>> jobs);
+
+  static unsigned DefaultThreadCount();
+
+  // Index (0..count-1) of the pool worker running the calling thread, -1 otherwise.
+  static int CurrentWorkerIndex();
+
+private:
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::function<void()>> m_queue;
+  bool m_stopping = false;
+
+  void WorkerLoop(int workerIndex);
+};
@@ -18,6 +18,8 @@
 
 #include "ard_update.hpp"
 
+#include "ard_httppool.hpp"
+#include "ard_sched.hpp"
 #include "utils.hpp"
 
 #include <wx/app.h> // wxTheApp
@@ -97,12 +99,10 @@ static bool CurlHttpGet(const wxString &url,
                         long &outHttpStatus,
                         wxString &outBodyUtf8,
                         wxString &outError) {
-  static std::once_flag once;
-  std::call_once(once, []() {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-  });
-
-  CURL *curl = curl_easy_init();
+  // keep the pool alive for the whole request (also shares DNS/TLS with AiClient)
+  std::shared_ptr<ArduinoHttpPool> pool = ArduinoHttpPool::Shared();
+  ArduinoHttpPool::Handle handle = pool->Acquire();
+  CURL *curl = handle.get();
   if (!curl) {
     outError = wxT("curl_easy_init failed");
     return false;
@@ -141,7 +141,6 @@ static bool CurlHttpGet(const wxString &url,
 
   if (hdrs)
     curl_slist_free_all(hdrs);
-  curl_easy_cleanup(curl);
 
   if (res != CURLE_OK) {
     outError = wxString::FromUTF8(curl_easy_strerror(res));
@@ -465,7 +464,7 @@ void ArduinoEditorUpdateDialog::CheckAndShowIfNeeded(wxWindow *parent, wxConfigB
   wxConfigBase *cfgPtr = &cfg;
 
   // Do network + parsing off the UI thread
-  std::thread([apiUrl, parentPtr, cfgPtr, nowUtc, force]() {
+  ArduinoTaskScheduler::Get().Submit(TaskLane::Io, [apiUrl, parentPtr, cfgPtr, nowUtc, force]() {
     AeReleaseInfo rel;
     wxString err;
     wxString body;
@@ -547,7 +546,7 @@ void ArduinoEditorUpdateDialog::CheckAndShowIfNeeded(wxWindow *parent, wxConfigB
       ArduinoEditorUpdateDialog dlg(parentPtr, *cfgPtr, relLocal);
       dlg.ShowModal();
     });
-  }).detach();
+  });
 }
 
 // ---------------------------------------------------------
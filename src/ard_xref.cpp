@@ -0,0 +1,223 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ard_xref.hpp"
+#include "utils.hpp"
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+// bump when the meaning of stored data changes
+static constexpr int XREF_INDEX_VERSION = 1;
+
+ArduinoXrefIndex::ArduinoXrefIndex(std::string sketchPath)
+    : m_sketchPath(std::move(sketchPath)) {
+}
+
+std::string ArduinoXrefIndex::GetIndexPath() const {
+  return (fs::path(m_sketchPath) / ".ardedit" / "xref.json").string();
+}
+
+// Files inside the sketch are stored relative, so the index survives moving the sketch.
+std::string ArduinoXrefIndex::ToStoredPath(const std::string &path) const {
+  if (!m_sketchPath.empty() && path.size() > m_sketchPath.size() && hasPrefix(path, m_sketchPath.c_str())) {
+    char sep = path[m_sketchPath.size()];
+    if (sep == '/' || sep == '\\') {
+      return path.substr(m_sketchPath.size() + 1);
+    }
+  }
+  return path;
+}
+
+std::string ArduinoXrefIndex::FromStoredPath(const std::string &path) const {
+  fs::path p(path);
+  if (p.is_absolute()) {
+    return path;
+  }
+  return (fs::path(m_sketchPath) / p).string();
+}
+
+bool ArduinoXrefIndex::IsUpToDate(const std::string &fileKey, std::size_t signature) const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto it = m_files.find(fileKey);
+  return it != m_files.end() && it->second.signature == signature;
+}
+
+void ArduinoXrefIndex::UpdateFile(const std::string &fileKey, std::size_t signature, XrefMap refs) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  FileEntry &e = m_files[fileKey];
+  e.signature = signature;
+  e.refs = std::move(refs);
+  m_dirty = true;
+}
+
+void ArduinoXrefIndex::RetainFiles(const std::unordered_set<std::string> &fileKeys) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (auto it = m_files.begin(); it != m_files.end();) {
+    if (fileKeys.find(it->first) == fileKeys.end()) {
+      it = m_files.erase(it);
+      m_dirty = true;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ArduinoXrefIndex::FindOccurrences(const std::string &usr, const std::string &skipFileKey, std::vector<JumpTarget> &out) const {
+  if (usr.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (const auto &kv : m_files) {
+    if (kv.first == skipFileKey)
+      continue;
+
+    auto it = kv.second.refs.find(usr);
+    if (it == kv.second.refs.end())
+      continue;
+
+    out.insert(out.end(), it->second.begin(), it->second.end());
+  }
+}
+
+void ArduinoXrefIndex::Load() {
+  ScopeTimer t("XREF: Load()");
+
+  const std::string path = GetIndexPath();
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return;
+  }
+
+  std::unordered_map<std::string, FileEntry> files;
+
+  try {
+    json j = json::parse(in);
+    if (j.value("version", 0) != XREF_INDEX_VERSION) {
+      APP_DEBUG_LOG("XREF: %s has different version, ignored", path.c_str());
+      return;
+    }
+
+    for (auto &[storedKey, jf] : j["files"].items()) {
+      FileEntry e;
+      e.signature = jf.value("sig", (std::size_t)0);
+
+      std::vector<std::string> paths;
+      for (const auto &p : jf["paths"]) {
+        paths.push_back(FromStoredPath(p.get<std::string>()));
+      }
+
+      for (auto &[usr, jocc] : jf["refs"].items()) {
+        auto &vec = e.refs[usr];
+        vec.reserve(jocc.size());
+        for (const auto &o : jocc) {
+          size_t pi = o.at(0).get<size_t>();
+          if (pi >= paths.size())
+            continue;
+
+          JumpTarget jt;
+          jt.file = paths[pi];
+          jt.line = o.at(1).get<int>();
+          jt.column = o.at(2).get<int>();
+          vec.push_back(std::move(jt));
+        }
+      }
+
+      files[FromStoredPath(storedKey)] = std::move(e);
+    }
+  } catch (const std::exception &ex) {
+    APP_DEBUG_LOG("XREF: cannot load %s: %s", path.c_str(), ex.what());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_files = std::move(files);
+  m_dirty = false;
+
+  APP_DEBUG_LOG("XREF: loaded %zu files from %s", m_files.size(), path.c_str());
+}
+
+void ArduinoXrefIndex::SaveIfDirty() {
+  json j;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (!m_dirty) {
+      return;
+    }
+
+    ScopeTimer t("XREF: SaveIfDirty()");
+
+    j["version"] = XREF_INDEX_VERSION;
+    json &jfiles = j["files"];
+    jfiles = json::object();
+
+    for (const auto &kv : m_files) {
+      // occurrence file names are mostly the same -> index into "paths"
+      std::vector<std::string> paths;
+      std::unordered_map<std::string, size_t> pathIndex;
+
+      json jrefs = json::object();
+      for (const auto &rk : kv.second.refs) {
+        json jocc = json::array();
+        for (const auto &jt : rk.second) {
+          auto pit = pathIndex.find(jt.file);
+          if (pit == pathIndex.end()) {
+            pit = pathIndex.emplace(jt.file, paths.size()).first;
+            paths.push_back(ToStoredPath(jt.file));
+          }
+          jocc.push_back(json::array({pit->second, jt.line, jt.column}));
+        }
+        jrefs[rk.first] = std::move(jocc);
+      }
+
+      json jf;
+      jf["sig"] = kv.second.signature;
+      jf["paths"] = paths;
+      jf["refs"] = std::move(jrefs);
+      jfiles[ToStoredPath(kv.first)] = std::move(jf);
+    }
+
+    m_dirty = false;
+  }
+
+  const std::string path = GetIndexPath();
+  const std::string tmpPath = path + ".tmp";
+
+  std::error_code ec;
+  fs::create_directories(fs::path(path).parent_path(), ec);
+
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      APP_DEBUG_LOG("XREF: cannot write %s", tmpPath.c_str());
+      return;
+    }
+    out << j.dump();
+  }
+
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+    APP_DEBUG_LOG("XREF: cannot replace %s: %s", path.c_str(), ec.message().c_str());
+    fs::remove(tmpPath, ec);
+  }
+}
@@ -0,0 +1,74 @@
+/*
+ * Arduino Editor
+ * Copyright (c) 2025 Pavel Petržela
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "ard_cc.hpp"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// USR of the referenced symbol -> occurrences (declarations, definitions, references)
+using XrefMap = std::unordered_map<std::string, std::vector<JumpTarget>>;
+
+/**
+ * Persistent cross-reference index of one sketch.
+ *
+ * Every indexed source file keeps the occurrences found in its TU together
+ * with a signature of the code the TU was built from. Rename / find usages
+ * then only walk files whose signature changed. The index is stored in
+ * <sketch>/.ardedit/xref.json, so it survives editor restarts.
+ *
+ * All methods are thread safe.
+ */
+class ArduinoXrefIndex {
+public:
+  explicit ArduinoXrefIndex(std::string sketchPath);
+
+  const std::string &GetSketchPath() const { return m_sketchPath; }
+
+  bool IsUpToDate(const std::string &fileKey, std::size_t signature) const;
+  void UpdateFile(const std::string &fileKey, std::size_t signature, XrefMap refs);
+
+  // Drops files which are no longer part of the sketch.
+  void RetainFiles(const std::unordered_set<std::string> &fileKeys);
+
+  // Occurrences of usr in all indexed files except skipFileKey.
+  void FindOccurrences(const std::string &usr, const std::string &skipFileKey, std::vector<JumpTarget> &out) const;
+
+  void Load();
+  void SaveIfDirty();
+
+private:
+  struct FileEntry {
+    std::size_t signature = 0;
+    XrefMap refs;
+  };
+
+  std::string GetIndexPath() const;
+  std::string ToStoredPath(const std::string &path) const;
+  std::string FromStoredPath(const std::string &path) const;
+
+  mutable std::mutex m_mutex;
+  std::string m_sketchPath;
+  std::unordered_map<std::string, FileEntry> m_files;
+  bool m_dirty = false;
+};
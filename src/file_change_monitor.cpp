@@ -17,7 +17,18 @@
  */
 
 #include "file_change_monitor.hpp"
+#include "utils.hpp"
+#include <chrono>
 #include <filesystem>
+#include <unordered_set>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -29,47 +40,182 @@ static uint64_t ToUint64(const fs::file_time_type::duration &value) {
   return static_cast<uint64_t>(value.count());
 }
 
+#ifdef __linux__
+
+// quiet time after the last event / upper bound for a busy writer
+constexpr auto kDebounce = std::chrono::milliseconds(150);
+constexpr auto kMaxDelay = std::chrono::milliseconds(1000);
+
+constexpr uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF |
+                                IN_ONLYDIR | IN_EXCL_UNLINK;
+
+static bool IsInside(const std::string &child, const std::string &dir) {
+  if (child.size() <= dir.size() || child.compare(0, dir.size(), dir) != 0) {
+    return false;
+  }
+  return dir.back() == '/' || child[dir.size()] == '/';
+}
+
+static std::string ParentOf(const std::string &path) {
+  return fs::u8path(path).parent_path().u8string();
+}
+
+// Directory watches of one inotify instance, owned by the backend thread.
+class InotifyWatchSet {
+public:
+  explicit InotifyWatchSet(int fd) : m_fd(fd) {}
+
+  const std::string *PathOf(int wd) const {
+    auto it = m_paths.find(wd);
+    return it == m_paths.end() ? nullptr : &it->second;
+  }
+
+  void Forget(int wd) {
+    auto it = m_paths.find(wd);
+    if (it == m_paths.end()) {
+      return;
+    }
+    m_wds.erase(it->second);
+    m_paths.erase(it);
+  }
+
+  bool IsWatched(const std::string &dir) const { return m_wds.find(dir) != m_wds.end(); }
+
+  // Drops watches which are not wanted anymore and adds the missing ones.
+  void Sync(const std::unordered_set<std::string> &wanted) {
+    for (auto it = m_wds.begin(); it != m_wds.end();) {
+      if (wanted.find(it->first) != wanted.end()) {
+        ++it;
+        continue;
+      }
+      inotify_rm_watch(m_fd, it->second);
+      m_paths.erase(it->second);
+      it = m_wds.erase(it);
+    }
+
+    for (const auto &dir : wanted) {
+      if (IsWatched(dir)) {
+        continue;
+      }
+
+      int wd = inotify_add_watch(m_fd, dir.c_str(), kWatchMask);
+      if (wd < 0) {
+        if (errno != ENOENT) {
+          APP_DEBUG_LOG("FCM: inotify_add_watch(%s) failed: %d", dir.c_str(), errno);
+        }
+        continue;
+      }
+
+      // the same directory reachable by two paths shares the descriptor
+      auto old = m_paths.find(wd);
+      if (old != m_paths.end()) {
+        m_wds.erase(old->second);
+      }
+      m_paths[wd] = dir;
+      m_wds[dir] = wd;
+    }
+  }
+
+private:
+  int m_fd;
+  std::unordered_map<int, std::string> m_paths;
+  std::unordered_map<std::string, int> m_wds;
+};
+
+#endif
+
 } // namespace
 
 FileChangeMonitor::FileChangeMonitor(wxEvtHandler *owner, int pollIntervalMs)
     : m_owner(owner), m_timer(this) {
   Bind(wxEVT_TIMER, &FileChangeMonitor::OnTimer, this, m_timer.GetId());
   m_timer.Start(pollIntervalMs);
+
+#ifdef __linux__
+  if (!StartBackend()) {
+    APP_DEBUG_LOG("FCM: inotify not available, using polling");
+  }
+#endif
 }
 
-void FileChangeMonitor::WatchFile(const std::string &path) {
-  Entry entry;
-  entry.path = path;
-  entry.isDirectory = false;
-  entry.recursive = false;
-  entry.snapshot = CaptureSnapshot(entry);
-  m_entries[NormalizeKey(path)] = entry;
+FileChangeMonitor::~FileChangeMonitor() {
+  m_timer.Stop();
+#ifdef __linux__
+  StopBackend();
+#endif
 }
 
-void FileChangeMonitor::WatchDirectory(const std::string &path, bool recursive) {
+void FileChangeMonitor::AddEntry(const std::string &path, bool isDirectory, bool recursive) {
   Entry entry;
   entry.path = path;
-  entry.isDirectory = true;
+  entry.isDirectory = isDirectory;
   entry.recursive = recursive;
   entry.snapshot = CaptureSnapshot(entry);
-  m_entries[NormalizeKey(path)] = entry;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry.generation = ++m_nextGeneration;
+    m_entries[NormalizeKey(path)] = entry;
+  }
+
+#ifdef __linux__
+  RequestResync();
+#endif
+}
+
+void FileChangeMonitor::WatchFile(const std::string &path) {
+  AddEntry(path, /*isDirectory=*/false, /*recursive=*/false);
+}
+
+void FileChangeMonitor::WatchDirectory(const std::string &path, bool recursive) {
+  AddEntry(path, /*isDirectory=*/true, recursive);
 }
 
 void FileChangeMonitor::Unwatch(const std::string &path) {
-  m_entries.erase(NormalizeKey(path));
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(NormalizeKey(path));
+  }
+
+#ifdef __linux__
+  RequestResync();
+#endif
 }
 
 void FileChangeMonitor::Clear() {
-  m_entries.clear();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+  }
+
+#ifdef __linux__
+  RequestResync();
+#endif
 }
 
 void FileChangeMonitor::SyncPath(const std::string &path) {
-  auto it = m_entries.find(NormalizeKey(path));
-  if (it == m_entries.end()) {
-    return;
+  const std::string key = NormalizeKey(path);
+
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      return;
+    }
+    entry = it->second;
   }
 
-  it->second.snapshot = CaptureSnapshot(it->second);
+  const Snapshot snapshot = CaptureSnapshot(entry);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(key);
+  if (it != m_entries.end()) {
+    // a check which is already running must not report the old state
+    it->second.snapshot = snapshot;
+    it->second.generation = ++m_nextGeneration;
+  }
 }
 
 FileChangeMonitor::Snapshot FileChangeMonitor::CaptureSnapshot(const Entry &entry) {
@@ -167,18 +313,39 @@ void FileChangeMonitor::PostChange(const Entry &entry, FileChangeKind kind) {
     return;
   }
 
-  wxThreadEvent evt(EVT_FILE_MONITOR_CHANGED);
-  evt.SetString(wxString::FromUTF8(entry.path));
-  evt.SetInt(static_cast<int>(kind));
-  evt.SetExtraLong(entry.isDirectory ? 1 : 0);
-  wxPostEvent(m_owner, evt);
+  // called from the GUI timer as well as from the backend thread
+  auto *evt = new wxThreadEvent(EVT_FILE_MONITOR_CHANGED);
+  evt->SetString(wxString::FromUTF8(entry.path));
+  evt->SetInt(static_cast<int>(kind));
+  evt->SetExtraLong(entry.isDirectory ? 1 : 0);
+  wxQueueEvent(m_owner, evt);
 }
 
-void FileChangeMonitor::OnTimer(wxTimerEvent &event) {
-  for (auto &item : m_entries) {
-    Entry &entry = item.second;
-    const Snapshot current = CaptureSnapshot(entry);
+size_t FileChangeMonitor::CheckEntries(const std::vector<std::string> &keys) {
+  std::vector<std::pair<std::string, Entry>> pending;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    pending.reserve(keys.size());
+    for (const auto &key : keys) {
+      auto it = m_entries.find(key);
+      if (it != m_entries.end()) {
+        pending.emplace_back(key, it->second);
+      }
+    }
+  }
+
+  std::vector<std::pair<Entry, FileChangeKind>> changes;
 
+  for (const auto &item : pending) {
+    const Snapshot current = CaptureSnapshot(item.second);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(item.first);
+    if (it == m_entries.end() || it->second.generation != item.second.generation) {
+      continue; // unwatched, re-synced or checked meanwhile
+    }
+
+    Entry &entry = it->second;
     if (current.exists == entry.snapshot.exists &&
         current.isDirectory == entry.snapshot.isDirectory &&
         current.signature == entry.snapshot.signature) {
@@ -193,8 +360,284 @@ void FileChangeMonitor::OnTimer(wxTimerEvent &event) {
     }
 
     entry.snapshot = current;
-    PostChange(entry, kind);
+    entry.generation = ++m_nextGeneration;
+    changes.emplace_back(entry, kind);
+  }
+
+  for (const auto &change : changes) {
+    PostChange(change.first, change.second);
+  }
+
+  return changes.size();
+}
+
+void FileChangeMonitor::OnTimer(wxTimerEvent &event) {
+  std::vector<std::string> keys;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &item : m_entries) {
+      if (item.second.polling) {
+        keys.push_back(item.first);
+      }
+    }
+  }
+
+  if (!keys.empty() && CheckEntries(keys) > 0) {
+#ifdef __linux__
+    // e.g. a missing directory appeared, it may be watchable now
+    RequestResync();
+#endif
   }
 
   event.Skip();
 }
+
+#ifdef __linux__
+
+bool FileChangeMonitor::StartBackend() {
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd < 0) {
+    return false;
+  }
+
+  m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_wakeFd < 0) {
+    close(m_inotifyFd);
+    m_inotifyFd = -1;
+    return false;
+  }
+
+  m_thread = std::thread(&FileChangeMonitor::BackendLoop, this);
+  return true;
+}
+
+void FileChangeMonitor::StopBackend() {
+  if (!m_thread.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  RequestResync();
+  m_thread.join();
+
+  close(m_wakeFd);
+  close(m_inotifyFd);
+  m_wakeFd = -1;
+  m_inotifyFd = -1;
+}
+
+void FileChangeMonitor::RequestResync() {
+  if (m_wakeFd < 0) {
+    return;
+  }
+
+  const uint64_t one = 1;
+  ssize_t rc = write(m_wakeFd, &one, sizeof(one));
+  (void)rc;
+}
+
+void FileChangeMonitor::BackendLoop() {
+  InotifyWatchSet watches(m_inotifyFd);
+
+  // Watches the directories of all entries (a file is watched through its
+  // parent directory). Entries which cannot be watched fall back to polling.
+  auto syncWatches = [&]() {
+    struct Root {
+      std::string key;
+      bool recursive = false;
+      std::vector<std::string> dirs;
+    };
+
+    std::vector<Root> roots;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const auto &item : m_entries) {
+        const Entry &entry = item.second;
+        Root root;
+        root.key = item.first;
+        root.recursive = entry.isDirectory && entry.recursive;
+        root.dirs.push_back(entry.isDirectory ? item.first : ParentOf(item.first));
+        roots.push_back(std::move(root));
+      }
+    }
+
+    std::unordered_set<std::string> wanted;
+    for (auto &root : roots) {
+      if (root.recursive) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(fs::u8path(root.dirs.front()), fs::directory_options::skip_permission_denied, ec);
+        fs::recursive_directory_iterator end;
+        for (; it != end && !ec; it.increment(ec)) {
+          std::error_code itemEc;
+          if (it->is_directory(itemEc) && !it->is_symlink(itemEc)) {
+            root.dirs.push_back(it->path().u8string());
+          }
+        }
+      }
+      wanted.insert(root.dirs.begin(), root.dirs.end());
+    }
+
+    watches.Sync(wanted);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &root : roots) {
+      auto it = m_entries.find(root.key);
+      if (it == m_entries.end()) {
+        continue;
+      }
+
+      bool watched = true;
+      for (const auto &dir : root.dirs) {
+        if (!watches.IsWatched(dir)) {
+          watched = false;
+          break;
+        }
+      }
+      it->second.polling = !watched;
+    }
+  };
+
+  std::unordered_set<std::string> changedPaths;
+  bool overflow = false;
+  bool resync = true;
+  bool pending = false;
+  Clock::time_point firstEvent;
+  Clock::time_point lastEvent;
+
+  auto markChanged = [&](std::string path) {
+    const auto now = Clock::now();
+    if (!pending) {
+      pending = true;
+      firstEvent = now;
+    }
+    lastEvent = now;
+    if (!path.empty()) {
+      changedPaths.insert(std::move(path));
+    }
+  };
+
+  // Maps the coalesced paths to the watched entries and re-checks only those.
+  auto flush = [&]() {
+    std::vector<std::string> keys;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const auto &item : m_entries) {
+        const std::string &key = item.first;
+        const Entry &entry = item.second;
+
+        bool affected = overflow;
+        for (auto it = changedPaths.begin(); !affected && it != changedPaths.end(); ++it) {
+          const std::string &path = *it;
+          affected = (path == key) ||
+                     IsInside(key, path) ||
+                     (entry.isDirectory && IsInside(path, key) && (entry.recursive || ParentOf(path) == key));
+        }
+        if (affected) {
+          keys.push_back(key);
+        }
+      }
+    }
+
+    changedPaths.clear();
+    overflow = false;
+    pending = false;
+
+    CheckEntries(keys);
+  };
+
+  alignas(struct inotify_event) char buf[16 * 1024];
+
+  for (;;) {
+    if (resync) {
+      resync = false;
+      ScopeTimer t("FCM: sync watches");
+      syncWatches();
+    }
+
+    int timeoutMs = -1;
+    if (pending) {
+      const auto deadline = std::min(lastEvent + kDebounce, firstEvent + kMaxDelay);
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+      timeoutMs = std::max<int>(0, static_cast<int>(left.count()));
+    }
+
+    pollfd fds[2] = {{m_inotifyFd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+    int rc = poll(fds, 2, timeoutMs);
+    if (rc < 0 && errno != EINTR) {
+      APP_DEBUG_LOG("FCM: poll failed: %d", errno);
+      break;
+    }
+
+    if (rc > 0 && (fds[1].revents & POLLIN)) {
+      uint64_t value = 0;
+      ssize_t n = read(m_wakeFd, &value, sizeof(value));
+      (void)n;
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_stop) {
+        break;
+      }
+      resync = true;
+    }
+
+    if (rc > 0 && (fds[0].revents & POLLIN)) {
+      for (;;) {
+        ssize_t len = read(m_inotifyFd, buf, sizeof(buf));
+        if (len <= 0) {
+          break;
+        }
+
+        for (char *p = buf; p < buf + len;) {
+          const auto *ev = reinterpret_cast<const struct inotify_event *>(p);
+          p += sizeof(struct inotify_event) + ev->len;
+
+          if (ev->mask & IN_Q_OVERFLOW) {
+            overflow = true;
+            resync = true;
+            markChanged({});
+            continue;
+          }
+
+          const std::string *dir = watches.PathOf(ev->wd);
+          if (!dir) {
+            continue;
+          }
+
+          std::string path = *dir;
+          if (ev->len > 0 && ev->name[0] != '\0') {
+            path += '/';
+            path += ev->name;
+          }
+
+          // new / removed subdirectories and removed roots change the watch set
+          if (((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))) ||
+              (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+            resync = true;
+          }
+          if (ev->mask & IN_IGNORED) {
+            watches.Forget(ev->wd);
+            resync = true;
+          }
+
+          markChanged(std::move(path));
+        }
+      }
+    }
+
+    if (pending) {
+      const auto now = Clock::now();
+      if (now >= lastEvent + kDebounce || now >= firstEvent + kMaxDelay) {
+        if (resync) {
+          resync = false;
+          syncWatches();
+        }
+        flush();
+      }
+    }
+  }
+}
+
+#endif
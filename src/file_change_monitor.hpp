@@ -19,8 +19,11 @@
 #pragma once
 
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #include <wx/event.h>
 #include <wx/timer.h>
 
@@ -32,9 +35,19 @@ enum class FileChangeKind {
 
 wxDECLARE_EVENT(EVT_FILE_MONITOR_CHANGED, wxThreadEvent);
 
+/**
+ * Watches files and directory trees and posts EVT_FILE_MONITOR_CHANGED to the owner.
+ *
+ * On Linux the changes are delivered by inotify on a worker thread: events are
+ * coalesced per watched entry and debounced, then only the affected entries are
+ * re-checked (off the GUI thread). Snapshot polling on the GUI timer is kept as a
+ * fallback for other platforms and for entries which cannot be watched (missing
+ * path, inotify watch limit, ...).
+ */
 class FileChangeMonitor : public wxEvtHandler {
 public:
   explicit FileChangeMonitor(wxEvtHandler *owner, int pollIntervalMs = 1000);
+  ~FileChangeMonitor() override;
 
   void WatchFile(const std::string &path);
   void WatchDirectory(const std::string &path, bool recursive = true);
@@ -53,18 +66,37 @@ private:
     std::string path;
     bool isDirectory = false;
     bool recursive = false;
+    bool polling = true;     // false -> covered by the event backend
+    uint64_t generation = 0; // bumped whenever the snapshot is reset
     Snapshot snapshot;
   };
 
   wxEvtHandler *m_owner = nullptr;
   wxTimer m_timer;
+
+  std::mutex m_mutex; // guards m_entries (shared with the backend thread)
   std::unordered_map<std::string, Entry> m_entries;
+  uint64_t m_nextGeneration = 0;
+
+#ifdef __linux__
+  int m_inotifyFd = -1;
+  int m_wakeFd = -1;
+  bool m_stop = false; // guarded by m_mutex
+  std::thread m_thread;
+
+  bool StartBackend();
+  void StopBackend();
+  void RequestResync();
+  void BackendLoop();
+#endif
 
   static Snapshot CaptureSnapshot(const Entry &entry);
   static uint64_t HashString(const std::string &value);
   static void HashCombine(uint64_t &seed, uint64_t value);
   static std::string NormalizeKey(const std::string &path);
 
+  void AddEntry(const std::string &path, bool isDirectory, bool recursive);
+  size_t CheckEntries(const std::vector<std::string> &keys); // returns number of posted changes
   void PostChange(const Entry &entry, FileChangeKind kind);
   void OnTimer(wxTimerEvent &event);
 };
@@ -19,6 +19,10 @@
 #include "lcs.hpp"
 #include "ard_diff.hpp"
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -33,113 +37,275 @@ static wxString NormalizeForCompare(wxString s) {
   s.Replace(wxT("\r"), wxEmptyString);
 
   if (IsWeakLine(s)) {
-    // empty key => never match (we'll enforce that in comparisons)
+    // empty key => left out of the diff, never an anchor
     return wxEmptyString;
   }
 
   return s;
 }
 
-ArduinoLcsDiffAligner::AlignedBlocks ArduinoLcsDiffAligner::AlignByPadding(const std::vector<wxString> &a,
-                                                                           const std::vector<wxString> &b) {
-  AlignedBlocks r;
-  const size_t maxLen = std::max(a.size(), b.size());
-  r.left = a;
-  r.right = b;
-  r.left.resize(maxLen, wxEmptyString);
-  r.right.resize(maxLen, wxEmptyString);
-  return r;
-}
+namespace {
+
+// Linear space Myers diff (divide & conquer on the middle snake), the same
+// scheme xdiff uses. Works on interned ids, so comparing two lines is a
+// single int compare.
+class MyersDiff {
+public:
+  MyersDiff(const std::vector<int> &a, const std::vector<int> &b, std::vector<std::pair<int, int>> &out)
+      : m_a(a), m_b(b), m_out(out) {
+    const size_t diags = a.size() + b.size() + 3;
+    m_fwd.resize(diags);
+    m_bwd.resize(diags);
+    m_offset = (int)b.size() + 1;
+
+    // Past this edit cost the split is only approximated.
+    m_maxCost = std::max(256, (int)std::sqrt((double)diags));
+  }
 
-std::vector<int>
-ArduinoLcsDiffAligner::LcsScoreForward(const std::vector<wxString> &a, int a0, int a1,
-                                       const std::vector<wxString> &b, int b0, int b1) {
-  const int n = a1 - a0;
-  const int m = b1 - b0;
-
-  std::vector<int> prev(m + 1, 0), cur(m + 1, 0);
-  for (int i = 0; i < n; ++i) {
-    cur[0] = 0;
-    const wxString ai = NormalizeForCompare(a[a0 + i]);
-    for (int j = 0; j < m; ++j) {
-      const wxString bj = NormalizeForCompare(b[b0 + j]);
-      const bool match = !ai.empty() && (ai == bj);
-      if (match)
-        cur[j + 1] = prev[j] + 1;
-      else
-        cur[j + 1] = std::max(cur[j], prev[j + 1]);
-    }
-    std::swap(prev, cur);
+  void Run() {
+    Compare(0, (int)m_a.size(), 0, (int)m_b.size());
   }
-  return prev;
-}
 
-std::vector<int>
-ArduinoLcsDiffAligner::LcsScoreReverse(const std::vector<wxString> &a, int a0, int a1,
-                                       const std::vector<wxString> &b, int b0, int b1) {
-  const int n = a1 - a0;
-  const int m = b1 - b0;
-
-  std::vector<int> prev(m + 1, 0), cur(m + 1, 0);
-  for (int i = 0; i < n; ++i) {
-    cur[0] = 0;
-    const wxString ai = NormalizeForCompare(a[a1 - 1 - i]);
-    for (int j = 0; j < m; ++j) {
-      const wxString bj = NormalizeForCompare(b[b1 - 1 - j]);
-      const bool match = !ai.empty() && (ai == bj);
-      if (match)
-        cur[j + 1] = prev[j] + 1;
-      else
-        cur[j + 1] = std::max(cur[j], prev[j + 1]);
+private:
+  const std::vector<int> &m_a;
+  const std::vector<int> &m_b;
+  std::vector<std::pair<int, int>> &m_out;
+
+  std::vector<int> m_fwd; // furthest x reached on diagonal k (forward)
+  std::vector<int> m_bwd; // furthest x reached on diagonal k (backward)
+  int m_offset = 0;
+  int m_maxCost = 256;
+
+  int &Fwd(int k) { return m_fwd[(size_t)(k + m_offset)]; }
+  int &Bwd(int k) { return m_bwd[(size_t)(k + m_offset)]; }
+
+  void Compare(int a0, int a1, int b0, int b1) {
+    // common prefix
+    while (a0 < a1 && b0 < b1 && m_a[a0] == m_b[b0]) {
+      m_out.emplace_back(a0++, b0++);
+    }
+
+    // common suffix (emitted after the middle part)
+    int suffix = 0;
+    while (a0 < a1 && b0 < b1 && m_a[a1 - 1] == m_b[b1 - 1]) {
+      --a1;
+      --b1;
+      ++suffix;
+    }
+
+    if (a0 < a1 && b0 < b1) {
+      int sx = 0, sy = 0;
+      Split(a0, a1, b0, b1, sx, sy);
+
+      const bool degenerate = (sx == a0 && sy == b0) || (sx == a1 && sy == b1);
+      if (!degenerate) {
+        Compare(a0, sx, b0, sy);
+        Compare(sx, a1, sy, b1);
+      }
+      // degenerate split -> the whole range is delete + insert
+    }
+
+    for (int i = 0; i < suffix; ++i) {
+      m_out.emplace_back(a1 + i, b1 + i);
     }
-    std::swap(prev, cur);
   }
-  return prev;
-}
 
-void ArduinoLcsDiffAligner::Hirschberg(
-    const std::vector<wxString> &a, int a0, int a1,
-    const std::vector<wxString> &b, int b0, int b1,
-    std::vector<std::pair<int, int>> &outMatches) {
+  // Finds a point (sx, sy) on an optimal path (or a good one when the cost
+  // limit is reached) through a[a0, a1) x b[b0, b1).
+  void Split(int a0, int a1, int b0, int b1, int &sx, int &sy) {
+    const int dmin = a0 - b1;
+    const int dmax = a1 - b0;
+    const int fmid = a0 - b0;
+    const int bmid = a1 - b1;
+    const bool odd = ((fmid - bmid) & 1) != 0;
+
+    int fmin = fmid, fmax = fmid;
+    int bmin = bmid, bmax = bmid;
+
+    Fwd(fmid) = a0;
+    Bwd(bmid) = a1;
+
+    for (int cost = 1;; ++cost) {
+      // forward step
+      if (fmin > dmin)
+        Fwd(--fmin - 1) = -1;
+      else
+        ++fmin;
+      if (fmax < dmax)
+        Fwd(++fmax + 1) = -1;
+      else
+        --fmax;
+
+      for (int k = fmax; k >= fmin; k -= 2) {
+        int x = (Fwd(k - 1) >= Fwd(k + 1)) ? Fwd(k - 1) + 1 : Fwd(k + 1);
+        int y = x - k;
+        while (x < a1 && y < b1 && m_a[x] == m_b[y]) {
+          ++x;
+          ++y;
+        }
+        Fwd(k) = x;
+        if (odd && bmin <= k && k <= bmax && Bwd(k) <= x) {
+          sx = x;
+          sy = y;
+          return;
+        }
+      }
 
-  const int n = a1 - a0;
-  const int m = b1 - b0;
+      // backward step
+      if (bmin > dmin)
+        Bwd(--bmin - 1) = std::numeric_limits<int>::max();
+      else
+        ++bmin;
+      if (bmax < dmax)
+        Bwd(++bmax + 1) = std::numeric_limits<int>::max();
+      else
+        --bmax;
+
+      for (int k = bmax; k >= bmin; k -= 2) {
+        int x = (Bwd(k - 1) < Bwd(k + 1)) ? Bwd(k - 1) : Bwd(k + 1) - 1;
+        int y = x - k;
+        while (x > a0 && y > b0 && m_a[x - 1] == m_b[y - 1]) {
+          --x;
+          --y;
+        }
+        Bwd(k) = x;
+        if (!odd && fmin <= k && k <= fmax && x <= Fwd(k)) {
+          sx = x;
+          sy = y;
+          return;
+        }
+      }
 
-  if (n <= 0 || m <= 0)
-    return;
+      if (cost < m_maxCost)
+        continue;
+
+      // Too expensive: take whichever frontier got furthest.
+      int fbest = -1, fbestX = a0;
+      for (int k = fmax; k >= fmin; k -= 2) {
+        int x = std::min(Fwd(k), a1);
+        int y = x - k;
+        if (y > b1) {
+          x = b1 + k;
+          y = b1;
+        }
+        if (fbest < x + y) {
+          fbest = x + y;
+          fbestX = x;
+        }
+      }
 
-  if (n == 1) {
-    const wxString needle = NormalizeForCompare(a[a0]);
-    if (!needle.empty()) {
-      for (int j = b0; j < b1; ++j) {
-        if (needle == NormalizeForCompare(b[j])) {
-          outMatches.emplace_back(a0, j);
-          break;
+      int bbest = std::numeric_limits<int>::max(), bbestX = a1;
+      for (int k = bmax; k >= bmin; k -= 2) {
+        int x = std::max(a0, Bwd(k));
+        int y = x - k;
+        if (y < b0) {
+          x = b0 + k;
+          y = b0;
         }
+        if (x + y < bbest) {
+          bbest = x + y;
+          bbestX = x;
+        }
+      }
+
+      if ((a1 + b1) - bbest < fbest - (a0 + b0)) {
+        sx = fbestX;
+        sy = fbest - fbestX;
+      } else {
+        sx = bbestX;
+        sy = bbest - bbestX;
       }
+      return;
     }
-    return;
   }
+};
+
+enum class TokenClass { Word,
+                        Space,
+                        Punct };
+
+TokenClass ClassifyByte(unsigned char c) {
+  if (c == '_' || c >= 0x80 || std::isalnum(c))
+    return TokenClass::Word;
+  if (c == ' ' || c == '\t')
+    return TokenClass::Space;
+  return TokenClass::Punct;
+}
 
-  const int amid = a0 + n / 2;
+// Splits a line into [start, end) token ranges and interns each token.
+void TokenizeLine(const std::string &s,
+                  std::unordered_map<std::string, int> &ids,
+                  std::vector<int> &outIds,
+                  std::vector<ArduinoLcsDiffAligner::WordRange> &outRanges) {
+  size_t i = 0;
+  while (i < s.size()) {
+    const TokenClass cls = ClassifyByte((unsigned char)s[i]);
+    size_t j = i + 1;
+    if (cls != TokenClass::Punct) {
+      while (j < s.size() && ClassifyByte((unsigned char)s[j]) == cls) {
+        ++j;
+      }
+    }
 
-  const auto leftScore = LcsScoreForward(a, a0, amid, b, b0, b1);
-  const auto rightScore = LcsScoreReverse(a, amid, a1, b, b0, b1);
+    auto it = ids.emplace(s.substr(i, j - i), (int)ids.size()).first;
+    outIds.push_back(it->second);
+    outRanges.push_back({(int)i, (int)j});
+    i = j;
+  }
+}
 
-  int bestK = 0;
-  int bestVal = -1;
-  for (int k = 0; k <= m; ++k) {
-    const int v = leftScore[k] + rightScore[m - k];
-    if (v > bestVal) {
-      bestVal = v;
-      bestK = k;
-    }
+// Unmatched tokens -> merged byte ranges.
+void CollectChangedRanges(const std::vector<ArduinoLcsDiffAligner::WordRange> &tokens,
+                          const std::vector<char> &matched,
+                          std::vector<ArduinoLcsDiffAligner::WordRange> &out) {
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    if (matched[i])
+      continue;
+    if (!out.empty() && out.back().end == tokens[i].start)
+      out.back().end = tokens[i].end;
+    else
+      out.push_back(tokens[i]);
   }
+}
+
+} // namespace
 
-  const int bmid = b0 + bestK;
+void ArduinoLcsDiffAligner::DiffIds(const std::vector<int> &a,
+                                    const std::vector<int> &b,
+                                    std::vector<std::pair<int, int>> &outMatches) {
+  MyersDiff diff(a, b, outMatches);
+  diff.Run();
+}
+
+bool ArduinoLcsDiffAligner::DiffWords(const std::string &a,
+                                      const std::string &b,
+                                      std::vector<WordRange> &outA,
+                                      std::vector<WordRange> &outB) {
+  outA.clear();
+  outB.clear();
+
+  constexpr size_t maxLineBytes = 4096;
+  if (a.size() > maxLineBytes || b.size() > maxLineBytes)
+    return false;
+
+  std::unordered_map<std::string, int> ids;
+  std::vector<int> idsA, idsB;
+  std::vector<WordRange> tokA, tokB;
+  TokenizeLine(a, ids, idsA, tokA);
+  TokenizeLine(b, ids, idsB, tokB);
 
-  Hirschberg(a, a0, amid, b, b0, bmid, outMatches);
-  Hirschberg(a, amid, a1, b, bmid, b1, outMatches);
+  std::vector<std::pair<int, int>> matches;
+  DiffIds(idsA, idsB, matches);
+
+  std::vector<char> matchedA(tokA.size(), 0), matchedB(tokB.size(), 0);
+  for (const auto &p : matches) {
+    matchedA[(size_t)p.first] = 1;
+    matchedB[(size_t)p.second] = 1;
+  }
+
+  CollectChangedRanges(tokA, matchedA, outA);
+  CollectChangedRanges(tokB, matchedB, outB);
+  return true;
 }
 
 ArduinoLcsDiffAligner::AlignedBlocks
@@ -200,19 +366,16 @@ ArduinoLcsDiffAligner::BuildAlignedFromMatches(
       }
     }
 
-    // 3) The rest: deletions
-    for (int x = i; x <= ii; ++x) {
-      r.left.push_back(a[x]);
-      r.right.push_back(wxEmptyString);
-    }
-
-    // 4) The rest: insertions
-    for (int y = j; y <= jj; ++y) {
-      r.left.push_back(wxEmptyString);
-      r.right.push_back(b[y]);
+    // 3) The rest: deletions and insertions side by side (modified lines),
+    //    the longer side is padded with empty lines
+    const int dels = ii - i + 1;
+    const int ins = jj - j + 1;
+    for (int k = 0; k < std::max(dels, ins); ++k) {
+      r.left.push_back(k < dels ? a[i + k] : wxString());
+      r.right.push_back(k < ins ? b[j + k] : wxString());
     }
 
-    // 5) And finally, the paired tail (reverse the order, we collected from the back)
+    // 4) And finally, the paired tail (reverse the order, we collected from the back)
     for (auto it = tail.rbegin(); it != tail.rend(); ++it) {
       r.left.push_back(it->first);
       r.right.push_back(it->second);
@@ -238,24 +401,37 @@ ArduinoLcsDiffAligner::BuildAlignedFromMatches(
 ArduinoLcsDiffAligner::AlignedBlocks
 ArduinoLcsDiffAligner::Align(const std::vector<wxString> &a,
                              const std::vector<wxString> &b) const {
-  const uint64_t n = a.size();
-  const uint64_t m = b.size();
+  ScopeTimer t("LCS: Align %zu x %zu lines", a.size(), b.size());
+
+  // Weak lines (empty / braces) never act as anchors, they are left out of
+  // the diff and paired locally by BuildAlignedFromMatches.
+  std::unordered_map<std::string, int> ids;
+  std::vector<int> idsA, idsB;
+  std::vector<int> lineA, lineB; // id index -> line index
+
+  auto intern = [&](const std::vector<wxString> &lines, std::vector<int> &outIds, std::vector<int> &outLines) {
+    outIds.reserve(lines.size());
+    outLines.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+      const wxString key = NormalizeForCompare(lines[i]);
+      if (key.empty())
+        continue;
+      const wxScopedCharBuffer utf8 = key.utf8_str();
+      auto it = ids.emplace(std::string(utf8.data(), utf8.length()), (int)ids.size()).first;
+      outIds.push_back(it->second);
+      outLines.push_back((int)i);
+    }
+  };
 
-  if (n * m > m_maxCells)
-    return AlignByPadding(a, b);
+  intern(a, idsA, lineA);
+  intern(b, idsB, lineB);
 
   std::vector<std::pair<int, int>> matches;
-  Hirschberg(a, 0, (int)a.size(), b, 0, (int)b.size(), matches);
+  DiffIds(idsA, idsB, matches);
 
-  std::vector<std::pair<int, int>> filtered;
-  filtered.reserve(matches.size());
-  int lastA = -1, lastB = -1;
-  for (const auto &p : matches) {
-    if (p.first > lastA && p.second > lastB) {
-      filtered.push_back(p);
-      lastA = p.first;
-      lastB = p.second;
-    }
+  for (auto &p : matches) {
+    p.first = lineA[(size_t)p.first];
+    p.second = lineB[(size_t)p.second];
   }
-  return BuildAlignedFromMatches(a, b, filtered);
+  return BuildAlignedFromMatches(a, b, matches);
 }
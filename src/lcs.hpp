@@ -19,15 +19,18 @@
 #pragma once
 
 #include <cstdint>
-#include <deque>
-#include <map>
-#include <set>
+#include <string>
+#include <utility>
 #include <vector>
 #include <wx/string.h>
 
-// LCS-based aligner for side-by-side diff views.
+// Myers-diff based aligner for side-by-side diff views.
 // Takes two sequences of logical lines and produces two aligned sequences
 // of equal length, inserting empty lines where needed.
+//
+// Lines are interned to integer ids first, the diff itself runs in
+// O((N+M)*D) time and linear space. Very expensive inputs are split
+// heuristically (like git does), so the result is always a real alignment.
 class ArduinoLcsDiffAligner {
 public:
   struct AlignedBlocks {
@@ -35,26 +38,28 @@ public:
     std::vector<wxString> right;
   };
 
-  // Guard against pathological cases (O(n*m)).
-  void SetMaxCellWork(uint64_t maxCells) { m_maxCells = maxCells; }
+  // Byte range [start, end) inside a UTF-8 line.
+  struct WordRange {
+    int start = 0;
+    int end = 0;
+  };
 
   AlignedBlocks Align(const std::vector<wxString> &a,
                       const std::vector<wxString> &b) const;
 
-private:
-  uint64_t m_maxCells = 100'000ULL;
-
-  static AlignedBlocks AlignByPadding(const std::vector<wxString> &a,
-                                      const std::vector<wxString> &b);
+  // Intra-line diff of two UTF-8 lines (words, whitespace runs and single
+  // punctuation chars are the tokens). Returns false when the lines are too
+  // long to be worth it.
+  static bool DiffWords(const std::string &a,
+                        const std::string &b,
+                        std::vector<WordRange> &outA,
+                        std::vector<WordRange> &outB);
 
-  static std::vector<int> LcsScoreForward(const std::vector<wxString> &a, int a0, int a1,
-                                          const std::vector<wxString> &b, int b0, int b1);
-  static std::vector<int> LcsScoreReverse(const std::vector<wxString> &a, int a0, int a1,
-                                          const std::vector<wxString> &b, int b0, int b1);
-
-  static void Hirschberg(const std::vector<wxString> &a, int a0, int a1,
-                         const std::vector<wxString> &b, int b0, int b1,
-                         std::vector<std::pair<int, int>> &outMatches);
+private:
+  // Matching (i, j) index pairs of two id sequences, in increasing order.
+  static void DiffIds(const std::vector<int> &a,
+                      const std::vector<int> &b,
+                      std::vector<std::pair<int, int>> &outMatches);
 
   static AlignedBlocks BuildAlignedFromMatches(
       const std::vector<wxString> &a,
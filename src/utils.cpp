@@ -807,6 +807,45 @@ wxImageList *CreateNotebookPageImageList(const wxColour &color) {
   return imgList;
 }
 
+SketchFileBuffer::SketchFileBuffer(std::string name, std::string code)
+    : filename(std::move(name)) {
+  auto text = std::make_shared<std::string>(std::move(code));
+  m_owned = text.get();
+  m_text = std::move(text);
+}
+
+SketchFileBuffer::SketchFileBuffer(std::string name, std::shared_ptr<const std::string> text)
+    : filename(std::move(name)), m_text(std::move(text)) {
+}
+
+SketchFileBuffer::SketchFileBuffer(const SketchFileBuffer &other)
+    : filename(other.filename), m_text(other.m_text) {
+}
+
+SketchFileBuffer &SketchFileBuffer::operator=(const SketchFileBuffer &other) {
+  if (this != &other) {
+    filename = other.filename;
+    m_text = other.m_text;
+    m_owned = nullptr;
+  }
+  return *this;
+}
+
+const std::string &SketchFileBuffer::Code() const {
+  static const std::string empty;
+  return m_text ? *m_text : empty;
+}
+
+std::string &SketchFileBuffer::MutableCode() {
+  // shared with another buffer (or an editor snapshot) -> take a private copy
+  if (!m_owned || m_text.use_count() != 1) {
+    auto text = std::make_shared<std::string>(Code());
+    m_owned = text.get();
+    m_text = std::move(text);
+  }
+  return *m_owned;
+}
+
 std::unordered_set<std::string> SearchCodeIncludes(const std::vector<SketchFileBuffer> &files, const std::string &sketchPath) {
   ScopeTimer t("UTIL: SearchCodeIncludes()");
 
@@ -870,7 +909,7 @@ std::unordered_set<std::string> SearchCodeIncludes(const std::vector<SketchFileB
 
   // Scan each file line-by-line using pointers and memchr (no per-line allocations).
   for (const auto &sf : files) {
-    const std::string &code = sf.code;
+    const std::string &code = sf.Code();
 
     // Be careful with logging in hot paths. Even in debug builds this can cost real time.
     // APP_DEBUG_LOG("UTIL: Resolving includes in %s", sf.filename.c_str());
@@ -1257,7 +1296,7 @@ uint64_t CcSumCode(const std::vector<SketchFileBuffer> &files) {
   uint64_t h = fnv1a64_init();
   for (const auto &f : files) {
     std::string_view name = f.filename;
-    std::string_view code = f.code;
+    std::string_view code = f.Code();
 
     h = fnv1a64_update_sv(h, name);
     h = fnv1a64_update(h, "\0", 1); // separator
@@ -1275,7 +1314,7 @@ uint64_t CcSumIncludes(const std::vector<SketchFileBuffer> &files) {
 
   for (const auto &f : files) {
     std::string_view name = f.filename;
-    std::string_view code = f.code;
+    std::string_view code = f.Code();
 
     h = fnv1a64_update_sv(h, name);
     h = fnv1a64_update(h, "\n", 1);
@@ -2254,6 +2293,22 @@ wxFileConfig *OpenWorkspaceConfig(const std::string &sketchPath) {
       wxCONFIG_USE_LOCAL_FILE);
 }
 
+std::string GetAppCacheDir(const std::string &subdir) {
+  wxFileName dirFn(wxStandardPaths::Get().GetUserDir(wxStandardPaths::Dir_Cache), wxEmptyString);
+  dirFn.AppendDir(wxT("ArduinoEditor"));
+  if (!subdir.empty()) {
+    dirFn.AppendDir(wxString::FromUTF8(subdir));
+  }
+
+  wxString dirPath = dirFn.GetPath();
+  if (!wxDirExists(dirPath) && !wxFileName::Mkdir(dirPath, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+    APP_DEBUG_LOG("UTIL: cannot create cache dir %s", wxToStd(dirPath).c_str());
+    return std::string();
+  }
+
+  return wxToStd(dirPath);
+}
+
 // Join: ["a","b","c"] -> "a|b|c"
 wxString JoinWxStrings(const std::vector<wxString> &items, wxChar sep) {
   wxString out;
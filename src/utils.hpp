@@ -21,6 +21,7 @@
 #include <chrono>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_set>
@@ -106,9 +107,33 @@ struct ScopeTimer {
   }
 };
 
-struct SketchFileBuffer {
+/**
+ * One file of the sketch. The code is held as an immutable shared snapshot, so
+ * copying file lists (worker snapshots, AI sessions...) never copies the text
+ * and libclang unsaved files can point straight into it. MutableCode() detaches
+ * a private copy before the first write.
+ */
+class SketchFileBuffer {
+public:
   std::string filename; // relative/absolute path within the sketch (.ino, .cpp, .hpp...)
-  std::string code;     // current content of the editor
+
+  SketchFileBuffer() = default;
+  SketchFileBuffer(std::string name, std::string code);
+  SketchFileBuffer(std::string name, std::shared_ptr<const std::string> text);
+
+  SketchFileBuffer(const SketchFileBuffer &other);
+  SketchFileBuffer &operator=(const SketchFileBuffer &other);
+  SketchFileBuffer(SketchFileBuffer &&) = default;
+  SketchFileBuffer &operator=(SketchFileBuffer &&) = default;
+
+  // current content of the editor
+  const std::string &Code() const;
+  const std::shared_ptr<const std::string> &Text() const { return m_text; }
+  std::string &MutableCode();
+
+private:
+  std::shared_ptr<const std::string> m_text;
+  std::string *m_owned = nullptr; // m_text created by MutableCode()
 };
 
 // Returns <0 if a < b, 0 if a == b, >0 if a > b
@@ -223,6 +248,10 @@ void KillUnfocusedColor(wxGenericTreeCtrl *tree);
 
 wxFileConfig *OpenWorkspaceConfig(const std::string &sketchPath);
 
+// Per-user cache directory of the editor (created on demand), e.g. ~/.cache/ArduinoEditor/<subdir>.
+// Returns empty string when it cannot be created.
+std::string GetAppCacheDir(const std::string &subdir);
+
 std::vector<wxString> SplitWxString(const wxString &s, wxChar sep, bool trim = true, bool skipEmpty = true);
 wxString JoinWxStrings(const std::vector<wxString> &items, wxChar sep);
 